@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ *
+ *
+ * This program compiles the text .reg, .asic and .soc15 files of a database
+ * tree into a single binary image that umr can map instead of parsing text.
+ */
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../src/umr_database_image.h"
+
+#define MAXLEN 512
+#define STR_HASH_SIZE (1 << 20)
+
+// growable output buffer
+struct buf {
+	uint8_t *data;
+	uint64_t size, alloc;
+};
+
+struct srcfile {
+	char path[MAXLEN], relpath[MAXLEN];
+	int basename;                  // offset of the basename in relpath
+	enum umr_db_image_type type;
+	uint64_t size, mtime;
+	uint32_t ostrbase, ostrrel;
+	uint64_t off;
+};
+
+static struct buf image, strings;
+static struct srcfile *files;
+static uint32_t no_files, alloc_files;
+
+// string table with de-duplication (bitfield names repeat a lot)
+static struct strent {
+	uint32_t off;
+	struct strent *next;
+} *strhash[STR_HASH_SIZE];
+
+static void *buf_reserve(struct buf *b, uint64_t size)
+{
+	void *p;
+
+	// keep every record 8-byte aligned
+	size = (size + 7) & ~7ULL;
+	if (b->size + size > b->alloc) {
+		b->alloc = (b->alloc + size) * 2;
+		b->data = realloc(b->data, b->alloc);
+		if (!b->data) {
+			fprintf(stderr, "[ERROR]: Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	p = &b->data[b->size];
+	memset(p, 0, size);
+	b->size += size;
+	return p;
+}
+
+static uint32_t str_hash(const char *s)
+{
+	uint32_t h = 2166136261UL;
+	while (*s)
+		h = (h ^ (uint8_t)*s++) * 16777619UL;
+	return h & (STR_HASH_SIZE - 1);
+}
+
+static uint32_t add_string(const char *s)
+{
+	struct strent *e;
+	uint32_t h, len;
+	char *p;
+
+	h = str_hash(s);
+	for (e = strhash[h]; e; e = e->next)
+		if (!strcmp((char *)&strings.data[e->off], s))
+			return e->off;
+
+	len = strlen(s) + 1;
+	if (strings.size + len > strings.alloc) {
+		strings.alloc = (strings.alloc + len) * 2;
+		strings.data = realloc(strings.data, strings.alloc);
+		if (!strings.data) {
+			fprintf(stderr, "[ERROR]: Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	p = (char *)&strings.data[strings.size];
+	memcpy(p, s, len);
+
+	e = calloc(1, sizeof *e);
+	e->off = strings.size;
+	e->next = strhash[h];
+	strhash[h] = e;
+
+	strings.size += len;
+	return e->off;
+}
+
+static void add_file(const char *root, const char *relpath, enum umr_db_image_type type)
+{
+	struct srcfile *f;
+	struct stat st;
+	char *p;
+
+	if (no_files == alloc_files) {
+		alloc_files = alloc_files ? alloc_files * 2 : 256;
+		files = realloc(files, alloc_files * sizeof *files);
+	}
+	f = &files[no_files];
+	memset(f, 0, sizeof *f);
+	snprintf(f->path, sizeof f->path, "%s/%s", root, relpath);
+	snprintf(f->relpath, sizeof f->relpath, "%s", relpath);
+	p = strrchr(f->relpath, '/');
+	f->basename = p ? (p + 1 - f->relpath) : 0;
+	f->type = type;
+	if (stat(f->path, &st)) {
+		fprintf(stderr, "[WARNING]: Cannot stat '%s'\n", f->path);
+		return;
+	}
+	f->size = st.st_size;
+	f->mtime = st.st_mtime;
+	++no_files;
+}
+
+// recursively collect database files, relpath is relative to the database root
+static void scan_dir(const char *root, const char *relpath)
+{
+	DIR *dir;
+	struct dirent *di;
+	char p[MAXLEN], rp[MAXLEN];
+	int len;
+
+	snprintf(p, sizeof p, "%s/%s", root, relpath);
+	dir = opendir(p);
+	if (!dir) {
+		fprintf(stderr, "[ERROR]: Cannot open directory '%s'\n", p);
+		return;
+	}
+	while ((di = readdir(dir))) {
+		if (!strcmp(di->d_name, ".") || !strcmp(di->d_name, ".."))
+			continue;
+		if (relpath[0])
+			snprintf(rp, sizeof rp, "%s/%s", relpath, di->d_name);
+		else
+			snprintf(rp, sizeof rp, "%s", di->d_name);
+		if (di->d_type == DT_DIR) {
+			scan_dir(root, rp);
+			continue;
+		}
+		len = strlen(di->d_name);
+		if (len > 4 && !strcmp(di->d_name + len - 4, ".reg"))
+			add_file(root, rp, UMR_DB_IMAGE_REG);
+		else if (len > 5 && !strcmp(di->d_name + len - 5, ".asic"))
+			add_file(root, rp, UMR_DB_IMAGE_ASIC);
+		else if (len > 6 && !strcmp(di->d_name + len - 6, ".soc15"))
+			add_file(root, rp, UMR_DB_IMAGE_SOC15);
+	}
+	closedir(dir);
+}
+
+static int compile_reg(struct srcfile *sf, FILE *f)
+{
+	char linebuf[MAXLEN], name[MAXLEN];
+	struct umr_db_image_regfile *rf;
+	struct umr_db_image_reg *regs;
+	struct umr_db_image_bit *bits;
+	uint64_t rf_off, regs_off, bits_off, alloc_bits;
+	uint32_t no_regs, no_bits, x, y;
+
+	if (!fgets(linebuf, sizeof linebuf, f) || sscanf(linebuf, "%"SCNu32, &no_regs) != 1) {
+		fprintf(stderr, "[ERROR]: Invalid register count in '%s'\n", sf->path);
+		return -1;
+	}
+
+	// registers are stored now, bitfields are collected and appended afterwards
+	rf_off = image.size;
+	buf_reserve(&image, sizeof *rf);
+	regs_off = image.size;
+	buf_reserve(&image, no_regs * sizeof *regs);
+
+	alloc_bits = 1024;
+	bits = calloc(alloc_bits, sizeof *bits);
+	no_bits = 0;
+
+	for (x = 0; x < no_regs && fgets(linebuf, sizeof linebuf, f); x++) {
+		struct {
+			int type;
+			uint64_t addr;
+			uint32_t nobits, is64, idx;
+		} reg_fields;
+
+		regs = (struct umr_db_image_reg *)&image.data[regs_off];
+		if (sscanf(linebuf, "%s %d 0x%"SCNx64" %"SCNu32" %"SCNu32" %"SCNu32,
+			   name, &reg_fields.type, &reg_fields.addr,
+			   &reg_fields.nobits, &reg_fields.is64, &reg_fields.idx) != 6) {
+			fprintf(stderr, "[ERROR]: Invalid regfile line [%s] in '%s'\n", linebuf, sf->path);
+			free(bits);
+			return -1;
+		}
+		regs[x].name = add_string(name);
+		regs[x].type = reg_fields.type;
+		regs[x].addr = reg_fields.addr;
+		regs[x].no_bits = reg_fields.nobits;
+		regs[x].bit64 = reg_fields.is64;
+		regs[x].idx = reg_fields.idx;
+		regs[x].first_bit = no_bits;
+
+		for (y = 0; y < reg_fields.nobits; y++) {
+			int start, stop;
+			if (!fgets(linebuf, sizeof linebuf, f) ||
+			    sscanf(linebuf, "\t%s %d %d", name, &start, &stop) != 3) {
+				fprintf(stderr, "[ERROR]: Invalid bitfield line [%s] in '%s'\n", linebuf, sf->path);
+				free(bits);
+				return -1;
+			}
+			if (no_bits == alloc_bits) {
+				alloc_bits *= 2;
+				bits = realloc(bits, alloc_bits * sizeof *bits);
+			}
+			memset(&bits[no_bits], 0, sizeof bits[0]);
+			bits[no_bits].name = add_string(name);
+			bits[no_bits].start = start;
+			bits[no_bits].stop = stop;
+			++no_bits;
+		}
+	}
+	if (x != no_regs) {
+		fprintf(stderr, "[ERROR]: Truncated register file '%s'\n", sf->path);
+		free(bits);
+		return -1;
+	}
+
+	bits_off = image.size;
+	memcpy(buf_reserve(&image, no_bits * sizeof *bits), bits, no_bits * sizeof *bits);
+	free(bits);
+
+	rf = (struct umr_db_image_regfile *)&image.data[rf_off];
+	rf->no_regs = no_regs;
+	rf->no_bits = no_bits;
+	rf->regs_off = regs_off;
+	rf->bits_off = bits_off;
+	sf->off = rf_off;
+	return 0;
+}
+
+static int compile_asic(struct srcfile *sf, FILE *f)
+{
+	char linebuf[MAXLEN], cmnname[MAXLEN], soc15fname[MAXLEN], ipcmnname[MAXLEN], ipsocname[MAXLEN], regfile[MAXLEN];
+	struct umr_db_image_asic *asic;
+	struct umr_db_image_asic_block *blocks;
+	uint64_t asic_off, blocks_off;
+	int family, numblocks, vgpr_granularity, is_apu, instance, x;
+
+	if (!fgets(linebuf, sizeof linebuf, f) ||
+	    sscanf(linebuf, "%s %s %d %d %d %d", cmnname, soc15fname, &family, &numblocks, &vgpr_granularity, &is_apu) != 6) {
+		fprintf(stderr, "[ERROR]: Invalid ASIC header line in '%s'\n", sf->path);
+		return -1;
+	}
+
+	asic_off = image.size;
+	buf_reserve(&image, sizeof *asic);
+	blocks_off = image.size;
+	buf_reserve(&image, numblocks * sizeof *blocks);
+
+	for (x = 0; x < numblocks; x++) {
+		blocks = (struct umr_db_image_asic_block *)&image.data[blocks_off];
+		if (!fgets(linebuf, sizeof linebuf, f) ||
+		    sscanf(linebuf, "%s %s %d %s", ipcmnname, ipsocname, &instance, regfile) != 4) {
+			fprintf(stderr, "[ERROR]: Invalid IP header line in '%s'\n", sf->path);
+			return -1;
+		}
+		blocks[x].ipname = add_string(ipcmnname);
+		blocks[x].socname = add_string(ipsocname);
+		blocks[x].regfile = add_string(regfile);
+		blocks[x].instance = instance;
+	}
+
+	asic = (struct umr_db_image_asic *)&image.data[asic_off];
+	asic->name = add_string(cmnname);
+	asic->soc15name = add_string(soc15fname);
+	asic->family = family;
+	asic->no_blocks = numblocks;
+	asic->vgpr_granularity = vgpr_granularity;
+	asic->is_apu = is_apu;
+	asic->blocks_off = blocks_off;
+	sf->off = asic_off;
+	return 0;
+}
+
+// parse a row of segment offsets, mirrors parse_segments() in read_soc15.c
+static int parse_segments(char *linebuf, uint64_t *segs, int max_segs)
+{
+	int n = 0;
+
+	while (*linebuf && (*linebuf == '\t' || *linebuf == ' ')) ++linebuf;
+	while (n < max_segs && *linebuf && (*linebuf != '\n')) {
+		if (sscanf(linebuf, "0x%"SCNx64, &segs[n]) != 1)
+			return n;
+		++n;
+		while (*linebuf && (*linebuf == 'x' || isxdigit(*linebuf))) ++linebuf;
+		while (*linebuf && (*linebuf == '\t' || *linebuf == ' ')) ++linebuf;
+	}
+	return n;
+}
+
+static int compile_soc15(struct srcfile *sf, FILE *f)
+{
+	static uint64_t segs[256][256];
+	char linebuf[4096], ipname[4096];
+	struct umr_db_image_soc15 *soc;
+	struct umr_db_image_soc15_ip *ips;
+	uint64_t soc_off, ip_alloc;
+	uint32_t no_ips, no_inst, no_seg, x;
+	int n, have_line;
+
+	soc_off = image.size;
+	buf_reserve(&image, sizeof *soc);
+
+	ip_alloc = 64;
+	ips = calloc(ip_alloc, sizeof *ips);
+	no_ips = 0;
+	have_line = fgets(linebuf, sizeof linebuf, f) != NULL;
+	while (have_line) {
+		linebuf[strcspn(linebuf, "\r\n")] = 0;
+		snprintf(ipname, sizeof ipname, "%s", linebuf);
+		memset(segs, 0, sizeof segs);
+		no_inst = no_seg = 0;
+		have_line = 0;
+		while (no_inst < 256 && fgets(linebuf, sizeof linebuf, f)) {
+			n = parse_segments(linebuf, segs[no_inst], 256);
+			if (!n) {
+				// this is the name of the next IP block
+				have_line = 1;
+				break;
+			}
+			if ((uint32_t)n > no_seg)
+				no_seg = n;
+			++no_inst;
+		}
+		if (!have_line && no_inst == 256)
+			have_line = fgets(linebuf, sizeof linebuf, f) != NULL;
+
+		if (no_ips == ip_alloc) {
+			ip_alloc *= 2;
+			ips = realloc(ips, ip_alloc * sizeof *ips);
+		}
+		memset(&ips[no_ips], 0, sizeof ips[0]);
+		ips[no_ips].name = add_string(ipname);
+		ips[no_ips].no_inst = no_inst;
+		ips[no_ips].no_seg = no_seg;
+		ips[no_ips].off = image.size;
+		for (x = 0; x < no_inst; x++)
+			memcpy(buf_reserve(&image, no_seg * sizeof(uint64_t)), segs[x], no_seg * sizeof(uint64_t));
+		++no_ips;
+	}
+
+	soc = (struct umr_db_image_soc15 *)&image.data[soc_off];
+	soc->no_ips = no_ips;
+	soc->ips_off = image.size;
+	memcpy(buf_reserve(&image, no_ips * sizeof *ips), ips, no_ips * sizeof *ips);
+	free(ips);
+	sf->off = soc_off;
+	return 0;
+}
+
+static int file_sort(const void *a, const void *b)
+{
+	const struct srcfile *A = a, *B = b;
+	int r = strcmp(A->relpath + A->basename, B->relpath + B->basename);
+	if (!r)
+		r = strcmp(A->relpath, B->relpath);
+	return r;
+}
+
+int main(int argc, char **argv)
+{
+	struct umr_db_image_header *hdr;
+	struct umr_db_image_file *df;
+	uint64_t files_off, image_size;
+	uint32_t x, y;
+	FILE *f;
+	int r;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage:\n"
+"\tTo compile a database tree into a binary image:\n\t\t%s database_dir output_file\n\n"
+"\tThe image is typically installed as '" UMR_DB_IMAGE_NAME "' in the root of the database tree.\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	scan_dir(argv[1], "");
+	if (!no_files) {
+		fprintf(stderr, "[ERROR]: No database files found in '%s'\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	qsort(files, no_files, sizeof files[0], file_sort);
+
+	buf_reserve(&image, sizeof *hdr);
+	for (x = y = 0; x < no_files; x++) {
+		f = fopen(files[x].path, "r");
+		if (!f) {
+			fprintf(stderr, "[ERROR]: Could not open file '%s'\n", files[x].path);
+			return EXIT_FAILURE;
+		}
+		image_size = image.size;
+		switch (files[x].type) {
+			case UMR_DB_IMAGE_REG: r = compile_reg(&files[x], f); break;
+			case UMR_DB_IMAGE_ASIC: r = compile_asic(&files[x], f); break;
+			case UMR_DB_IMAGE_SOC15: r = compile_soc15(&files[x], f); break;
+			default: r = -1; break;
+		}
+		fclose(f);
+		if (r) {
+			// leave it out of the image so umr parses (and reports on) the text file
+			fprintf(stderr, "[WARNING]: Skipping '%s'\n", files[x].path);
+			image.size = image_size;
+			continue;
+		}
+		files[x].ostrbase = add_string(files[x].relpath + files[x].basename);
+		files[x].ostrrel = add_string(files[x].relpath);
+		files[y++] = files[x];
+	}
+	no_files = y;
+
+	files_off = image.size;
+	df = buf_reserve(&image, no_files * sizeof *df);
+	for (x = 0; x < no_files; x++) {
+		df[x].basename = files[x].ostrbase;
+		df[x].relpath = files[x].ostrrel;
+		df[x].type = files[x].type;
+		df[x].src_size = files[x].size;
+		df[x].src_mtime = files[x].mtime;
+		df[x].off = files[x].off;
+	}
+
+	hdr = (struct umr_db_image_header *)image.data;
+	memcpy(hdr->magic, UMR_DB_IMAGE_MAGIC, 8);
+	hdr->version = UMR_DB_IMAGE_VERSION;
+	hdr->endian = UMR_DB_IMAGE_ENDIAN;
+	hdr->no_files = no_files;
+	hdr->files_off = files_off;
+	hdr->strings_off = image.size;
+	hdr->strings_size = strings.size;
+	hdr->image_size = image.size + strings.size;
+
+	f = fopen(argv[2], "wb");
+	if (!f) {
+		fprintf(stderr, "[ERROR]: Could not open file '%s' for writing\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	if (fwrite(image.data, 1, image.size, f) != image.size ||
+	    fwrite(strings.data, 1, strings.size, f) != strings.size) {
+		fprintf(stderr, "[ERROR]: Could not write image '%s'\n", argv[2]);
+		fclose(f);
+		return EXIT_FAILURE;
+	}
+	fclose(f);
+	fprintf(stderr, "Wrote %"PRIu32" files (%"PRIu64" bytes) to '%s'\n", no_files, hdr->image_size, argv[2]);
+	return 0;
+}
@@ -202,7 +202,7 @@ static char * _read_file(const char *path, char **buffer, unsigned *buffer_size)
 
 static const char *uint64_to_str(uint64_t m)
 {
-	static char tmp[128];
+	static __thread char tmp[128];
 	sprintf(tmp, "%0lx", m);
 	return tmp;
 }
@@ -217,8 +217,8 @@ static uint64_t str_to_uint64(const char *s)
 }
 
 static char *read_file(const char *format, ...) {
-	static char *buffer = NULL;
-	static unsigned buffer_size = 0;
+	static __thread char *buffer = NULL;
+	static __thread unsigned buffer_size = 0;
 	char path[PATH_MAX];
 	va_list args;
 	va_start (args, format);
@@ -766,7 +766,7 @@ void parse_sysfs_clock_file(char *content, int *min, int *max) {
 }
 
 static const char * lookup_field(const char **in, const char *field, char separator) {
-	static char value[2048];
+	static __thread char value[2048];
 	const char *input = *in;
 	input = strstr(input, field);
 	if (!input)
@@ -2075,6 +2075,7 @@ void init_asics(void) {
 
 		/* Assign linux callbacks */
 		asics[i]->ring_func.read_ring_data = umr_read_ring_data;
+		asics[i]->ring_func.read_ring_ptrs = umr_read_ring_ptrs;
 
 		asics[i]->mem_funcs.vm_message = dummy_printf;
 		asics[i]->mem_funcs.gpu_bus_to_cpu_address = umr_vm_dma_to_phys;
@@ -2092,6 +2093,7 @@ void init_asics(void) {
 
 		asics[i]->wave_funcs.get_wave_sq_info = umr_get_wave_sq_info;
 		asics[i]->wave_funcs.get_wave_status = umr_get_wave_status;
+		asics[i]->wave_funcs.thread_context = umr_wave_thread_context;
 
 		/* Default shader options */
 		if (asics[i]->family <= FAMILY_VI) {
@@ -2106,6 +2108,7 @@ void init_asics(void) {
 
 		asics[i]->gpr_read_funcs.read_sgprs = umr_read_sgprs;
 		asics[i]->gpr_read_funcs.read_vgprs = umr_read_vgprs;
+		asics[i]->gpr_read_funcs.read_vgprs_batch = umr_read_vgprs_batch;
 
 		asics[i]->err_msg = printf;
 
@@ -2209,8 +2212,8 @@ void init_asics(void) {
 }
 
 static bool is_thread_alive(struct umr_asic *asic, struct umr_wave_data *wd, int tid) {
-	uint32_t exec_mask = umr_wave_data_get_value(asic, wd,
-		tid < 32 ? "ixSQ_WAVE_EXEC_LO" : "ixSQ_WAVE_EXEC_HI");
+	uint32_t exec_mask = umr_wave_data_get_reg(asic, wd,
+		tid < 32 ? UMR_WAVE_REG_EXEC_LO : UMR_WAVE_REG_EXEC_HI);
 	return exec_mask & (1u << (tid % 32));
 }
 
@@ -2260,13 +2263,13 @@ static JSON_Value *wave_to_json(struct umr_asic *asic, struct umr_wave_data *wd,
 		int sgpr_count = umr_wave_data_num_of_sgprs(asic, wd);
 		JSON_Value *sgpr = json_value_init_array();
 		for (int x = 0; x < sgpr_count; x++)
-			json_array_append_number(json_array(sgpr), wd->sgprs[x]);
+			json_array_append_number(json_array(sgpr), umr_wave_data_sgpr(wd, x));
 		json_object_set_value(json_object(wave), "sgpr", sgpr);
 
 		if (umr_wave_data_get_flag_trap_en(asic, wd) || umr_wave_data_get_flag_priv(asic, wd)) {
 			JSON_Value *extra_sgpr = json_value_init_array();
 			for (int x = 0; x < 16; x++)
-				json_array_append_number(json_array(extra_sgpr), wd->sgprs[0x6C + x]);
+				json_array_append_number(json_array(extra_sgpr), umr_wave_data_sgpr(wd, 0x6C + x));
 			json_object_set_value(json_object(wave), "extra_sgpr", extra_sgpr);
 		}
 
@@ -2274,12 +2277,12 @@ static JSON_Value *wave_to_json(struct umr_asic *asic, struct umr_wave_data *wd,
 		if (wd->have_vgprs) {
 			unsigned granularity = asic->parameters.vgpr_granularity;
 			int vpgr_count =
-				(umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << granularity;
+				(umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << granularity;
 			JSON_Value *vgpr = json_value_init_array();
 			for (int x = 0; x < vpgr_count; x++) {
 				JSON_Value *v = json_value_init_array();
 				for (int thread = 0; thread < num_threads; thread++) {
-					json_array_append_number(json_array(v), wd->vgprs[thread * 256 + x]);
+					json_array_append_number(json_array(v), umr_wave_data_vgpr(wd, thread, x));
 				}
 				json_array_append_value(json_array(vgpr), v);
 			}
@@ -2895,20 +2898,17 @@ static void waves_to_json(struct umr_asic *asic, JSON_Object *out) {
 		asic, NULL, asic->options.ring_name, 0, &start, &stop, UMR_RING_GUESS);
 
 	/* Get wave data. */
-	wd = umr_scan_wave_data(asic);
+	owd = umr_scan_wave_data(asic);
 
 	JSON_Value *shaders = json_value_init_object();
 	JSON_Value *waves = json_value_init_array();
 
-	while (wd) {
+	umr_for_each_wave(wd, owd) {
 		JSON_Value *wave = wave_to_json(asic, wd, maj, stream, shaders);
 
 		json_array_append_value(json_array(waves), wave);
-
-		owd = wd;
-		wd = wd->next;
-		free(owd);
 	}
+	umr_free_wave_data(owd);
 
 	json_object_set_value(out, "waves", waves);
 	json_object_set_value(out, "shaders", shaders);
@@ -2917,36 +2917,108 @@ static void waves_to_json(struct umr_asic *asic, JSON_Object *out) {
 		umr_packet_free(stream);
 }
 
-/* We need to remember this one so we can close any dmabuf that
- * we created.
+/* The server runs requests from more than one thread.  A request that
+ * targets a device holds that device's lock, so a long running request
+ * only holds up other requests for the same device and accumulate drops
+ * it while it sleeps between samples.  command_lock covers asics[] and
+ * the requests that don't target a device.  The scratch buffers of the
+ * helpers above (read_file() & co.) are per thread.
  */
-static JSON_Value *previous_framebuffers_answer = NULL;
+static pthread_mutex_t command_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t device_state_once = PTHREAD_ONCE_INIT;
 
-JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsigned *raw_data_size)
+static struct device_state {
+	pthread_mutex_t lock;
+
+	// number of requests that currently need GFXOFF disabled
+	int gfxoff_users;
+
+	/* We need to remember this one so we can close any dmabuf that
+	 * we created.
+	 */
+	JSON_Value *previous_framebuffers_answer;
+} device_state[ARRAY_SIZE(asics)];
+
+#if COMMANDS_TEST
+/* called by accumulate between two samples without the device lock so
+ * the tests can hold it there */
+void (*accumulate_step_hook)(void);
+#endif
+
+static void init_device_state(void)
 {
-	JSON_Value *answer = NULL;
-	const char *last_error;
-	const char *command = json_object_get_string(request, "command");
+	for (size_t i = 0; i < ARRAY_SIZE(device_state); i++)
+		pthread_mutex_init(&device_state[i].lock, NULL);
+}
 
-	if (!command) {
-		last_error = "missing command";
-		goto error;
-	}
+static struct device_state *get_device_state(struct umr_asic *asic)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(asics); i++)
+		if (asics[i] == asic)
+			return &device_state[i];
+	return NULL;
+}
 
-	if (asics[0] == NULL) {
-		init_asics();
-	}
+/* Requests that run at the same time on a device share one GFXOFF
+ * disable, it is only enabled again once the last of them is done.
+ * Called with the device lock held.  Both fail for a device that isn't
+ * in asics[].
+ */
+static int device_disable_gfxoff(struct umr_asic *asic)
+{
+	struct device_state *ds = get_device_state(asic);
+	uint32_t value = 0;
 
-	struct umr_asic *asic = NULL;
+	if (!ds)
+		return -1;
+	if (ds->gfxoff_users++ == 0 && asic->fd.gfxoff >= 0)
+		write(asic->fd.gfxoff, &value, sizeof(value));
+	return 0;
+}
+
+static int device_enable_gfxoff(struct umr_asic *asic)
+{
+	struct device_state *ds = get_device_state(asic);
+	uint32_t value = 1;
+
+	if (!ds || ds->gfxoff_users == 0)
+		return -1;
+	if (--ds->gfxoff_users == 0 && asic->fd.gfxoff >= 0)
+		write(asic->fd.gfxoff, &value, sizeof(value));
+	return 0;
+}
+
+static struct umr_asic *find_request_asic(JSON_Object *request)
+{
 	JSON_Object *asc = json_object_get_object(request, "asic");
+
 	if (asc) {
 		unsigned did = json_object_get_number(asc, "did");
 		int instance = json_object_get_number(asc, "instance");
-		for (int i = 0; !asic; i++) {
+		for (size_t i = 0; i < ARRAY_SIZE(asics); i++) {
 			if (asics[i] && asics[i]->did == did && asics[i]->instance == instance)
-				asic = asics[i];
+				return asics[i];
 		}
 	}
+	return NULL;
+}
+
+static JSON_Value *process_json_request(JSON_Object *request, struct umr_asic *asic, void **raw_data, unsigned *raw_data_size)
+{
+	JSON_Value *answer = NULL;
+	const char *last_error;
+	const char *command = json_object_get_string(request, "command");
+
+	if (!command) {
+		last_error = "missing command";
+		goto error;
+	}
+
+	// mappings and shaders may have changed since the last request
+	if (asic) {
+		umr_vm_cache_invalidate(asic);
+		umr_shader_cache_invalidate(asic);
+	}
 
 	const char *asicless_commands[] = {
 		"enumerate", "ping", "tracing", "read-trace-buffer"
@@ -3062,18 +3134,36 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 			unsigned value = umr_read_reg_by_name_by_ip(asic, (char*) json_object_get_string(request, "block"), r->regname);
 			json_object_set_number(json_object(answer), "value", value);
 		} else {
-			JSON_Value *values = json_value_init_array();
-			for (unsigned i = 0; i < count; i++) {
-				unsigned v = umr_read_reg_by_name_by_ip(asic, (char*) json_object_get_string(request, "block"), r->regname);
-				json_array_append_number(json_array(values), v);
+			// sample the register 'count' times in a single batch
+			uint64_t scale = r->type == REG_MMIO ? 4 : 1;
+			struct umr_reg_batch *rb = calloc(count, sizeof *rb);
+			if (!rb) {
+				last_error = "out of memory";
+				goto error;
 			}
+			for (unsigned i = 0; i < count; i++)
+				umr_reg_batch_entry(asic, &rb[i], r->addr * scale, r->type);
+			umr_read_reg_batch(asic, rb, count);
+
+			JSON_Value *values = json_value_init_array();
+			for (unsigned i = 0; i < count; i++)
+				json_array_append_number(json_array(values), rb[i].value);
 			json_object_set_value(json_object(answer), "value", values);
+			free(rb);
 		}
 	} else if (strcmp(command, "accumulate") == 0) {
 		JSON_Array *regs = json_object_get_array(request, "registers");
 		const int num_reg = json_array_get_count(regs);
 		char *ipname = (char*) json_object_get_string(request, "block");
+		if (num_reg <= 0) {
+			last_error = "no registers to accumulate";
+			goto error;
+		}
 		struct umr_reg **reg = malloc(num_reg * sizeof(struct umr_reg*));
+		if (!reg) {
+			last_error = "out of memory";
+			goto error;
+		}
 		for (int i = 0; i < num_reg; i++) {
 			reg[i] = umr_find_reg_data_by_ip(asic, ipname, json_array_get_string(regs, i));
 			if (!reg[i]) {
@@ -3083,33 +3173,47 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 			}
 		}
 
-		answer = json_value_init_object();
-		int step_ms = json_object_get_number(request, "step_ms");
-		int period_ms = json_object_get_number(request, "period");
+		struct umr_reg_batch *rb = calloc(num_reg, sizeof *rb);
 		unsigned *counters = calloc(32 * num_reg, sizeof(unsigned));
+		if (!rb || !counters) {
+			free(counters);
+			free(rb);
+			free(reg);
+			last_error = "out of memory";
+			goto error;
+		}
+		for (int i = 0; i < num_reg; i++)
+			umr_reg_batch_entry(asic, &rb[i], reg[i]->addr * (reg[i]->type == REG_MMIO ? 4 : 1), reg[i]->type);
 
-		/* Disable GFXOFF */
-		if (asic->fd.gfxoff >= 0) {
-			uint32_t value = 0;
-			write(asic->fd.gfxoff, &value, sizeof(value));
+		if (device_disable_gfxoff(asic)) {
+			free(counters);
+			free(rb);
+			free(reg);
+			last_error = "asic not found";
+			goto error;
 		}
 
+		answer = json_value_init_object();
+		int step_ms = json_object_get_number(request, "step_ms");
+		int period_ms = json_object_get_number(request, "period");
+
 		/* Get our ID. */
 		char *dev_name = read_file(SYSFS_PATH_DEBUG_DRI "%d/name", asic->instance);
+		JSON_Array *pids = NULL;
 		dev_name = strstr(dev_name, "dev=");
-		if (!dev_name)
-			goto error;
-		dev_name += strlen("dev=");
-		int n = 0;
-		while (!isspace(dev_name[n]))
-			n++;
-		dev_name = strndup(dev_name, n);
-
-		JSON_Array *pids = get_active_amdgpu_clients(asic);
+		if (dev_name) {
+			dev_name += strlen("dev=");
+			int n = 0;
+			while (dev_name[n] && !isspace(dev_name[n]))
+				n++;
+			dev_name = strndup(dev_name, n);
+			pids = get_active_amdgpu_clients(asic);
+		}
+		/* else no debugfs, sample the registers without fdinfo */
 
 		/* Read fdinfo for each client. */
 		JSON_Value *start = json_value_init_object();
-		for (size_t i = 0; i < json_array_get_count(pids); i++) {
+		for (size_t i = 0; pids && i < json_array_get_count(pids); i++) {
 			JSON_Object *pid = json_object(json_array_get_value(pids, i));
 			read_fdinfo(start, pid, dev_name);
 		}
@@ -3123,35 +3227,39 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 			req.tv_sec = 0;
 			req.tv_nsec = step_ms * 1000000;
 
+			umr_read_reg_batch(asic, rb, num_reg);
 			for (int j = 0; j < num_reg; j++) {
-				uint64_t value = (uint64_t)asic->reg_funcs.read_reg(asic,
-																	reg[j]->addr * (reg[j]->type == REG_MMIO ? 4 : 1),
-																	reg[j]->type);
+				uint64_t value = rb[j].value;
 				for (int k = 0; k < reg[j]->no_bits; k++) {
 					uint64_t v = umr_bitslice_reg_quiet(asic, reg[j], reg[j]->bits[k].regname, value);
 					counters[32 * j + k] += (unsigned)v;
 				}
 			}
 
+			/* let other requests for this device in between samples */
+			pthread_mutex_unlock(&get_device_state(asic)->lock);
+#if COMMANDS_TEST
+			if (accumulate_step_hook)
+				accumulate_step_hook();
+#endif
 			while (nanosleep(&req, &rem) == EINTR) {
 				req = rem;
 			}
+			pthread_mutex_lock(&get_device_state(asic)->lock);
 		}
 
 		/* Read fdinfo for each client. */
 		JSON_Value *end = json_value_init_object();
-		for (size_t i = 0; i < json_array_get_count(pids); i++) {
+		for (size_t i = 0; pids && i < json_array_get_count(pids); i++) {
 			JSON_Object *pid = json_object(json_array_get_value(pids, i));
 			read_fdinfo(end, pid, dev_name);
 		}
 
+		if (pids)
+			json_value_free(json_array_get_wrapping_value(pids));
 		free(dev_name);
 
-		/* Re-enable GFXOFF */
-		if (asic->fd.gfxoff >= 0) {
-			uint32_t value = 1;
-			write(asic->fd.gfxoff, &value, sizeof(value));
-		}
+		device_enable_gfxoff(asic);
 
 		JSON_Value *fences = compare_fence_infos(
 			content_before,
@@ -3175,8 +3283,8 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 		json_object_set_value(json_object(answer), "fdinfo", json_object_get_wrapping_value(fdinfo));
 		json_object_set_value(fdinfo, "start", start);
 		json_object_set_value(fdinfo, "end", end);
-		json_value_free(json_array_get_wrapping_value(pids));
 		free(counters);
+		free(rb);
 		free(reg);
 	} else if (strcmp(command, "write") == 0) {
 		struct umr_reg *r = umr_find_reg_data_by_ip(
@@ -3255,9 +3363,9 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 		int disable_gfxoff = json_object_get_boolean(request, "disable_gfxoff");
 		strcpy(asic->options.ring_name, json_object_get_string(request, "ring"));
 
-		if (disable_gfxoff && asic->fd.gfxoff >= 0) {
-			uint32_t value = 0;
-			write(asic->fd.gfxoff, &value, sizeof(value));
+		if (disable_gfxoff && device_disable_gfxoff(asic)) {
+			last_error = "asic not found";
+			goto error;
 		}
 
 		asic->options.skip_gprs = 0;
@@ -3275,10 +3383,8 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 		if (resume_waves)
 			umr_sq_cmd_halt_waves(asic, UMR_SQ_CMD_RESUME, 0);
 
-		if (disable_gfxoff && asic->fd.gfxoff >= 0) {
-			uint32_t value = 1;
-			write(asic->fd.gfxoff, &value, sizeof(value));
-		}
+		if (disable_gfxoff)
+			device_enable_gfxoff(asic);
 
 		if (!ring_is_halted) {
 			last_error = "Failed to halt the ring (or GPU is idle?)";
@@ -3307,9 +3413,11 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 
 		r = umr_singlestep_wave(asic, &wd);
 		if (r == -2) {
+			umr_wave_data_free_gprs(&wd);
 			last_error = "failed to scan wave slot after single-stepping";
 			goto error;
 		} else if (r == -1) {
+			umr_wave_data_free_gprs(&wd);
 			last_error = "failed to single-step wave";
 			goto error;
 		}
@@ -3322,22 +3430,23 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 			json_object_set_value(json_object(answer), "wave", wave);
 			json_object_set_value(json_object(answer), "shaders", shaders);
 		}
+		umr_wave_data_free_gprs(&wd);
 	} else if (strcmp(command, "resume-waves") == 0) {
 		strcpy(asic->options.ring_name, json_object_get_string(request, "ring"));
 		umr_sq_cmd_halt_waves(asic, UMR_SQ_CMD_RESUME, 0);
 		answer = json_value_init_object();
 	} else if (strcmp(command, "ring") == 0) {
 		char *ring_name = (char*)json_object_get_string(request, "ring");
-		uint32_t wptr, rptr, drv_wptr, ringsize, value, *ring_data;
+		uint32_t wptr, rptr, drv_wptr, ringsize, ptrs[3];
 		int halt_waves = json_object_get_boolean(request, "halt_waves");
 		enum umr_ring_type rt;
 		asic->options.halt_waves = halt_waves;
 		strcpy(asic->options.ring_name, ring_name);
 
-		/* Disable gfxoff */
-		value = 0;
-		if (asic->fd.gfxoff >= 0)
-			write(asic->fd.gfxoff, &value, sizeof(value));
+		if (device_disable_gfxoff(asic)) {
+			last_error = "asic not found";
+			goto error;
+		}
 
 		if (halt_waves)
 			umr_sq_cmd_halt_waves(asic, UMR_SQ_CMD_HALT, 100);
@@ -3357,17 +3466,19 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 		const char *fence_info = read_file(SYSFS_PATH_DEBUG_DRI "%d/amdgpu_fence_info", asic->instance);
 		JSON_Array *signaled_fences = get_rings_last_signaled_fences(fence_info, ring_name);
 
-		ring_data = umr_read_ring_data(asic, ring_name, &ringsize);
 		/* read pointers */
+		if (umr_read_ring_ptrs(asic, ring_name, ptrs, &ringsize))
+			ringsize = 0;
 		ringsize /= 4;
-		rptr = ring_data[0] % ringsize;
-		wptr = ring_data[1] % ringsize;
-		drv_wptr = ring_data[2] % ringsize;
+		rptr = ringsize ? ptrs[0] % ringsize : 0;
+		wptr = ringsize ? ptrs[1] % ringsize : 0;
+		drv_wptr = ringsize ? ptrs[2] % ringsize : 0;
 
-		int start = 0, stop = ringsize;
+		/* only the words that get decoded are read from the ring */
+		uint32_t start = 0, count = ringsize;
 		if (json_object_get_boolean(request, "rptr_wptr")) {
 			start = rptr;
-			stop = wptr;
+			count = ringsize ? (wptr + ringsize - rptr) % ringsize : 0;
 		}
 
 		if (!memcmp(ring_name, "sdma", 4) ||
@@ -3397,13 +3508,12 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 		ui.unhandled = ring_unhandled;
 		ui.unhandled_size = NULL;
 		ui.done = ring_done;
+		ui.reused_ib = NULL;
 
-		uint32_t *lineardata = calloc(ringsize, sizeof(uint32_t));
+		uint32_t *lineardata = calloc(count ? count : 1, sizeof(uint32_t));
 		unsigned lineardatasize = 0;
-		while (start != stop && lineardatasize < ringsize) {
-			lineardata[lineardatasize++] = ring_data[3 + start];
-			start = (start + 1) % ringsize;
-		}
+		if (count && lineardata && !umr_read_ring_words(asic, ring_name, start, count, lineardata))
+			lineardatasize = count;
 
 		struct umr_packet_stream *str = NULL;
 
@@ -3430,7 +3540,6 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 
 		free(data.raw_opcodes);
 
-		free(ring_data);
 		json_object_set_number(json_object(answer), "read_ptr", rptr);
 		json_object_set_number(json_object(answer), "write_ptr", wptr);
 		json_object_set_number(json_object(answer), "driver_write_ptr", drv_wptr);
@@ -3439,10 +3548,7 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 
 		if (halt_waves)
 			umr_sq_cmd_halt_waves(asic, UMR_SQ_CMD_RESUME, 0);
-		/* Reenable gfxoff */
-		value = 1;
-		if (asic->fd.gfxoff >= 0)
-			write(asic->fd.gfxoff, &value, sizeof(value));
+		device_enable_gfxoff(asic);
 
 	} else if (strcmp(command, "power") == 0) {
 		const char *profiles[] = {
@@ -3817,8 +3923,9 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 			pthread_mutex_unlock(&__sensor_data->mtx);
 		}
 	} else if (!strcmp(command, "gem-info")) {
-		if (previous_framebuffers_answer) {
-			JSON_Array *fbs = json_array(previous_framebuffers_answer);
+		JSON_Value **previous_framebuffers_answer = &get_device_state(asic)->previous_framebuffers_answer;
+		if (*previous_framebuffers_answer) {
+			JSON_Array *fbs = json_array(*previous_framebuffers_answer);
 			for (size_t i = 0; i < json_array_get_count(fbs); i++) {
 				JSON_Object *fb = json_object(json_array_get_value(fbs, i));
 				JSON_Object *md = json_object_get_object(fb, "metadata");
@@ -3827,8 +3934,8 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 					close(dmabuf);
 				}
 			}
-			json_value_free(previous_framebuffers_answer);
-			previous_framebuffers_answer = NULL;
+			json_value_free(*previous_framebuffers_answer);
+			*previous_framebuffers_answer = NULL;
 		}
 
 		struct pid_exported *pids_mapping = NULL;
@@ -3885,7 +3992,7 @@ JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsi
 
 		char *content = read_file(SYSFS_PATH_DEBUG_DRI "%d/framebuffer", asic->instance);
 		JSON_Array *framebuffers = parse_kms_framebuffer_sysfs_file(asic, content);
-		previous_framebuffers_answer = json_value_deep_copy(json_array_get_wrapping_value(framebuffers));
+		*previous_framebuffers_answer = json_value_deep_copy(json_array_get_wrapping_value(framebuffers));
 		json_object_set_value(json_object(answer), "framebuffers", json_array_get_wrapping_value(framebuffers));
 	#if CAN_IMPORT_BO
 	} else if (!strcmp(command, "peak-bo")) {
@@ -3932,3 +4039,31 @@ error:
 	json_object_set_boolean(json_object(answer), "has_raw_data", false);
 	return answer;
 }
+
+JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsigned *raw_data_size)
+{
+	struct device_state *ds = NULL;
+	struct umr_asic *asic;
+	JSON_Value *answer;
+
+	pthread_once(&device_state_once, init_device_state);
+
+	pthread_mutex_lock(&command_lock);
+	if (asics[0] == NULL) {
+		init_asics();
+	}
+	asic = find_request_asic(request);
+	if (asic) {
+		ds = get_device_state(asic);
+		pthread_mutex_unlock(&command_lock);
+		pthread_mutex_lock(&ds->lock);
+	}
+
+	answer = process_json_request(request, asic, raw_data, raw_data_size);
+
+	if (ds)
+		pthread_mutex_unlock(&ds->lock);
+	else
+		pthread_mutex_unlock(&command_lock);
+	return answer;
+}
@@ -131,16 +131,20 @@ retry:
 	asic->reg_funcs.read_reg = umr_read_reg;
 	asic->reg_funcs.write_reg = umr_write_reg;
 	asic->ring_func.read_ring_data = umr_read_ring_data;
+	asic->ring_func.read_ring_ptrs = umr_read_ring_ptrs;
 
 	asic->wave_funcs.get_wave_sq_info = umr_get_wave_sq_info;
 	if (options.no_kernel) {
 		asic->gpr_read_funcs.read_sgprs = umr_read_sgprs_via_mmio;
 		asic->gpr_read_funcs.read_vgprs = umr_read_vgprs_via_mmio;
+		asic->gpr_read_funcs.read_vgprs_batch = NULL;
 		asic->wave_funcs.get_wave_status = umr_get_wave_status_via_mmio;
 	} else {
 		asic->gpr_read_funcs.read_sgprs = umr_read_sgprs;
 		asic->gpr_read_funcs.read_vgprs = umr_read_vgprs;
+		asic->gpr_read_funcs.read_vgprs_batch = umr_read_vgprs_batch;
 		asic->wave_funcs.get_wave_status = umr_get_wave_status;
+		asic->wave_funcs.thread_context = umr_wave_thread_context;
 	}
 
 	asic->shader_disasm_funcs.disasm = umr_shader_disasm;
@@ -160,6 +164,7 @@ retry:
 		asic->options.shader_enable.enable_es_ls_swap = 1;  // on >FAMILY_VI we swap LS/ES for HS/GS
 
 	umr_create_mmio_accel(asic);
+	umr_create_reg_index(asic);
 
 	if (asic->options.vgpr_granularity >= 0)
 		asic->parameters.vgpr_granularity = asic->options.vgpr_granularity;
@@ -257,6 +262,8 @@ static void parse_options(char *str)
 			options.disasm_anyways = 1;
 		} else if (!strcmp(option, "no_fold_vm_decode")) {
 			options.no_fold_vm_decode = 1;
+		} else if (!strcmp(option, "no_vm_cache")) {
+			options.no_vm_cache = 1;
 		} else if (!strcmp(option, "force_asic_file")) {
 			options.force_asic_file = 1;
 		} else if (!strcmp(option, "export_model")) {
@@ -288,7 +295,8 @@ static void do_help(void)
 	"\n\t--option -O <string>[,<string>,...]\n\t\tEnable various flags:"
 		"\n\t\t\tbits, bitsfull, empty_log, follow, no_follow_ib,"
 		"\n\t\t\tuse_pci, use_colour, read_smc, quiet, no_kernel, verbose, halt_waves,"
-		"\n\t\t\tdisasm_early_term, no_disasm, disasm_anyways, wave64, full_shader, skip_gprs, no_fold_vm_decode, force_asic_file\n"
+		"\n\t\t\tdisasm_early_term, no_disasm, disasm_anyways, wave64, full_shader, skip_gprs, no_fold_vm_decode, no_vm_cache,"
+		"\n\t\t\tforce_asic_file\n"
 	"\n\t--gpu, -g <asicname>(@<instance> | =<pcidevice>)"
 		"\n\t\tSelect a gpu by ASIC name and either the instance number or the PCI bus identifier.\n"
 	"\n\t--instance, -i <number>\n\t\tSelect a device instance to investigate. (default: 0)"
@@ -313,6 +321,8 @@ static void do_help(void)
 		"\n\t\tspecifying '0'.  Values above -1 are for ASICs with multiple IP instances.\n"
 	"\n\t--vgpr-granularity, -vgpr <-1, 0...n>"
 		"\n\t\tSpecify the VGPR size granularity as a power of 2, e.g., '2' means 4 DWORDs per increment.\n"
+	"\n\t--wave-threads, -wt <n>"
+		"\n\t\tUse up to <n> threads to read the busy SIMDs when scanning for waves.\n"
 	"\n*** Bank Selection ***\n"
 	"\n\t--bank, -b <se> <sh> <instance>\n\t\tSelect a GRBM se/sh/instance bank in decimal. Can use 'x' to denote broadcast.\n"
 	"\n\t--sbank, -sb <me> <pipe> <queue> [vmid]\n\t\tSelect a SRBM me/pipe/queue bank in decimal.  VMID is optional (default: 0). \n"
@@ -322,10 +332,16 @@ static void do_help(void)
 	"\n\t--enumerate, -e\n\t\tEnumerate all AMDGPU devices detected.\n"
 	"\n\t--list-blocks, -lb\n\t\tList the IP blocks discovered for this device.\n"
 	"\n\t--list-regs, -lr <string>\n\t\tList the registers for a given IP block (can use '-O bits' to list bitfields).\n"
-	"\n\t--dump-discovery-table, -ddt \n\t\tDump device discovery table information.\n"
+	"\n\t--dump-discovery-table, -ddt \n\t\tDump device discovery table information.\n",
+		UMR_BUILD_VER, UMR_BUILD_REV, UMR_BUILD_BRANCH, __DATE__);
+
+	printf(
 	"\n*** Register Access ***\n"
 	"\n\t--lookup, -lu <address_or_regname> <value>\n\t\tLook up bit decoding of an MMIO register by address (with 0x prefix) or by register name."
 		"\n\t\tThe register name string must include the ipname, e.g., uvd6.mmUVD_CONTEXT_ID.\n"
+	"\n\t--lookup-batch, -lub <file>\n\t\tLook up bit decoding of every <address_or_regname> <value> pair in a file"
+		"\n\t\t(one pair per line, '-' reads stdin).  Pairs can be separated by white space, '=', ':'"
+		"\n\t\tor ',' and lines starting with '#' are skipped.\n"
 	"\n\t--write, -w <address> <number>\n\t\tWrite a value in hex to a register specified as a register path in the"
 		"\n\t\tform <asicname.ipname.regname>.  For instance \"tonga.uvd5.mmUVD_SOFT_RESET\"."
 		"\n\t\tCan be used multiple times to set multiple registers.  You can"
@@ -335,8 +351,7 @@ static void do_help(void)
 	"\n\t--read, -r <string>\n\t\tRead a value from a register and print it to stdout.  This command"
 		"\n\t\tuses the same path notation as --write.  It also accepts * for regname."
 		"\n\t\tA trailing * on a regname will read any register that has a name that contains the"
-		"\n\t\tremainder of the name specified.\n",
-		UMR_BUILD_VER, UMR_BUILD_REV, UMR_BUILD_BRANCH, __DATE__);
+		"\n\t\tremainder of the name specified.\n");
 
 	printf(
 	"\n\t--logscan, -ls\n\t\tRead and display contents of the MMIO register log (usually specified with"
@@ -344,6 +359,8 @@ static void do_help(void)
 	"\n*** Device Utilization ***\n"
 	"\n\t--top, -t\n\t\tSummarize GPU utilization.  Can select a SE block with --bank.  Can use"
 		"\n\t\toptions 'use_colour' to colourize output and 'use_pci' to improve efficiency.\n"
+	"\n\t--top-log-csv, -tlc <file>\n\t\tConvert a binary log captured by the --top logger to comma separated"
+		"\n\t\tvalues on stdout.\n"
 	"\n\t--waves, -wa [<ring_name> | <vmid>@<addr>.<size>]\n\t\tPrint out information about any active CU waves.  Can use '-O bits'"
 		"\n\t\tto see decoding of various wave fields.  Can use the '-O halt_waves' option"
 		"\n\t\tto halt the SQ while reading registers.  An optional ring name can be specified"
@@ -477,7 +494,6 @@ int main(int argc, char **argv)
 	int pass, i, j, k, l;
 	char *blockname, *str, *str2, asicname[256], ipname[256], regname[256], clockperformance[256];
 	struct timespec req;
-	FILE *f;
 	struct rumr_client_state client_st;
 	char *argflags;
 #if UMR_GUI
@@ -531,17 +547,14 @@ int main(int argc, char **argv)
 		}
 
 		if ((pass - 1) == PASS_OPTIONS) {
-			// sanity check
-			f = umr_database_open(options.database_path, "pci.did", 0);
-			if (!f) {
+			// sanity check (this also loads the DID table for later lookups)
+			if (umr_database_did_lookup(options.database_path, 0, NULL, 0) < 0) {
 				fprintf(stderr, "[ERROR]: Cannot open pci.did which means the database isn't found.\n");
 				fprintf(stderr, "[ERROR]: UMR should either be installed via packaging or 'make install', or\n");
 				fprintf(stderr, "[ERROR]: you should run UMR from the original build tree it was built in.\n");
 				fprintf(stderr, "[ERROR]: Copying a build tree from one host to another may not work if the build tree\n");
 				fprintf(stderr, "[ERROR]: is not in the same path location.\n");
 				return EXIT_FAILURE;
-			} else {
-				fclose(f);
 			}
 		}
 
@@ -557,6 +570,16 @@ int main(int argc, char **argv)
 						fprintf(stderr, "[ERROR]: --vgpr-granularity requires at least one parameter\n");
 						return EXIT_FAILURE;
 					}
+				} else if (!strcmp(argv[i], "--wave-threads") || !strcmp(argv[i], "-wt")) {
+					if (i + 1 < argc) {
+						argflags[i] = 1;
+						argflags[i+1] = 1;
+						options.wave_threads = atoi(argv[i+1]);
+						++i;
+					} else {
+						fprintf(stderr, "[ERROR]: --wave-threads requires one parameter\n");
+						return EXIT_FAILURE;
+					}
 				} else if (!strcmp(argv[i], "--option") || !strcmp(argv[i], "-O")) {
 					if (i + 1 < argc) {
 						argflags[i] = 1;
@@ -639,7 +662,28 @@ int main(int argc, char **argv)
 					do_help();
 				}
 			} else if (pass == PASS_ASIC_MODEL) {
-				if (!strcmp(argv[i], "--script")) {
+				if (!strcmp(argv[i], "--top-log-csv") || !strcmp(argv[i], "-tlc")) {
+					FILE *in;
+					int64_t n;
+					argflags[i] = 1;
+					if (i + 1 < argc) {
+						argflags[i+1] = 1;
+						in = fopen(argv[i+1], "rb");
+						if (!in) {
+							fprintf(stderr, "[ERROR]: Cannot open log file [%s]\n", argv[i+1]);
+							return EXIT_FAILURE;
+						}
+						n = umr_sample_log_to_csv(err_printf, in, stdout);
+						fclose(in);
+						if (n < 0)
+							return EXIT_FAILURE;
+						++i;
+					} else {
+						fprintf(stderr, "[ERROR]: --top-log-csv requires one parameter\n");
+						return EXIT_FAILURE;
+					}
+					goto stopprocessingcommands;
+				} else if (!strcmp(argv[i], "--script")) {
 					int argi, argj;
 					argflags[i] = 1;
 
@@ -849,6 +893,27 @@ int main(int argc, char **argv)
 						asic->options.bitfields = tmp;
 						i += 2;
 					}
+				} else if (!strcmp(argv[i], "--lookup-batch") || !strcmp(argv[i], "-lub")) {
+					if (i + 1 < argc) {
+						int tmp = asic->options.bitfields;
+						FILE *in;
+						argflags[i] = 1;
+						argflags[i+1] = 1;
+						in = strcmp(argv[i+1], "-") ? fopen(argv[i+1], "r") : stdin;
+						if (!in) {
+							fprintf(stderr, "[ERROR]: Cannot open lookup file [%s]\n", argv[i+1]);
+							return EXIT_FAILURE;
+						}
+						asic->options.bitfields = 1;
+						umr_lookup_batch(asic, in);
+						asic->options.bitfields = tmp;
+						if (in != stdin)
+							fclose(in);
+						++i;
+					} else {
+						fprintf(stderr, "[ERROR]: --lookup-batch requires one parameter\n");
+						return EXIT_FAILURE;
+					}
 				} else if (!strcmp(argv[i], "--write") || !strcmp(argv[i], "-w")) {
 					if (i + 2 < argc) {
 						uint32_t reg, val;
@@ -937,6 +1002,7 @@ int main(int argc, char **argv)
 						}
 
 						r = umr_singlestep_wave(asic, &wd);
+						umr_wave_data_free_gprs(&wd);
 						if (r < 0) {
 							fprintf(stderr, "[ERROR]: Failed to single-step wave!\n");
 							return EXIT_FAILURE;
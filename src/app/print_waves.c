@@ -132,10 +132,10 @@ void umr_print_waves(struct umr_asic *asic)
 				fprintf(output, ">SGPRS[%s%u%s..%s%u%s] = { %s%08lx%s, %s%08lx%s, %s%08lx%s, %s%08lx%s }\n",
 					YELLOW, (unsigned)(x), RST,
 					YELLOW, (unsigned)(x + 3), RST,
-					BLUE, (unsigned long)wd->sgprs[x], RST,
-					BLUE, (unsigned long)wd->sgprs[x+1], RST,
-					BLUE, (unsigned long)wd->sgprs[x+2], RST,
-					BLUE, (unsigned long)wd->sgprs[x+3], RST);
+					BLUE, (unsigned long)umr_wave_data_sgpr(wd, x), RST,
+					BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+1), RST,
+					BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+2), RST,
+					BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+3), RST);
 
 			if (umr_wave_data_get_flag_trap_en(asic, wd) || umr_wave_data_get_flag_priv(asic, wd)) {
 				for (y = 0, x = 0x6C; x < (16 + 0x6C); x += 4) {
@@ -143,10 +143,10 @@ void umr_print_waves(struct umr_asic *asic)
 						(x < (0x6C + 4) && gfx_maj <= 8) ? "TBA/TMA" : "TTMP",
 						YELLOW, (unsigned)(y), RST,
 						YELLOW, (unsigned)(y + 3), RST,
-						BLUE, (unsigned long)wd->sgprs[x], RST,
-						BLUE, (unsigned long)wd->sgprs[x+1], RST,
-						BLUE, (unsigned long)wd->sgprs[x+2], RST,
-						BLUE, (unsigned long)wd->sgprs[x+3], RST);
+						BLUE, (unsigned long)umr_wave_data_sgpr(wd, x), RST,
+						BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+1), RST,
+						BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+2), RST,
+						BLUE, (unsigned long)umr_wave_data_sgpr(wd, x+3), RST);
 
 					// restart numbering on SI..VI with TTMP0
 					y += 4;
@@ -158,9 +158,9 @@ void umr_print_waves(struct umr_asic *asic)
 			if (wd->have_vgprs) {
 				unsigned granularity = asic->parameters.vgpr_granularity; // default is blocks of 4 VGPRs
 				uint32_t vgpr_size, exec_lo, exec_hi;
-				vgpr_size = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE");
-				exec_lo = umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_EXEC_LO");
-				exec_hi = umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_EXEC_HI");
+				vgpr_size = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE);
+				exec_lo = umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_EXEC_LO);
+				exec_hi = umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_EXEC_HI);
 				fprintf(output, "\n");
 				for (x = 0; x < ((vgpr_size + 1) << granularity); ++x) {
 					if (x % 16 == 0) {
@@ -180,7 +180,7 @@ void umr_print_waves(struct umr_asic *asic)
 					for (thread = 0; thread < 64; ++thread) {
 						unsigned live = thread < 32 ? (exec_lo & (1u << thread))
 										: (exec_hi & (1u << (thread - 32)));
-						fprintf(output, " %s%08x%s", live ? BLUE : RST, wd->vgprs[thread * 256 + x], RST);
+						fprintf(output, " %s%08x%s", live ? BLUE : RST, umr_wave_data_vgpr(wd, thread, x), RST);
 					}
 					fprintf(output, " }\n");
 				}
@@ -223,12 +223,7 @@ void umr_print_waves(struct umr_asic *asic)
 	if (first)
 		fprintf(output, "No active waves! (or GFXOFF was not disabled)\n");
 
-	wd = owd;
-	while (wd) {
-		owd = wd->next;
-		free(wd);
-		wd = owd;
-	}
+	umr_free_wave_data(owd);
 
 	if (stream)
 		umr_packet_free(stream);
@@ -87,7 +87,7 @@ void umr_profiler(struct umr_asic *asic, int samples, int shader_target)
 	struct umr_profiler_shaders *shaders;
 	struct umr_profiler_text *texts, *otext;
 	struct umr_wave_data *owd, *wd;
-	struct umr_packet_stream *stream;
+	struct umr_ring_cache *ring;
 	struct umr_shaders_pgm *shader;
 	unsigned nitems, nmax, nshaders, x, y, z, found;
 	char *ringname;
@@ -115,10 +115,18 @@ void umr_profiler(struct umr_asic *asic, int samples, int shader_target)
 	ringname = asic->options.ring_name[0] ? asic->options.ring_name : "gfx";
 	gprs = asic->options.skip_gprs;
 
+	// the ring is decoded once and then only what was submitted between samples
+	ring = umr_ring_cache_create(asic, ringname, UMR_RING_GUESS);
+
 	while (samples--) {
-		int start = -1, stop = -1;
+		int have_ring;
 		fprintf(stderr, "%5u samples left\r", samples);
 		fflush(stderr);
+
+		// the page tables and shaders may have changed since the last sample
+		umr_vm_cache_invalidate(asic);
+		umr_shader_cache_invalidate(asic);
+
 		wd = NULL;
 		do {
 			umr_sq_cmd_halt_waves(asic, UMR_SQ_CMD_RESUME, 0);
@@ -138,10 +146,11 @@ void umr_profiler(struct umr_asic *asic, int samples, int shader_target)
 		// processor is also halted so we can grab the
 		// stream.  This isn't 100% though it seems so race
 		// conditions might occur.
-		stream = umr_packet_decode_ring(asic, NULL, ringname, 0, &start, &stop, UMR_RING_GUESS);
+		have_ring = ring && !umr_ring_cache_update(ring);
 
 		// loop through data ...
 		sample_hit = 0;
+		owd = wd;
 		while (wd) {
 			uint32_t w_vmid;
 			uint64_t w_pc;
@@ -152,8 +161,8 @@ void umr_profiler(struct umr_asic *asic, int samples, int shader_target)
 
 			// try to find shader in PM4 stream
 			shader = NULL;
-			if (stream)
-				shader = umr_packet_find_shader(stream, phit[nitems].vmid, phit[nitems].pc);
+			if (have_ring)
+				shader = umr_ring_cache_find_shader(ring, phit[nitems].vmid, phit[nitems].pc);
 			if (shader) {
 				struct umr_profiler_text *shader_text;
 
@@ -228,17 +237,14 @@ void umr_profiler(struct umr_asic *asic, int samples, int shader_target)
 
 			sample_hit = 1;
 throw_back:
-			owd = wd->next;
-			free(wd);
-			wd = owd;
+			wd = wd->next;
 		}
+		umr_free_wave_data(owd);
 
 		if (!sample_hit)
 			++samples;
-
-		if (stream)
-			umr_packet_free(stream);
 	}
+	umr_ring_cache_free(ring);
 
 	// we're done scanning so resume the waves
 	// at this point the jobs could in theory be terminated
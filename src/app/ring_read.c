@@ -167,11 +167,7 @@ void umr_read_ring(struct umr_asic *asic, char *ringpath)
 		pdecoder = ppdecoder;
 	}
 
-	while (wd) {
-		struct umr_wave_data *pwd = wd->next;
-		free(wd);
-		wd = pwd;
-	}
+	umr_free_wave_data(wd);
 
 end:
 	if (asic->options.halt_waves)
@@ -25,12 +25,19 @@
 #include "umrapp.h"
 #include <regex.h>
 
+struct scan_hit {
+	struct umr_ip_block *ip;
+	struct umr_reg *reg;
+	int slot;	// index of the low DWORD in the read batch
+};
+
 int umr_scan_asic(struct umr_asic *asic, char *asicname, char *ipname, char *regname)
 {
-	int r, i, j, k, count = 0, noipreg = 1;
+	int r, i, j, k, count = 0, noipreg = 1, no_hits = 0, max_hits = 0, no_rb = 0;
 	uint64_t scale;
 	char regname_copy[256], ipname_esc[256];
-	uint32_t v32;
+	struct scan_hit *hits = NULL;
+	struct umr_reg_batch *rb = NULL;
 
 	regex_t ip_regex, reg_regex;
 
@@ -62,7 +69,7 @@ int umr_scan_asic(struct umr_asic *asic, char *asicname, char *ipname, char *reg
 		regname_copy[strlen(regname_copy)-1] = 0;
 	}
 
-	/* scan them all in order */
+	/* collect them all in order and read them in one batch */
 	if (!asicname[0] || !strcmp(asicname, "*") || !strcmp(asicname, asic->asicname)) {
 		for (i = 0; i < asic->no_blocks; i++) {
 			if (!ipname[0] || ipname[0] == '*' || !regexec(&ip_regex, asic->blocks[i]->ipname, 0, NULL, 0)) {
@@ -82,33 +89,64 @@ int umr_scan_asic(struct umr_asic *asic, char *asicname, char *ipname, char *reg
 									continue;
 								}
 								break;
-							default: return -1;
+							default: r = -1; goto error;
 						}
 
-						v32 = asic->reg_funcs.read_reg(asic, asic->blocks[i]->regs[j].addr*scale, asic->blocks[i]->regs[j].type);
-						asic->blocks[i]->regs[j].value = v32;
-						if (asic->blocks[i]->regs[j].bit64) {
-							v32 = asic->reg_funcs.read_reg(asic, (asic->blocks[i]->regs[j].addr+1)*scale, asic->blocks[i]->regs[j].type);
-							asic->blocks[i]->regs[j].value |= (uint64_t)v32 << 32;
-						}
+						if (no_hits == max_hits) {
+							struct scan_hit *nhits;
+							struct umr_reg_batch *nrb;
 
-						if (regname[0]) {
-							printf("%s%s.%s%s => ", CYAN, asic->blocks[i]->ipname,  asic->blocks[i]->regs[j].regname, RST);
-							printf("%s0x%08lx%s\n", YELLOW, (unsigned long)asic->blocks[i]->regs[j].value, RST);
-							if (asic->options.bitfields)
-								for (k = 0; k < asic->blocks[i]->regs[j].no_bits; k++) {
-									uint32_t v;
-									v = (1UL << (asic->blocks[i]->regs[j].bits[k].stop + 1 - asic->blocks[i]->regs[j].bits[k].start)) - 1;
-									v &= (asic->blocks[i]->regs[j].value >> asic->blocks[i]->regs[j].bits[k].start);
-									asic->blocks[i]->regs[j].bits[k].bitfield_print(asic, asic->asicname, asic->blocks[i]->ipname, asic->blocks[i]->regs[j].regname, asic->blocks[i]->regs[j].bits[k].regname, asic->blocks[i]->regs[j].bits[k].start, asic->blocks[i]->regs[j].bits[k].stop, v);
-								}
+							// keep the old buffers on failure so the error path frees them
+							max_hits = max_hits ? max_hits * 2 : 256;
+							nhits = realloc(hits, max_hits * sizeof *hits);
+							if (nhits)
+								hits = nhits;
+							nrb = realloc(rb, 2 * max_hits * sizeof *rb);
+							if (nrb)
+								rb = nrb;
+							if (!nhits || !nrb) {
+								fprintf(stderr, "[ERROR]: Out of memory\n");
+								r = -1;
+								goto error;
+							}
 						}
+						hits[no_hits].ip = asic->blocks[i];
+						hits[no_hits].reg = &asic->blocks[i]->regs[j];
+						hits[no_hits++].slot = no_rb;
+						umr_reg_batch_entry(asic, &rb[no_rb++], asic->blocks[i]->regs[j].addr*scale, asic->blocks[i]->regs[j].type);
+						if (asic->blocks[i]->regs[j].bit64)
+							umr_reg_batch_entry(asic, &rb[no_rb++], (asic->blocks[i]->regs[j].addr+1)*scale, asic->blocks[i]->regs[j].type);
 					}
 				}
 			}
 		}
 	}
 
+	if (umr_read_reg_batch(asic, rb, no_rb)) {
+		r = -1;
+		goto error;
+	}
+
+	for (i = 0; i < no_hits; i++) {
+		struct umr_reg *reg = hits[i].reg;
+
+		reg->value = rb[hits[i].slot].value;
+		if (reg->bit64)
+			reg->value |= (uint64_t)rb[hits[i].slot + 1].value << 32;
+
+		if (regname[0]) {
+			printf("%s%s.%s%s => ", CYAN, hits[i].ip->ipname, reg->regname, RST);
+			printf("%s0x%08lx%s\n", YELLOW, (unsigned long)reg->value, RST);
+			if (asic->options.bitfields)
+				for (k = 0; k < reg->no_bits; k++) {
+					uint32_t v;
+					v = (1UL << (reg->bits[k].stop + 1 - reg->bits[k].start)) - 1;
+					v &= (reg->value >> reg->bits[k].start);
+					reg->bits[k].bitfield_print(asic, asic->asicname, hits[i].ip->ipname, reg->regname, reg->bits[k].regname, reg->bits[k].start, reg->bits[k].stop, v);
+				}
+		}
+	}
+
 	if (count == 0) {
 		if (!memcmp(regname_copy, "reg", 3)) {
 			fprintf(stderr, "[ERROR]: Path <%s.%s.%s> not found on this ASIC\n", asicname, ipname, regname);
@@ -127,6 +165,8 @@ int umr_scan_asic(struct umr_asic *asic, char *asicname, char *ipname, char *reg
 
 	r = 0;
 error:
+	free(hits);
+	free(rb);
 	if (!noipreg)
 		regfree(&ip_regex);
 	regfree(&reg_regex);
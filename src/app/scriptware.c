@@ -34,6 +34,7 @@ static void helptext(umr_err_output errout)
     errout("\tinstances\n\t\tList all AMDGPU instances in space delimited format\n\n");
     errout("\tpci-instances <did>\n\t\tList all AMDGPU instances matching a given PCI DID in space delimited format\n\n");
     errout("\tpci-did <instance>\n\t\tOutput the PCI device ID (did) of the AMDGPU device with a given instance\n\n");
+    errout("\tpci-name <did>\n\t\tOutput the ASIC name the database maps a PCI device ID (did) to\n\n");
     errout("\tpci-bus <instance>\n\t\tOutput the PCI device bus address of the AMDGPU device with a given instance\n\n");
     errout("\tpci-bus-to-instance <busno>\n\t\tOutput the DRI instance matching a PCI device bus address\n\n");
     errout("\txcds <instance>\n\t\tList all GC partitions for a given device\n\n");
@@ -89,6 +90,21 @@ void umr_handle_scriptware(umr_err_output errout, char *database_path, char **ar
             } else {
                 errout("[ERROR]: 'pci-did' --script command requires one parameter.\n");
             }
+        } else if (!strcmp(argv[x], "pci-name")) {
+            if (x + 1 < argc) {
+                uint32_t did;
+                char name[128];
+                sscanf(argv[x+1], "%"SCNx32, &did);
+                if (umr_database_did_lookup(database_path, did, name, sizeof name) == 1) {
+                    if (strstr(name, ".asic"))
+                        *strstr(name, ".asic") = 0;
+                    errout("%s", name);
+                }
+                errout("\n");
+                ++x;
+            } else {
+                errout("[ERROR]: 'pci-name' --script command requires one parameter.\n");
+            }
         } else if (!strcmp(argv[x], "pci-bus-to-instance")) {
             if (x + 1 < argc) {
                 int y;
@@ -23,6 +23,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
 #include <nanomsg/nn.h>
 #include <nanomsg/reqrep.h>
 #include "parson.h"
@@ -31,9 +34,128 @@ extern JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_dat
 extern void init_asics(void);
 extern struct umr_asic *asics[16];
 
+/* Requests are received on a raw REP socket.  The control header nanomsg
+ * hands us with every message carries the REQ request ID, sending it back
+ * with the reply routes the reply to the request it answers so they can be
+ * completed out of order.  Commands that can run for a long time are queued
+ * to a pool of worker threads, everything else is answered right away.
+ */
+#define SERVER_WORKERS 2
+
+static const char *long_running_commands[] = {
+	"accumulate", "waves", "ring",
+};
+
+struct server_job {
+	JSON_Value *request;
+	void *control;
+	struct server_job *next;
+};
+
+static struct {
+	int sock, done;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct server_job *head, **tail;
+} server;
+
+static int is_long_running(JSON_Value *request)
+{
+	const char *command = json_object_get_string(json_object(request), "command");
+	unsigned i;
+
+	for (i = 0; command && i < sizeof(long_running_commands) / sizeof(long_running_commands[0]); i++)
+		if (!strcmp(command, long_running_commands[i]))
+			return 1;
+	return 0;
+}
+
+static void process_job(struct server_job *job)
+{
+	struct nn_msghdr hdr;
+	struct nn_iovec iov;
+	void *raw_data = NULL;
+	unsigned raw_data_size = 0;
+	JSON_Value *answer = umr_process_json_request(
+		json_object(job->request), &raw_data, &raw_data_size);
+
+	char* s = json_serialize_to_string(answer);
+	size_t len = strlen(s) + 1;
+
+	/* We can only send a single reply because of the nn protocol used,
+	 * so pack everything.
+	 */
+	uint8_t *msg = nn_allocmsg(sizeof(uint32_t) + len + raw_data_size, 0);
+
+	memcpy(msg, &raw_data_size, sizeof(uint32_t));
+	memcpy(&msg[sizeof(uint32_t)], s, len);
+	memcpy(&msg[sizeof(uint32_t) + len], raw_data, raw_data_size);
+
+	iov.iov_base = &msg;
+	iov.iov_len = NN_MSG;
+	memset(&hdr, 0, sizeof hdr);
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	hdr.msg_control = &job->control;
+	hdr.msg_controllen = NN_MSG;
+
+	/* a client that went away is not fatal for the others */
+	if (nn_sendmsg(server.sock, &hdr, 0) < 0) {
+		nn_freemsg(msg);
+		nn_freemsg(job->control);
+	}
+
+	json_free_serialized_string(s);
+	json_value_free(answer); // also frees job->request
+	free(raw_data);
+	free(job);
+}
+
+static void *server_worker(void *arg)
+{
+	struct server_job *job;
+
+	(void)arg;
+	for (;;) {
+		pthread_mutex_lock(&server.lock);
+		while (!server.head && !server.done)
+			pthread_cond_wait(&server.cond, &server.lock);
+		job = server.head;
+		if (job) {
+			server.head = job->next;
+			if (!server.head)
+				server.tail = &server.head;
+		}
+		pthread_mutex_unlock(&server.lock);
+
+		if (!job)
+			return NULL;
+		process_job(job);
+	}
+}
+
+static void queue_job(struct server_job *job)
+{
+	pthread_mutex_lock(&server.lock);
+	*server.tail = job;
+	server.tail = &job->next;
+	pthread_cond_signal(&server.cond);
+	pthread_mutex_unlock(&server.lock);
+}
+
+/**
+ * run_server_loop - Serve JSON requests from the GUI
+ * @url: nanomsg endpoint to bind to
+ * @asic: ASIC to serve, or NULL to serve every ASIC found
+ *
+ * Returns once nn_term() is called, exits on any other socket error.
+ */
 void run_server_loop(const char *url, struct umr_asic * asic)
 {
-	int sock = nn_socket(AF_SP, NN_REP);
+	pthread_t workers[SERVER_WORKERS];
+	int nworkers, x;
+
+	int sock = nn_socket(AF_SP_RAW, NN_REP);
 	if (sock < 0) {
 		exit(1);
 	}
@@ -54,47 +176,78 @@ void run_server_loop(const char *url, struct umr_asic * asic)
 		init_asics();
 	}
 
+	server.sock = sock;
+	server.done = 0;
+	server.head = NULL;
+	server.tail = &server.head;
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_cond_init(&server.cond, NULL);
+	for (nworkers = 0; nworkers < SERVER_WORKERS; nworkers++)
+		if (pthread_create(&workers[nworkers], NULL, server_worker, NULL))
+			break;
+
 	/* Everything is ready. Wait for commands */
 
 	printf("Waiting for commands.\n");
 	for (;;) {
+		struct nn_msghdr hdr;
+		struct nn_iovec iov;
+		struct server_job *job;
 		char* buf;
-		int len = nn_recv(sock, &buf, NN_MSG, 0);
-		if (len < 0)
+		void *control;
+
+		iov.iov_base = &buf;
+		iov.iov_len = NN_MSG;
+		memset(&hdr, 0, sizeof hdr);
+		hdr.msg_iov = &iov;
+		hdr.msg_iovlen = 1;
+		hdr.msg_control = &control;
+		hdr.msg_controllen = NN_MSG;
+
+		int len = nn_recvmsg(sock, &hdr, 0);
+		if (len < 0) {
+			if (nn_errno() == ETERM)
+				break;
 			exit(0);
-		else if (len == 0)
+		} else if (len == 0) {
+			nn_freemsg(buf);
+			nn_freemsg(control);
 			continue;
+		}
 
 		buf[len - 1] = '\0';
 		JSON_Value *request = json_parse_string(buf);
+		nn_freemsg(buf);
 
 		if (request == NULL) {
 			printf("ERROR\n");
-		} else {
-			void *raw_data = NULL;
-			unsigned raw_data_size = 0;
-			JSON_Value *answer = umr_process_json_request(
-				json_object(request), &raw_data, &raw_data_size);
-
-			char* s = json_serialize_to_string(answer);
-			size_t len = strlen(s) + 1;
-
-			/* We can only send a single reply because of the nn protocol used,
-			 * so pack everything.
-			 */
-			uint8_t *msg = nn_allocmsg(sizeof(uint32_t) + len + raw_data_size, 0);
-
-			memcpy(msg, &raw_data_size, sizeof(uint32_t));
-			memcpy(&msg[sizeof(uint32_t)], s, len);
-			memcpy(&msg[sizeof(uint32_t) + len], raw_data, raw_data_size);
-
-			if (nn_send(sock, &msg, NN_MSG, 0) < 0)
-				exit(0);
-
-			json_free_serialized_string(s);
-			json_value_free(answer);
-			free(raw_data);
+			nn_freemsg(control);
+			continue;
 		}
-		nn_freemsg(buf);
+
+		job = calloc(1, sizeof *job);
+		if (!job) {
+			json_value_free(request);
+			nn_freemsg(control);
+			continue;
+		}
+		job->request = request;
+		job->control = control;
+
+		if (nworkers && is_long_running(request))
+			queue_job(job);
+		else
+			process_job(job);
 	}
+
+	/* drain the queue and stop the workers */
+	pthread_mutex_lock(&server.lock);
+	server.done = 1;
+	pthread_cond_broadcast(&server.cond);
+	pthread_mutex_unlock(&server.lock);
+	for (x = 0; x < nworkers; x++)
+		pthread_join(workers[x], NULL);
+	nn_close(sock);
+	pthread_cond_destroy(&server.cond);
+	pthread_mutex_destroy(&server.lock);
 }
@@ -330,7 +330,8 @@ static struct umr_bitfield stat_drm_bits[] = {
 	{ NULL, 0, 0, NULL },
 };
 
-static FILE *logfile = NULL;
+static struct umr_sample_log *logfile = NULL;
+static uint32_t log_nfields;
 
 static uint64_t visible_vram_size = 0;
 
@@ -413,7 +414,7 @@ static void slice(char *r, char *s)
 
 
 static int maxstrlen = 0;
-static int grab_bits(char *name, struct umr_asic *asic, struct umr_bitfield *bits, uint32_t *addr)
+static int grab_bits(char *name, struct umr_asic *asic, struct umr_bitfield *bits, struct umr_bitslice *slices, uint32_t *addr)
 {
 	int i, j, k, l;
 
@@ -433,8 +434,9 @@ out:
 		for (k = 0; bits[k].regname; k++) {
 			for (l = 0; l < asic->blocks[i]->regs[j].no_bits; l++) {
 				if (!strcmp(bits[k].regname, asic->blocks[i]->regs[j].bits[l].regname)) {
-					// copy
+					// copy and resolve it once for parse_bits()
 					bits[k] = asic->blocks[i]->regs[j].bits[l];
+					umr_bitslice_resolve(asic, &asic->blocks[i]->regs[j], bits[k].regname, &slices[k]);
 					break;
 				}
 			}
@@ -611,31 +613,19 @@ static void print_iov(uint64_t *counts)
 	}
 }
 
-static void parse_bits(struct umr_asic *asic, uint32_t addr, struct umr_bitfield *bits, uint64_t *counts, uint32_t *mask, uint32_t *cmp, uint64_t addr_mask)
+static void parse_bits(uint32_t addr, uint32_t value, struct umr_bitfield *bits, struct umr_bitslice *slices, uint64_t *counts, uint32_t *mask, uint32_t *cmp)
 {
+	uint64_t v;
 	int j;
-	uint32_t value;
 
 	if (addr) {
-		if (addr_mask && asic->fd.mmio < 0) {
-			value = 0;
-		} else if (!addr_mask && asic->pci.mem) {
-			value = asic->pci.mem[addr>>2];
-		} else {
-			if (addr_mask & REG_USE_PG_LOCK)
-				asic->options.pg_lock = 1;
-
-			value = asic->reg_funcs.read_reg(asic, addr, REG_MMIO);
-
-			asic->options.pg_lock = 0;
-		}
 		for (j = 0; bits[j].regname; j++)
 			if (bits[j].start != 255) {
+				v = umr_bitslice_extract(&slices[j], value);
 				if (bits[j].start == bits[j].stop) {
-					counts[j] += (value & (1UL<<bits[j].start)) ? (top_options.high_frequency ? 10 : 1) : 0;
+					counts[j] += v ? (top_options.high_frequency ? 10 : 1) : 0;
 				} else {
-					value = (value >> bits[j].start) & ((1UL << (bits[j].stop-bits[j].start)) - 1);
-					counts[j] += ((value & mask[j]) == cmp[j]) ? (top_options.high_frequency ? 10 : 1) : 0;
+					counts[j] += ((v & mask[j]) == cmp[j]) ? (top_options.high_frequency ? 10 : 1) : 0;
 				}
 			}
 	}
@@ -706,27 +696,14 @@ static void parse_drm(struct umr_asic *asic, uint32_t addr, struct umr_bitfield
 	}
 }
 
-static void parse_iov(struct umr_asic *asic, uint32_t addr, struct umr_bitfield *bits, uint64_t *counts, uint32_t *mask, uint32_t *cmp, uint64_t addr_mask)
+static void parse_iov(uint32_t addr, uint32_t value, struct umr_bitfield *bits, uint64_t *counts, uint32_t *mask, uint32_t *cmp)
 {
 	int j;
-	uint32_t value;
 
 	(void)mask;
 	(void)cmp;
 
 	if (addr) {
-		if (addr_mask && asic->fd.mmio < 0) {
-			value = 0;
-		} else if (!addr_mask && asic->pci.mem) {
-			value = asic->pci.mem[addr>>2];
-		} else {
-			if (addr_mask & REG_USE_PG_LOCK)
-				asic->options.pg_lock = 1;
-
-			value = asic->reg_funcs.read_reg(asic, addr, REG_MMIO);
-
-			asic->options.pg_lock = 0;
-		}
 		for (j = 0; bits[j].regname; j++)
 			if (bits[j].start != 255) {
 				if (bits[j].stop == IOV_VF) {
@@ -891,8 +868,76 @@ static struct {
 		uint32_t addr, mask[32], cmp[32];
 		uint64_t addr_mask;
 		struct umr_bitfield *bits;
+		struct umr_bitslice slices[32];
 } stat_counters[64];
 
+// register counters are read by a sampler thread, slot[j] is where
+// counter j is in each sample (or -1 if it is not read)
+static struct {
+	struct umr_sampler *s;
+	int slot[64];
+	uint32_t rate;
+} sampler;
+
+// build the read plan of every enabled register counter and start sampling it
+static void start_sampler(struct umr_asic *asic)
+{
+	struct umr_reg_batch rb[64];
+	uint32_t n = 0;
+	int j;
+
+	umr_sampler_free(sampler.s);
+	sampler.s = NULL;
+
+	for (j = 0; stat_counters[j].name[0]; j++) {
+		sampler.slot[j] = -1;
+		if (!stat_counters[j].addr ||
+		    (stat_counters[j].is_sensor != 0 && stat_counters[j].is_sensor != 3) ||
+		    (stat_counters[j].addr_mask && asic->fd.mmio < 0))
+			continue;
+
+		// the active VF is needed to filter samples even if it is not displayed
+		if (!(top_options.all || *stat_counters[j].opt) && !(j == 2 && top_options.sriov.num_vf))
+			continue;
+
+		asic->options.pg_lock = (stat_counters[j].addr_mask & REG_USE_PG_LOCK) ? 1 : 0;
+		umr_reg_batch_entry(asic, &rb[n], stat_counters[j].addr, REG_MMIO);
+		sampler.slot[j] = n++;
+	}
+	asic->options.pg_lock = 0;
+
+	if (n) {
+		sampler.s = umr_sampler_create(asic, rb, n, sampler.rate, 4096);
+		if (sampler.s && umr_sampler_start(sampler.s)) {
+			umr_sampler_free(sampler.s);
+			sampler.s = NULL;
+		}
+	}
+}
+
+// fold the samples taken so far into the counters
+static void collect_samples(void)
+{
+	uint32_t values[64];
+	int j, s;
+
+	while (sampler.s && umr_sampler_pop(sampler.s, NULL, values)) {
+		if (top_options.sriov.num_vf && top_options.sriov.active_vf >= 0 &&
+		    sampler.slot[2] >= 0 && top_options.sriov.active_vf != (int)(values[sampler.slot[2]] & 0xF))
+			continue;
+
+		for (j = 0; stat_counters[j].name[0]; j++) {
+			s = sampler.slot[j];
+			if (s < 0 || !(top_options.all || *stat_counters[j].opt))
+				continue;
+			if (stat_counters[j].is_sensor == 0)
+				parse_bits(stat_counters[j].addr, values[s], stat_counters[j].bits, stat_counters[j].slices, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp);
+			else if (stat_counters[j].is_sensor == 3)
+				parse_iov(stat_counters[j].addr, values[s], stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp);
+		}
+	}
+}
+
 #define ENTRY(_j, _prefix, _name, _bits, _opt, _tag) do { int _i = (_j); snprintf(stat_counters[_i].name, sizeof(stat_counters[_i].name), "%s%s", _prefix, _name); stat_counters[_i].bits = _bits; stat_counters[_i].opt = _opt; stat_counters[_i].tag = _tag; } while (0)
 #define ENTRY_SENSOR(_j, _name, _bits, _opt, _tag) do { int _i = (_j); strcpy(stat_counters[_i].name, _name); stat_counters[_i].bits = _bits; stat_counters[_i].opt = _opt; stat_counters[_i].tag = _tag; stat_counters[_i].is_sensor = 1; } while (0)
 
@@ -1066,28 +1111,106 @@ static void top_build_vi_program(struct umr_asic *asic)
 
 }
 
-static void toggle_logger(void)
+static const char *field_unit(int i, int j)
+{
+	switch (stat_counters[i].is_sensor) {
+	case 1:
+		switch (stat_counters[i].bits[j].stop >> 4) {
+		case SENSOR_MILLIVOLT: return "mV";
+		case SENSOR_MHZ: return "MHz";
+		case SENSOR_PERCENT: return "%";
+		case SENSOR_TEMP: return "C";
+		case SENSOR_POWER: return "cW";
+		}
+		return "";
+	case 2:
+		return stat_counters[i].bits[j].stop == DRM_INFO_BYTES ? "bytes" : "";
+	default:
+		return "samples";
+	}
+}
+
+// every logged field of the enabled panels in a fixed order, returns how many
+static uint32_t log_fields(char (*names)[96], const char **units, uint64_t *values)
 {
+	uint32_t n = 0;
 	int i, j;
-	top_options.logger ^= 1;
 
-	if (top_options.logger) {
-		char *p, name[512];
-		if (!(p = getenv("UMR_LOGGER")))
-			p = getenv("HOME");
-		sprintf(name, "%s/umr.log", p);
-		logfile = fopen(name, "a");
+	for (i = 0; stat_counters[i].name[0]; i++)
+		if (top_options.all || *stat_counters[i].opt)
+			for (j = 0; stat_counters[i].bits[j].regname != 0; j++) {
+				if (stat_counters[i].bits[j].start == 255)
+					continue;
+				if (names)
+					snprintf(names[n], sizeof names[n], "%s.%s", stat_counters[i].tag, stat_counters[i].bits[j].regname);
+				if (units)
+					units[n] = field_unit(i, j);
+				if (values)
+					values[n] = stat_counters[i].counts[j];
+				++n;
+			}
+	return n;
+}
 
-		fprintf(logfile, "Time (seconds),");
-		for (i = 0; stat_counters[i].name[0]; i++)
-			if (top_options.all || *stat_counters[i].opt)
-				for (j = 0; stat_counters[i].bits[j].regname != 0; j++)
-					fprintf(logfile, "%s.%s,", stat_counters[i].tag, stat_counters[i].bits[j].regname);
-		fprintf(logfile, "\n");
+// the names and units of the fields of the enabled panels for the log header
+static uint32_t log_header(const char ***names, const char ***units)
+{
+	static char buf[64*32][96];
+	static const char *namep[64*32], *unitp[64*32];
+	uint32_t n, x;
+
+	n = log_fields(buf, unitp, NULL);
+	for (x = 0; x < n; x++)
+		namep[x] = buf[x];
+	*names = namep;
+	*units = unitp;
+	return n;
+}
+
+static void open_logger(void)
+{
+	const char **names, **units;
+	char *p, name[512];
+
+	if (!(p = getenv("UMR_LOGGER")))
+		p = getenv("HOME");
+	snprintf(name, sizeof name, "%s/umr.ulog", p);
+
+	log_nfields = log_header(&names, &units);
+	logfile = umr_sample_log_open(name, log_nfields, names, units);
+	if (!logfile)
+		top_options.logger = 0;
+}
+
+static void close_logger(void)
+{
+	umr_sample_log_close(logfile);
+	logfile = NULL;
+	top_options.logger = 0;
+}
+
+static void toggle_logger(void)
+{
+	if (top_options.logger) {
+		close_logger();
 	} else {
-		if (logfile)
-			fclose(logfile);
-		logfile = NULL;
+		top_options.logger = 1;
+		open_logger();
+	}
+}
+
+// the enabled panels changed, start over with the new set of registers and fields
+static void panels_changed(struct umr_asic *asic)
+{
+	const char **names, **units;
+
+	start_sampler(asic);
+
+	// the log carries on in the same file with the new columns
+	if (logfile) {
+		log_nfields = log_header(&names, &units);
+		if (umr_sample_log_set_fields(logfile, log_nfields, names, units))
+			close_logger();
 	}
 }
 
@@ -1106,26 +1229,12 @@ static uint64_t get_visible_vram_size(struct umr_asic *asic)
 	return info.vram_cpu_accessible_size;
 }
 
-int get_active_vf(struct umr_asic *asic, uint32_t addr)
-{
-	uint32_t value = -1;
-
-	if (addr) {
-		if (asic->pci.mem) {
-			value = asic->pci.mem[addr>>2];
-		} else {
-			value = asic->reg_funcs.read_reg(asic, addr, REG_MMIO);
-		}
-		value &= 0xF;
-	}
-	return value;
-}
-
 void umr_top(struct umr_asic *asic)
 {
 	int i, j, k;
-	struct timespec req;
-	uint32_t rep;
+	struct timespec req, deadline, now;
+	struct umr_sampler_stats stats;
+	static uint64_t log_values[64*32];
 	time_t tt;
 	char hostname[64] = { 0 };
 	char fname[64], *e;
@@ -1158,7 +1267,7 @@ void umr_top(struct umr_asic *asic)
 
 	for (i = 0; stat_counters[i].name[0]; i++) {
 		if (stat_counters[i].is_sensor == 0)
-			grab_bits(stat_counters[i].name, asic, stat_counters[i].bits, &stat_counters[i].addr);
+			grab_bits(stat_counters[i].name, asic, stat_counters[i].bits, stat_counters[i].slices, &stat_counters[i].addr);
 		else if (stat_counters[i].is_sensor == 3)
 			grab_addr(stat_counters[i].name, asic, stat_counters[i].bits, &stat_counters[i].addr);
 	}
@@ -1184,36 +1293,39 @@ void umr_top(struct umr_asic *asic)
 	init_pair(3, COLOR_YELLOW, COLOR_BLACK);
 	init_pair(4, COLOR_RED, COLOR_BLACK);
 
-	// setup loop
-	if (top_options.high_precision)
-		rep = 1000;
-	else
-		rep = 100;
+	// the registers are sampled at 100Hz or 1kHz in the background and
+	// folded into the counters here every 10ms until the next report is due
+	sampler.rate = top_options.high_precision ? 1000 : 100;
+	start_sampler(asic);
 	req.tv_sec = 0;
-	req.tv_nsec = 1000000000/rep; // 10ms
+	req.tv_nsec = 10000000;
 
 	while (!top_options.quit) {
 		for (i = 0; stat_counters[i].name[0]; i++)
 			memset(stat_counters[i].counts, 0, sizeof(stat_counters[i].counts[0])*32);
 
-		for (i = 0; i < (int)rep / (top_options.high_frequency ? 10 : 1); i++) {
-			if (!top_options.sriov.num_vf || top_options.sriov.active_vf < 0 ||
-				top_options.sriov.active_vf == get_active_vf(asic, stat_counters[2].addr)) {
-				for (j = 0; stat_counters[j].name[0]; j++) {
-					if (top_options.all || *stat_counters[j].opt) {
-						if (stat_counters[j].is_sensor == 0)
-							parse_bits(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
-						else if (i == 0 && stat_counters[j].is_sensor == 1) // only parse sensors on first go-around per display
-							parse_sensors(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
-						else if (i == 0 && stat_counters[j].is_sensor == 2) // only parse drm on first go-around per display
-							parse_drm(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
-						else if (stat_counters[j].is_sensor == 3)
-							parse_iov(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
-					}
-				}
+		// sensors and drm are only parsed once per report
+		for (j = 0; stat_counters[j].name[0]; j++) {
+			if (top_options.all || *stat_counters[j].opt) {
+				if (stat_counters[j].is_sensor == 1)
+					parse_sensors(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
+				else if (stat_counters[j].is_sensor == 2)
+					parse_drm(asic, stat_counters[j].addr, stat_counters[j].bits, stat_counters[j].counts, stat_counters[j].mask, stat_counters[j].cmp, stat_counters[j].addr_mask);
 			}
-			nanosleep(&req, NULL);
 		}
+
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_nsec += top_options.high_frequency ? 100000000 : 0;
+		deadline.tv_sec += top_options.high_frequency ? 0 : 1;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_nsec -= 1000000000;
+			++deadline.tv_sec;
+		}
+		do {
+			nanosleep(&req, NULL);
+			collect_samples();
+			clock_gettime(CLOCK_MONOTONIC, &now);
+		} while (now.tv_sec < deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec < deadline.tv_nsec));
 		move(0, 0);
 		clear();
 
@@ -1221,19 +1333,15 @@ void umr_top(struct umr_asic *asic)
 			switch (i) {
 			case 'q':  top_options.quit = 1; break;
 			case 'l':  toggle_logger(); break;
-			case 'a':  top_options.all ^= 1; break;
+			case 'a':  top_options.all ^= 1; panels_changed(asic); break;
 			case 'w':  top_options.wide ^= 1; break;
 			case 'v':  top_options.vram ^= 1; break;
 			case 'W':  save_options(); break;
 			case '1':
 				top_options.high_precision ^= 1;
-				if (top_options.high_precision)
-					rep = 1000;
-				else
-					rep = 100;
-
-				req.tv_sec = 0;
-				req.tv_nsec = 1000000000/rep; // 10ms
+				sampler.rate = top_options.high_precision ? 1000 : 100;
+				if (sampler.s)
+					umr_sampler_set_rate(sampler.s, sampler.rate);
 				break;
 			case '2':
 				top_options.high_frequency ^= 1;
@@ -1257,9 +1365,10 @@ void umr_top(struct umr_asic *asic)
 					top_options.sriov.active_vf = -1;
 				}
 				break;
-			case 'r': top_options.drm ^= 1; break;
+			case 'r': top_options.drm ^= 1; panels_changed(asic); break;
 			default:
 				top_options.handle_key(i);
+				panels_changed(asic);
 			}
 		}
 
@@ -1271,6 +1380,11 @@ void umr_top(struct umr_asic *asic)
 				(top_options.high_precision ? "(sample @ 1ms, report @ 100ms)" : "(sample @ 10ms, report @ 100ms)") :
 				(top_options.high_precision ? "(sample @ 1ms, report @ 1000ms)" : "(sample @ 10ms, report @ 1000ms)"),
 			ctime(&tt));
+		if (sampler.s) {
+			umr_sampler_get_stats(sampler.s, &stats);
+			printw("(sampling @ %.0fHz, jitter %.1fus avg %.1fus max, %llu dropped)\n",
+				stats.rate_hz, stats.jitter_us, stats.max_jitter_us, (unsigned long long)stats.dropped);
+		}
 
 		// figure out padding
 		for (i = maxstrlen = 0; stat_counters[i].name[0]; i++)
@@ -1282,18 +1396,12 @@ void umr_top(struct umr_asic *asic)
 
 		print_j = 0;
 		if (logfile != NULL) {
-			struct timespec tp;
-			clock_gettime(CLOCK_MONOTONIC, &tp);
-			fprintf(logfile, "%f,", ((double)tp.tv_sec * 1000000000.0 + tp.tv_nsec) / 1000000000.0);
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			log_fields(NULL, NULL, log_values);
+			umr_sample_log_write(logfile, (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec, log_values);
 		}
 		for (i = 0; stat_counters[i].name[0]; i++) {
 			if (top_options.all || *stat_counters[i].opt) {
-				if (logfile != NULL) {
-					for (j = 0; stat_counters[i].bits[j].regname != 0; j++) {
-						if (stat_counters[i].bits[j].start != 255)
-							fprintf(logfile, "%llu,", (unsigned long long)stat_counters[i].counts[j]);
-					}
-				}
 				if (!i || strcmp(stat_counters[i-1].tag, stat_counters[i].tag)) {
 					if (print_j & (top_options.wide ? 3 : 1))
 						printw("\n");
@@ -1311,10 +1419,6 @@ void umr_top(struct umr_asic *asic)
 					print_iov(stat_counters[i].counts);
 			}
 		}
-		if (logfile != NULL) {
-			fprintf(logfile, "\n");
-		}
-
 		if (top_options.all || top_options.vram) {
 			if (print_j & (top_options.wide ? 3 : 1))
 				printw("\n");
@@ -1331,6 +1435,10 @@ void umr_top(struct umr_asic *asic)
 	}
 	endwin();
 
+	umr_sampler_free(sampler.s);
+	sampler.s = NULL;
+	close_logger();
+
 	sensor_thread_quit = 1;
 	pthread_join(sensor_thread, NULL);
 }
@@ -196,7 +196,21 @@ void force_redraw() {
 	SDL_PushEvent(&evt);
 }
 
-static struct Link lnk;
+/* Requests are answered by COMM_THREADS threads, each with its own
+ * connection to the server, so a short request isn't stuck behind a long
+ * running one (e.g. accumulate).
+ */
+#define COMM_THREADS 4
+
+struct AsicData;
+
+struct CommThread {
+	struct Link lnk;
+	std::vector<AsicData*> *asics;
+	pthread_t id;
+};
+
+static struct CommThread comm_threads[COMM_THREADS];
 static pthread_cond_t cond;
 static bool done;
 
@@ -267,9 +281,20 @@ struct AsicData {
 	std::vector<Panel*> panels;
 };
 
-std::vector<JSON_Value*> pending_request;
+/* Queued requests and the ones waiting for their answer, in the order
+ * they were sent.  Requests from the same panel run one after the other.
+ */
+struct PendingRequest {
+	JSON_Value *req;
+	Panel *panel; /* NULL if not sent by a panel */
+	unsigned seq;
+	bool running;
+};
+
+std::vector<PendingRequest> pending_request;
+static unsigned next_request_seq;
 
-void send_request(JSON_Value *req, struct umr_asic *asic) {
+static void queue_request(JSON_Value *req, struct umr_asic *asic, Panel *panel) {
 	if (asic) {
 		JSON_Value *a = json_value_init_object();
 		json_object_set_number(json_object(a), "did", asic->did);
@@ -277,22 +302,39 @@ void send_request(JSON_Value *req, struct umr_asic *asic) {
 		json_object_set_value(json_object(req), "asic", a);
 	}
 	pthread_mutex_lock(&mtx);
-	pending_request.push_back(req);
+	pending_request.push_back({ req, panel, next_request_seq++, false });
 	pthread_cond_signal(&cond);
 	pthread_mutex_unlock(&mtx);
 }
 
+void send_request(JSON_Value *req, struct umr_asic *asic) {
+	queue_request(req, asic, NULL);
+}
+
 void Panel::send_request(JSON_Value *req) {
-	if (asic) {
-		JSON_Value *a = json_value_init_object();
-		json_object_set_number(json_object(a), "did", asic->did);
-		json_object_set_number(json_object(a), "instance", asic->instance);
-		json_object_set_value(json_object(req), "asic", a);
+	queue_request(req, asic, this);
+}
+
+/* A panel doesn't send a new request before the previous ones are answered. */
+static bool panel_can_send_request(Panel *panel) {
+	for (auto &p: pending_request)
+		if (p.panel == panel)
+			return false;
+	return true;
+}
+
+/* The oldest request that can start now, called with mtx held. */
+static PendingRequest *next_request(void) {
+	for (size_t i = 0; i < pending_request.size(); i++) {
+		if (pending_request[i].running)
+			continue;
+		bool blocked = false;
+		for (size_t j = 0; j < i && !blocked; j++)
+			blocked = pending_request[i].panel && pending_request[j].panel == pending_request[i].panel;
+		if (!blocked)
+			return &pending_request[i];
 	}
-	pthread_mutex_lock(&mtx);
-	pending_request.push_back(req);
-	pthread_cond_signal(&cond);
-	pthread_mutex_unlock(&mtx);
+	return NULL;
 }
 
 AsicData *answer_to_asic_data(std::vector<AsicData*> *asics, JSON_Object *request) {
@@ -372,9 +414,12 @@ static void process_response(std::vector<AsicData*> *asics, JSON_Object *respons
 	force_redraw();
 }
 
-static void *communication_thread(void *_job) {
+static char session_folder[PATH_MAX];
+static bool save_session;
+static int msg_count;
+
+static void open_session_folder(void) {
 	int id = 0;
-	char session_folder[PATH_MAX];
 	while (id < 1024) {
 		struct stat statbuf;
 		snprintf(session_folder, sizeof(session_folder), "/tmp/umr_session.%d", id++);
@@ -383,53 +428,71 @@ static void *communication_thread(void *_job) {
 		}
 	}
 
-	int save_to_disk = mkdir(session_folder, 0755) == 0;
-	if (!save_to_disk) {
+	save_session = mkdir(session_folder, 0755) == 0;
+	if (!save_session) {
 		printf("Failed to create the replay folder (error: %d)\n", errno);
 	}
+}
+
+static int64_t last_ping;
+static bool ping_pending;
 
-	std::vector<AsicData*> *asics = (std::vector<AsicData*> *)_job;
-	int64_t last_ping = time_ns();
+static void *communication_thread(void *_job) {
+	struct CommThread *ct = (struct CommThread *)_job;
 
-	int msg_count = 0;
+	pthread_mutex_lock(&mtx);
 	while (!done) {
-		pthread_mutex_lock(&mtx);
-		if (pending_request.empty()) {
+		PendingRequest *p = next_request();
+		if (!p) {
 			int64_t now = time_ns();
 
-			if (now - last_ping > 1000000000) {
+			/* pings keep going while long requests are running */
+			if (!ping_pending && now - last_ping > 1000000000) {
 				JSON_Value *req = json_value_init_object();
 				json_object_set_string(json_object(req), "command", "ping");
 				json_object_set_number(json_object(req), "ts", now);
 				last_ping = now;
-				pending_request.push_back(req);
+				ping_pending = true;
+				pending_request.push_back({ req, NULL, next_request_seq++, false });
 			} else {
 				struct timespec t;
 				clock_gettime(CLOCK_REALTIME, &t);
 				t.tv_sec += 1;
 				pthread_cond_timedwait(&cond, &mtx, &t);
 			}
+			continue;
 		}
-		for (int i = 0; i < pending_request.size(); i++) {
-			void *raw_data = NULL;
-			unsigned raw_data_size = 0;
-			JSON_Value* req = pending_request[i];
-			pthread_mutex_unlock(&mtx);
-			bool is_ping = strcmp(json_object_get_string(json_object(req), "command"), "ping") == 0;
-			JSON_Value *in = query(lnk, req, &raw_data, &raw_data_size,
-										  (save_to_disk && !is_ping) ? session_folder : NULL, msg_count);
-			if (!is_ping)
-				msg_count++;
-
-			pthread_mutex_lock(&mtx);
-
-			process_response(asics, json_object(in), raw_data, raw_data_size);
-
-			json_value_free(in);
-		}
-		pending_request.clear();
+
+		void *raw_data = NULL;
+		unsigned raw_data_size = 0;
+		JSON_Value* req = p->req;
+		unsigned seq = p->seq;
+		bool is_ping = strcmp(json_object_get_string(json_object(req), "command"), "ping") == 0;
+		int msg_idx = is_ping ? 0 : msg_count++;
+		p->running = true;
 		pthread_mutex_unlock(&mtx);
+
+		JSON_Value *in = query(ct->lnk, req, &raw_data, &raw_data_size,
+							   (save_session && !is_ping) ? session_folder : NULL, msg_idx);
+
+		pthread_mutex_lock(&mtx);
+
+		process_response(ct->asics, json_object(in), raw_data, raw_data_size);
+
+		json_value_free(in);
+
+		for (size_t i = 0; i < pending_request.size(); i++) {
+			if (pending_request[i].seq == seq) {
+				pending_request.erase(pending_request.begin() + i);
+				break;
+			}
+		}
+		if (is_ping)
+			ping_pending = false;
+		/* the next request of the same panel can go now */
+		pthread_cond_broadcast(&cond);
 	}
+	pthread_mutex_unlock(&mtx);
 	return 0;
 }
 
@@ -554,27 +617,31 @@ static int run_gui(const char *url)
 			replay = true;
 		} else {
 			#if UMR_SERVER
-			int rv;
-			if ((lnk.sock = nn_socket(AF_SP, NN_REQ)) < 0) {
-				exit(1);
-			}
-			if ((rv = nn_connect (lnk.sock, url)) < 0) {
-				printf("Error: invalid url '%s'\n", url);
-				exit(1);
-			}
-			int size = 100000000;
-			if (nn_setsockopt(lnk.sock, NN_SOL_SOCKET, NN_RCVMAXSIZE, &size, sizeof(size)) < 0) {
-				exit(0);
+			for (int i = 0; i < COMM_THREADS; i++) {
+				struct Link &lnk = comm_threads[i].lnk;
+				int rv;
+				if ((lnk.sock = nn_socket(AF_SP, NN_REQ)) < 0) {
+					exit(1);
+				}
+				if ((rv = nn_connect (lnk.sock, url)) < 0) {
+					printf("Error: invalid url '%s'\n", url);
+					exit(1);
+				}
+				int size = 100000000;
+				if (nn_setsockopt(lnk.sock, NN_SOL_SOCKET, NN_RCVMAXSIZE, &size, sizeof(size)) < 0) {
+					exit(0);
+				}
+				lnk.use_sock = true;
+				lnk.endpoint = rv;
 			}
-			lnk.use_sock = true;
-			lnk.endpoint = rv;
 			#else
 			printf("Error: UMR remote GUI feature was not enabled at build time.\n");
 			exit(1);
 			#endif
 		}
 	} else {
-		lnk.use_sock = false;
+		for (int i = 0; i < COMM_THREADS; i++)
+			comm_threads[i].lnk.use_sock = false;
 	}
 
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
@@ -584,12 +651,16 @@ static int run_gui(const char *url)
 
 	std::vector<AsicData*> asics;
 
-	pthread_t t_id;
 	std::vector<std::string> replay_commands;
 	if (replay) {
 		current_replay = replay_up_to(url, asics, replay_commands, -1);
 	} else {
-		pthread_create(&t_id, NULL, communication_thread, &asics);
+		open_session_folder();
+		last_ping = time_ns();
+		for (int i = 0; i < COMM_THREADS; i++) {
+			comm_threads[i].asics = &asics;
+			pthread_create(&comm_threads[i].id, NULL, communication_thread, &comm_threads[i]);
+		}
 	}
 
 	ImVec4 clear_color = ImColor(0, 43, 54, 255).Value;
@@ -609,7 +680,7 @@ static int run_gui(const char *url)
 		(SDL_WindowFlags)(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
 	char title[512];
-	if (lnk.use_sock)
+	if (comm_threads[0].lnk.use_sock)
 		sprintf(title, "umr (%s)", url);
 	else
 		strcpy(title, "umr");
@@ -713,7 +784,7 @@ static int run_gui(const char *url)
 		}
 		memcpy(&before, &now, sizeof(now));
 
-		if (lnk.use_sock && previous_ping != ping_value) {
+		if (comm_threads[0].lnk.use_sock && previous_ping != ping_value) {
 			char title[512];
 			sprintf(title, "umr (%s, %.1f ms)", url, ping_value);
 			previous_ping = ping_value;
@@ -855,64 +926,62 @@ static int run_gui(const char *url)
 			if (!ImGui::BeginTabItem(asic, NULL))
 				continue;
 
-			bool can_send_request = pending_request.empty();
-
 			ImGui::BeginTabBar("tabs", ImGuiTabBarFlags_None);
 
 			if (ImGui::BeginTabItem("#b58900I#ffffffnfo", NULL, kb_shortcut(SDLK_i) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				data.panels[0]->display(dt, avail, can_send_request);
+				data.panels[0]->display(dt, avail, panel_can_send_request(data.panels[0]));
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900R#ffffffegisters", NULL, kb_shortcut(SDLK_r) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[1]->display(dt, avail, can_send_request))
+				if (data.panels[1]->display(dt, avail, panel_can_send_request(data.panels[1])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900W#ffffffaves", NULL, kb_shortcut(SDLK_w) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[7]->display(dt, avail, can_send_request))
+				if (data.panels[7]->display(dt, avail, panel_can_send_request(data.panels[7])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("Rin#b58900g#ffffffs", NULL, kb_shortcut(SDLK_g) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				data.panels[3]->display(dt, avail, can_send_request);
+				data.panels[3]->display(dt, avail, panel_can_send_request(data.panels[3]));
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900P#ffffffower", NULL, kb_shortcut(SDLK_p) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[2]->display(dt, avail, can_send_request))
+				if (data.panels[2]->display(dt, avail, panel_can_send_request(data.panels[2])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900M#ffffffemory Usage", NULL, kb_shortcut(SDLK_m) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[5]->display(dt, avail, can_send_request))
+				if (data.panels[5]->display(dt, avail, panel_can_send_request(data.panels[5])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900T#ffffffop", NULL, kb_shortcut(SDLK_t) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[4]->display(dt, avail, can_send_request))
+				if (data.panels[4]->display(dt, avail, panel_can_send_request(data.panels[4])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("#b58900K#ffffffMS", NULL, kb_shortcut(SDLK_k) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[8]->display(dt, avail, can_send_request))
+				if (data.panels[8]->display(dt, avail, panel_can_send_request(data.panels[8])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("Memory #b58900I#ffffffnspector", NULL, kb_shortcut(SDLK_i) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[6]->display(dt, avail, can_send_request))
+				if (data.panels[6]->display(dt, avail, panel_can_send_request(data.panels[6])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
 
 			if (ImGui::BeginTabItem("Buffer #b58900O#ffffffjects", NULL, kb_shortcut(SDLK_o) ? ImGuiTabItemFlags_SetSelected : 0)) {
-				if (data.panels[9]->display(dt, avail, can_send_request))
+				if (data.panels[9]->display(dt, avail, panel_can_send_request(data.panels[9])))
 					need_auto_refresh = -1;
 				ImGui::EndTabItem();
 			}
@@ -954,19 +1023,23 @@ static int run_gui(const char *url)
 	}
 
 	pthread_mutex_lock(&mtx);
-	pthread_cond_signal(&cond);
+	pthread_cond_broadcast(&cond);
 	pthread_mutex_unlock(&mtx);
 
 #if UMR_SERVER
-	if (lnk.use_sock) {
-		nn_shutdown(lnk.sock, lnk.endpoint);
-		nn_close(lnk.sock);
+	for (int i = 0; i < COMM_THREADS; i++) {
+		struct Link &lnk = comm_threads[i].lnk;
+		if (lnk.use_sock) {
+			nn_shutdown(lnk.sock, lnk.endpoint);
+			nn_close(lnk.sock);
+		}
 	}
 #endif
 
 	if (!replay) {
 		void *res;
-		pthread_join(t_id, &res);
+		for (int i = 0; i < COMM_THREADS; i++)
+			pthread_join(comm_threads[i].id, &res);
 	}
 
 	for (int i = 0; i < asics.size(); i++)
@@ -25,55 +25,37 @@
 #include "umrapp.h"
 #include <inttypes.h>
 
-void umr_lookup(struct umr_asic *asic, char *address, char *value)
+static void print_reg(struct umr_asic *asic, struct umr_ip_block *ip, struct umr_reg *reg, uint32_t num, void *data)
 {
-	int byaddress, i, j, k;
-	uint32_t regno, num;
-
-	byaddress = sscanf(address, "0x%"SCNx32, &regno);
-	sscanf(value, "%"SCNx32, &num);
+	int k;
+	uint32_t v;
 
-	if (byaddress) {
-		for (i = 0; i < asic->no_blocks; i++)
-		for (j = 0; j < asic->blocks[i]->no_regs; j++)
-			if (asic->blocks[i]->regs[j].type == REG_MMIO &&
-			    asic->blocks[i]->regs[j].addr == regno) {
-				printf("%s.%s => 0x%08lx\n", asic->blocks[i]->ipname, asic->blocks[i]->regs[j].regname, (unsigned long)num);
-				for (k = 0; k < asic->blocks[i]->regs[j].no_bits; k++) {
-					uint32_t v;
-					v = (1UL << (asic->blocks[i]->regs[j].bits[k].stop + 1 - asic->blocks[i]->regs[j].bits[k].start)) - 1;
-					v &= (num >> asic->blocks[i]->regs[j].bits[k].start);
-					asic->blocks[i]->regs[j].bits[k].bitfield_print(asic, asic->asicname, asic->blocks[i]->ipname, asic->blocks[i]->regs[j].regname, asic->blocks[i]->regs[j].bits[k].regname, asic->blocks[i]->regs[j].bits[k].start, asic->blocks[i]->regs[j].bits[k].stop, v);
-				}
-			}
-	} else {
-		char ipname[256], regname[256], *p;
+	(void)data;
+	printf("%s.%s => 0x%08lx\n", ip->ipname, reg->regname, (unsigned long)num);
+	for (k = 0; k < reg->no_bits; k++) {
+		v = (1UL << (reg->bits[k].stop + 1 - reg->bits[k].start)) - 1;
+		v &= (num >> reg->bits[k].start);
+		reg->bits[k].bitfield_print(asic, asic->asicname, ip->ipname, reg->regname, reg->bits[k].regname, reg->bits[k].start, reg->bits[k].stop, v);
+	}
+}
 
-		memset(ipname, 0, sizeof ipname);
-		memset(regname, 0, sizeof regname);
-		p = strstr(address, ".");
-		if (!p) {
-			fprintf(stderr, "[ERROR]: Must specify ipname.regname for umr_lookup()\n");
-			return;
-		}
-		memcpy(ipname, address, p - address);
-		strcpy(regname, p + 1);
+void umr_lookup(struct umr_asic *asic, char *address, char *value)
+{
+	uint32_t num = 0;
 
-		for (i = 0; i < asic->no_blocks; i++)
-			if (!strcmp(asic->blocks[i]->ipname, ipname)) {
-				for (j = 0; j < asic->blocks[i]->no_regs; j++) {
-					if (asic->blocks[i]->regs[j].type == REG_MMIO &&
-					    !strcmp(asic->blocks[i]->regs[j].regname, regname)) {
-						printf("%s.%s => 0x%08lx\n", asic->blocks[i]->ipname, asic->blocks[i]->regs[j].regname, (unsigned long)num);
-						for (k = 0; k < asic->blocks[i]->regs[j].no_bits; k++) {
-							uint32_t v;
-							v = (1UL << (asic->blocks[i]->regs[j].bits[k].stop + 1 - asic->blocks[i]->regs[j].bits[k].start)) - 1;
-							v &= (num >> asic->blocks[i]->regs[j].bits[k].start);
-							asic->blocks[i]->regs[j].bits[k].bitfield_print(asic, asic->asicname, asic->blocks[i]->ipname, asic->blocks[i]->regs[j].regname, asic->blocks[i]->regs[j].bits[k].regname, asic->blocks[i]->regs[j].bits[k].start, asic->blocks[i]->regs[j].bits[k].stop, v);
-						}
-					}
-				}
-			}
-	}
+	sscanf(value, "%"SCNx32, &num);
+	if (umr_lookup_reg_value(asic, address, num, print_reg, NULL) < 0)
+		fprintf(stderr, "[ERROR]: Must specify ipname.regname for umr_lookup()\n");
 }
 
+/**
+ * umr_lookup_batch - Decode a stream of register values
+ *
+ * See umr_lookup_reg_batch() for the format of @f.
+ *
+ * Returns the number of lines that did not decode.
+ */
+int umr_lookup_batch(struct umr_asic *asic, FILE *f)
+{
+	return umr_lookup_reg_batch(asic, f, print_reg, NULL);
+}
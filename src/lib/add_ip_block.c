@@ -35,5 +35,14 @@ int umr_add_ip_block(struct umr_asic *asic, struct umr_ip_block *ip)
 	}
 	asic->blocks = tmp;
 	asic->blocks[asic->no_blocks++] = ip;
+
+	// the preformatted names, bitfield index and wave bitfields are rebuilt on next use
+	umr_free_reg_name_table(asic);
+	umr_free_bit_index(asic);
+	umr_wave_fields_free(asic);
+
+	// keep the register name index in sync if there is one
+	if (asic->reg_index)
+		return umr_create_reg_index(asic);
 	return 0;
 }
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+
+/* The bitfield index maps a register to its bitfields sorted by name
+ * so a bitfield can be found by binary search instead of comparing
+ * against every bitfield of the register.  Registers are indexed the
+ * first time one of their bitfields is looked up by name, under a lock
+ * since threads may share the index.  umr_create_bit_index() indexes
+ * every register up front after which lookups no longer lock.
+ */
+
+struct umr_bit_index_entry {
+	const struct umr_reg *reg;
+	struct umr_bitfield **sorted;
+};
+
+struct umr_bit_index {
+	uint32_t size, used;
+	int complete;
+	struct umr_bit_index_entry *entries;
+#if defined(__unix__)
+	pthread_mutex_t lock;
+#endif
+};
+
+#if defined(__unix__)
+#define bit_index_lock(bi) pthread_mutex_lock(&(bi)->lock)
+#define bit_index_unlock(bi) pthread_mutex_unlock(&(bi)->lock)
+#else
+#define bit_index_lock(bi) do { } while (0)
+#define bit_index_unlock(bi) do { } while (0)
+#endif
+
+// registers with this few bitfields are just searched in order
+#define BIT_INDEX_MIN_BITS 8
+
+static uint32_t reg_hash(const struct umr_reg *reg)
+{
+	uint64_t h = (uintptr_t)reg;
+
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+// by name then by position so the first of any duplicates sorts first
+static int cmp_bits(const void *A, const void *B)
+{
+	const struct umr_bitfield *a = *(struct umr_bitfield * const *)A, *b = *(struct umr_bitfield * const *)B;
+	int r = strcmp(a->regname, b->regname);
+
+	if (r)
+		return r;
+	return (a > b) - (a < b);
+}
+
+static int bit_index_grow(struct umr_bit_index *bi)
+{
+	struct umr_bit_index_entry *entries;
+	uint32_t size, x, slot;
+
+	size = bi->size ? bi->size * 2 : 256;
+	entries = calloc(size, sizeof entries[0]);
+	if (!entries)
+		return -1;
+	for (x = 0; x < bi->size; x++) {
+		if (!bi->entries[x].reg)
+			continue;
+		for (slot = reg_hash(bi->entries[x].reg) & (size - 1); entries[slot].reg; slot = (slot + 1) & (size - 1));
+		entries[slot] = bi->entries[x];
+	}
+	free(bi->entries);
+	bi->entries = entries;
+	bi->size = size;
+	return 0;
+}
+
+static struct umr_bit_index *bit_index_alloc(struct umr_asic *asic)
+{
+	if (!asic->bit_index) {
+		asic->bit_index = calloc(1, sizeof *asic->bit_index);
+		if (!asic->bit_index)
+			return NULL;
+#if defined(__unix__)
+		pthread_mutex_init(&asic->bit_index->lock, NULL);
+#endif
+	}
+	return asic->bit_index;
+}
+
+static struct umr_bitfield **bit_index_find(struct umr_bit_index *bi, const struct umr_reg *reg)
+{
+	uint32_t slot;
+
+	if (bi->size) {
+		for (slot = reg_hash(reg) & (bi->size - 1); bi->entries[slot].reg; slot = (slot + 1) & (bi->size - 1))
+			if (bi->entries[slot].reg == reg)
+				return bi->entries[slot].sorted;
+	}
+	return NULL;
+}
+
+/*
+ * bit_index_insert - Index @reg (called with the index locked)
+ */
+static struct umr_bitfield **bit_index_insert(struct umr_bit_index *bi, const struct umr_reg *reg)
+{
+	struct umr_bitfield **sorted;
+	uint32_t slot;
+	int x;
+
+	sorted = bit_index_find(bi, reg);
+	if (sorted)
+		return sorted;
+
+	// keep the table at most half full
+	if (2 * (bi->used + 1) > bi->size && bit_index_grow(bi))
+		return NULL;
+
+	sorted = calloc(reg->no_bits, sizeof sorted[0]);
+	if (!sorted)
+		return NULL;
+	for (x = 0; x < reg->no_bits; x++)
+		sorted[x] = &reg->bits[x];
+	qsort(sorted, reg->no_bits, sizeof sorted[0], cmp_bits);
+
+	for (slot = reg_hash(reg) & (bi->size - 1); bi->entries[slot].reg; slot = (slot + 1) & (bi->size - 1));
+	bi->entries[slot].reg = reg;
+	bi->entries[slot].sorted = sorted;
+	++bi->used;
+	return sorted;
+}
+
+/*
+ * bit_index_get - Return the bitfields of @reg sorted by name, indexing it if needed
+ */
+static struct umr_bitfield **bit_index_get(struct umr_asic *asic, const struct umr_reg *reg)
+{
+	struct umr_bit_index *bi;
+	struct umr_bitfield **sorted;
+
+	bi = bit_index_alloc(asic);
+	if (!bi)
+		return NULL;
+
+	// a complete index is never written to again
+	if (bi->complete)
+		return bit_index_find(bi, reg);
+
+	bit_index_lock(bi);
+	sorted = bit_index_insert(bi, reg);
+	bit_index_unlock(bi);
+	return sorted;
+}
+
+/**
+ * umr_create_bit_index - Index the bitfields of every register
+ *
+ * @asic: The device to index
+ *
+ * Call this before sharing @asic (or shallow copies of it) between
+ * threads so they never have to build the index themselves.
+ *
+ * Returns 0 on success.
+ */
+int umr_create_bit_index(struct umr_asic *asic)
+{
+	struct umr_bit_index *bi;
+	int i, j, r = 0;
+
+	bi = bit_index_alloc(asic);
+	if (!bi)
+		return -1;
+	if (bi->complete)
+		return 0;
+
+	bit_index_lock(bi);
+	for (i = 0; i < asic->no_blocks && !r; i++)
+		for (j = 0; j < asic->blocks[i]->no_regs && !r; j++)
+			if (asic->blocks[i]->regs[j].no_bits > BIT_INDEX_MIN_BITS &&
+			    !bit_index_insert(bi, &asic->blocks[i]->regs[j]))
+				r = -1;
+	bi->complete = !r;
+	bit_index_unlock(bi);
+	return r;
+}
+
+/**
+ * umr_find_bitfield - Find a bitfield of a register by name
+ *
+ * @asic: The device the register belongs to
+ * @reg: The register
+ * @bitname: The name of the bitfield (case sensitive)
+ *
+ * If a register has several bitfields with the same name the first
+ * one is returned.
+ *
+ * Returns NULL if the register has no such bitfield.
+ */
+struct umr_bitfield *umr_find_bitfield(struct umr_asic *asic, struct umr_reg *reg, const char *bitname)
+{
+	struct umr_bitfield **sorted;
+	int lo, hi, mid, r;
+
+	if (reg->no_bits > BIT_INDEX_MIN_BITS && (sorted = bit_index_get(asic, reg))) {
+		// the leftmost match
+		for (lo = 0, hi = reg->no_bits; lo < hi; ) {
+			mid = (lo + hi) / 2;
+			r = strcmp(sorted[mid]->regname, bitname);
+			if (r < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < reg->no_bits && !strcmp(sorted[lo]->regname, bitname))
+			return sorted[lo];
+		return NULL;
+	}
+
+	for (r = 0; r < reg->no_bits; r++)
+		if (!strcmp(bitname, reg->bits[r].regname))
+			return &reg->bits[r];
+	return NULL;
+}
+
+/**
+ * umr_free_bit_index - Free the bitfield index
+ *
+ * It is rebuilt as bitfields are looked up again.
+ */
+void umr_free_bit_index(struct umr_asic *asic)
+{
+	uint32_t x;
+
+	if (!asic->bit_index)
+		return;
+	for (x = 0; x < asic->bit_index->size; x++)
+		free(asic->bit_index->entries[x].sorted);
+	free(asic->bit_index->entries);
+#if defined(__unix__)
+	pthread_mutex_destroy(&asic->bit_index->lock);
+#endif
+	free(asic->bit_index);
+	asic->bit_index = NULL;
+}
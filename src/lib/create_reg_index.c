@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+#include <ctype.h>
+
+/**
+ * umr_reg_index_hash - Hash a register name for the register name index
+ *
+ * @regname: The register name
+ *
+ * The hash is case insensitive since register lookups by name are.
+ */
+uint32_t umr_reg_index_hash(const char *regname)
+{
+	uint32_t h = 2166136261UL;
+
+	while (*regname)
+		h = (h ^ (uint8_t)toupper(*regname++)) * 16777619UL;
+	return h;
+}
+
+/**
+ * umr_create_reg_index - Create the register name index
+ *
+ * @asic:  Device to create the index for
+ *
+ * This function creates an open addressed hash table that maps
+ * (case folded) register names to the register and IP block
+ * structures.  Registers with the same name in several IP blocks
+ * all appear in the table and are visited in IP block order by
+ * the linear probe so the lookup returns the same register the
+ * block by block search would.
+ */
+int umr_create_reg_index(struct umr_asic *asic)
+{
+	int i, j;
+	uint32_t no_regs, size, h, mask, slot;
+
+	free(asic->reg_index);
+	asic->reg_index = NULL;
+	asic->reg_index_size = 0;
+
+	for (no_regs = i = 0; i < asic->no_blocks; i++)
+		no_regs += asic->blocks[i]->no_regs;
+
+	// keep the table at most half full
+	for (size = 16; size < 2 * no_regs; size <<= 1);
+	mask = size - 1;
+
+	asic->reg_index = calloc(size, sizeof asic->reg_index[0]);
+	if (!asic->reg_index) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	asic->reg_index_size = size;
+
+	for (i = 0; i < asic->no_blocks; i++) {
+		for (j = 0; j < asic->blocks[i]->no_regs; j++) {
+			h = umr_reg_index_hash(asic->blocks[i]->regs[j].regname);
+			for (slot = h & mask; asic->reg_index[slot].reg; slot = (slot + 1) & mask);
+			asic->reg_index[slot].hash = h;
+			asic->reg_index[slot].block = i;
+			asic->reg_index[slot].reg = &asic->blocks[i]->regs[j];
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+
+// register windows written by SET_SH_REG, SET_CONTEXT_REG and SET_UCONFIG_REG
+static const struct {
+	uint32_t base, size;
+} windows[] = {
+	{ 0x2C00, 0x400 },  // SH
+	{ 0xA000, 0x400 },  // context
+	{ 0xC000, 0x4000 }, // uconfig
+};
+#define NO_WINDOWS (sizeof windows / sizeof windows[0])
+
+struct umr_reg_name_table {
+	int use_colour;            // the names were formatted with this colour setting
+	char *pool;                // all of the names back to back
+	const char *names[];       // one per offset of every window in order (NULL if unknown)
+};
+
+// index of @addr in the table or -1 if it is outside of the windows
+static int64_t window_slot(uint64_t addr)
+{
+	uint32_t w, off;
+
+	for (off = w = 0; w < NO_WINDOWS; off += windows[w++].size)
+		if (addr >= windows[w].base && addr < windows[w].base + windows[w].size)
+			return off + addr - windows[w].base;
+	return -1;
+}
+
+/**
+ * umr_create_reg_name_table - Create the register name table for PM4 windows
+ *
+ * @asic:  Device to create the table for
+ *
+ * Formats the names of every register in the SH, context and uconfig
+ * windows once so umr_reg_name() can return them without searching
+ * or formatting.  The registers are found in one pass over the
+ * database, the first one at an offset wins as in umr_find_reg_by_addr().
+ */
+int umr_create_reg_name_table(struct umr_asic *asic)
+{
+	struct umr_reg_name_table *table;
+	struct {
+		struct umr_ip_block *ip;
+		struct umr_reg *reg;
+	} *found;
+	uint32_t x, w, no_names;
+	int64_t slot;
+	int i, j;
+	size_t len;
+	char *p;
+
+	umr_free_reg_name_table(asic);
+
+	for (no_names = w = 0; w < NO_WINDOWS; w++)
+		no_names += windows[w].size;
+
+	found = calloc(no_names, sizeof found[0]);
+	if (!found) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	for (i = 0; i < asic->no_blocks; i++) {
+		for (j = 0; j < asic->blocks[i]->no_regs; j++) {
+			if (asic->blocks[i]->regs[j].type != REG_MMIO)
+				continue;
+			slot = window_slot(asic->blocks[i]->regs[j].addr);
+			if (slot >= 0 && !found[slot].reg) {
+				found[slot].ip = asic->blocks[i];
+				found[slot].reg = &asic->blocks[i]->regs[j];
+			}
+		}
+	}
+
+	// size the pool first so the names never move
+	for (len = x = 0; x < no_names; x++)
+		if (found[x].reg)
+			len += strlen(RED) + strlen(found[x].ip->ipname) + 1 + strlen(found[x].reg->regname) + strlen(RST) + 1;
+
+	table = calloc(1, sizeof *table + no_names * sizeof table->names[0]);
+	if (table)
+		table->pool = calloc(1, len ? len : 1);
+	if (!table || !table->pool) {
+		free(table);
+		free(found);
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	table->use_colour = asic->options.use_colour;
+
+	for (p = table->pool, x = 0; x < no_names; x++) {
+		if (found[x].reg) {
+			table->names[x] = p;
+			p += sprintf(p, "%s%s.%s%s", RED, found[x].ip->ipname, found[x].reg->regname, RST) + 1;
+		}
+	}
+	free(found);
+
+	asic->reg_names = table;
+	return 0;
+}
+
+/**
+ * umr_free_reg_name_table - Free the register name table of @asic
+ */
+void umr_free_reg_name_table(struct umr_asic *asic)
+{
+	if (asic->reg_names) {
+		free(asic->reg_names->pool);
+		free(asic->reg_names);
+		asic->reg_names = NULL;
+	}
+}
+
+/**
+ * umr_reg_name_table_lookup - Look up a preformatted register name
+ *
+ * @asic: The device the register belongs to
+ * @addr: The register offset
+ * @name: Where to store the name (NULL if there is no such register)
+ *
+ * Returns 0 and sets @name if @addr falls in one of the PM4 register
+ * windows, the table is created on first use.  Returns -1 if @addr is
+ * outside of the windows or the table cannot be created.
+ */
+int umr_reg_name_table_lookup(struct umr_asic *asic, uint64_t addr, const char **name)
+{
+	int64_t slot;
+
+	slot = window_slot(addr);
+	if (slot < 0)
+		return -1;
+
+	// the names carry the colour codes so a change of setting needs a new table
+	if (!asic->reg_names || asic->reg_names->use_colour != asic->options.use_colour)
+		if (umr_create_reg_name_table(asic))
+			return -1;
+
+	*name = asic->reg_names->names[slot];
+	return 0;
+}
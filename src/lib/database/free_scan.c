@@ -28,6 +28,8 @@ void umr_database_free_scan_items(struct umr_database_scan_item *it)
 {
 	struct umr_database_scan_item *nit;
 
+	if (it)
+		free(it->ip_hash);
 	while (it) {
 		nit = it->next;
 		free(it);
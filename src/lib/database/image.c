@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ */
+#include "umr.h"
+#include "umr_database_image.h"
+
+#if defined(__unix__)
+#include <sys/mman.h>
+
+struct umr_database_image {
+	const uint8_t *base;
+	uint64_t size;
+	dev_t dev;
+	ino_t ino;
+	int refcnt;
+	struct umr_database_image *next;
+};
+
+static struct umr_database_image *images;
+static pthread_mutex_t images_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *img_str(struct umr_database_image *img, uint32_t off)
+{
+	const struct umr_db_image_header *hdr = (const void *)img->base;
+	return (const char *)img->base + hdr->strings_off + off;
+}
+
+/* Nothing read from the image is trusted: every offset and count is
+ * checked against the mapping before it is used and a payload that
+ * fails a check is treated as missing so the text file is parsed
+ * instead.
+ */
+
+// is @n records of @size bytes at @off inside the image (and aligned like dbcompiler writes them)
+static int img_range(struct umr_database_image *img, uint64_t off, uint64_t n, uint64_t size)
+{
+	return !(off & 7) && off <= img->size && n <= (img->size - off) / size;
+}
+
+// the string table is checked to end in a NUL so any offset inside it is a valid string
+static int img_str_ok(struct umr_database_image *img, uint32_t off)
+{
+	const struct umr_db_image_header *hdr = (const void *)img->base;
+	return off < hdr->strings_size;
+}
+
+/**
+ * image_check - Check the tables every lookup goes through
+ *
+ * @img: The freshly mapped image
+ *
+ * Checks the file table and the string table.  The payloads are
+ * checked when they are used.  Returns 0 if the image can be used.
+ */
+static int image_check(struct umr_database_image *img)
+{
+	const struct umr_db_image_header *hdr = (const void *)img->base;
+	const struct umr_db_image_file *files;
+	uint32_t x;
+
+	if (!hdr->strings_size || hdr->strings_off > img->size ||
+	    hdr->strings_size > img->size - hdr->strings_off ||
+	    img->base[hdr->strings_off + hdr->strings_size - 1] ||
+	    !img_range(img, hdr->files_off, hdr->no_files, sizeof *files))
+		return -1;
+
+	files = (const void *)(img->base + hdr->files_off);
+	for (x = 0; x < hdr->no_files; x++)
+		if (!img_str_ok(img, files[x].basename) || !img_str_ok(img, files[x].relpath))
+			return -1;
+	return 0;
+}
+
+/**
+ * image_get - Map (or re-use a mapping of) the database image
+ *
+ * @path: The database path option (may be NULL)
+ *
+ * The image is searched for with the same rules as the text
+ * files (see umr_database_open()).  Returns a referenced image
+ * or NULL if no usable image was found.
+ */
+static struct umr_database_image *image_get(char *path)
+{
+	struct umr_database_image *img;
+	const struct umr_db_image_header *hdr;
+	struct stat st;
+	FILE *f;
+	void *base;
+
+	if (getenv("UMR_NO_DATABASE_IMAGE"))
+		return NULL;
+
+	f = umr_database_open(path, UMR_DB_IMAGE_NAME, 1);
+	if (!f)
+		return NULL;
+
+	if (fstat(fileno(f), &st) || st.st_size < (off_t)sizeof(*hdr)) {
+		fclose(f);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&images_lock);
+	for (img = images; img; img = img->next) {
+		if (img->dev == st.st_dev && img->ino == st.st_ino && img->size == (uint64_t)st.st_size) {
+			++img->refcnt;
+			pthread_mutex_unlock(&images_lock);
+			fclose(f);
+			return img;
+		}
+	}
+
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	fclose(f);
+	if (base == MAP_FAILED) {
+		pthread_mutex_unlock(&images_lock);
+		return NULL;
+	}
+
+	// only accept images built for this version and byte order
+	hdr = base;
+	if (memcmp(hdr->magic, UMR_DB_IMAGE_MAGIC, 8) ||
+	    hdr->version != UMR_DB_IMAGE_VERSION ||
+	    hdr->endian != UMR_DB_IMAGE_ENDIAN ||
+	    hdr->image_size != (uint64_t)st.st_size) {
+		munmap(base, st.st_size);
+		pthread_mutex_unlock(&images_lock);
+		return NULL;
+	}
+
+	img = calloc(1, sizeof *img);
+	if (!img) {
+		munmap(base, st.st_size);
+		pthread_mutex_unlock(&images_lock);
+		return NULL;
+	}
+	img->base = base;
+	img->size = st.st_size;
+	if (image_check(img)) {
+		munmap(base, st.st_size);
+		free(img);
+		pthread_mutex_unlock(&images_lock);
+		return NULL;
+	}
+	img->dev = st.st_dev;
+	img->ino = st.st_ino;
+	img->refcnt = 1;
+	img->next = images;
+	images = img;
+	pthread_mutex_unlock(&images_lock);
+	return img;
+}
+
+/**
+ * umr_database_image_put - Drop a reference to a database image
+ *
+ * @img: The image to release
+ *
+ * The image is unmapped when the last IP block referencing it is freed.
+ */
+void umr_database_image_put(struct umr_database_image *img)
+{
+	struct umr_database_image **pimg;
+
+	if (!img)
+		return;
+
+	pthread_mutex_lock(&images_lock);
+	if (--img->refcnt == 0) {
+		for (pimg = &images; *pimg; pimg = &(*pimg)->next) {
+			if (*pimg == img) {
+				*pimg = img->next;
+				break;
+			}
+		}
+		munmap((void *)img->base, img->size);
+		free(img);
+	}
+	pthread_mutex_unlock(&images_lock);
+}
+
+/**
+ * image_find - Find the payload for a database file in the image
+ *
+ * @img: The database image
+ * @path: The database path option (may be NULL)
+ * @filename: The database file as it would be passed to umr_database_open()
+ * @type: The type of payload expected
+ * @size: The size of the payload header for @type
+ *
+ * The entry is only used if the text file that would otherwise be
+ * parsed still has the size and modification time recorded when
+ * the image was compiled.  Returns a pointer to the payload or NULL.
+ */
+static const void *image_find(struct umr_database_image *img, char *path, char *filename, enum umr_db_image_type type, size_t size)
+{
+	const struct umr_db_image_header *hdr = (const void *)img->base;
+	const struct umr_db_image_file *files, *df;
+	const char *basename, *relpath;
+	struct stat st;
+	uint32_t lo, hi, mid;
+	int r, flen, rlen;
+	FILE *f;
+
+	basename = strrchr(filename, '/');
+	basename = basename ? basename + 1 : filename;
+
+	// binary search the file table by basename
+	files = (const void *)(img->base + hdr->files_off);
+	df = NULL;
+	lo = 0;
+	hi = hdr->no_files;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		r = strcmp(basename, img_str(img, files[mid].basename));
+		if (!r) {
+			// step back to the first entry with this basename
+			while (mid && !strcmp(basename, img_str(img, files[mid - 1].basename)))
+				--mid;
+			df = &files[mid];
+			break;
+		} else if (r < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	if (!df)
+		return NULL;
+
+	// pick the entry whose relative path is a suffix of the requested name
+	flen = strlen(filename);
+	for (; df < &files[hdr->no_files] && !strcmp(basename, img_str(img, df->basename)); df++) {
+		relpath = img_str(img, df->relpath);
+		rlen = strlen(relpath);
+		if (df->type == type &&
+		    ((rlen <= flen && !strcmp(filename + flen - rlen, relpath) &&
+		      (rlen == flen || filename[flen - rlen - 1] == '/')) ||
+		     (flen < rlen && !strcmp(relpath + rlen - flen, filename))))
+			break;
+	}
+	if (df == &files[hdr->no_files] || strcmp(basename, img_str(img, df->basename)))
+		return NULL;
+
+	// make sure the image isn't stale compared to the text file
+	f = umr_database_open(path, filename, 0);
+	if (!f)
+		return NULL;
+	r = fstat(fileno(f), &st);
+	fclose(f);
+	if (r || (uint64_t)st.st_size != df->src_size || (uint64_t)st.st_mtime != df->src_mtime)
+		return NULL;
+
+	if (!img_range(img, df->off, 1, size))
+		return NULL;
+	return img->base + df->off;
+}
+
+/**
+ * umr_database_image_read_ipblock - Build an IP block from the database image
+ *
+ * @path: The database path option (may be NULL)
+ * @filename: The register file name (e.g. "ip/gc_10_1_0.reg")
+ * @cmnname: The name to give the IP block
+ * @segs: SOC15 segment offsets to add to MMIO registers (may be NULL)
+ * @no_segs: Number of entries in @segs
+ *
+ * The registers and bitfields of the block are placed in a single
+ * allocation and their names point directly into the mapped image.
+ * Returns NULL if no up to date image entry exists in which case the
+ * caller should parse the text file instead.
+ */
+struct umr_ip_block *umr_database_image_read_ipblock(char *path, char *filename, char *cmnname, const uint64_t *segs, int no_segs)
+{
+	struct umr_database_image *img;
+	const struct umr_db_image_regfile *rf;
+	const struct umr_db_image_reg *ir;
+	const struct umr_db_image_bit *ib;
+	struct umr_ip_block *ip;
+	struct umr_bitfield *bits;
+	uint32_t x;
+
+	img = image_get(path);
+	if (!img)
+		return NULL;
+
+	rf = image_find(img, path, filename, UMR_DB_IMAGE_REG, sizeof *rf);
+	if (!rf || !img_range(img, rf->regs_off, rf->no_regs, sizeof *ir) ||
+	    !img_range(img, rf->bits_off, rf->no_bits, sizeof *ib)) {
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	ip = calloc(1, sizeof *ip);
+	if (!ip) {
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	ip->regs = calloc(1, rf->no_regs * sizeof(*(ip->regs)) + rf->no_bits * sizeof(*bits));
+	ip->ipname = strdup(cmnname);
+	if (!ip->regs || !ip->ipname) {
+		free(ip->regs);
+		free(ip->ipname);
+		free(ip);
+		umr_database_image_put(img);
+		return NULL;
+	}
+	ip->no_regs = rf->no_regs;
+	ip->image = img;
+
+	ir = (const void *)(img->base + rf->regs_off);
+	ib = (const void *)(img->base + rf->bits_off);
+	bits = (struct umr_bitfield *)&ip->regs[rf->no_regs];
+	for (x = 0; x < rf->no_bits; x++) {
+		if (!img_str_ok(img, ib[x].name) || ib[x].start > ib[x].stop || ib[x].stop > 63)
+			goto bad;
+		bits[x].regname = (char *)img_str(img, ib[x].name);
+		bits[x].start = ib[x].start;
+		bits[x].stop = ib[x].stop;
+		bits[x].bitfield_print = &umr_bitfield_default;
+	}
+	for (x = 0; x < rf->no_regs; x++) {
+		if (!img_str_ok(img, ir[x].name) || ir[x].first_bit > rf->no_bits ||
+		    ir[x].no_bits > rf->no_bits - ir[x].first_bit)
+			goto bad;
+		ip->regs[x].regname = (char *)img_str(img, ir[x].name);
+		ip->regs[x].type    = ir[x].type;
+		ip->regs[x].addr    = ir[x].addr;
+		if (segs && ip->regs[x].type == REG_MMIO && ir[x].idx < (uint32_t)no_segs)
+			ip->regs[x].addr += segs[ir[x].idx];
+		ip->regs[x].no_bits = ir[x].no_bits;
+		ip->regs[x].bit64   = ir[x].bit64;
+		if (ir[x].no_bits)
+			ip->regs[x].bits = &bits[ir[x].first_bit];
+	}
+
+	// try to parse version out of filename like the text loader does
+	umr_database_fill_ipver_from_path(filename, ip);
+	return ip;
+bad:
+	free(ip->regs);
+	free(ip->ipname);
+	free(ip);
+	umr_database_image_put(img);
+	return NULL;
+}
+
+/**
+ * umr_database_image_read_soc15 - Read a SOC15 offset table from the database image
+ *
+ * @path: The database path option (may be NULL)
+ * @filename: The SOC15 file name (e.g. "navi10.soc15")
+ *
+ * Returns a list in the same form umr_database_read_soc15() produces
+ * or NULL if the image cannot be used.
+ */
+struct umr_soc15_database *umr_database_image_read_soc15(char *path, char *filename)
+{
+	struct umr_database_image *img;
+	const struct umr_db_image_soc15 *isoc;
+	const struct umr_db_image_soc15_ip *iip;
+	struct umr_soc15_database *s, *os;
+	const uint64_t *off;
+	uint32_t x, y;
+
+	img = image_get(path);
+	if (!img)
+		return NULL;
+
+	isoc = image_find(img, path, filename, UMR_DB_IMAGE_SOC15, sizeof *isoc);
+	if (!isoc || !img_range(img, isoc->ips_off, isoc->no_ips, sizeof *iip)) {
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	os = s = calloc(1, sizeof *s);
+	if (!s) {
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	iip = (const void *)(img->base + isoc->ips_off);
+	for (x = 0; x < isoc->no_ips; x++) {
+		if (!img_str_ok(img, iip[x].name) || iip[x].no_seg > UMR_SOC15_MAX_SEG ||
+		    !img_range(img, iip[x].off, (uint64_t)iip[x].no_inst * iip[x].no_seg, sizeof off[0])) {
+			umr_database_free_soc15(os);
+			umr_database_image_put(img);
+			return NULL;
+		}
+		snprintf(s->ipname, sizeof s->ipname, "%s", img_str(img, iip[x].name));
+		off = (const void *)(img->base + iip[x].off);
+		for (y = 0; y < iip[x].no_inst && y < UMR_SOC15_MAX_INST; y++)
+			memcpy(&s->off[y][0], &off[y * iip[x].no_seg], iip[x].no_seg * sizeof off[0]);
+		s->next = calloc(1, sizeof *s);
+		if (!s->next) {
+			umr_database_free_soc15(os);
+			umr_database_image_put(img);
+			return NULL;
+		}
+		s = s->next;
+	}
+	umr_database_image_put(img);
+	return os;
+}
+
+/**
+ * umr_database_image_read_asic - Read an ASIC description from the database image
+ *
+ * @options: The options the ASIC is being created with
+ * @filename: The ASIC file name (e.g. "navi10.asic")
+ * @errout: Callback for error messages
+ *
+ * Returns a fully populated ASIC (IP blocks included) or NULL if the
+ * image cannot be used in which case the caller should parse the text
+ * file instead.
+ */
+struct umr_asic *umr_database_image_read_asic(struct umr_options *options, char *filename, umr_err_output errout)
+{
+	struct umr_database_image *img;
+	const struct umr_db_image_asic *ia;
+	const struct umr_db_image_asic_block *ib;
+	struct umr_soc15_database *soc15;
+	struct umr_asic *asic;
+	int x;
+
+	img = image_get(options->database_path);
+	if (!img)
+		return NULL;
+
+	ia = image_find(img, options->database_path, filename, UMR_DB_IMAGE_ASIC, sizeof *ia);
+	if (!ia || !img_str_ok(img, ia->name) || !img_str_ok(img, ia->soc15name) ||
+	    ia->no_blocks < 0 || !img_range(img, ia->blocks_off, ia->no_blocks, sizeof *ib)) {
+		umr_database_image_put(img);
+		return NULL;
+	}
+	ib = (const void *)(img->base + ia->blocks_off);
+	for (x = 0; x < ia->no_blocks; x++) {
+		if (!img_str_ok(img, ib[x].ipname) || !img_str_ok(img, ib[x].socname) ||
+		    !img_str_ok(img, ib[x].regfile)) {
+			umr_database_image_put(img);
+			return NULL;
+		}
+	}
+
+	if (strcmp(img_str(img, ia->soc15name), "null")) {
+		soc15 = umr_database_read_soc15(options->database_path, (char *)img_str(img, ia->soc15name), errout);
+		if (!soc15) {
+			umr_database_image_put(img);
+			return NULL;
+		}
+	} else {
+		soc15 = NULL;
+	}
+
+	asic = calloc(1, sizeof *asic);
+	if (!asic) {
+		umr_database_free_soc15(soc15);
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	asic->err_msg   = errout;
+	asic->asicname  = strdup(img_str(img, ia->name));
+	asic->options   = *options;
+	asic->no_blocks = ia->no_blocks;
+	asic->family    = ia->family;
+	asic->is_apu    = ia->is_apu;
+	asic->parameters.vgpr_granularity = ia->vgpr_granularity;
+	asic->blocks    = calloc(asic->no_blocks, sizeof(*(asic->blocks)));
+	if (!asic->asicname || (asic->no_blocks && !asic->blocks)) {
+		free(asic->blocks);
+		free(asic->asicname);
+		free(asic);
+		umr_database_free_soc15(soc15);
+		umr_database_image_put(img);
+		return NULL;
+	}
+
+	for (x = 0; x < asic->no_blocks; x++) {
+		asic->blocks[x] = umr_database_read_ipblock(soc15, options->database_path,
+			(char *)img_str(img, ib[x].regfile), (char *)img_str(img, ib[x].ipname),
+			(char *)img_str(img, ib[x].socname), ib[x].instance, errout);
+		if (!asic->blocks[x]) {
+			umr_database_free_soc15(soc15);
+			umr_free_asic_blocks(asic);
+			umr_database_image_put(img);
+			return NULL;
+		}
+	}
+
+	umr_database_free_soc15(soc15);
+	umr_database_image_put(img);
+	return asic;
+}
+
+#else
+
+void umr_database_image_put(struct umr_database_image *img)
+{
+	(void)img;
+}
+
+struct umr_ip_block *umr_database_image_read_ipblock(char *path, char *filename, char *cmnname, const uint64_t *segs, int no_segs)
+{
+	(void)path; (void)filename; (void)cmnname; (void)segs; (void)no_segs;
+	return NULL;
+}
+
+struct umr_soc15_database *umr_database_image_read_soc15(char *path, char *filename)
+{
+	(void)path; (void)filename;
+	return NULL;
+}
+
+struct umr_asic *umr_database_image_read_asic(struct umr_options *options, char *filename, umr_err_output errout)
+{
+	(void)options; (void)filename; (void)errout;
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ */
+#include "umr.h"
+
+/* ==== Shared IP block cache ====
+ *
+ * Systems with several identical GPUs would otherwise parse and hold the
+ * same register tables once per device.  Tables are cached by database
+ * path, register file and the segment offsets that were folded into the
+ * register addresses.  Every ASIC still gets its own umr_ip_block (name,
+ * versioning) but the regs array is shared and must be treated as read
+ * only.  Entries are refcounted and freed with their last user.
+ */
+struct umr_ip_block_cache_entry {
+	char *path, *filename;
+	uint64_t *segs;
+	int no_segs, refcnt;
+	struct umr_ip_block table; // owns the regs (and the image reference)
+	struct umr_ip_block_cache_entry *next;
+};
+
+static struct umr_ip_block_cache_entry *cache;
+
+#if defined(__unix__)
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define cache_lock_acquire() pthread_mutex_lock(&cache_lock)
+#define cache_lock_release() pthread_mutex_unlock(&cache_lock)
+#else
+#define cache_lock_acquire() do { } while (0)
+#define cache_lock_release() do { } while (0)
+#endif
+
+static int entry_matches(struct umr_ip_block_cache_entry *ent, char *path, char *filename, const uint64_t *segs, int no_segs)
+{
+	return !strcmp(ent->path, path ? path : "") &&
+	       !strcmp(ent->filename, filename) &&
+	       ent->no_segs == no_segs &&
+	       (!no_segs || !memcmp(ent->segs, segs, no_segs * sizeof(segs[0])));
+}
+
+/**
+ * umr_database_ip_cache_get - Look up a cached IP block
+ *
+ * @path: The database path option (may be NULL)
+ * @filename: The register file the block is read from
+ * @segs: Segment offsets added to MMIO register addresses (may be NULL)
+ * @no_segs: Number of entries in @segs
+ *
+ * Returns a new IP block which shares the register table of the cached
+ * one, or NULL if there is no match.  The caller sets the name.
+ */
+struct umr_ip_block *umr_database_ip_cache_get(char *path, char *filename, const uint64_t *segs, int no_segs)
+{
+	struct umr_ip_block_cache_entry *ent;
+	struct umr_ip_block *ip;
+
+	if (!segs)
+		no_segs = 0;
+
+	ip = calloc(1, sizeof *ip);
+	if (!ip)
+		return NULL;
+
+	cache_lock_acquire();
+	for (ent = cache; ent; ent = ent->next) {
+		if (entry_matches(ent, path, filename, segs, no_segs)) {
+			++ent->refcnt;
+			break;
+		}
+	}
+	cache_lock_release();
+
+	if (!ent) {
+		free(ip);
+		return NULL;
+	}
+
+	ip->no_regs = ent->table.no_regs;
+	ip->regs = ent->table.regs;
+	ip->discoverable = ent->table.discoverable;
+	ip->shared = ent;
+	return ip;
+}
+
+/**
+ * umr_database_ip_cache_add - Hand a freshly read IP block to the cache
+ *
+ * @path: The database path option (may be NULL)
+ * @filename: The register file the block was read from
+ * @segs: Segment offsets added to MMIO register addresses (may be NULL)
+ * @no_segs: Number of entries in @segs
+ * @ip: The IP block (may be NULL)
+ *
+ * The register table of @ip moves into the cache and @ip keeps a
+ * reference to it.  If the block cannot be cached it is returned
+ * unchanged so this never fails.  Returns @ip.
+ */
+struct umr_ip_block *umr_database_ip_cache_add(char *path, char *filename, const uint64_t *segs, int no_segs, struct umr_ip_block *ip)
+{
+	struct umr_ip_block_cache_entry *ent;
+
+	if (!segs)
+		no_segs = 0;
+	if (!ip || ip->shared)
+		return ip;
+
+	ent = calloc(1, sizeof *ent);
+	if (!ent)
+		return ip;
+	ent->path = strdup(path ? path : "");
+	ent->filename = strdup(filename);
+	ent->segs = calloc(no_segs + 1, sizeof(segs[0]));
+	if (!ent->path || !ent->filename || !ent->segs) {
+		free(ent->path);
+		free(ent->filename);
+		free(ent->segs);
+		free(ent);
+		return ip;
+	}
+	if (no_segs)
+		memcpy(ent->segs, segs, no_segs * sizeof(segs[0]));
+	ent->no_segs = no_segs;
+	ent->refcnt = 1;
+	ent->table = *ip;
+	ent->table.ipname = NULL;
+
+	ip->image = NULL;
+	ip->shared = ent;
+
+	cache_lock_acquire();
+	ent->next = cache;
+	cache = ent;
+	cache_lock_release();
+	return ip;
+}
+
+/**
+ * umr_database_ip_cache_put - Drop a reference to a cached register table
+ *
+ * @ent: The cache entry (from ip->shared)
+ */
+void umr_database_ip_cache_put(struct umr_ip_block_cache_entry *ent)
+{
+	struct umr_ip_block_cache_entry **pent;
+
+	cache_lock_acquire();
+	if (--ent->refcnt) {
+		cache_lock_release();
+		return;
+	}
+	for (pent = &cache; *pent; pent = &(*pent)->next) {
+		if (*pent == ent) {
+			*pent = ent->next;
+			break;
+		}
+	}
+	cache_lock_release();
+
+	umr_free_ip_block_regs(&ent->table);
+	free(ent->path);
+	free(ent->filename);
+	free(ent->segs);
+	free(ent);
+}
@@ -24,12 +24,38 @@
 
 #include "umr.h"
 
+/**
+ * @brief Decides whether a candidate is a closer version match than the best so far.
+ *
+ * @param si The candidate (same IP name and major version as requested).
+ * @param best The best match so far (may be NULL).
+ * @param min The requested minor version.
+ * @param rev The requested revision.
+ * @return Non-zero if @si should replace @best.
+ */
+static int closer_match(struct umr_database_scan_item *si, struct umr_database_scan_item *best, int min, int rev)
+{
+	if (!best)
+		return 1;
+	if (min >= si->min) {
+		if (min - si->min < min - best->min || min < best->min)
+			return 1;
+		if (min - si->min == min - best->min)
+			if (rev >= si->rev && (rev - si->rev < rev - best->rev || rev < best->rev))
+				return 1;
+	}
+	return 0;
+}
+
 /**
  * @brief Finds an IP in the database that matches the specified criteria.
  *
  * This function searches through a linked list of database scan items to find an item that matches
  * the given IP name, major version, minor version, and revision. It also optionally filters by a desired path.
  *
+ * Lists made by umr_database_scan() are searched through their IP name hash
+ * table, other lists are searched item by item.
+ *
  * @param db Pointer to the head of the database scan item list.
  * @param ipname The name of the IP to search for.
  * @param maj The major version number of the IP.
@@ -46,27 +72,19 @@ struct umr_database_scan_item *umr_database_find_ip(
 {
 	struct umr_database_scan_item *si, *best;
 
-	si = db;
 	best = NULL;
-	while (si) {
-		if (!desired_path ||
-		    (desired_path && strstr(si->path, desired_path))) {
-			if (!strcmp(ipname, si->ipname)) {
-				if (maj == si->maj) {
-					if (!best) {
-						best = si;
-					} else if (min >= si->min) {
-						if (min - si->min < min - best->min || min < best->min) {
-							best = si;
-						} else if (min - si->min == min - best->min) {
-							if (rev >= si->rev && (rev - si->rev < rev - best->rev || rev < best->rev))
-								best = si;
-						}
-					}
-				}
-			}
-		}
-		si = si->next;
+	if (db && db->ip_hash) {
+		// only visit the items with this name
+		for (si = umr_database_scan_find_ipname(db, ipname); si; si = si->next_ip)
+			if ((!desired_path || strstr(si->path, desired_path)) &&
+			    maj == si->maj && closer_match(si, best, min, rev))
+				best = si;
+	} else {
+		for (si = db; si; si = si->next)
+			if ((!desired_path || strstr(si->path, desired_path)) &&
+			    !strcmp(ipname, si->ipname) &&
+			    maj == si->maj && closer_match(si, best, min, rev))
+				best = si;
 	}
 	if (!best && desired_path)
 		return umr_database_find_ip(db, ipname, maj, min, rev, NULL);
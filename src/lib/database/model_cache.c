@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <unistd.h>
+
+/* ==== Persistent ASIC model cache ====
+ *
+ * Assembling an ASIC model from the IP discovery table means scanning
+ * every database directory, matching each discovered IP against the
+ * register files and renaming multi-instance blocks.  The outcome only
+ * depends on the discovery table and the database tree so it is saved
+ * to a small text file keyed by a hash of both.  A later run on the same
+ * board reads the register files named in the snapshot directly.
+ *
+ * A snapshot is only used if every database directory and every
+ * register file it names still has the size and mtime it was saved
+ * with.  The cache is on by default and creates $XDG_CACHE_HOME/umr (or
+ * ~/.cache/umr) on first use.  Set UMR_NO_MODEL_CACHE to bypass it and
+ * UMR_MODEL_CACHE to store it somewhere else.
+ */
+#define MODEL_MAGIC "UMRMODEL"
+#define MODEL_VERSION 1
+
+static uint64_t fnv_bytes(uint64_t h, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--)
+		h = (h ^ *p++) * 0x100000001b3ULL;
+	return h;
+}
+
+static uint64_t fnv_str(uint64_t h, const char *s)
+{
+	// include the terminator so "ab" "c" and "a" "bc" differ
+	return fnv_bytes(h, s ? s : "", s ? strlen(s) + 1 : 1);
+}
+
+/**
+ * umr_database_model_key - Compute the cache key of an ASIC model
+ *
+ * @asicname: The name the model will be given
+ * @options: The options the model is created with
+ * @det: The IP discovery table the model is assembled from
+ *
+ * The key covers every field of the discovery table as well as the
+ * options and environment that select which database files match and
+ * the version of umr that matched them.
+ */
+uint64_t umr_database_model_key(const char *asicname, struct umr_options *options, struct umr_discovery_table_entry *det)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int v[7];
+
+	h = fnv_bytes(h, MODEL_MAGIC, 8);
+	v[0] = MODEL_VERSION;
+	h = fnv_bytes(h, v, sizeof v[0]);
+	// another build may match IP blocks to register files differently
+	h = fnv_str(h, UMR_BUILD_VER);
+	h = fnv_str(h, UMR_BUILD_REV);
+	h = fnv_str(h, asicname);
+	h = fnv_str(h, options->database_path);
+	h = fnv_str(h, options->desired_path);
+	h = fnv_str(h, getenv("UMR_DATABASE_PATH"));
+	for (; det; det = det->next) {
+		h = fnv_str(h, det->ipname);
+		v[0] = det->die;
+		v[1] = det->instance;
+		v[2] = det->maj;
+		v[3] = det->min;
+		v[4] = det->rev;
+		v[5] = det->logical_inst;
+		v[6] = det->harvest;
+		h = fnv_bytes(h, v, sizeof v);
+		h = fnv_bytes(h, det->segments, sizeof det->segments);
+	}
+	return h;
+}
+
+/**
+ * umr_database_cache_filename - Find a file in a umr cache directory
+ *
+ * @fname: Receives the path
+ * @size: Size of @fname
+ * @dir: The directory to use instead of the default one (can be NULL)
+ * @subdir: Subdirectory of the default directory (can be NULL)
+ * @name: The name of the file in the cache directory
+ * @create: Create the cache directory if it does not exist
+ *
+ * The default directory is $XDG_CACHE_HOME/umr or ~/.cache/umr.
+ *
+ * Returns 0 on success or -1 if the cache has no home.
+ */
+int umr_database_cache_filename(char *fname, size_t size, const char *dir, const char *subdir, const char *name, int create)
+{
+	char root[512];
+	const char *e;
+
+	if (dir) {
+		snprintf(root, sizeof root, "%s", dir);
+	} else {
+		if ((e = getenv("XDG_CACHE_HOME"))) {
+			snprintf(root, sizeof root, "%s/umr", e);
+		} else if ((e = getenv("HOME"))) {
+			snprintf(root, sizeof root, "%s/.cache", e);
+			if (create)
+				mkdir(root, 0755);
+			snprintf(root, sizeof root, "%s/.cache/umr", e);
+		} else {
+			return -1;
+		}
+		if (subdir) {
+			if (create)
+				mkdir(root, 0755);
+			snprintf(root + strlen(root), sizeof root - strlen(root), "/%s", subdir);
+		}
+	}
+	if (create)
+		mkdir(root, 0755);
+
+	snprintf(fname, size, "%s/%s", root, name);
+	return 0;
+}
+
+static int model_filename(char *fname, size_t size, uint64_t key, int create)
+{
+	char name[32];
+
+	if (getenv("UMR_NO_MODEL_CACHE"))
+		return -1;
+	snprintf(name, sizeof name, "model-%016" PRIx64, key);
+	return umr_database_cache_filename(fname, size, getenv("UMR_MODEL_CACHE"), NULL, name, create);
+}
+
+static int64_t path_mtime(const char *path, int64_t *size)
+{
+	struct stat st;
+
+	if (stat(path, &st))
+		return -1;
+	if (size)
+		*size = st.st_size;
+	return st.st_mtime;
+}
+
+/**
+ * write_dirs - Record the mtime of a database directory and its subdirectories
+ *
+ * Adding or removing a register file changes the mtime of the directory
+ * it lives in which invalidates any snapshot that recorded it.
+ */
+static void write_dirs(FILE *f, const char *path, int depth)
+{
+	DIR *dir;
+	struct dirent *di;
+	char p[512];
+
+	fprintf(f, "dir %" PRId64 " %s\n", path_mtime(path, NULL), path);
+	if (depth > 8 || !(dir = opendir(path)))
+		return;
+	while ((di = readdir(dir))) {
+		if (di->d_type == DT_DIR && strcmp(di->d_name, ".") && strcmp(di->d_name, "..")) {
+			snprintf(p, sizeof p, "%s/%s", path, di->d_name);
+			write_dirs(f, p, depth + 1);
+		}
+	}
+	closedir(dir);
+}
+
+/**
+ * umr_database_model_save - Save an assembled ASIC model
+ *
+ * @options: The options the model was created with
+ * @model: The model to save
+ *
+ * The roots searched are the same as for umr_database_scan().
+ * Returns 0 on success.
+ */
+int umr_database_model_save(struct umr_options *options, struct umr_database_model *model)
+{
+	char fname[600], tmpname[640], p[512];
+	struct umr_database_model_block *b;
+	int64_t size, mtime;
+	FILE *f;
+	int x, y;
+
+	if (model_filename(fname, sizeof fname, model->key, 1))
+		return -1;
+
+	// write to a private file first so concurrent readers never see half a snapshot
+	snprintf(tmpname, sizeof tmpname, "%s.%d", fname, (int)getpid());
+	f = fopen(tmpname, "w");
+	if (!f)
+		return -1;
+
+	fprintf(f, "%s %d %016" PRIx64 " %d\n", MODEL_MAGIC, MODEL_VERSION, model->key, model->no_blocks);
+	if (options->database_path[0])
+		write_dirs(f, options->database_path, 0);
+	if (getenv("UMR_DATABASE_PATH"))
+		write_dirs(f, getenv("UMR_DATABASE_PATH"), 0);
+#ifdef UMR_DB_DIR
+	write_dirs(f, UMR_DB_DIR, 0);
+#endif
+	snprintf(p, sizeof p, "%s/database/", UMR_SOURCE_DIR);
+	write_dirs(f, p, 0);
+
+	for (x = 0; x < model->no_blocks; x++) {
+		b = &model->blocks[x];
+		mtime = path_mtime(b->fname, &size);
+		if (mtime < 0)
+			goto error;
+		fprintf(f, "block %s %s %d %d %d %d %d %d %" PRId64 " %" PRId64,
+			b->ipname, b->det.ipname, b->det.die, b->det.instance,
+			b->det.maj, b->det.min, b->det.rev, b->det.logical_inst,
+			size, mtime);
+		for (y = 0; y < 32; y++)
+			fprintf(f, " %" PRIx64, b->det.segments[y]);
+		fprintf(f, " %s\n", b->fname);
+	}
+	if (fclose(f) || rename(tmpname, fname)) {
+		unlink(tmpname);
+		return -1;
+	}
+	return 0;
+error:
+	fclose(f);
+	unlink(tmpname);
+	return -1;
+}
+
+/**
+ * umr_database_model_load - Load a saved ASIC model
+ *
+ * @key: The key computed by umr_database_model_key()
+ *
+ * Returns the model if there is an up to date snapshot for @key
+ * and NULL otherwise.
+ */
+struct umr_database_model *umr_database_model_load(uint64_t key)
+{
+	char fname[600], linebuf[2048], magic[16], path[512];
+	struct umr_database_model *model;
+	struct umr_database_model_block *b;
+	int64_t size, mtime, cursize;
+	uint64_t fkey;
+	int version, no_blocks, y, n;
+	char *p;
+	FILE *f;
+
+	if (model_filename(fname, sizeof fname, key, 0))
+		return NULL;
+	f = fopen(fname, "r");
+	if (!f)
+		return NULL;
+
+	model = NULL;
+	if (!fgets(linebuf, sizeof linebuf, f) ||
+	    sscanf(linebuf, "%15s %d %" SCNx64 " %d", magic, &version, &fkey, &no_blocks) != 4 ||
+	    strcmp(magic, MODEL_MAGIC) || version != MODEL_VERSION || fkey != key ||
+	    no_blocks <= 0)
+		goto error;
+
+	model = calloc(1, sizeof *model);
+	if (!model)
+		goto error;
+	model->key = key;
+	model->blocks = calloc(no_blocks, sizeof model->blocks[0]);
+	if (!model->blocks)
+		goto error;
+
+	while (fgets(linebuf, sizeof linebuf, f)) {
+		linebuf[strcspn(linebuf, "\n")] = 0;
+		if (sscanf(linebuf, "dir %" SCNd64 " %511[^\n]", &mtime, path) == 2) {
+			if (path_mtime(path, NULL) != mtime)
+				goto error;
+		} else if (!memcmp(linebuf, "block ", 6)) {
+			if (model->no_blocks == no_blocks)
+				goto error;
+			b = &model->blocks[model->no_blocks];
+			if (sscanf(linebuf, "block %127s %127s %d %d %d %d %d %d %" SCNd64 " %" SCNd64 "%n",
+				   b->ipname, b->det.ipname, &b->det.die, &b->det.instance,
+				   &b->det.maj, &b->det.min, &b->det.rev, &b->det.logical_inst,
+				   &size, &mtime, &n) != 10)
+				goto error;
+			p = linebuf + n;
+			for (y = 0; y < 32; y++) {
+				if (sscanf(p, " %" SCNx64 "%n", &b->det.segments[y], &n) != 1)
+					goto error;
+				p += n;
+			}
+			if (*p++ != ' ' || !*p || strlen(p) >= sizeof b->fname)
+				goto error;
+			strcpy(b->fname, p);
+			if (path_mtime(b->fname, &cursize) != mtime || cursize != size)
+				goto error;
+			++model->no_blocks;
+		} else {
+			goto error;
+		}
+	}
+	if (model->no_blocks != no_blocks)
+		goto error;
+	fclose(f);
+	return model;
+error:
+	fclose(f);
+	umr_database_model_free(model);
+	return NULL;
+}
+
+/**
+ * umr_database_model_free - Free a model returned by umr_database_model_load()
+ */
+void umr_database_model_free(struct umr_database_model *model)
+{
+	if (model) {
+		free(model->blocks);
+		free(model);
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+
+/* ==== PCI device ID table ====
+ *
+ * pci.did maps a PCI device ID to the name of the ASIC (or .asic file)
+ * to use for it.  The file is parsed once per database path into an
+ * array sorted by device ID and looked up with a binary search.
+ * Tables live until the process exits.
+ */
+struct did_entry {
+	uint32_t did, line;
+	char name[128];
+};
+
+struct did_table {
+	char *path;
+	struct did_entry *entries;
+	uint32_t no_entries;
+	struct did_table *next;
+};
+
+static struct did_table *tables;
+
+#if defined(__unix__)
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+#define tables_lock_acquire() pthread_mutex_lock(&tables_lock)
+#define tables_lock_release() pthread_mutex_unlock(&tables_lock)
+#else
+#define tables_lock_acquire() do { } while (0)
+#define tables_lock_release() do { } while (0)
+#endif
+
+static int sort_did(const void *A, const void *B)
+{
+	const struct did_entry *a = A, *b = B;
+	if (a->did != b->did)
+		return a->did > b->did ? 1 : -1;
+	// keep duplicates in file order, the first one wins
+	return a->line > b->line ? 1 : (a->line < b->line ? -1 : 0);
+}
+
+/**
+ * load_table - Parse pci.did into a sorted table
+ *
+ * @path: The database path option (may be NULL)
+ *
+ * Returns NULL if pci.did cannot be found.
+ */
+static struct did_table *load_table(char *path)
+{
+	struct did_table *t;
+	struct did_entry *e;
+	char linebuf[256];
+	uint32_t size = 0;
+	FILE *f;
+
+	f = umr_database_open(path, "pci.did", 0);
+	if (!f)
+		return NULL;
+
+	t = calloc(1, sizeof *t);
+	if (!t)
+		goto error;
+	t->path = strdup(path ? path : "");
+
+	while (fgets(linebuf, sizeof linebuf, f)) {
+		if (t->no_entries == size) {
+			size = size ? size * 2 : 256;
+			e = realloc(t->entries, size * sizeof *e);
+			if (!e)
+				goto error;
+			t->entries = e;
+		}
+		e = &t->entries[t->no_entries];
+		if (sscanf(linebuf, "%"SCNx32" %127s", &e->did, e->name) == 2) {
+			e->line = t->no_entries++;
+		}
+	}
+	fclose(f);
+
+	qsort(t->entries, t->no_entries, sizeof t->entries[0], sort_did);
+	return t;
+error:
+	fclose(f);
+	if (t) {
+		free(t->entries);
+		free(t->path);
+		free(t);
+	}
+	return NULL;
+}
+
+/**
+ * umr_database_did_lookup - Find the ASIC name for a PCI device ID
+ *
+ * @path: The database path option (may be NULL)
+ * @did: The PCI device ID to look up
+ * @name: Receives the name from pci.did (e.g. "navi10.asic") if not NULL
+ * @size: Size of @name
+ *
+ * Returns 1 if @did was found, 0 if it was not and -1 if pci.did
+ * could not be found (or read) at all.
+ */
+int umr_database_did_lookup(char *path, uint32_t did, char *name, int size)
+{
+	struct did_table *t;
+	uint32_t bot, mid, top;
+
+	tables_lock_acquire();
+	for (t = tables; t; t = t->next)
+		if (!strcmp(t->path, path ? path : ""))
+			break;
+	if (!t) {
+		t = load_table(path);
+		if (!t) {
+			tables_lock_release();
+			return -1;
+		}
+		t->next = tables;
+		tables = t;
+	}
+	tables_lock_release();
+
+	bot = 0;
+	top = t->no_entries;
+	while (bot < top) {
+		mid = (bot + top) >> 1;
+		if (t->entries[mid].did < did)
+			bot = mid + 1;
+		else
+			top = mid;
+	}
+	if (bot < t->no_entries && t->entries[bot].did == did) {
+		if (name && size > 0)
+			snprintf(name, size, "%s", t->entries[bot].name);
+		return 1;
+	}
+	return 0;
+}
@@ -58,6 +58,10 @@ struct umr_asic *umr_database_read_asic(struct umr_options *options, char *filen
 		int family, numblocks, vgpr_granularity, is_apu;
 	} asic_fields;
 
+	asic = umr_database_image_read_asic(options, filename, errout);
+	if (asic)
+		return asic;
+
 	f = umr_database_open(options->database_path, filename, 0);
 	if (!f) {
 		return NULL;
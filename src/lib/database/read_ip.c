@@ -27,7 +27,7 @@
 // We try to parse paths like "my_ip/sdma0_4_0_0.reg" to major, minor, and
 // revision version number. We also accept paths like "gc_5_0.reg" to parse into
 // just major and minor version numbers.
-static void fill_ipver_from_path(char* ip_path, struct umr_ip_block* ip_block) {
+void umr_database_fill_ipver_from_path(char* ip_path, struct umr_ip_block* ip_block) {
 	char* (pos[3]) = {NULL};
 	int len = strlen(ip_path);
 	int i;
@@ -76,6 +76,7 @@ static void fill_ipver_from_path(char* ip_path, struct umr_ip_block* ip_block) {
 struct umr_ip_block *umr_database_read_ipblock(struct umr_soc15_database *soc15, char *path, char *filename, char *cmnname, char *soc15name, int inst, umr_err_output errout)
 {
 	struct umr_ip_block *ip;
+	const uint64_t *segs;
 	FILE *f;
 	uint32_t no_regs;
 	int x;
@@ -94,6 +95,20 @@ struct umr_ip_block *umr_database_read_ipblock(struct umr_soc15_database *soc15,
 		}
 	}
 
+	segs = soc15 ? &soc15->off[inst][0] : NULL;
+
+	// another ASIC may already have read the same table
+	ip = umr_database_ip_cache_get(path, filename, segs, UMR_SOC15_MAX_SEG);
+	if (ip) {
+		ip->ipname = strdup(cmnname);
+		return ip;
+	}
+
+	// use the precompiled image if there is an up to date one
+	ip = umr_database_image_read_ipblock(path, filename, cmnname, segs, UMR_SOC15_MAX_SEG);
+	if (ip)
+		return umr_database_ip_cache_add(path, filename, segs, UMR_SOC15_MAX_SEG, ip);
+
 	f = umr_database_open(path, filename, 0);
 	if (!f) {
 		errout("[ERROR]: IP register file [%s] not found\n", filename);
@@ -116,7 +131,7 @@ struct umr_ip_block *umr_database_read_ipblock(struct umr_soc15_database *soc15,
 
 	// try to parse version out of filename (assume path has no spaces)
 	if (sscanf(filename, "%s", linebuf)) {
-		fill_ipver_from_path(linebuf, ip);
+		umr_database_fill_ipver_from_path(linebuf, ip);
 	}
 
 	x = 0;
@@ -163,5 +178,5 @@ struct umr_ip_block *umr_database_read_ipblock(struct umr_soc15_database *soc15,
 		++x;
 	}
 	fclose(f);
-	return ip;
+	return umr_database_ip_cache_add(path, filename, segs, UMR_SOC15_MAX_SEG, ip);
 }
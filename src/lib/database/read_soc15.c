@@ -68,6 +68,10 @@ struct umr_soc15_database *umr_database_read_soc15(char *path, char *filename, u
 	char linebuf[1024];
 	int x, segs;
 
+	os = umr_database_image_read_soc15(path, filename);
+	if (os)
+		return os;
+
 	f = umr_database_open(path, filename, 0);
 	if (!f) {
 		errout("[ERROR]: SOC15 offset file [%s] not found\n", filename);
@@ -23,14 +23,55 @@
  */
 
 #include "umr.h"
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <time.h>
+#include <unistd.h>
 
-static int umr_do_scan(struct umr_database_scan_item *it, char *path)
+/* ==== Database scan index ====
+ *
+ * Scanning the database means opening every directory of every
+ * database root.  The result only changes when a directory changes so
+ * it is saved to an index file together with the mtime of every
+ * directory that was scanned.  The next scan of the same roots loads
+ * the index instead if none of those directories changed, and
+ * regenerates it otherwise.
+ *
+ * The index lives in the "scan" subdirectory of the umr cache directory
+ * (see umr_database_cache_filename()), apart from the ASIC models.  Set
+ * UMR_NO_SCAN_INDEX to always scan and UMR_SCAN_INDEX to keep the index
+ * in another directory.
+ */
+#define SCAN_INDEX_MAGIC "UMRSCAN"
+#define SCAN_INDEX_VERSION 1
+
+struct scan_index {
+	FILE *f;
+	int fresh;      // a directory changed too recently for its mtime to be trusted
+};
+
+static int64_t dir_mtime(const char *path)
+{
+	struct stat st;
+
+	if (stat(path, &st))
+		return -1;
+	return st.st_mtime;
+}
+
+static int umr_do_scan(struct umr_database_scan_item *it, char *path, struct scan_index *idx)
 {
 	DIR *dir;
 	struct dirent *di;
 
+	if (idx->f) {
+		int64_t mtime = dir_mtime(path);
+		fprintf(idx->f, "dir %" PRId64 " %s\n", mtime, path);
+		if (mtime >= (int64_t)time(NULL) - 1)
+			idx->fresh = 1;
+	}
+
 	dir = opendir(path);
 	if (!dir)
 		return 0;
@@ -45,11 +86,15 @@ static int umr_do_scan(struct umr_database_scan_item *it, char *path)
 			int r;
 			char p[512];
 			sprintf(p, "%s/%s", path, di->d_name);
-			r = umr_do_scan(it, p);
+			r = umr_do_scan(it, p, idx);
 			if (r) {
 				closedir(dir);
 				return r;
 			}
+			// the subdirectory appended to the list
+			while (it->next) {
+				it = it->next;
+			}
 		}
 		if (strstr(di->d_name, ".reg")) { // we only care about register files
 			strcpy(it->path, path);
@@ -76,6 +121,159 @@ static int umr_do_scan(struct umr_database_scan_item *it, char *path)
 	return 0;
 }
 
+static uint32_t ipname_hash(const char *ipname)
+{
+	uint32_t h = 2166136261UL;
+
+	while (*ipname)
+		h = (h ^ (uint8_t)*ipname++) * 16777619UL;
+	return h;
+}
+
+/**
+ * @brief Builds the ipname hash table used by umr_database_find_ip().
+ *
+ * Every slot holds the first item of one ipname and the items of that
+ * ipname are chained through next_ip in list order.  The table hangs
+ * off the head of the list.
+ *
+ * @param head The head of the list.
+ * @return 0 on success, -1 if out of memory (the list still works, just unindexed).
+ */
+static int build_ip_hash(struct umr_database_scan_item *head)
+{
+	struct umr_database_scan_item *it, **tails;
+	uint32_t n, size, mask, slot;
+
+	for (n = 0, it = head; it; it = it->next)
+		++n;
+	for (size = 16; size < 2 * n; size <<= 1);
+	mask = size - 1;
+
+	head->ip_hash = calloc(size, sizeof head->ip_hash[0]);
+	tails = calloc(size, sizeof tails[0]);
+	if (!head->ip_hash || !tails) {
+		free(head->ip_hash);
+		free(tails);
+		head->ip_hash = NULL;
+		return -1;
+	}
+	head->ip_hash_size = size;
+
+	for (it = head; it; it = it->next) {
+		for (slot = ipname_hash(it->ipname) & mask;
+		     head->ip_hash[slot] && strcmp(head->ip_hash[slot]->ipname, it->ipname);
+		     slot = (slot + 1) & mask);
+		if (!head->ip_hash[slot])
+			head->ip_hash[slot] = it;
+		else
+			tails[slot]->next_ip = it;
+		tails[slot] = it;
+	}
+	free(tails);
+	return 0;
+}
+
+/**
+ * @brief Finds the first item with a given ipname through the hash table.
+ *
+ * @param head The head of a list made by umr_database_scan().
+ * @param ipname The IP name to look up.
+ * @return The first item (follow next_ip for the rest) or NULL if there is none.
+ */
+struct umr_database_scan_item *umr_database_scan_find_ipname(struct umr_database_scan_item *head, const char *ipname)
+{
+	uint32_t mask, slot;
+
+	mask = head->ip_hash_size - 1;
+	for (slot = ipname_hash(ipname) & mask; head->ip_hash[slot]; slot = (slot + 1) & mask)
+		if (!strcmp(head->ip_hash[slot]->ipname, ipname))
+			return head->ip_hash[slot];
+	return NULL;
+}
+
+/**
+ * @brief Loads a scan from an index file.
+ *
+ * @param head The (empty) head of the list to fill.
+ * @param fname The index file.
+ * @return 0 on success, -1 if the index is missing, malformed or out of date.
+ */
+static int load_index(struct umr_database_scan_item *head, const char *fname)
+{
+	struct umr_database_scan_item *it;
+	char *buf, *line, *next, ipname[128];
+	int64_t mtime;
+	long size;
+	int version, n, r = -1;
+	FILE *f;
+
+	f = fopen(fname, "r");
+	if (!f)
+		return -1;
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	rewind(f);
+	buf = size > 0 ? malloc(size + 1) : NULL;
+	if (!buf || fread(buf, 1, size, f) != (size_t)size) {
+		free(buf);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	buf[size] = 0;
+
+	it = head;
+	line = buf;
+	next = strchr(line, '\n');
+	if (!next || sscanf(line, SCAN_INDEX_MAGIC " %d", &version) != 1 || version != SCAN_INDEX_VERSION)
+		goto done;
+
+	for (line = next + 1; *line; line = next + 1) {
+		next = strchr(line, '\n');
+		if (!next)
+			goto done;
+		*next = 0;
+		if (!memcmp(line, "dir ", 4)) {
+			if (sscanf(line, "dir %" SCNd64 " %n", &mtime, &n) != 1 || dir_mtime(line + n) != mtime)
+				goto done;
+		} else if (!memcmp(line, "reg ", 4)) {
+			if (sscanf(line, "reg %d %d %d %127s %127s %n", &it->maj, &it->min, &it->rev, ipname, it->fname, &n) != 5 ||
+			    strlen(line + n) >= sizeof it->path)
+				goto done;
+			strcpy(it->ipname, strcmp(ipname, "-") ? ipname : "");
+			strcpy(it->path, line + n);
+			it->next = calloc(1, sizeof *it);
+			if (!it->next)
+				goto done;
+			it = it->next;
+		} else {
+			goto done;
+		}
+	}
+	r = 0;
+done:
+	free(buf);
+	if (r) {
+		umr_database_free_scan_items(head->next);
+		memset(head, 0, sizeof *head);
+	}
+	return r;
+}
+
+/**
+ * @brief Writes the register file part of a scan index.
+ */
+static void write_index_items(FILE *f, struct umr_database_scan_item *it)
+{
+	for (; it; it = it->next) {
+		if (!it->fname[0])
+			continue;
+		fprintf(f, "reg %d %d %d %s %s %s\n", it->maj, it->min, it->rev,
+			it->ipname[0] ? it->ipname : "-", it->fname, it->path);
+	}
+}
+
 /**
  * @brief Scans directories for register files and populates a database scan item list.
  *
@@ -88,47 +286,80 @@ static int umr_do_scan(struct umr_database_scan_item *it, char *path)
  * `umr_database_scan_item` containing details such as the file path, name, IP name,
  * major, minor, and revision numbers.
  *
+ * The result is taken from the scan index in the umr cache directory when none
+ * of the scanned directories changed since it was written.  The head of the list
+ * carries a hash table of IP names used by umr_database_find_ip().
+ *
  * @param path The initial directory path to start scanning. If NULL or empty, the function
  *             will attempt to use other sources specified by environment variables and defaults.
  * @return A pointer to the head of the linked list containing scan items, or NULL if an error occurs.
  */
 struct umr_database_scan_item *umr_database_scan(char *path)
 {
-	int r;
+	int r, x, no_roots;
 	struct umr_database_scan_item *it, *pit;
-	char p[512];
+	struct scan_index idx;
+	char p[512], *roots[4], name[32], fname[600], tmpname[640];
+	uint32_t h;
 
 	pit = it = calloc(1, sizeof *it);
 	if (!it) {
 		return NULL;
 	}
 
-	if (path && *path) {
-		r = umr_do_scan(it, path);
-		if (r)
-			goto error;
+	// the roots in search order
+	no_roots = 0;
+	if (path && *path)
+		roots[no_roots++] = path;
+	path = getenv("UMR_DATABASE_PATH");
+	if (path)
+		roots[no_roots++] = path;
+#ifdef UMR_DB_DIR
+	roots[no_roots++] = UMR_DB_DIR;
+#endif
+	sprintf(p, "%s/database/", UMR_SOURCE_DIR);
+	roots[no_roots++] = p;
+
+	// the index is named after the roots it covers
+	h = 2166136261UL;
+	for (x = 0; x < no_roots; x++)
+		h = (ipname_hash(roots[x]) ^ h) * 16777619UL;
+	snprintf(name, sizeof name, "scan-%08" PRIx32, h);
+
+	memset(&idx, 0, sizeof idx);
+	if (!getenv("UMR_NO_SCAN_INDEX") &&
+	    !umr_database_cache_filename(fname, sizeof fname, getenv("UMR_SCAN_INDEX"), "scan", name, 0)) {
+		if (!load_index(pit, fname)) {
+			build_ip_hash(pit);
+			return pit;
+		}
+		if (!umr_database_cache_filename(fname, sizeof fname, getenv("UMR_SCAN_INDEX"), "scan", name, 1)) {
+			snprintf(tmpname, sizeof tmpname, "%s.%d", fname, (int)getpid());
+			idx.f = fopen(tmpname, "w");
+			if (idx.f)
+				fprintf(idx.f, "%s %d\n", SCAN_INDEX_MAGIC, SCAN_INDEX_VERSION);
+		}
 	}
 
-	path = getenv("UMR_DATABASE_PATH");
-	if (path) {
-		r = umr_do_scan(it, path);
+	for (x = 0; x < no_roots; x++) {
+		r = umr_do_scan(it, roots[x], &idx);
 		if (r)
 			goto error;
 	}
 
-#ifdef UMR_DB_DIR
-	r = umr_do_scan(it, UMR_DB_DIR);
-	if (r)
-		goto error;
-#endif
-
-	sprintf(p, "%s/database/", UMR_SOURCE_DIR);
-	r = umr_do_scan(it, p);
-	if (r)
-		goto error;
+	if (idx.f) {
+		write_index_items(idx.f, pit);
+		if (fclose(idx.f) || idx.fresh || rename(tmpname, fname))
+			unlink(tmpname);
+	}
 
-	return it;
+	build_ip_hash(pit);
+	return pit;
 error:
+	if (idx.f) {
+		fclose(idx.f);
+		unlink(tmpname);
+	}
 	while (pit) {
 		it = pit->next;
 		free(pit);
@@ -80,12 +80,11 @@ static int find_first_did(long did, long start_instance)
 struct umr_asic *umr_discover_asic_by_did(struct umr_options *options, long did, umr_err_output errout, int *tryipdiscovery)
 {
 	struct umr_asic *asic;
-	FILE *f;
-	char linebuf[128], lname[128];
-	uint32_t ldid;
+	char lname[128];
+	int r;
 
-	f = umr_database_open(options->database_path, "pci.did", 0);
-	if (!f) {
+	r = umr_database_did_lookup(options->database_path, did, lname, sizeof lname);
+	if (r < 0) {
 		errout("[ERROR]: Can't find [pci.did] file in database, required to map PCI DID to name\n");
 		errout("[ERROR]: The file [pci.did] is found in the source tree at 'database/pci.did'\n");
 		errout("[ERROR]: Without this file non-IP discovery ASICs cannot be instantiated.\n");
@@ -93,27 +92,19 @@ struct umr_asic *umr_discover_asic_by_did(struct umr_options *options, long did,
 		return NULL;
 	}
 
-	*tryipdiscovery = 1;
+	*tryipdiscovery = !r;
 	asic = NULL;
-	while (fgets(linebuf, sizeof linebuf, f)) {
-		sscanf(linebuf, "%"SCNx32" %s", &ldid, lname);
-		if (ldid == did && strstr(lname, ".asic")) {
-			*tryipdiscovery = 0;
-			if (options->force_asic_file) {
-				asic = umr_database_read_asic(options, lname, errout);
-			} else {
-				asic = umr_discover_asic_by_discovery_table(lname, options, errout);
-				if (!asic)
-					asic = umr_database_read_asic(options, lname, errout);
-			}
-			break;
-		} else if (ldid == did) {
-			*tryipdiscovery = 0;
+	if (r && strstr(lname, ".asic")) {
+		if (options->force_asic_file) {
+			asic = umr_database_read_asic(options, lname, errout);
+		} else {
 			asic = umr_discover_asic_by_discovery_table(lname, options, errout);
-			break;
+			if (!asic)
+				asic = umr_database_read_asic(options, lname, errout);
 		}
+	} else if (r) {
+		asic = umr_discover_asic_by_discovery_table(lname, options, errout);
 	}
-	fclose(f);
 
 	if (asic) {
 		asic->did = did;
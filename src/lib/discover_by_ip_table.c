@@ -30,38 +30,14 @@
 #include <stdlib.h>
 
 /**
- * read_ip_block - Create and populate an IP block based on IP discovery/Database matching
+ * set_ip_names - Copy IP discovery versioning and naming to an IP block
  *
- * @asic: The ASIC the IP block is meant to be attached to
+ * @ip: The IP block being created
  * @det: The IP discovery entry being parsed
- * @nit: The database item matched to this block
- *
- * Returns a pointer to a umr_ip_block structure on success.
  */
-static struct umr_ip_block *read_ip_block(struct umr_asic *asic, struct umr_discovery_table_entry *det, struct umr_database_scan_item *nit)
+static void set_ip_names(struct umr_ip_block *ip, struct umr_discovery_table_entry *det)
 {
-	FILE *f;
-	char ipcmn[256], linebuf[512];
-	uint32_t no_regs, x;
-	struct umr_ip_block *ip;
-
-	snprintf(linebuf, (sizeof linebuf) - 1, "%s/%s", nit->path, nit->fname);
-	f = fopen(linebuf, "r");
-	if (!f) {
-		asic->err_msg("Could not open file %s\n", linebuf);
-		return NULL;
-	}
-	ip = calloc(1, sizeof *ip);
-	if (!ip) {
-		fclose(f);
-		return NULL;
-	}
-
-	// the first line has the number of registers
-	fgets(linebuf, sizeof(linebuf) - 1, f);
-	sscanf(linebuf, "%"SCNu32, &no_regs);
-	ip->no_regs = no_regs;
-	ip->regs = calloc(no_regs, sizeof(*(ip->regs)));
+	char ipcmn[256];
 
 	// copy over the IP discovery versioning to this IP block
 	// so we can have more precise versioning info since the database
@@ -99,6 +75,57 @@ static struct umr_ip_block *read_ip_block(struct umr_asic *asic, struct umr_disc
 		snprintf(ipname, sizeof ipname - 1, "%s%d%d%d", ipcmn, det->maj, det->min, det->rev);
 		ip->ipname = strdup(ipname);
 	}
+}
+
+/**
+ * read_ip_block - Create and populate an IP block based on IP discovery/Database matching
+ *
+ * @asic: The ASIC the IP block is meant to be attached to
+ * @det: The IP discovery entry being parsed
+ * @fname: The database register file matched to this block
+ *
+ * Returns a pointer to a umr_ip_block structure on success.
+ */
+static struct umr_ip_block *read_ip_block(struct umr_asic *asic, struct umr_discovery_table_entry *det, char *fname)
+{
+	FILE *f;
+	char linebuf[512];
+	uint32_t no_regs, x;
+	struct umr_ip_block *ip;
+
+	// identical GPUs share the register table
+	ip = umr_database_ip_cache_get(asic->options.database_path, fname, det->segments, 32);
+	if (ip) {
+		set_ip_names(ip, det);
+		return ip;
+	}
+
+	// use the precompiled image if there is an up to date one
+	ip = umr_database_image_read_ipblock(asic->options.database_path, fname, "", det->segments, 32);
+	if (ip) {
+		free(ip->ipname);
+		set_ip_names(ip, det);
+		return umr_database_ip_cache_add(asic->options.database_path, fname, det->segments, 32, ip);
+	}
+
+	f = fopen(fname, "r");
+	if (!f) {
+		asic->err_msg("Could not open file %s\n", fname);
+		return NULL;
+	}
+	ip = calloc(1, sizeof *ip);
+	if (!ip) {
+		fclose(f);
+		return NULL;
+	}
+
+	// the first line has the number of registers
+	fgets(linebuf, sizeof(linebuf) - 1, f);
+	sscanf(linebuf, "%"SCNu32, &no_regs);
+	ip->no_regs = no_regs;
+	ip->regs = calloc(no_regs, sizeof(*(ip->regs)));
+
+	set_ip_names(ip, det);
 
 	// parse the IP database file for this block
 	x = 0;
@@ -149,7 +176,7 @@ static struct umr_ip_block *read_ip_block(struct umr_asic *asic, struct umr_disc
 		++x;
 	}
 	fclose(f);
-	return ip;
+	return umr_database_ip_cache_add(asic->options.database_path, fname, det->segments, 32, ip);
 }
 
 /**
@@ -250,10 +277,12 @@ static struct umr_discovery_table_entry *import_det_from_log(struct umr_options
 struct umr_asic *umr_discover_asic_by_discovery_table(char *aname, struct umr_options *options, umr_err_output errout)
 {
 	struct umr_discovery_table_entry *det = NULL, *pdet = NULL;
-	struct umr_database_scan_item *it, *nit;
+	struct umr_database_scan_item *it = NULL, *nit;
+	struct umr_database_model *model;
 	int numblocks, used_blocks, x, y;
+	uint64_t key;
 	struct umr_asic *asic;
-	char asicname[128], *dasic;
+	char asicname[128], fname[512], *dasic;
 	struct export_data {
 		struct umr_discovery_table_entry *det;
 		struct umr_database_scan_item *nit;
@@ -284,9 +313,6 @@ struct umr_asic *umr_discover_asic_by_discovery_table(char *aname, struct umr_op
 		dump_discovery_to_log(det, options);
 	}
 
-	// create database of IP
-	it = umr_database_scan(options->database_path);
-
 	asic = calloc(1, sizeof *asic);
 	if (!asic) {
 		errout("[ERROR]: Out of memory allocating ASIC model\n");
@@ -304,7 +330,36 @@ struct umr_asic *umr_discover_asic_by_discovery_table(char *aname, struct umr_op
 
 	asic->err_msg = errout;
 
+	// a board we have seen before can skip the database scan
 	pdet = det;
+	key = umr_database_model_key(asicname, options, det);
+	model = options->export_model ? NULL : umr_database_model_load(key);
+	if (model && model->no_blocks <= numblocks) {
+		for (x = 0; x < model->no_blocks; x++) {
+			if (options->verbose)
+				errout("[VERBOSE]: Using %s (cached) for %s\n", model->blocks[x].fname, model->blocks[x].ipname);
+			asic->blocks[x] = read_ip_block(asic, &model->blocks[x].det, model->blocks[x].fname);
+			if (asic->blocks[x]) {
+				free(asic->blocks[x]->ipname);
+				asic->blocks[x]->ipname = strdup(model->blocks[x].ipname);
+			}
+		}
+		asic->no_blocks = model->no_blocks;
+		umr_database_model_free(model);
+		goto done;
+	}
+	umr_database_model_free(model);
+
+	// remember which file each block came from so the model can be cached
+	model = calloc(1, sizeof *model);
+	if (model) {
+		model->key = key;
+		model->blocks = calloc(numblocks, sizeof model->blocks[0]);
+	}
+
+	// create database of IP
+	it = umr_database_scan(options->database_path);
+
 	used_blocks = 0;
 	while (det) {
 		char cmnname[256];
@@ -347,10 +402,15 @@ struct umr_asic *umr_discover_asic_by_discovery_table(char *aname, struct umr_op
 				errout("[VERBOSE]: Using %s/%s (%d.%d.%d) for %s (%d.%d.%d)\n",
 					nit->path, nit->fname, nit->maj, nit->min, nit->rev,
 					det->ipname, det->maj, det->min, det->rev);
-                        if (!det->harvest)
-                                asic->blocks[used_blocks++] =
-                                    read_ip_block(asic, det, nit);
-                }
+			if (!det->harvest) {
+				snprintf(fname, sizeof fname, "%s/%s", nit->path, nit->fname);
+				if (model && model->blocks) {
+					model->blocks[used_blocks].det = *det;
+					strcpy(model->blocks[used_blocks].fname, fname);
+				}
+				asic->blocks[used_blocks++] = read_ip_block(asic, det, fname);
+			}
+		}
 		det = det->next;
 	}
 	asic->no_blocks = used_blocks - 1;
@@ -374,6 +434,15 @@ struct umr_asic *umr_discover_asic_by_discovery_table(char *aname, struct umr_op
 		}
 	}
 
+	if (model && model->blocks && asic->no_blocks > 0) {
+		for (x = 0; x < asic->no_blocks && asic->blocks[x]; x++)
+			snprintf(model->blocks[x].ipname, sizeof model->blocks[x].ipname, "%s", asic->blocks[x]->ipname);
+		model->no_blocks = x;
+		if (x == asic->no_blocks)
+			umr_database_model_save(options, model);
+	}
+	umr_database_model_free(model);
+
 	// optionally we can export the model we discovered as a static ASIC model
 	if (options->export_model) {
 		FILE *fexp;
@@ -77,6 +77,97 @@ static int expression_matches(const char* str, const char* pattern)
 	return !*pattern;
 }
 
+/**
+ * block_matches - Check if an IP block is eligible for a register search
+ *
+ * @asic: The ASIC the block belongs to
+ * @i: The index of the IP block
+ * @ip: The optional IP block name prefix
+ * @inst: The instance being searched for (see umr_find_reg_data_by_ip_by_instance_with_ip())
+ * @instname: The "{inst}" string for @inst
+ */
+static int block_matches(struct umr_asic *asic, int i, const char *ip, int inst, const char *instname)
+{
+	// optionally require the ip block name to partially match (allows for ignoring version numbers)
+	if (ip && (strlen(asic->blocks[i]->ipname) >= strlen(ip) && memcmp(asic->blocks[i]->ipname, ip, strlen(ip))))
+		return 0;
+
+	// if we are looking for an instance require the {inst} as well
+	if (inst >= 0 && !strstr(asic->blocks[i]->ipname, instname))
+		return 0;
+
+	// if we are not looking for an instance skip over IP blocks with an instance
+	// this is mostly to catch UMR bugs that don't forward say
+	// --vm-partition to a register function on partitioned hosts
+	if (inst < 0 && inst != -2 && strstr(asic->blocks[i]->ipname, "{"))
+		return 0;
+
+	return 1;
+}
+
+/**
+ * find_reg_by_block - Search every eligible IP block for a register
+ *
+ * Binary searches the (sorted) register list of each eligible IP block
+ * in order and returns the first match.
+ */
+static struct umr_reg *find_reg_by_block(struct umr_asic *asic, const char *ip, int inst, const char *instname, const char *regname, struct umr_ip_block **ipp)
+{
+	int i, bot, top, mid, diff;
+
+	for (i = 0; i < asic->no_blocks; i++) {
+		if (!block_matches(asic, i, ip, inst, instname))
+			continue;
+
+		bot = 0;
+		top = asic->blocks[i]->no_regs;
+		while (bot < top) {
+			mid = (bot + top) >> 1;
+			diff = istr_cmp(asic->blocks[i]->regs[mid].regname, regname);
+			if (diff < 0) {
+				// needle is above mid
+				bot = mid + 1;
+			} else {
+				// needle is below or equal to mid
+				top = mid;
+			}
+		}
+		if (bot < asic->blocks[i]->no_regs && !istr_cmp(asic->blocks[i]->regs[bot].regname, regname)) {
+			if (ipp)
+				*ipp = asic->blocks[i];
+			return &asic->blocks[i]->regs[bot];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * find_reg_indexed - Search the register name index for a register
+ *
+ * Same as find_reg_by_block() but uses the hash table built by
+ * umr_create_reg_index().  Entries with the same name are probed in
+ * IP block order so the first eligible one is the same register
+ * find_reg_by_block() would return.
+ */
+static struct umr_reg *find_reg_indexed(struct umr_asic *asic, const char *ip, int inst, const char *instname, const char *regname, struct umr_ip_block **ipp)
+{
+	uint32_t h, mask, slot;
+	struct umr_reg_index_entry *e;
+
+	h = umr_reg_index_hash(regname);
+	mask = asic->reg_index_size - 1;
+	for (slot = h & mask; asic->reg_index[slot].reg; slot = (slot + 1) & mask) {
+		e = &asic->reg_index[slot];
+		if (e->hash == h && !istr_cmp(e->reg->regname, regname) &&
+		    block_matches(asic, e->block, ip, inst, instname)) {
+			if (ipp)
+				*ipp = asic->blocks[e->block];
+			return e->reg;
+		}
+	}
+	return NULL;
+}
+
 /**
  * umr_find_reg_wild_first - Initiate a wildcard iterative search
  *
@@ -210,6 +301,7 @@ struct umr_reg* umr_find_reg_data_by_ip_by_instance_with_ip(struct umr_asic* asi
 	int i, k;
 	char origname[96], tmpregname[96], instname[16];
 	const char *oregname = regname;
+	struct umr_reg *reg;
 
 	strcpy(origname, regname);
 
@@ -229,42 +321,12 @@ struct umr_reg* umr_find_reg_data_by_ip_by_instance_with_ip(struct umr_asic* asi
 
 	oregname = regname;
 retry:
-	for (i = 0; i < asic->no_blocks; i++) {
-		// optionally require the ip block name to partially match (allows for ignoring version numbers)
-		if (ip && (strlen(asic->blocks[i]->ipname) >= strlen(ip) && memcmp(asic->blocks[i]->ipname, ip, strlen(ip))))
-			continue;
-
-		// if we are looking for an instance require the {inst} as well
-		if (inst >= 0 && !strstr(asic->blocks[i]->ipname, instname))
-			continue;
-
-		// if we are not looking for an instance skip over IP blocks with an instance
-		// this is mostly to catch UMR bugs that don't forward say
-		// --vm-partition to a register function on partitioned hosts
-		if (inst < 0 && inst != -2 && strstr(asic->blocks[i]->ipname, "{"))
-			continue;
-		{
-			int bot, top, mid, diff;
-			bot = 0;
-			top = asic->blocks[i]->no_regs;
-			while (bot < top) {
-				mid = (bot + top) >> 1;
-				diff = istr_cmp(asic->blocks[i]->regs[mid].regname, regname);
-				if (diff < 0) {
-					// needle is above mid
-					bot = mid + 1;
-				} else {
-					// needle is below or equal to mid
-					top = mid;
-				}
-			}
-			if (bot < asic->blocks[i]->no_regs && !istr_cmp(asic->blocks[i]->regs[bot].regname, regname)) {
-				if (ipp)
-					*ipp = asic->blocks[i];
-				return &asic->blocks[i]->regs[bot];
-			}
-		}
-	}
+	if (asic->reg_index)
+		reg = find_reg_indexed(asic, ip, inst, instname, regname, ipp);
+	else
+		reg = find_reg_by_block(asic, ip, inst, instname, regname, ipp);
+	if (reg)
+		return reg;
 
 	// if regname starts with 'mm' search for variant with 'reg' prefix
 	// this avoids having to recode a lot of logic.
@@ -359,13 +421,19 @@ struct umr_reg* umr_find_reg_by_addr(struct umr_asic* asic, uint64_t addr, struc
  * umr_reg_name - Construct a human readable name for a register
  *
  * Returns a human readable name including IP and register name
- * to the caller based on the address specified.
+ * to the caller based on the address specified.  Names of registers
+ * in the PM4 register windows come from a table that is formatted
+ * once and stay valid until the ASIC is freed.
  */
 char* umr_reg_name(struct umr_asic* asic, uint64_t addr)
 {
 	struct umr_reg* reg;
 	struct umr_ip_block* ip;
 	static char name[512];
+	const char *tname;
+
+	if (!umr_reg_name_table_lookup(asic, addr, &tname))
+		return tname ? (char *)tname : "<unknown>";
 
 	reg = umr_find_reg_by_addr(asic, addr, &ip);
 	if (ip && reg) {
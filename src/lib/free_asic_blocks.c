@@ -24,28 +24,56 @@
  */
 #include "umr.h"
 
+/**
+ * umr_free_ip_block_regs - Free the register table of an IP block
+ *
+ * @ip: The IP block, its name and the block itself are not freed
+ */
+void umr_free_ip_block_regs(struct umr_ip_block *ip)
+{
+	int y, z;
+
+	if (ip->image) {
+		// names live in the image and the bitfields share the regs allocation
+		umr_database_image_put(ip->image);
+	} else {
+		for (y = 0; y < ip->no_regs; y++) {
+			free(ip->regs[y].regname);
+			for (z = 0; z < ip->regs[y].no_bits; z++) {
+				free(ip->regs[y].bits[z].regname);
+			}
+			free(ip->regs[y].bits);
+		}
+	}
+	free(ip->regs);
+}
+
 /**
  * umr_free_asic - Free memory associated with an @asic device
  */
 void umr_free_asic_blocks(struct umr_asic *asic)
 {
-	int x, y, z;
+	int x;
 	for (x = 0; x < asic->no_blocks; x++) {
 		if (asic->blocks[x]) {
-			for (y = 0; y < asic->blocks[x]->no_regs; y++) {
-				free(asic->blocks[x]->regs[y].regname);
-				for (z = 0; z < asic->blocks[x]->regs[y].no_bits; z++) {
-					free(asic->blocks[x]->regs[y].bits[z].regname);
-				}
-				free(asic->blocks[x]->regs[y].bits);
-			}
+			if (asic->blocks[x]->shared)
+				umr_database_ip_cache_put(asic->blocks[x]->shared);
+			else
+				umr_free_ip_block_regs(asic->blocks[x]);
 			free(asic->blocks[x]->ipname);
-			free(asic->blocks[x]->regs);
 		}
 		free(asic->blocks[x]);
 	}
 	free(asic->blocks);
 	free(asic->mmio_accel);
+	free(asic->reg_index);
+	umr_free_reg_name_table(asic);
+	umr_free_bit_index(asic);
+	umr_wave_fields_free(asic);
+	umr_vm_cache_free(asic);
+	umr_shader_cache_free(asic);
+	umr_shader_disasm_free(asic);
+	umr_ring_poll_close(asic);
 	free(asic->asicname);
 	free(asic);
 }
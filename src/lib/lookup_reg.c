@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+#include <inttypes.h>
+
+/**
+ * lookup_by_address - Find every MMIO register at an address
+ *
+ * Uses the sorted asic->mmio_accel table when it exists.  Registers
+ * that share an address are passed to @cb in database order either way.
+ *
+ * Returns the number of registers found.
+ */
+static int lookup_by_address(struct umr_asic *asic, uint32_t regno, uint32_t num, umr_reg_lookup_cb cb, void *data)
+{
+	uint32_t bot, mid, top;
+	int i, j, n = 0;
+
+	if (asic->mmio_accel) {
+		bot = 0;
+		top = asic->mmio_accel_size;
+		while (bot < top) {
+			mid = (bot + top) >> 1;
+			if (asic->mmio_accel[mid].mmio_addr < regno)
+				bot = mid + 1;
+			else
+				top = mid;
+		}
+		for (; bot < asic->mmio_accel_size && asic->mmio_accel[bot].mmio_addr == regno; bot++, n++)
+			cb(asic, asic->mmio_accel[bot].ip, asic->mmio_accel[bot].reg, num, data);
+		return n;
+	}
+
+	for (i = 0; i < asic->no_blocks; i++)
+		for (j = 0; j < asic->blocks[i]->no_regs; j++)
+			if (asic->blocks[i]->regs[j].type == REG_MMIO &&
+			    asic->blocks[i]->regs[j].addr == regno) {
+				cb(asic, asic->blocks[i], &asic->blocks[i]->regs[j], num, data);
+				++n;
+			}
+	return n;
+}
+
+/**
+ * lookup_by_name - Find an MMIO register by IP block and register name
+ *
+ * Both names must match exactly.  Uses the asic->reg_index hash table
+ * when it exists.
+ *
+ * Returns the number of registers found.
+ */
+static int lookup_by_name(struct umr_asic *asic, const char *ipname, const char *regname, uint32_t num, umr_reg_lookup_cb cb, void *data)
+{
+	uint32_t h, mask, slot;
+	struct umr_reg_index_entry *e;
+	int i, j, n = 0;
+
+	if (asic->reg_index) {
+		h = umr_reg_index_hash(regname);
+		mask = asic->reg_index_size - 1;
+		for (slot = h & mask; asic->reg_index[slot].reg; slot = (slot + 1) & mask) {
+			e = &asic->reg_index[slot];
+			if (e->hash == h && e->reg->type == REG_MMIO &&
+			    !strcmp(e->reg->regname, regname) &&
+			    !strcmp(asic->blocks[e->block]->ipname, ipname)) {
+				cb(asic, asic->blocks[e->block], e->reg, num, data);
+				++n;
+			}
+		}
+		return n;
+	}
+
+	for (i = 0; i < asic->no_blocks; i++)
+		if (!strcmp(asic->blocks[i]->ipname, ipname))
+			for (j = 0; j < asic->blocks[i]->no_regs; j++)
+				if (asic->blocks[i]->regs[j].type == REG_MMIO &&
+				    !strcmp(asic->blocks[i]->regs[j].regname, regname)) {
+					cb(asic, asic->blocks[i], &asic->blocks[i]->regs[j], num, data);
+					++n;
+				}
+	return n;
+}
+
+/**
+ * umr_lookup_reg_value - Find the registers a value was read from
+ *
+ * @asic: The ASIC whose register database is used
+ * @address: A 0x prefixed MMIO address or an ipname.regname string
+ * @num: The register value
+ * @cb: Called for every register that matches
+ * @data: Passed to @cb
+ *
+ * Registers that share an address are all passed to @cb in database
+ * order.
+ *
+ * Returns the number of registers found or -1 if @address is neither
+ * a 0x prefixed address nor an ipname.regname string.
+ */
+int umr_lookup_reg_value(struct umr_asic *asic, const char *address, uint32_t num, umr_reg_lookup_cb cb, void *data)
+{
+	char ipname[256], *p;
+	uint32_t regno;
+
+	if (sscanf(address, "0x%"SCNx32, &regno) == 1)
+		return lookup_by_address(asic, regno, num, cb, data);
+
+	p = strstr(address, ".");
+	if (!p || (size_t)(p - address) >= sizeof ipname)
+		return -1;
+	memcpy(ipname, address, p - address);
+	ipname[p - address] = 0;
+	return lookup_by_name(asic, ipname, p + 1, num, cb, data);
+}
+
+/**
+ * umr_lookup_reg_batch - Find the registers of a stream of values
+ *
+ * @asic: The ASIC whose register database is used
+ * @f: The stream to read from
+ * @cb: Called for every register that matches
+ * @data: Passed to @cb
+ *
+ * Each line of @f holds an address (with 0x prefix) or an
+ * ipname.regname string followed by a value in hex, separated by
+ * white space, '=', ':' or ','.  Blank lines and lines starting
+ * with '#' are skipped.  Lines that do not match a register are
+ * reported with asic->err_msg and the rest of the stream is still
+ * processed.
+ *
+ * Returns the number of lines that did not decode.
+ */
+int umr_lookup_reg_batch(struct umr_asic *asic, FILE *f, umr_reg_lookup_cb cb, void *data)
+{
+	static const char *sep = " \t\r\n=:,";
+	char line[512], *address, *value, *save;
+	unsigned long lineno = 0;
+	uint32_t num;
+	int bad = 0, r;
+
+	while (fgets(line, sizeof line, f)) {
+		++lineno;
+		address = strtok_r(line, sep, &save);
+		if (!address || address[0] == '#')
+			continue;
+		value = strtok_r(NULL, sep, &save);
+		if (!value || sscanf(value, "%"SCNx32, &num) != 1) {
+			asic->err_msg("[ERROR]: Line %lu: missing value for '%s'\n", lineno, address);
+			++bad;
+			continue;
+		}
+		r = umr_lookup_reg_value(asic, address, num, cb, data);
+		if (r <= 0) {
+			asic->err_msg("[ERROR]: Line %lu: unknown register '%s'\n", lineno, address);
+			++bad;
+		}
+	}
+	return bad;
+}
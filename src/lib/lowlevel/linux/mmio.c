@@ -197,7 +197,7 @@ static uint32_t umr_smc_write(struct umr_asic *asic, uint64_t addr, uint32_t val
 }
 
 // this sends the grbm/srbm data up based on flags...
-static int mmio2_apply_bank(struct umr_asic *asic)
+static int mmio2_set_state(struct umr_asic *asic)
 {
 	struct amdgpu_debugfs_regs2_iocdata id;
 	struct amdgpu_debugfs_regs2_iocdata_v2 id_v2;
@@ -257,6 +257,25 @@ static int mmio2_apply_bank(struct umr_asic *asic)
 	return ioctl(asic->fd.mmio2, AMDGPU_DEBUGFS_REGS2_IOC_SET_STATE, &id);
 }
 
+// the state is held per open file so only send it when it changes
+static int mmio2_apply_bank(struct umr_asic *asic)
+{
+	struct umr_bank_state bs;
+	int r;
+
+	umr_get_bank_state(asic, &bs);
+	if (asic->mmio2_bank.valid && !umr_bank_state_cmp(&bs, &asic->mmio2_bank.state))
+		return 0;
+
+	asic->mmio2_bank.valid = 0;
+	r = mmio2_set_state(asic);
+	if (!r) {
+		asic->mmio2_bank.state = bs;
+		asic->mmio2_bank.valid = 1;
+	}
+	return r;
+}
+
 /** @brief Reads a register by address, applying bank selection if necessary.
  *
  * @param asic Pointer to the umr_asic structure containing ASIC information.
@@ -303,11 +322,7 @@ uint32_t umr_read_reg(struct umr_asic *asic, uint64_t addr, enum regclass type)
 						asic->err_msg("[ERROR]: Could not set register IOCTL state\n");
 						return 0;
 					}
-					if (lseek(asic->fd.mmio2, addr, SEEK_SET) < 0) {
-						asic->err_msg("[ERROR]: Cannot seek to MMIO address for read\n");
-						return 0;
-					}
-					if (read(asic->fd.mmio2, &value, 4) != 4) {
+					if (pread(asic->fd.mmio2, &value, 4, addr) != 4) {
 						asic->err_msg("[ERROR]: Cannot read from MMIO reg\n");
 						return 0;
 					}
@@ -395,10 +410,7 @@ int umr_write_reg(struct umr_asic *asic, uint64_t addr, uint32_t value, enum reg
 						asic->err_msg("[ERROR]: Could not set register IOCTL state\n");
 						return 0;
 					}
-					if (lseek(asic->fd.mmio2, addr, SEEK_SET) < 0) {
-						asic->err_msg("[ERROR]: Cannot seek to MMIO address\n");
-						r = -1;
-					} else if (write(asic->fd.mmio2, &value, 4) != 4) {
+					if (pwrite(asic->fd.mmio2, &value, 4, addr) != 4) {
 						asic->err_msg("[ERROR]: Cannot write to MMIO reg\n");
 						r = -1;
 					}
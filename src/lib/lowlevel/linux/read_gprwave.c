@@ -42,6 +42,24 @@ enum AMDGPU_DEBUGFS_GPRWAVE_CMDS {
 };
 #define AMDGPU_DEBUGFS_GPRWAVE_IOC_SET_STATE _IOWR(0x20, AMDGPU_DEBUGFS_GPRWAVE_CMD_SET_STATE, struct amdgpu_debugfs_gprwave_iocdata)
 
+/**
+ * gprwave_set_iocdata - Fill in the gprwave state selecting a GPR read
+ */
+static void gprwave_set_iocdata(struct umr_asic *asic, struct amdgpu_debugfs_gprwave_iocdata *id, int v_or_s,
+				uint32_t thread, uint32_t se, uint32_t sh, uint32_t cu, uint32_t wave, uint32_t simd)
+{
+	memset(id, 0, sizeof *id);
+	id->gpr_or_wave = 1;
+	id->se = se;
+	id->sh = sh;
+	id->cu = cu;
+	id->wave = wave;
+	id->simd = asic->family < FAMILY_NV ? simd : 0;
+	id->gpr.thread = v_or_s ? thread : 0;
+	id->gpr.vpgr_or_sgpr = v_or_s;
+	id->xcc_id = asic->options.vm_partition == -1 ? 0 : asic->options.vm_partition;
+}
+
 /**
  * @brief Reads GPR or wave data from a specified GPU resource.
  *
@@ -70,56 +88,27 @@ int umr_linux_read_gpr_gprwave_raw(struct umr_asic *asic, int v_or_s,
 	struct amdgpu_debugfs_gprwave_iocdata id;
 	int r = 0;
 
-	memset(&id, 0, sizeof id);
-	id.gpr_or_wave = 1;
-	if (asic->family < FAMILY_NV) {
-		id.se = se;
-		id.sh = sh;
-		id.cu = cu;
-		id.wave = wave;
-		id.simd = simd;
-
-		if (v_or_s == 0) {
-			id.gpr.thread = 0;
-		} else {
-			id.gpr.thread = thread;
-		}
-	} else {
-		id.se = se;
-		id.sh = sh;
-		id.cu = cu;
-		id.wave = wave;
-		id.simd = 0;
-		if (v_or_s == 0) {
-			id.gpr.thread = 0;
-		} else {
-			id.gpr.thread = thread;
-		}
-	}
-	id.gpr.vpgr_or_sgpr = v_or_s;
-	id.xcc_id = asic->options.vm_partition == -1 ? 0 : asic->options.vm_partition;
+	gprwave_set_iocdata(asic, &id, v_or_s, thread, se, sh, cu, wave, simd);
 
 	r = ioctl(asic->fd.gprwave, AMDGPU_DEBUGFS_GPRWAVE_IOC_SET_STATE, &id);
 	if (r)
 		return r;
 
-	lseek(asic->fd.gprwave, offset, SEEK_SET);
-	return read(asic->fd.gprwave, dst, size);
+	return pread(asic->fd.gprwave, dst, size, offset);
 }
 
-// TODO: hoist id/lseek/read calls into raw function out of this function
-static int read_gpr_gprwave(struct umr_asic *asic, int v_or_s, uint32_t thread, struct umr_wave_data *wd, uint32_t *dst)
+/**
+ * gprwave_wave_params - Find where a wave lives and how many bytes of GPRs it has
+ */
+static void gprwave_wave_params(struct umr_asic *asic, int v_or_s, struct umr_wave_data *wd,
+				uint32_t *se, uint32_t *sh, uint32_t *cu, uint32_t *wave, uint32_t *simd, uint32_t *size)
 {
-	uint32_t se, sh, cu, wave, simd, size;
-	int r = 0;
-	uint64_t addr = 0;
-
 	if (asic->family < FAMILY_NV) {
-		se = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SE_ID");
-		sh = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SH_ID");
-		cu = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "CU_ID");
-		wave = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID");
-		simd = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID");
+		*se = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SE_ID);
+		*sh = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SH_ID);
+		*cu = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_CU_ID);
+		*wave = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID);
+		*simd = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID);
 
 		if (v_or_s == 0) {
 			uint32_t shift;
@@ -127,31 +116,72 @@ static int read_gpr_gprwave(struct umr_asic *asic, int v_or_s, uint32_t thread,
 				shift = 3;  // on SI..CIK allocations were done in 8-dword blocks
 			else
 				shift = 4;  // on VI allocations are in 16-dword blocks
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "SGPR_SIZE") + 1) << shift);
+			*size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE) + 1) << shift);
 		} else {
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << asic->parameters.vgpr_granularity);
+			*size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity);
 		}
 	} else {
 #if 0
-		se = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SE_ID");
-		sh = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SA_ID");
-		cu = ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WGP_ID") << 2) | umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID"));
-		wave = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID");
-		simd = 0;
+		*se = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SE_ID);
+		*sh = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SA_ID);
+		*cu = ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WGP_ID) << 2) | umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID));
+		*wave = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID);
+		*simd = 0;
 #else
-		se = wd->se;
-		sh = wd->sh;
-		cu = (wd->cu << 2) | wd->simd;
-		simd = 0;
-		wave = wd->wave;
+		*se = wd->se;
+		*sh = wd->sh;
+		*cu = (wd->cu << 2) | wd->simd;
+		*simd = 0;
+		*wave = wd->wave;
 #endif
 
 		if (v_or_s == 0) {
-			size = 4 * 124; // regular SGPRs, VCC, and TTMPs
+			*size = 4 * 124; // regular SGPRs, VCC, and TTMPs
 		} else {
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << asic->parameters.vgpr_granularity);
+			*size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity);
 		}
 	}
+}
+
+/**
+ * gprwave_log - Dump GPRs that were read to the test harness log file
+ *
+ * @addr: The harness address the GPRs are recorded under
+ * @nbytes: The number of bytes that were read
+ */
+static void gprwave_log(struct umr_asic *asic, int v_or_s, uint64_t addr, uint32_t *dst, int nbytes)
+{
+	int x;
+
+	fprintf(asic->options.test_log_fd, "%cGPR@0x%"PRIx64" = { ", "SV"[v_or_s], addr);
+	for (x = 0; x < nbytes; x += 4) {
+		fprintf(asic->options.test_log_fd, "0x%"PRIx32, dst[x/4]);
+		if (x < (nbytes - 4))
+			fprintf(asic->options.test_log_fd, ", ");
+	}
+	fprintf(asic->options.test_log_fd, "}\n");
+}
+
+static uint64_t gprwave_log_addr(int v_or_s, uint32_t thread, uint32_t se, uint32_t sh, uint32_t cu, uint32_t wave, uint32_t simd)
+{
+	return
+		((v_or_s ? 0ULL : 1ULL) << 60) | // reading SGPRs
+		((uint64_t)0)                  | // starting address to read from
+		((uint64_t)se << 12)        |
+		((uint64_t)sh << 20)        |
+		((uint64_t)cu << 28)        |
+		((uint64_t)wave << 36)      |
+		((uint64_t)simd << 44)      |
+		((uint64_t)thread << 52ULL); // thread_id
+}
+
+static int read_gpr_gprwave(struct umr_asic *asic, int v_or_s, uint32_t thread, struct umr_wave_data *wd, uint32_t *dst)
+{
+	uint32_t se, sh, cu, wave, simd, size;
+	int r = 0;
+	uint64_t addr = 0;
+
+	gprwave_wave_params(asic, v_or_s, wd, &se, &sh, &cu, &wave, &simd, &size);
 
 	r = umr_linux_read_gpr_gprwave_raw(asic, v_or_s, thread, se, sh, cu, wave, simd, 0, size, dst);
 	if (r < 0)
@@ -159,45 +189,20 @@ static int read_gpr_gprwave(struct umr_asic *asic, int v_or_s, uint32_t thread,
 
 	// if we are reading SGPRS then optionally dump them
 	// and then read TRAP registers if necessary
-	if (asic->options.test_log && asic->options.test_log_fd) {
-		int x;
+	// we use addr for test logging
+	addr = gprwave_log_addr(v_or_s, thread, se, sh, cu, wave, simd);
+	if (asic->options.test_log && asic->options.test_log_fd)
+		gprwave_log(asic, v_or_s, addr, dst, r);
 
-		// we use addr for test logging
-		addr =
-			((v_or_s ? 0ULL : 1ULL) << 60) | // reading SGPRs
-			((uint64_t)0)                  | // starting address to read from
-			((uint64_t)se << 12)        |
-			((uint64_t)sh << 20)        |
-			((uint64_t)cu << 28)        |
-			((uint64_t)wave << 36)      |
-			((uint64_t)simd << 44)      |
-			((uint64_t)thread << 52ULL); // thread_id
-
-		fprintf(asic->options.test_log_fd, "%cGPR@0x%"PRIx64" = { ", "SV"[v_or_s], addr);
-		for (x = 0; x < r; x += 4) {
-			fprintf(asic->options.test_log_fd, "0x%"PRIx32, dst[x/4]);
-			if (x < (r - 4))
-				fprintf(asic->options.test_log_fd, ", ");
-		}
-		fprintf(asic->options.test_log_fd, "}\n");
-	}
-
-	// TODO: hoist trap to _raw
+	// the trap temporaries are only there when the wave status says so, which
+	// _raw can't see as it only gets the wave's location
 	if (v_or_s == 0 && size < (4*0x6C)) {
 		// read trap if any
 		if (umr_wave_data_get_flag_trap_en(asic, wd) || umr_wave_data_get_flag_priv(asic, wd)) {
 			r = umr_linux_read_gpr_gprwave_raw(asic, v_or_s, thread, se, sh, cu, wave, simd, 4 * 0x6C, size, &dst[0x6C]);
 			if (r > 0) {
-				if (asic->options.test_log && asic->options.test_log_fd) {
-					int x;
-					fprintf(asic->options.test_log_fd, "SGPR@0x%"PRIx64" = { ", addr + 0x6C * 4);
-					for (x = 0; x < r; x += 4) {
-						fprintf(asic->options.test_log_fd, "0x%"PRIx32, dst[0x6C + x/4]);
-						if (x < (r - 4))
-							fprintf(asic->options.test_log_fd, ", ");
-					}
-					fprintf(asic->options.test_log_fd, "}\n");
-				}
+				if (asic->options.test_log && asic->options.test_log_fd)
+					gprwave_log(asic, v_or_s, addr + 0x6C * 4, &dst[0x6C], r);
 			}
 		}
 	}
@@ -205,6 +210,39 @@ static int read_gpr_gprwave(struct umr_asic *asic, int v_or_s, uint32_t thread,
 	return r;
 }
 
+/**
+ * read_vgprs_gprwave_batch - Read the VGPRs of several threads of a wave
+ *
+ * The wave is looked up and the gprwave state is set up once, after that
+ * each thread only costs the ioctl selecting it and a pread.
+ */
+static int read_vgprs_gprwave_batch(struct umr_asic *asic, struct umr_wave_data *wd, uint64_t thread_mask, uint32_t stride, uint32_t *dst)
+{
+	struct amdgpu_debugfs_gprwave_iocdata id;
+	uint32_t se, sh, cu, wave, simd, size, thread;
+	int r;
+
+	gprwave_wave_params(asic, 1, wd, &se, &sh, &cu, &wave, &simd, &size);
+	gprwave_set_iocdata(asic, &id, 1, 0, se, sh, cu, wave, simd);
+
+	for (thread = 0; thread < 64; thread++) {
+		if (!(thread_mask & (1ULL << thread)))
+			continue;
+
+		id.gpr.thread = thread;
+		r = ioctl(asic->fd.gprwave, AMDGPU_DEBUGFS_GPRWAVE_IOC_SET_STATE, &id);
+		if (r)
+			return r;
+		r = pread(asic->fd.gprwave, &dst[stride * thread], size, 0);
+		if (r < 0)
+			return r;
+
+		if (asic->options.test_log && asic->options.test_log_fd)
+			gprwave_log(asic, 1, gprwave_log_addr(1, thread, se, sh, cu, wave, simd), &dst[stride * thread], r);
+	}
+	return 0;
+}
+
 /**
  * @brief Reads SGPR registers for a specific wave.
  *
@@ -255,6 +293,34 @@ int umr_read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thr
 	}
 }
 
+/**
+ * @brief Reads the VGPRs of several threads of a wave.
+ *
+ * Same as calling umr_read_vgprs() for every thread in @thread_mask but the
+ * wave is only looked up once.
+ *
+ * @param asic Pointer to the UMR ASIC structure representing the GPU.
+ * @param wd Pointer to the UMR wave data structure containing information about the wavefront.
+ * @param thread_mask Bit N set to read thread N.
+ * @param stride Number of words between the VGPRs of consecutive threads in @dst.
+ * @param dst Pointer to the buffer, the VGPRs of thread N are stored at dst[stride * N].
+ *
+ * @return Returns 0 on success, or a negative value on error.
+ */
+int umr_read_vgprs_batch(struct umr_asic *asic, struct umr_wave_data *wd, uint64_t thread_mask, uint32_t stride, uint32_t *dst)
+{
+	// reading VGPR is not supported on pre GFX9 devices
+	if (asic->family < FAMILY_AI)
+		return -1;
+
+	if (asic->fd.gprwave >= 0) {
+		return read_vgprs_gprwave_batch(asic, wd, thread_mask, stride, dst);
+	} else {
+		asic->err_msg("[ERROR]:  Your kernel is too old the amdgpu_gprwave file is now required.\n");
+		return -1;
+	}
+}
+
 /**
  * @brief Reads raw wave status data from a specified GPU resource.
  *
@@ -353,3 +419,35 @@ int umr_get_wave_sq_info(struct umr_asic *asic, unsigned se, unsigned sh, unsign
 {
 	return umr_get_wave_sq_info_vi(asic, se, sh, cu, ws);
 }
+
+/**
+ * @brief Sets up or releases a copy of the device for a wave scanning thread.
+ *
+ * The GPR/wave debugfs file keeps the selected wave in its per open file
+ * state so each scanning thread needs its own handle.  The copy shares
+ * everything else with the device it was made from.
+ *
+ * @param asic Pointer to the UMR ASIC structure the copy was made from.
+ * @param copy Pointer to the copy that a single thread will use.
+ * @param setup 1 to open the handle for the copy, 0 to close it.
+ *
+ * @return Returns 0 on success, or -1 if the handle could not be opened.
+ */
+int umr_wave_thread_context(struct umr_asic *asic, struct umr_asic *copy, int setup)
+{
+	char fname[128];
+
+	if (!setup) {
+		if (copy->fd.gprwave >= 0 && copy->fd.gprwave != asic->fd.gprwave)
+			close(copy->fd.gprwave);
+		copy->fd.gprwave = -1;
+		return 0;
+	}
+
+	if (asic->fd.gprwave < 0)
+		return -1;
+
+	snprintf(fname, sizeof(fname)-1, "/sys/kernel/debug/dri/%d/amdgpu_gprwave", asic->instance);
+	copy->fd.gprwave = open(fname, O_RDWR);
+	return copy->fd.gprwave < 0 ? -1 : 0;
+}
@@ -88,3 +88,172 @@ void *umr_read_ring_data(struct umr_asic *asic, char *ringname, uint32_t *ringsi
 
 	return ring_data;
 }
+
+/**
+ * umr_ring_poll_open - Open a ring file to poll its pointers
+ *
+ * @ringname:  Common name for the ring, e.g., 'gfx' or 'comp_1.0.0'
+ * @path:  The file to read, NULL for the ring's debugfs file
+ *
+ * The file stays open until another ring is polled or the ASIC is
+ * closed.  Any previously open ring file is closed.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int umr_ring_poll_open(struct umr_asic *asic, const char *ringname, const char *path)
+{
+	struct umr_ring_poll *rp;
+	char fname[128];
+	off_t size;
+	int fd;
+
+	if (!path) {
+		snprintf(fname, sizeof(fname)-1, "/sys/kernel/debug/dri/%d/amdgpu_ring_%s", asic->instance, ringname);
+		path = fname;
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		asic->err_msg("[ERROR]: Could not open ring debugfs file '%s'\n", path);
+		if (asic->family >= FAMILY_NV && !strcmp(ringname, "gfx"))
+			asic->err_msg("[WARNING]: On Navi and later ASICs the gfx ring name has changed, for instance: 'gfx_0.0.0'\n");
+		return -1;
+	}
+
+	size = lseek(fd, 0, SEEK_END);
+	if (size < 12) {
+		asic->err_msg("[ERROR]: Ring file '%s' is too small\n", path);
+		close(fd);
+		return -1;
+	}
+
+	rp = calloc(1, sizeof *rp);
+	if (!rp) {
+		close(fd);
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	rp->fd = fd;
+	rp->ringsize = size - 12;
+	strncpy(rp->ringname, ringname, sizeof(rp->ringname) - 1);
+
+	umr_ring_poll_close(asic);
+	asic->ring_poll = rp;
+	return 0;
+}
+
+/**
+ * umr_ring_poll_close - Close the ring file opened by umr_ring_poll_open()
+ */
+void umr_ring_poll_close(struct umr_asic *asic)
+{
+	if (asic->ring_poll) {
+		close(asic->ring_poll->fd);
+		free(asic->ring_poll);
+		asic->ring_poll = NULL;
+	}
+}
+
+/*
+ * ring_poll_get - Return the open ring file for @ringname
+ *
+ * Returns NULL if the envdef ring data should be used instead (test
+ * harness) or on error.
+ */
+static struct umr_ring_poll *ring_poll_get(struct umr_asic *asic, const char *ringname)
+{
+	if (asic->ring_poll && !strcmp(asic->ring_poll->ringname, ringname))
+		return asic->ring_poll;
+	if (asic->options.test_log)
+		return NULL;
+	if (umr_ring_poll_open(asic, ringname, NULL))
+		return NULL;
+	return asic->ring_poll;
+}
+
+/**
+ * umr_read_ring_ptrs - Read the pointers of a ring
+ *
+ * @ringname:  Common name for the ring, e.g., 'gfx' or 'comp_1.0.0'
+ * @ptrs:  Receives the read, write and device write pointers
+ * @ringsize:  Receives the size of the ring in bytes (excluding the 12 byte header)
+ *
+ * Only the 12 byte header of the ring is read and the ring file is kept
+ * open between calls so this is cheap enough to poll.  The pointers may be
+ * unwrapped, reduce them modulo (@ringsize / 4).
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int umr_read_ring_ptrs(struct umr_asic *asic, char *ringname, uint32_t *ptrs, uint32_t *ringsize)
+{
+	struct umr_ring_poll *rp;
+	uint32_t *ring_data;
+
+	rp = ring_poll_get(asic, ringname);
+	if (!rp) {
+		if (!asic->options.test_log)
+			return -1;
+
+		// test harness or test vector capture, both work on the whole ring
+		ring_data = umr_read_ring_data(asic, ringname, ringsize);
+		if (!ring_data)
+			return -1;
+		memcpy(ptrs, ring_data, 12);
+		free(ring_data);
+		return 0;
+	}
+
+	if (pread(rp->fd, ptrs, 12, 0) != 12)
+		return -1;
+	rp->bytes_read += 12;
+	*ringsize = rp->ringsize;
+	return 0;
+}
+
+/**
+ * umr_read_ring_words - Read part of the contents of a ring
+ *
+ * @ringname:  Common name for the ring, e.g., 'gfx' or 'comp_1.0.0'
+ * @start:  The first word to read, reduced modulo the ring size
+ * @n:  The number of words to read, may wrap around the end of the ring
+ * @dst:  Receives the words
+ *
+ * Uses the same open ring file as umr_read_ring_ptrs().
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int umr_read_ring_words(struct umr_asic *asic, char *ringname, uint32_t start, uint32_t n, uint32_t *dst)
+{
+	struct umr_ring_poll *rp;
+	uint32_t *ring_data, ringsize, x, chunk;
+
+	rp = ring_poll_get(asic, ringname);
+	if (!rp) {
+		if (!asic->options.test_log)
+			return -1;
+
+		ring_data = umr_read_ring_data(asic, ringname, &ringsize);
+		if (!ring_data)
+			return -1;
+		ringsize /= 4;
+		for (x = 0; x < n; x++)
+			dst[x] = ring_data[3 + (start + x) % ringsize];
+		free(ring_data);
+		return 0;
+	}
+
+	ringsize = rp->ringsize / 4;
+	if (!ringsize || n > ringsize)
+		return -1;
+	start %= ringsize;
+	while (n) {
+		chunk = (start + n > ringsize) ? ringsize - start : n;
+		if (pread(rp->fd, dst, chunk * 4, 12 + (off_t)start * 4) != (ssize_t)(chunk * 4))
+			return -1;
+		rp->bytes_read += chunk * 4;
+		dst += chunk;
+		n -= chunk;
+		start = 0;
+	}
+	return 0;
+}
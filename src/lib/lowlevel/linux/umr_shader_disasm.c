@@ -28,48 +28,33 @@
 #include <llvm-c/Disassembler.h>
 #include <llvm-c/Target.h>
 
-/**
- * @brief Disassemble a shader program.
- *
- * This function takes a shader program and disassembles it into human-readable form.
- * The disassembled instructions are stored in an array of strings, which is allocated
- * by this function and must be freed by the caller.
- *
- * @param asic         Pointer to the UMR ASIC structure representing the GPU.
- * @param inst         Pointer to the shader program bytes.
- * @param inst_bytes   Number of bytes in the shader program.
- * @param PC           Shader address in virtual memory.
- * @param disasm_text  Output parameter: array of pointers to disassembled shader instructions.
- *
- * @return             0 on success, -1 on failure (e.g., out of memory).
+/* Creating a disassembler context means setting up the whole LLVM
+ * target so one is kept per device and reused until the device is
+ * closed.  LLVM contexts are not thread safe so the lock is held while
+ * one is in use.
  */
-int umr_shader_disasm(struct umr_asic *asic,
-		     uint8_t *inst, unsigned inst_bytes,
-		     uint64_t PC,
-		     char ***disasm_text)
-{
-	LLVMDisasmContextRef disasm_ref;
-	unsigned x, z, i;
-	size_t n;
-	char tmp[256], *cpuname, *features;
+struct umr_disasm_context {
+	pthread_mutex_t lock;
+	LLVMDisasmContextRef ref;
+	char cpuname[32], features[32];
+};
 
-	*disasm_text = calloc(inst_bytes/4, sizeof(**disasm_text));
-	if (!*disasm_text) {
-		asic->err_msg("[ERROR]: Out of memory\n");
-		return -1;
-	}
+static pthread_once_t llvm_init_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t disasm_create_lock = PTHREAD_MUTEX_INITIALIZER;
 
-	if (asic->options.no_disasm) {
-		for (x = 0; x < inst_bytes; x += 4) {
-			(*disasm_text)[x/4] = strdup("...");
-		}
-		return 0;
-	}
-
-	// initialize LLVM
+static void llvm_init(void)
+{
 	LLVMInitializeAllTargetInfos();
 	LLVMInitializeAllTargetMCs();
 	LLVMInitializeAllDisassemblers();
+}
+
+/**
+ * get_cpuname - Get the LLVM processor name of a device
+ */
+static const char *get_cpuname(struct umr_asic *asic)
+{
+	const char *cpuname;
 
 	// cpuname based on mesa usage
 	cpuname = asic->asicname;
@@ -129,25 +114,118 @@ int umr_shader_disasm(struct umr_asic *asic,
 			}
 		}
 	}
+	return cpuname;
+}
+
+/**
+ * get_disasm_context - Get the locked disassembler context of a device
+ *
+ * @asic: The device
+ *
+ * The context is created on first use and re-created if the processor
+ * or the features (wave64) changed since.  Returns the context with its
+ * lock held or NULL on error.
+ */
+static struct umr_disasm_context *get_disasm_context(struct umr_asic *asic)
+{
+	struct umr_disasm_context *dc;
+	const char *cpuname, *features;
+
+	pthread_once(&llvm_init_once, llvm_init);
+
+	pthread_mutex_lock(&disasm_create_lock);
+	if (!asic->disasm) {
+		asic->disasm = calloc(1, sizeof *asic->disasm);
+		if (asic->disasm)
+			pthread_mutex_init(&asic->disasm->lock, NULL);
+	}
+	dc = asic->disasm;
+	pthread_mutex_unlock(&disasm_create_lock);
+
+	if (!dc) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return NULL;
+	}
+
+	cpuname = get_cpuname(asic);
 
 	// compute features
 	features = "";
 	if (asic->family >= FAMILY_NV && asic->options.wave64)
 		features = "+wavefrontsize64";
 
-	disasm_ref = LLVMCreateDisasmCPUFeatures(
-			"amdgcn-mesa-mesa3d", cpuname, features, NULL, 0,
-			NULL, NULL);
+	pthread_mutex_lock(&dc->lock);
+	if (dc->ref && (strcmp(dc->cpuname, cpuname) || strcmp(dc->features, features))) {
+		LLVMDisasmDispose(dc->ref);
+		dc->ref = NULL;
+	}
 
-	if (!disasm_ref) {
-		asic->err_msg("[ERROR]:  Could not create disassembler context\n");
+	if (!dc->ref) {
+		dc->ref = LLVMCreateDisasmCPUFeatures(
+				"amdgcn-mesa-mesa3d", cpuname, features, NULL, 0,
+				NULL, NULL);
+		if (!dc->ref) {
+			pthread_mutex_unlock(&dc->lock);
+			asic->err_msg("[ERROR]:  Could not create disassembler context\n");
+			return NULL;
+		}
+		snprintf(dc->cpuname, sizeof dc->cpuname, "%s", cpuname);
+		snprintf(dc->features, sizeof dc->features, "%s", features);
+	}
+	return dc;
+}
+
+/**
+ * @brief Disassemble a shader program.
+ *
+ * This function takes a shader program and disassembles it into human-readable form.
+ * The disassembled instructions are stored in an array of strings, which is allocated
+ * by this function and must be freed by the caller.
+ *
+ * The LLVM disassembler context is created on the first call and reused
+ * by later calls on the same device until umr_close_asic().  Calls from
+ * several threads on the same device are serialized.
+ *
+ * @param asic         Pointer to the UMR ASIC structure representing the GPU.
+ * @param inst         Pointer to the shader program bytes.
+ * @param inst_bytes   Number of bytes in the shader program.
+ * @param PC           Shader address in virtual memory.
+ * @param disasm_text  Output parameter: array of pointers to disassembled shader instructions.
+ *
+ * @return             0 on success, -1 on failure (e.g., out of memory).
+ */
+int umr_shader_disasm(struct umr_asic *asic,
+		     uint8_t *inst, unsigned inst_bytes,
+		     uint64_t PC,
+		     char ***disasm_text)
+{
+	struct umr_disasm_context *dc;
+	unsigned x, z, i;
+	size_t n;
+	char tmp[256];
+
+	*disasm_text = calloc(inst_bytes/4, sizeof(**disasm_text));
+	if (!*disasm_text) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+
+	if (asic->options.no_disasm) {
+		for (x = 0; x < inst_bytes; x += 4) {
+			(*disasm_text)[x/4] = strdup("...");
+		}
+		return 0;
+	}
+
+	dc = get_disasm_context(asic);
+	if (!dc) {
 		free(*disasm_text);
 		return -1;
 	}
 
 	for (i = x = 0; x < inst_bytes; x += n) {
 		n = LLVMDisasmInstruction(
-				disasm_ref,
+				dc->ref,
 				inst + x, inst_bytes - x,
 				PC + x,
 				tmp, sizeof(tmp));
@@ -166,10 +244,24 @@ int umr_shader_disasm(struct umr_asic *asic,
 		}
 	}
 
-	LLVMDisasmDispose(disasm_ref);
+	pthread_mutex_unlock(&dc->lock);
 	return 0;
 }
 
+/**
+ * umr_shader_disasm_free - Free the disassembler context of a device
+ */
+void umr_shader_disasm_free(struct umr_asic *asic)
+{
+	if (asic->disasm) {
+		if (asic->disasm->ref)
+			LLVMDisasmDispose(asic->disasm->ref);
+		pthread_mutex_destroy(&asic->disasm->lock);
+		free(asic->disasm);
+		asic->disasm = NULL;
+	}
+}
+
 #else
 
 /**
@@ -200,4 +292,12 @@ int umr_shader_disasm(struct umr_asic *asic,
 	return 0;
 }
 
+/**
+ * umr_shader_disasm_free - Free the disassembler context of a device
+ */
+void umr_shader_disasm_free(struct umr_asic *asic)
+{
+	(void)asic;
+}
+
 #endif
@@ -154,6 +154,76 @@ int umr_write_reg_by_name(struct umr_asic *asic, char *name, uint64_t value)
 	return umr_write_reg_by_name_by_ip(asic, NULL, name, value);
 }
 
+/**
+ * umr_bitslice_resolve - Resolve a bitfield of a register once for repeated use
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param reg Pointer to the register structure.
+ * @param bitname Name of the bitfield.
+ * @param bs Receives the shift and mask of the bitfield.
+ * @return 0 on success or -1 if the register has no such bitfield.
+ *
+ * The handle can be used with umr_bitslice_extract() and
+ * umr_bitslice_compose() without looking up the name again.
+ */
+int umr_bitslice_resolve(struct umr_asic *asic, struct umr_reg *reg, const char *bitname, struct umr_bitslice *bs)
+{
+	struct umr_bitfield *bit;
+	unsigned width;
+
+	bit = umr_find_bitfield(asic, reg, bitname);
+	if (!bit)
+		return -1;
+	width = bit->stop - bit->start + 1;
+	bs->shift = bit->start;
+	bs->mask = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+	return 0;
+}
+
+/**
+ * umr_bitslice_resolve_by_name_by_ip - Resolve a bitfield by IP and register name
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param ip Name of the IP block or NULL for any IP block.
+ * @param regname Name of the register.
+ * @param bitname Name of the bitfield.
+ * @param bs Receives the shift and mask of the bitfield.
+ * @return 0 on success or -1 if the register or bitfield is not found.
+ */
+int umr_bitslice_resolve_by_name_by_ip(struct umr_asic *asic, char *ip, char *regname, const char *bitname, struct umr_bitslice *bs)
+{
+	struct umr_reg *reg;
+
+	reg = umr_find_reg_data_by_ip(asic, ip, regname);
+	if (!reg)
+		return -1;
+	return umr_bitslice_resolve(asic, reg, bitname, bs);
+}
+
+/**
+ * umr_bitslice_extract - Slice a register value with a resolved bitfield
+ *
+ * @param bs The bitfield from umr_bitslice_resolve().
+ * @param regvalue The entire value of the register.
+ * @return The value of the bitfield shifted into the LSBs.
+ */
+uint64_t umr_bitslice_extract(const struct umr_bitslice *bs, uint64_t regvalue)
+{
+	return (regvalue >> bs->shift) & bs->mask;
+}
+
+/**
+ * umr_bitslice_compose - Shift a value into position for a resolved bitfield
+ *
+ * @param bs The bitfield from umr_bitslice_resolve().
+ * @param value The value of the bitfield.
+ * @return The masked and shifted value to be OR'ed into the register value.
+ */
+uint64_t umr_bitslice_compose(const struct umr_bitslice *bs, uint64_t value)
+{
+	return (value & bs->mask) << bs->shift;
+}
+
 /**
  * umr_bitslice_reg_quiet - Slice a register value by a bitfield (quiet version)
  *
@@ -171,16 +241,11 @@ int umr_write_reg_by_name(struct umr_asic *asic, char *name, uint64_t value)
  */
 uint64_t umr_bitslice_reg_quiet(struct umr_asic *asic, struct umr_reg *reg, char *bitname, uint64_t regvalue)
 {
-	int i;
-	(void)asic;
-	for (i = 0; i < reg->no_bits; i++) {
-		if (!strcmp(bitname, reg->bits[i].regname)) {
-			regvalue >>= reg->bits[i].start;
-			regvalue &= (1ULL << (reg->bits[i].stop - reg->bits[i].start + 1)) - 1;
-			return regvalue;
-		}
-	}
-	return 0xFFFFFFFFULL;
+	struct umr_bitslice bs;
+
+	if (umr_bitslice_resolve(asic, reg, bitname, &bs))
+		return 0xFFFFFFFFULL;
+	return umr_bitslice_extract(&bs, regvalue);
 }
 
 /**
@@ -197,14 +262,10 @@ uint64_t umr_bitslice_reg_quiet(struct umr_asic *asic, struct umr_reg *reg, char
  */
 uint64_t umr_bitslice_reg(struct umr_asic *asic, struct umr_reg *reg, char *bitname, uint64_t regvalue)
 {
-	int i;
-	for (i = 0; i < reg->no_bits; i++) {
-		if (!strcmp(bitname, reg->bits[i].regname)) {
-			regvalue >>= reg->bits[i].start;
-			regvalue &= (1ULL << (reg->bits[i].stop - reg->bits[i].start + 1)) - 1;
-			return regvalue;
-		}
-	}
+	struct umr_bitslice bs;
+
+	if (!umr_bitslice_resolve(asic, reg, bitname, &bs))
+		return umr_bitslice_extract(&bs, regvalue);
 	asic->err_msg("[BUG]: Bitfield [%s] not found in reg [%s] on asic [%s]\n", bitname, reg->regname, asic->asicname);
 	return 0;
 }
@@ -224,14 +285,10 @@ uint64_t umr_bitslice_reg(struct umr_asic *asic, struct umr_reg *reg, char *bitn
  */
 uint64_t umr_bitslice_compose_value(struct umr_asic *asic, struct umr_reg *reg, char *bitname, uint64_t regvalue)
 {
-	int i;
-	for (i = 0; i < reg->no_bits; i++) {
-		if (!strcmp(bitname, reg->bits[i].regname)) {
-			regvalue &= (1ULL << (reg->bits[i].stop - reg->bits[i].start + 1)) - 1;
-			regvalue <<= reg->bits[i].start;
-			return regvalue;
-		}
-	}
+	struct umr_bitslice bs;
+
+	if (!umr_bitslice_resolve(asic, reg, bitname, &bs))
+		return umr_bitslice_compose(&bs, regvalue);
 	asic->err_msg("[BUG]: Bitfield [%s] not found in reg [%s] on asic [%s]\n", bitname, reg->regname, asic->asicname);
 	return 0;
 }
@@ -457,3 +514,140 @@ int umr_srbm_select_index(struct umr_asic *asic, uint32_t me, uint32_t pipe, uin
 		return -1;
 	}
 }
+
+/**
+ * umr_get_bank_state - Capture the banking state from the options
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param bs Where to store the current use_bank/bank/pg_lock/vm_partition.
+ */
+void umr_get_bank_state(struct umr_asic *asic, struct umr_bank_state *bs)
+{
+	bs->use_bank = asic->options.use_bank;
+	bs->pg_lock = asic->options.pg_lock;
+	bs->vm_partition = asic->options.vm_partition;
+	bs->bank = asic->options.bank;
+}
+
+/**
+ * umr_set_bank_state - Load a banking state into the options
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param bs The state to apply to subsequent register accesses.
+ */
+void umr_set_bank_state(struct umr_asic *asic, const struct umr_bank_state *bs)
+{
+	asic->options.use_bank = bs->use_bank;
+	asic->options.pg_lock = bs->pg_lock;
+	asic->options.vm_partition = bs->vm_partition;
+	asic->options.bank = bs->bank;
+}
+
+/**
+ * umr_bank_state_cmp - Order two banking states
+ *
+ * The bank selection is only compared for the GRBM or SRBM fields
+ * that are actually in use.
+ *
+ * @param a First state.
+ * @param b Second state.
+ * @return 0 if both states program the hardware the same way, otherwise
+ * a negative or positive value like memcmp().
+ */
+int umr_bank_state_cmp(const struct umr_bank_state *a, const struct umr_bank_state *b)
+{
+#define CMP(x) if (a->x != b->x) return (a->x < b->x) ? -1 : 1;
+	CMP(use_bank);
+	CMP(pg_lock);
+	CMP(vm_partition);
+	if (a->use_bank == 1) {
+		CMP(bank.grbm.se);
+		CMP(bank.grbm.sh);
+		CMP(bank.grbm.instance);
+	} else if (a->use_bank == 2) {
+		CMP(bank.srbm.me);
+		CMP(bank.srbm.pipe);
+		CMP(bank.srbm.queue);
+		CMP(bank.srbm.vmid);
+	}
+#undef CMP
+	return 0;
+}
+
+/**
+ * umr_reg_batch_entry - Fill in a batch entry using the current banking
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param rb The batch entry to fill in.
+ * @param addr Byte address of the register.
+ * @param type The register class.
+ */
+void umr_reg_batch_entry(struct umr_asic *asic, struct umr_reg_batch *rb, uint64_t addr, enum regclass type)
+{
+	rb->addr = addr;
+	rb->type = type;
+	rb->value = 0;
+	umr_get_bank_state(asic, &rb->bank);
+}
+
+static int reg_batch_cmp(const void *a, const void *b)
+{
+	const struct umr_reg_batch *x = *(const struct umr_reg_batch **)a,
+				   *y = *(const struct umr_reg_batch **)b;
+	int r;
+
+	r = umr_bank_state_cmp(&x->bank, &y->bank);
+	if (r)
+		return r;
+
+	// keep the callers order within a bank
+	return (x < y) ? -1 : (x > y);
+}
+
+/**
+ * umr_read_reg_batch - Read a list of registers with as few bank changes as possible
+ *
+ * The reads are grouped by banking state so that each bank is
+ * selected once.  Within a bank the registers are read in the order they
+ * appear in @regs.  The banking options in effect before the call are
+ * restored afterwards.  Backends with a read_reg_batch callback are handed
+ * the whole list instead.
+ *
+ * @param asic Pointer to the ASIC structure.
+ * @param regs Array of registers to read, the values are stored in regs[].value.
+ * @param n Number of entries in @regs.
+ * @return 0 on success, -1 on failure.
+ */
+int umr_read_reg_batch(struct umr_asic *asic, struct umr_reg_batch *regs, uint32_t n)
+{
+	struct umr_reg_batch **order;
+	struct umr_bank_state saved;
+	uint32_t x;
+
+	if (!n)
+		return 0;
+
+	// let the backend issue the reads together if it can
+	if (asic->reg_funcs.read_reg_batch)
+		return asic->reg_funcs.read_reg_batch(asic, regs, n);
+
+	order = calloc(n, sizeof *order);
+	if (!order) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	for (x = 0; x < n; x++)
+		order[x] = &regs[x];
+	qsort(order, n, sizeof *order, reg_batch_cmp);
+
+	umr_get_bank_state(asic, &saved);
+	for (x = 0; x < n; x++) {
+		if (!x || umr_bank_state_cmp(&order[x]->bank, &order[x - 1]->bank))
+			umr_set_bank_state(asic, &order[x]->bank);
+		order[x]->value = asic->reg_funcs.read_reg(asic, order[x]->addr, order[x]->type);
+	}
+	umr_set_bank_state(asic, &saved);
+
+	free(order);
+	return 0;
+}
@@ -101,6 +101,41 @@ struct umr_packet_stream *umr_packet_decode_buffer(struct umr_asic *asic, struct
 	return str;
 }
 
+/**
+ * umr_packet_guess_ring_type - Guess the type of packets a ring holds from its name
+ * @asic: The ASIC model the ring belongs to
+ * @ringname: The name of the ring without the amdgpu_ring_ prefix
+ *
+ * Returns UMR_RING_UNK if the ring name is not recognized.
+ */
+enum umr_ring_type umr_packet_guess_ring_type(struct umr_asic *asic, const char *ringname)
+{
+	// only decode PM4 packets on certain rings
+	if (!memcmp(ringname, "gfx", 3) ||
+		!memcmp(ringname, "uvd", 3) ||
+		!memcmp(ringname, "mes_kiq", 7) ||
+		!memcmp(ringname, "kiq", 3) ||
+		!memcmp(ringname, "comp", 4)) {
+		return UMR_RING_PM4;
+	} else if (!memcmp(ringname, "vcn_enc", 7) ||
+		!memcmp(ringname, "vcn_unified_", 12)) {
+		return UMR_RING_VCN_ENC;
+	} else if (!memcmp(ringname, "vcn_dec", 7)) {
+		return UMR_RING_VCN_DEC;
+	} else if (!memcmp(ringname, "sdma", 4) ||
+		   !memcmp(ringname, "page", 4)) {
+		return UMR_RING_SDMA;
+	} else if (!memcmp(ringname, "mes", 3)) {
+		return UMR_RING_MES;
+	} else if (!memcmp(ringname, "vpe", 3)) {
+		return UMR_RING_VPE;
+	} else if (!memcmp(ringname, "umsch", 5)) {
+		return UMR_RING_UMSCH;
+	}
+	asic->err_msg("[ERROR]: Unknown ring type <%s> for umr_packet_decode_ring()\n", ringname);
+	return UMR_RING_UNK;
+}
+
 /**
  * umr_packet_decode_ring - Decode packets from a system kernel ring
  * @asic: The ASIC model the packet decoding corresponds to
@@ -121,31 +156,9 @@ struct umr_packet_stream *umr_packet_decode_ring(struct umr_asic *asic, struct u
 	int only_active = 1;
 
 	if (rt == UMR_RING_GUESS) {
-		// only decode PM4 packets on certain rings
-		if (!memcmp(ringname, "gfx", 3) ||
-			!memcmp(ringname, "uvd", 3) ||
-			!memcmp(ringname, "mes_kiq", 7) ||
-			!memcmp(ringname, "kiq", 3) ||
-			!memcmp(ringname, "comp", 4)) {
-			rt = UMR_RING_PM4;
-		} else if (!memcmp(ringname, "vcn_enc", 7) ||
-			!memcmp(ringname, "vcn_unified_", 12)) {
-			rt = UMR_RING_VCN_ENC;
-		} else if (!memcmp(ringname, "vcn_dec", 7)) {
-			rt = UMR_RING_VCN_DEC;
-		} else if (!memcmp(ringname, "sdma", 4) ||
-			   !memcmp(ringname, "page", 4)) {
-			rt = UMR_RING_SDMA;
-		} else if (!memcmp(ringname, "mes", 3)) {
-			rt = UMR_RING_MES;
-		} else if (!memcmp(ringname, "vpe", 3)) {
-			rt = UMR_RING_VPE;
-		} else if (!memcmp(ringname, "umsch", 5)) {
-			rt = UMR_RING_UMSCH;
-		} else {
-			asic->err_msg("[ERROR]: Unknown ring type <%s> for umr_packet_decode_ring()\n", ringname);
+		rt = umr_packet_guess_ring_type(asic, ringname);
+		if (rt == UMR_RING_UNK)
 			return NULL;
-		}
 	}
 
 	if (halt_waves && asic->options.halt_waves) {
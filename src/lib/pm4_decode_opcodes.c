@@ -2243,8 +2243,11 @@ struct umr_pm4_stream *umr_pm4_decode_stream_opcodes(struct umr_asic *asic, stru
 			if (stream->shader)
 				ui->add_shader(ui, asic, ib_addr, ib_vmid, stream->shader);
 
-			if (follow && stream->ib)
+			if (follow && stream->ib) {
+				if (stream->ib_reused && ui->reused_ib)
+					ui->reused_ib(ui, stream->ib_source.addr, stream->ib_source.vmid, ib_addr, ib_vmid);
 				umr_pm4_decode_stream_opcodes(asic, ui, stream->ib, stream->ib_source.addr, stream->ib_source.vmid, ib_addr, ib_vmid, ~0UL, follow);
+			}
 		}
 
 		ib_addr += 4 + stream->n_words * 4;
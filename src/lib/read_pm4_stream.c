@@ -24,6 +24,33 @@
  */
 #include "umr.h"
 
+// all of the packets of a decoded stream and a copy of their words
+struct umr_pm4_arena {
+	uint32_t no_packets, no_words,
+		 refcnt;                  // number of packets pointing at this stream as an IB (or 1 for the head)
+	uint32_t *words;
+	struct umr_pm4_stream packets[];
+};
+
+// at most this many IBs are remembered per decode session, past that IBs are still followed but not shared
+#define PM4_IB_CACHE_BUCKETS      64
+#define PM4_IB_CACHE_MAX_ENTRIES  1024
+
+struct pm4_ib_cache_entry {
+	uint64_t addr;
+	uint32_t vmid, size, hash;
+	struct umr_pm4_stream *ib;
+	struct pm4_ib_cache_entry *next_addr, *next_hash;
+};
+
+// IBs already decoded while decoding one stream (and the IBs it points to)
+struct pm4_ib_cache {
+	struct pm4_ib_cache_entry *by_addr[PM4_IB_CACHE_BUCKETS],
+				  *by_hash[PM4_IB_CACHE_BUCKETS];
+	uint32_t no_entries;
+};
+
+static struct umr_pm4_stream *pm4_decode_stream(struct umr_asic *asic, int vm_partition, uint32_t vmid, uint32_t *stream, uint32_t nwords, struct pm4_ib_cache *cache);
 
 static uint32_t fetch_word(struct umr_asic *asic, struct umr_pm4_stream *stream, uint32_t off)
 {
@@ -37,22 +64,137 @@ static uint32_t fetch_word(struct umr_asic *asic, struct umr_pm4_stream *stream,
 	}
 }
 
+static uint32_t pm4_ib_hash(const uint32_t *words, uint32_t nwords)
+{
+	uint32_t h = 2166136261UL;
+
+	while (nwords--)
+		h = (h ^ *words++) * 16777619UL;
+	return h;
+}
+
+static struct pm4_ib_cache_entry *pm4_ib_cache_find_addr(struct pm4_ib_cache *cache, uint32_t vmid, uint64_t addr, uint32_t size)
+{
+	struct pm4_ib_cache_entry *e;
+
+	for (e = cache->by_addr[(addr >> 2) % PM4_IB_CACHE_BUCKETS]; e; e = e->next_addr)
+		if (e->addr == addr && e->vmid == vmid && e->size == size)
+			return e;
+	return NULL;
+}
+
+static struct pm4_ib_cache_entry *pm4_ib_cache_find_words(struct pm4_ib_cache *cache, uint32_t vmid, const uint32_t *words, uint32_t size, uint32_t hash)
+{
+	struct pm4_ib_cache_entry *e;
+
+	for (e = cache->by_hash[hash % PM4_IB_CACHE_BUCKETS]; e; e = e->next_hash)
+		if (e->hash == hash && e->vmid == vmid && e->size == size &&
+		    e->ib->arena->no_words == size / 4 &&
+		    !memcmp(e->ib->arena->words, words, size))
+			return e;
+	return NULL;
+}
+
+static void pm4_ib_cache_add(struct pm4_ib_cache *cache, uint32_t vmid, uint64_t addr, uint32_t size, uint32_t hash, struct umr_pm4_stream *ib)
+{
+	struct pm4_ib_cache_entry *e;
+
+	if (cache->no_entries >= PM4_IB_CACHE_MAX_ENTRIES)
+		return;
+
+	e = calloc(1, sizeof *e);
+	if (!e)
+		return;
+	e->addr = addr;
+	e->vmid = vmid;
+	e->size = size;
+	e->hash = hash;
+	e->ib = ib;
+	e->next_addr = cache->by_addr[(addr >> 2) % PM4_IB_CACHE_BUCKETS];
+	cache->by_addr[(addr >> 2) % PM4_IB_CACHE_BUCKETS] = e;
+	e->next_hash = cache->by_hash[hash % PM4_IB_CACHE_BUCKETS];
+	cache->by_hash[hash % PM4_IB_CACHE_BUCKETS] = e;
+	++cache->no_entries;
+}
+
+static void pm4_ib_cache_free(struct pm4_ib_cache *cache)
+{
+	struct pm4_ib_cache_entry *e, *n;
+	int x;
+
+	for (x = 0; x < PM4_IB_CACHE_BUCKETS; x++)
+		for (e = cache->by_addr[x]; e; e = n) {
+			n = e->next_addr;
+			free(e);
+		}
+}
+
+/**
+ * pm4_follow_ib - Decode the IB a packet points to
+ *
+ * @vm_partition: What VM partition does it come from (-1 is default)
+ * @vmid: The VMID of the IB
+ * @addr: The address of the IB
+ * @size: The size of the IB in bytes
+ * @ps: The packet pointing to the IB
+ * @cache: The IBs already decoded in this session
+ *
+ * An IB that was already decoded at the same address is shared without
+ * reading it again.  Otherwise the IB is read and shared with an IB that
+ * has the same contents if any.  Shared IBs are marked with ib_reused.
+ */
+static void pm4_follow_ib(struct umr_asic *asic, int vm_partition, uint32_t vmid, uint64_t addr, uint32_t size, struct umr_pm4_stream *ps, struct pm4_ib_cache *cache)
+{
+	struct pm4_ib_cache_entry *e;
+	uint32_t hash;
+	void *buf;
+
+	e = pm4_ib_cache_find_addr(cache, vmid, addr, size);
+	if (!e) {
+		buf = calloc(1, size);
+		if (umr_read_vram(asic, vm_partition, vmid, addr, size, buf) < 0) {
+			asic->err_msg("[ERROR]: Could not read IB at 0x%"PRIx32":0x%" PRIx64 "\n", vmid, addr);
+			free(buf);
+			return;
+		}
+		hash = pm4_ib_hash(buf, size / 4);
+		e = pm4_ib_cache_find_words(cache, vmid, buf, size, hash);
+		if (e) {
+			// same contents elsewhere, remember this address as well
+			pm4_ib_cache_add(cache, vmid, addr, size, hash, e->ib);
+		} else {
+			ps->ib = pm4_decode_stream(asic, vm_partition, vmid, buf, size / 4, cache);
+			if (ps->ib && ps->ib->arena)
+				pm4_ib_cache_add(cache, vmid, addr, size, hash, ps->ib);
+		}
+		free(buf);
+	}
+
+	if (e) {
+		++e->ib->arena->refcnt;
+		ps->ib = e->ib;
+		ps->ib_reused = 1;
+	}
+	ps->ib_source.addr = addr;
+	ps->ib_source.vmid = vmid;
+}
+
 /**
  * parse_pm4 - Parse a PM4 packet looking for pointers to shaders or IBs
  *
  * @vm_partition: What VM partition does it come from (-1 is default)
  * @vmid:  The known VMID this packet belongs to (or 0 if from a ring)
  * @ps: The PM4 packet to parse
+ * @cache: The IBs already decoded in this session
  *
  * This function looks for shaders that are indicated by a single
  * SET_SH_REG packet or further IBs indicated by INDIRECT_BUFFER
  * packets.
  */
-static void parse_pm4(struct umr_asic *asic, int vm_partition, uint32_t vmid, struct umr_pm4_stream *ps)
+static void parse_pm4(struct umr_asic *asic, int vm_partition, uint32_t vmid, struct umr_pm4_stream *ps, struct pm4_ib_cache *cache)
 {
 	uint64_t addr;
 	uint32_t size, tvmid, rsrc1, rsrc2;
-	void *buf;
 
 	switch (ps->opcode) {
 		case 0x76: // SET_SH_REG (looking for writes to shader registers);
@@ -132,15 +274,7 @@ static void parse_pm4(struct umr_asic *asic, int vm_partition, uint32_t vmid, st
 				tvmid = (fetch_word(asic, ps, 2) >> 24) & 0xF;
 				if (!tvmid)
 					tvmid = vmid;
-				buf = calloc(1, size);
-				if (umr_read_vram(asic, vm_partition, tvmid, addr, size, buf) < 0) {
-					asic->err_msg("[ERROR]: Could not read IB at 0x%"PRIx32":0x%" PRIx64 "\n", tvmid, addr);
-				} else {
-					ps->ib = umr_pm4_decode_stream(asic, vm_partition, tvmid, buf, size / 4);
-					ps->ib_source.addr = addr;
-					ps->ib_source.vmid = tvmid;
-				}
-				free(buf);
+				pm4_follow_ib(asic, vm_partition, tvmid, addr, size, ps, cache);
 			}
 			break;
 	}
@@ -193,19 +327,75 @@ struct umr_shaders_pgm *umr_find_shader_in_stream(
 
 /**
  * umr_free_pm4_stream - Free a PM4 stream object
+ *
+ * Packets decoded by umr_pm4_decode_stream() share a single arena which
+ * is released once the whole list has been walked so this must be passed
+ * the head of the stream.  IBs shared by several packets are only
+ * released with their last reference.
  */
 void umr_free_pm4_stream(struct umr_pm4_stream *stream)
 {
+	struct umr_pm4_arena *arena = stream ? stream->arena : NULL;
+
+	if (arena && --arena->refcnt)
+		return;
+
 	while (stream) {
 		struct umr_pm4_stream *n;
 		n = stream->next;
 		if (stream->ib)
 			umr_free_pm4_stream(stream->ib);
 		free(stream->shader);
-		free(stream->words);
-		free(stream);
+		if (!stream->arena) {
+			free(stream->words);
+			free(stream);
+		}
 		stream = n;
 	}
+	free(arena);
+}
+
+/**
+ * pm4_arena_create - Allocate the storage for a PM4 stream
+ *
+ * @asic: The ASIC the stream belongs to
+ * @stream: An array of DWORDS which contain the PM4 packets
+ * @nwords:  The number of words in the stream
+ *
+ * Walks the packet headers to count the complete packets and then
+ * allocates one block for the packets and a copy of their words.
+ * Returns NULL if there is not a single complete packet.
+ */
+static struct umr_pm4_arena *pm4_arena_create(struct umr_asic *asic, const uint32_t *stream, uint32_t nwords)
+{
+	struct umr_pm4_arena *arena;
+	uint32_t no_packets, used, n;
+
+	for (no_packets = used = 0; used < nwords; no_packets++) {
+		n = 1 + (((stream[used] >> 16) + 1) & 0x3FFF);
+		if (nwords - used < n)
+			break;
+		used += n;
+	}
+
+	// an empty stream still decodes to a single blank packet
+	if (!nwords)
+		no_packets = 1;
+	else if (!no_packets)
+		return NULL;
+
+	arena = calloc(1, sizeof *arena + no_packets * sizeof arena->packets[0] + used * sizeof arena->words[0]);
+	if (!arena) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return NULL;
+	}
+
+	arena->refcnt = 1;
+	arena->no_packets = no_packets;
+	arena->no_words = used;
+	arena->words = (uint32_t *)&arena->packets[no_packets];
+	memcpy(arena->words, stream, used * sizeof arena->words[0]);
+	return arena;
 }
 
 /**
@@ -220,7 +410,20 @@ void umr_free_pm4_stream(struct umr_pm4_stream *stream)
  */
 struct umr_pm4_stream *umr_pm4_decode_stream(struct umr_asic *asic, int vm_partition, uint32_t vmid, uint32_t *stream, uint32_t nwords)
 {
-	struct umr_pm4_stream *ops, *ps, *prev_ps = NULL;
+	struct pm4_ib_cache cache;
+	struct umr_pm4_stream *ps;
+
+	memset(&cache, 0, sizeof cache);
+	ps = pm4_decode_stream(asic, vm_partition, vmid, stream, nwords, &cache);
+	pm4_ib_cache_free(&cache);
+	return ps;
+}
+
+static struct umr_pm4_stream *pm4_decode_stream(struct umr_asic *asic, int vm_partition, uint32_t vmid, uint32_t *stream, uint32_t nwords, struct pm4_ib_cache *cache)
+{
+	struct umr_pm4_arena *arena;
+	struct umr_pm4_stream *ps;
+	uint32_t x, off;
 	struct {
 		int n;
 		uint32_t
@@ -230,46 +433,37 @@ struct umr_pm4_stream *umr_pm4_decode_stream(struct umr_asic *asic, int vm_parti
 			addr;
 	} uvd_ib;
 
-	ps = ops = calloc(1, sizeof *ops);
-	if (!ps) {
-		asic->err_msg("[ERROR]: Out of memory\n");
+	// a trailing packet that is not complete is dropped
+	arena = pm4_arena_create(asic, stream, nwords);
+	if (!arena)
 		return NULL;
-	}
 
 	memset(&uvd_ib, 0, sizeof uvd_ib);
 
-	while (nwords) {
+	for (x = off = 0; off < arena->no_words; x++) {
+		ps = &arena->packets[x];
+		ps->arena = arena;
+		if (x + 1 < arena->no_packets)
+			ps->next = &arena->packets[x + 1];
+
 		// fetch basics out of header
-		ps->header = *stream;
-		ps->pkttype = *stream >> 30;
-		ps->n_words = ((*stream >> 16) + 1) & 0x3FFF;
+		ps->header = arena->words[off];
+		ps->pkttype = ps->header >> 30;
+		ps->n_words = ((ps->header >> 16) + 1) & 0x3FFF;
 
 		// grab type specific header data
 		if (ps->pkttype == 0)
-			ps->pkt0off = *stream & 0xFFFF;
+			ps->pkt0off = ps->header & 0xFFFF;
 		else if (ps->pkttype == 3)
-			ps->opcode = (*stream >> 8) & 0xFF;
-
-		if (nwords < 1 + ps->n_words) {
-			// if not enough words to fill packet, stop and set current packet to null
-			free(ps);
-			if (prev_ps) {
-				prev_ps->next = NULL;
-			} else {
-				ops = NULL;
-			}
-			return ops;
-		} 
+			ps->opcode = (ps->header >> 8) & 0xFF;
 
-		// grab rest of words
-		if (ps->n_words) {
-			ps->words = calloc(ps->n_words, sizeof(ps->words[0]));
-			memcpy(ps->words, &stream[1], ps->n_words * sizeof(stream[0]));
-		}
+		// the words following the header are in the arena
+		if (ps->n_words)
+			ps->words = &arena->words[off + 1];
 
 		// decode specific packets
 		if (ps->pkttype == 3) {
-			parse_pm4(asic, vm_partition, vmid, ps);
+			parse_pm4(asic, vm_partition, vmid, ps, cache);
 		} else if (ps->pkttype == 0) {
 			char *name;
 			name = umr_reg_name(asic, ps->pkt0off);
@@ -300,30 +494,16 @@ struct umr_pm4_stream *umr_pm4_decode_stream(struct umr_asic *asic, int vm_parti
 
 			// we have everything we need to point to an IB
 			if (!asic->options.no_follow_ib && uvd_ib.n == 15) {
-				void *buf;
-				buf = calloc(1, uvd_ib.size);
-				if (umr_read_vram(asic, vm_partition, uvd_ib.vmid, uvd_ib.addr, uvd_ib.size, buf) < 0) {
-					asic->err_msg("[ERROR]: Could not read IB at 0x%"PRIx32":0x%" PRIx64 "\n", uvd_ib.vmid, uvd_ib.addr);
-				} else {
-					ps->ib = umr_pm4_decode_stream(asic, vm_partition, uvd_ib.vmid, buf, uvd_ib.size / 4);
-					ps->ib_source.addr = uvd_ib.addr;
-					ps->ib_source.vmid = uvd_ib.vmid;
-				}
-				free(buf);
+				pm4_follow_ib(asic, vm_partition, uvd_ib.vmid, uvd_ib.addr, uvd_ib.size, ps, cache);
 				memset(&uvd_ib, 0, sizeof uvd_ib);
 			}
 		}
 
 		// advance stream
-		nwords -= 1 + ps->n_words;
-		stream += 1 + ps->n_words;
-		if (nwords) {
-			ps->next = calloc(1, sizeof(*ps));
-			prev_ps = ps;
-			ps = ps->next;
-		}
+		off += 1 + ps->n_words;
 	}
 
-	return ops;
+	arena->packets[0].arena = arena;
+	return &arena->packets[0];
 }
 
@@ -780,6 +780,272 @@ static void print_pte(struct umr_asic *asic,
 	}
 }
 
+// these are the verbatim registers being read to perform the page walk
+struct vm_context_regs {
+	uint32_t
+		mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32,
+		mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32,
+		mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32,
+		mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32,
+		mmVM_CONTEXTx_CNTL,
+		mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32,
+		mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32,
+		mmVGA_MEMORY_BASE_ADDRESS,
+		mmVGA_MEMORY_BASE_ADDRESS_HIGH,
+		mmMC_VM_FB_OFFSET,
+		mmMC_VM_MX_L1_TLB_CNTL,
+		mmMC_VM_SYSTEM_APERTURE_LOW_ADDR,
+		mmMC_VM_SYSTEM_APERTURE_HIGH_ADDR,
+		mmMC_VM_FB_LOCATION_BASE,
+		mmMC_VM_FB_LOCATION_TOP,
+		mmMC_VM_AGP_BASE,
+		mmMC_VM_AGP_BOT,
+		mmMC_VM_AGP_TOP;
+};
+
+// a snapshot of the VM context registers of a (partition, hub, vmid)
+struct vm_context {
+	int valid, partition;
+	uint32_t vmid;          // hub | vmid
+	char hub[32];
+	struct vm_context_regs registers;
+	int page_table_depth;
+	uint64_t page_table_block_size;
+	uint32_t sam;
+};
+
+// a PDE/PTE read during a page walk
+struct vm_cache_entry {
+	int valid, partition, sys;
+	uint32_t vmid;          // hub | vmid of the walk that read it
+	uint64_t addr, value;
+};
+
+#define VM_CACHE_CONTEXTS 16
+#define VM_CACHE_ENTRIES  4096
+
+struct umr_vm_cache {
+	struct vm_context contexts[VM_CACHE_CONTEXTS];
+	int next_context;
+	struct vm_cache_entry entries[VM_CACHE_ENTRIES];
+};
+
+/**
+ * umr_vm_cache_invalidate - Drop all cached VM translations
+ *
+ * @asic: The device whose cache to invalidate
+ *
+ * Must be called whenever page tables or VM context registers
+ * may have changed (e.g. between commands of a long running session).
+ */
+void umr_vm_cache_invalidate(struct umr_asic *asic)
+{
+	if (asic->vm_cache)
+		memset(asic->vm_cache, 0, sizeof *asic->vm_cache);
+}
+
+/**
+ * umr_vm_cache_invalidate_vmid - Drop cached VM translations of one VM
+ *
+ * @asic: The device whose cache to invalidate
+ * @partition: The VM partition
+ * @vmid: The hub and VMID (e.g. UMR_GFX_HUB | 3)
+ */
+void umr_vm_cache_invalidate_vmid(struct umr_asic *asic, int partition, uint32_t vmid)
+{
+	struct umr_vm_cache *vc = asic->vm_cache;
+	int x;
+
+	if (!vc)
+		return;
+
+	for (x = 0; x < VM_CACHE_CONTEXTS; x++)
+		if (vc->contexts[x].partition == partition && vc->contexts[x].vmid == vmid)
+			vc->contexts[x].valid = 0;
+	for (x = 0; x < VM_CACHE_ENTRIES; x++)
+		if (vc->entries[x].partition == partition && vc->entries[x].vmid == vmid)
+			vc->entries[x].valid = 0;
+}
+
+/**
+ * umr_vm_cache_free - Free the VM translation cache of a device
+ */
+void umr_vm_cache_free(struct umr_asic *asic)
+{
+	free(asic->vm_cache);
+	asic->vm_cache = NULL;
+}
+
+/**
+ * vm_cache_get - Get the VM cache of a device (if caching is enabled)
+ */
+static struct umr_vm_cache *vm_cache_get(struct umr_asic *asic)
+{
+	if (asic->options.no_vm_cache)
+		return NULL;
+	if (!asic->vm_cache)
+		asic->vm_cache = calloc(1, sizeof *asic->vm_cache);
+	return asic->vm_cache;
+}
+
+/**
+ * vm_read_context - Read the VM context registers for a page walk
+ *
+ * @ctx: Where to store the register values.  The page table base
+ *       registers are skipped if @read_base is zero.
+ */
+static void vm_read_context(struct umr_asic *asic, int partition, uint32_t vmid,
+			    const char *hub, const char *vm0prefix, const char *regprefix,
+			    int read_base, struct vm_context *ctx)
+{
+	struct vm_context_regs *registers = &ctx->registers;
+	uint32_t tmp;
+	char buf[64];
+
+	memset(registers, 0, sizeof *registers);
+
+	// read vm registers
+	if (vmid == 0) {
+		// only need system aperture registers (SAM) if we're using VMID 0
+		sprintf(buf, "mm%sMC_VM_SYSTEM_APERTURE_HIGH_ADDR", vm0prefix);
+			registers->mmMC_VM_SYSTEM_APERTURE_HIGH_ADDR = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		sprintf(buf, "mm%sMC_VM_SYSTEM_APERTURE_LOW_ADDR", vm0prefix);
+			registers->mmMC_VM_SYSTEM_APERTURE_LOW_ADDR = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		sprintf(buf, "mm%sMC_VM_MX_L1_TLB_CNTL", vm0prefix);
+			registers->mmMC_VM_MX_L1_TLB_CNTL = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	}
+
+	sprintf(buf, "mm%sMC_VM_FB_LOCATION_BASE", vm0prefix);
+		registers->mmMC_VM_FB_LOCATION_BASE = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	sprintf(buf, "mm%sMC_VM_FB_LOCATION_TOP", vm0prefix);
+		registers->mmMC_VM_FB_LOCATION_TOP = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+
+	// check if we are in ZFB mode
+	if ((((uint64_t)registers->mmMC_VM_FB_LOCATION_TOP + 1) << 24) < (((uint64_t)registers->mmMC_VM_FB_LOCATION_BASE) << 24)) {
+		sprintf(buf, "mm%sMC_VM_AGP_BASE", regprefix);
+			registers->mmMC_VM_AGP_BASE = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		sprintf(buf, "mm%sMC_VM_AGP_BOT", regprefix);
+			registers->mmMC_VM_AGP_BOT = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		sprintf(buf, "mm%sMC_VM_AGP_TOP", regprefix);
+			registers->mmMC_VM_AGP_TOP = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	}
+
+	// context registers
+	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_START_ADDR_LO32", regprefix, vmid);
+		registers->mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_START_ADDR_HI32", regprefix, vmid);
+		registers->mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_END_ADDR_LO32", regprefix, vmid);
+		registers->mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_END_ADDR_HI32", regprefix, vmid);
+		registers->mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+
+	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_CNTL", regprefix, vmid);
+		tmp = registers->mmVM_CONTEXTx_CNTL = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		ctx->page_table_depth      = umr_bitslice_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf, "PAGE_TABLE_DEPTH", tmp);
+		ctx->page_table_block_size = umr_bitslice_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf, "PAGE_TABLE_BLOCK_SIZE", tmp);
+
+	if (read_base) {
+		sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_BASE_ADDR_LO32", regprefix, vmid);
+			registers->mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+		sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_BASE_ADDR_HI32", regprefix, vmid);
+			registers->mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+	}
+
+	// update addresses for APUs
+	if (asic->is_apu) {
+		if (umr_find_reg(asic, "@mmVGA_MEMORY_BASE_ADDRESS") != 0xFFFFFFFF) {
+			registers->mmVGA_MEMORY_BASE_ADDRESS = umr_read_reg_by_name(asic, "mmVGA_MEMORY_BASE_ADDRESS");
+			registers->mmVGA_MEMORY_BASE_ADDRESS_HIGH = umr_read_reg_by_name(asic, "mmVGA_MEMORY_BASE_ADDRESS_HIGH");
+		}
+	}
+
+	sprintf(buf, "mm%sMC_VM_FB_OFFSET", regprefix);
+		registers->mmMC_VM_FB_OFFSET = umr_read_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf);
+
+	ctx->sam = 0;
+	if (vmid == 0) {
+		sprintf(buf, "mm%sMC_VM_MX_L1_TLB_CNTL", vm0prefix);
+		ctx->sam = umr_bitslice_reg_by_name_by_ip_by_instance(asic, (char *)hub, partition, buf, "SYSTEM_ACCESS_MODE", registers->mmMC_VM_MX_L1_TLB_CNTL);
+	}
+}
+
+/**
+ * vm_get_context - Find or read the VM context registers for a page walk
+ *
+ * Returns a cached snapshot of the registers if there is one
+ * for this (partition, hub, vmid) otherwise reads them and
+ * remembers them for the next walk.
+ */
+static struct vm_context *vm_get_context(struct umr_asic *asic, int partition, uint32_t hubid, uint32_t vmid,
+					 const char *hub, const char *vm0prefix, const char *regprefix,
+					 struct vm_context *tmp)
+{
+	struct umr_vm_cache *vc = vm_cache_get(asic);
+	struct vm_context *ctx;
+	int x;
+
+	if (!vc) {
+		vm_read_context(asic, partition, vmid, hub, vm0prefix, regprefix, 1, tmp);
+		return tmp;
+	}
+
+	for (x = 0; x < VM_CACHE_CONTEXTS; x++) {
+		ctx = &vc->contexts[x];
+		if (ctx->valid && ctx->partition == partition && ctx->vmid == (hubid | vmid) && !strcmp(ctx->hub, hub))
+			return ctx;
+	}
+
+	ctx = &vc->contexts[vc->next_context];
+	vc->next_context = (vc->next_context + 1) % VM_CACHE_CONTEXTS;
+	vm_read_context(asic, partition, vmid, hub, vm0prefix, regprefix, 1, ctx);
+	ctx->valid = 1;
+	ctx->partition = partition;
+	ctx->vmid = hubid | vmid;
+	snprintf(ctx->hub, sizeof ctx->hub, "%s", hub);
+	return ctx;
+}
+
+/**
+ * vm_read_entry - Read a PDE or PTE for a page walk
+ *
+ * @vmid: The hub and VMID of the walk (used to tag the cache entry)
+ * @sys: Read from system memory (otherwise linear VRAM)
+ * @addr: The address of the entry
+ * @entry: Where to store the entry
+ *
+ * Returns the result of the memory access.
+ */
+static int vm_read_entry(struct umr_asic *asic, int partition, uint32_t vmid, int sys, uint64_t addr, uint64_t *entry)
+{
+	struct umr_vm_cache *vc = vm_cache_get(asic);
+	struct vm_cache_entry *e = NULL;
+	int r;
+
+	if (vc) {
+		e = &vc->entries[((addr >> 3) ^ (addr >> 15) ^ vmid) & (VM_CACHE_ENTRIES - 1)];
+		if (e->valid && e->addr == addr && e->sys == sys && e->vmid == vmid && e->partition == partition) {
+			*entry = e->value;
+			return 0;
+		}
+	}
+
+	if (sys)
+		r = asic->mem_funcs.access_sram(asic, addr, 8, entry, 0);
+	else
+		r = umr_read_vram(asic, partition, UMR_LINEAR_HUB, addr, 8, entry);
+
+	if (e && r >= 0) {
+		e->valid = 1;
+		e->partition = partition;
+		e->vmid = vmid;
+		e->sys = sys;
+		e->addr = addr;
+		e->value = *entry;
+	}
+	return r;
+}
+
 /**
  * @brief Access GPU mapped memory for GFX9+ platforms
  *
@@ -821,35 +1087,14 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 		 va_mask, offset_mask, system_aperture_low, system_aperture_high,
 		 fb_top, fb_bottom, ptb_mask, pte_page_mask, agp_base, agp_bot, agp_top, prev_addr;
 
-	uint32_t chunk_size, tmp, pde0_block_fragment_size;
+	uint32_t chunk_size, pde0_block_fragment_size;
 	int pde_cnt, current_depth, page_table_depth, zfb, further, pde_was_pte;
 
-	// these are the verbatim registers being read to perform the page walk
-	struct {
-		uint32_t
-			mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32,
-			mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32,
-			mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32,
-			mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32,
-			mmVM_CONTEXTx_CNTL,
-			mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32,
-			mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32,
-			mmVGA_MEMORY_BASE_ADDRESS,
-			mmVGA_MEMORY_BASE_ADDRESS_HIGH,
-			mmMC_VM_FB_OFFSET,
-			mmMC_VM_MX_L1_TLB_CNTL,
-			mmMC_VM_SYSTEM_APERTURE_LOW_ADDR,
-			mmMC_VM_SYSTEM_APERTURE_HIGH_ADDR,
-			mmMC_VM_FB_LOCATION_BASE,
-			mmMC_VM_FB_LOCATION_TOP,
-			mmMC_VM_AGP_BASE,
-			mmMC_VM_AGP_BOT,
-			mmMC_VM_AGP_TOP;
-	} registers;
+	struct vm_context ctxbuf, *ctx;
+	struct vm_context_regs registers;
 
 	pde_fields_t pde_fields, pde_array[8];
 	pte_fields_t pte_fields = { 0 };
-	char buf[64];
 	unsigned char *pdst = dst;
 	char *hub, *vm0prefix, *regprefix;
 	unsigned hubid;
@@ -909,25 +1154,25 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 			return -1;
 	}
 
-	// read vm registers
+	// read vm registers (or use a snapshot from a previous walk)
+	if (vmdata && vmdata->registers.page_table_base_addr) {
+		vm_read_context(asic, partition, vmid, hub, vm0prefix, regprefix, 0, &ctxbuf);
+		ctx = &ctxbuf;
+		ctx->registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 = vmdata->registers.page_table_base_addr & 0xFFFFFFFFULL;
+		ctx->registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 = vmdata->registers.page_table_base_addr >> 32ULL;
+	} else {
+		ctx = vm_get_context(asic, partition, hubid, vmid, hub, vm0prefix, regprefix, &ctxbuf);
+	}
+	registers = ctx->registers;
+	page_table_depth = ctx->page_table_depth;
+	page_table_block_size = ctx->page_table_block_size;
+
 	if (vmid == 0) {
-		// only need system aperture registers (SAM) if we're using VMID 0
-		sprintf(buf, "mm%sMC_VM_SYSTEM_APERTURE_HIGH_ADDR", vm0prefix);
-			registers.mmMC_VM_SYSTEM_APERTURE_HIGH_ADDR = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		sprintf(buf, "mm%sMC_VM_SYSTEM_APERTURE_LOW_ADDR", vm0prefix);
-			registers.mmMC_VM_SYSTEM_APERTURE_LOW_ADDR = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
 		system_aperture_low = ((uint64_t)registers.mmMC_VM_SYSTEM_APERTURE_LOW_ADDR) << 18;
 		system_aperture_high = ((uint64_t)registers.mmMC_VM_SYSTEM_APERTURE_HIGH_ADDR + 1) << 18;
-		sprintf(buf, "mm%sMC_VM_MX_L1_TLB_CNTL", vm0prefix);
-			registers.mmMC_VM_MX_L1_TLB_CNTL = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
 	}
-
-	sprintf(buf, "mm%sMC_VM_FB_LOCATION_BASE", vm0prefix);
-		registers.mmMC_VM_FB_LOCATION_BASE = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		fb_bottom = ((uint64_t)registers.mmMC_VM_FB_LOCATION_BASE) << 24;
-	sprintf(buf, "mm%sMC_VM_FB_LOCATION_TOP", vm0prefix);
-		registers.mmMC_VM_FB_LOCATION_TOP = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		fb_top = ((uint64_t)registers.mmMC_VM_FB_LOCATION_TOP + 1) << 24;
+	fb_bottom = ((uint64_t)registers.mmMC_VM_FB_LOCATION_BASE) << 24;
+	fb_top = ((uint64_t)registers.mmMC_VM_FB_LOCATION_TOP + 1) << 24;
 
 	// check if we are in ZFB mode
 	if (fb_top < fb_bottom)
@@ -936,50 +1181,19 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 		zfb = 0;
 
 	if (zfb) {
-		sprintf(buf, "mm%sMC_VM_AGP_BASE", regprefix);
-			registers.mmMC_VM_AGP_BASE = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-			agp_base = ((uint64_t)registers.mmMC_VM_AGP_BASE) << 24;
-		sprintf(buf, "mm%sMC_VM_AGP_BOT", regprefix);
-			registers.mmMC_VM_AGP_BOT = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-			agp_bot = ((uint64_t)registers.mmMC_VM_AGP_BOT) << 24;
-		sprintf(buf, "mm%sMC_VM_AGP_TOP", regprefix);
-			registers.mmMC_VM_AGP_TOP = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-			agp_top = (((uint64_t)registers.mmMC_VM_AGP_TOP + 1) << 24) | 0xFFFFFFULL;
+		agp_base = ((uint64_t)registers.mmMC_VM_AGP_BASE) << 24;
+		agp_bot = ((uint64_t)registers.mmMC_VM_AGP_BOT) << 24;
+		agp_top = (((uint64_t)registers.mmMC_VM_AGP_TOP + 1) << 24) | 0xFFFFFFULL;
 	} else {
 		agp_base = agp_bot = agp_top = 0;
 	}
 
-	// context registers
-	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_START_ADDR_LO32", regprefix, vmid);
-		registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		page_table_start_addr = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32 << 12;
-	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_START_ADDR_HI32", regprefix, vmid);
-		registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		page_table_start_addr |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32 << 44;
-	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_END_ADDR_LO32", regprefix, vmid);
-		registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		page_table_end_addr = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32 << 12;
-	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_END_ADDR_HI32", regprefix, vmid);
-		registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		page_table_end_addr |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32 << 44;
-
-	sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_CNTL", regprefix, vmid);
-		tmp = registers.mmVM_CONTEXTx_CNTL = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		page_table_depth      = umr_bitslice_reg_by_name_by_ip_by_instance(asic, hub, partition, buf, "PAGE_TABLE_DEPTH", tmp);
-		page_table_block_size = umr_bitslice_reg_by_name_by_ip_by_instance(asic, hub, partition, buf, "PAGE_TABLE_BLOCK_SIZE", tmp);
-
-	if (vmdata && vmdata->registers.page_table_base_addr) {
-		page_table_base_addr = vmdata->registers.page_table_base_addr;
-		registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 = page_table_base_addr & 0xFFFFFFFFULL;
-		registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 = page_table_base_addr >> 32ULL;
-	} else {
-		sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_BASE_ADDR_LO32", regprefix, vmid);
-			registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-			page_table_base_addr  = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 << 0;
-		sprintf(buf, "mm%sVM_CONTEXT%" PRIu32 "_PAGE_TABLE_BASE_ADDR_HI32", regprefix, vmid);
-			registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-			page_table_base_addr  |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 << 32;
-	}
+	page_table_start_addr = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_LO32 << 12;
+	page_table_start_addr |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_START_ADDR_HI32 << 44;
+	page_table_end_addr = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_LO32 << 12;
+	page_table_end_addr |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_END_ADDR_HI32 << 44;
+	page_table_base_addr  = (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_LO32 << 0;
+	page_table_base_addr |= (uint64_t)registers.mmVM_CONTEXTx_PAGE_TABLE_BASE_ADDR_HI32 << 32;
 
 	// for some firmwares when in GFXOFF power off state the registers
 	// read back as all F's
@@ -988,17 +1202,7 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 			"PAGE_TABLE_BASE_ADDRESS read as all F's likely indicates that the ASIC is powered off (possibly via gfxoff)\n"
 			"On GFX 10+ parts with gfxoff enabled a hang can occur, please disable with '--gfxoff 0'\n");
 
-	// update addresses for APUs
-	if (asic->is_apu) {
-		if (umr_find_reg(asic, "@mmVGA_MEMORY_BASE_ADDRESS") != 0xFFFFFFFF) {
-			registers.mmVGA_MEMORY_BASE_ADDRESS = umr_read_reg_by_name(asic, "mmVGA_MEMORY_BASE_ADDRESS");
-			registers.mmVGA_MEMORY_BASE_ADDRESS_HIGH = umr_read_reg_by_name(asic, "mmVGA_MEMORY_BASE_ADDRESS_HIGH");
-		}
-	}
-
-	sprintf(buf, "mm%sMC_VM_FB_OFFSET", regprefix);
-		registers.mmMC_VM_FB_OFFSET = umr_read_reg_by_name_by_ip_by_instance(asic, hub, partition, buf);
-		vm_fb_offset      = (uint64_t)registers.mmMC_VM_FB_OFFSET << 24;
+	vm_fb_offset = (uint64_t)registers.mmMC_VM_FB_OFFSET << 24;
 
 	if (asic->options.verbose) {
 		asic->mem_funcs.vm_message("\n\n=== VM Decoding of address %d@0x%" PRIx64 " ===\n", vmid, address);
@@ -1060,10 +1264,7 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 	// if we are using VMID 0 we need to apply any address translations
 	// as specified by the System Aperature registers
 	if (vmid == 0) {
-		uint32_t sam;
-
-		sprintf(buf, "mm%sMC_VM_MX_L1_TLB_CNTL", vm0prefix);
-		sam = umr_bitslice_reg_by_name_by_ip_by_instance(asic, hub, partition, buf, "SYSTEM_ACCESS_MODE", registers.mmMC_VM_MX_L1_TLB_CNTL);
+		uint32_t sam = ctx->sam;
 
 		// addresses in VMID0 need special handling w.r.t. PAGE_TABLE_START_ADDR
 		switch (sam) {
@@ -1181,20 +1382,20 @@ static int umr_access_vram_ai(struct umr_asic *asic, int partition,
 					// if in ZFB mode translate VRAM addresses as necessary
 					if (zfb && (pde_addr >= agp_bot && pde_addr < agp_top)) {
 						pde_addr = (pde_addr - agp_bot) + agp_base;
-						r = asic->mem_funcs.access_sram(asic, pde_addr, 8, &pde_entry, 0);
+						r = vm_read_entry(asic, partition, hubid | vmid, 1, pde_addr, &pde_entry);
 						if (r < 0) {
 							asic->mem_funcs.vm_message("[ERROR]: Could not read PDE from ZFB (SYSTEM RAM)\n");
 							return -1;
 						}
 					} else {
-						if (umr_read_vram(asic, partition, UMR_LINEAR_HUB, pde_addr, 8, &pde_entry) < 0) {
+						if (vm_read_entry(asic, partition, hubid | vmid, 0, pde_addr, &pde_entry) < 0) {
 							asic->mem_funcs.vm_message("[ERROR]: Could not read PDE from VRAM\n");
 							return -1;
 						}
 					}
 				} else {
 					int r;
-					r = asic->mem_funcs.access_sram(asic, prev_addr, 8, &pde_entry, 0);
+					r = vm_read_entry(asic, partition, hubid | vmid, 1, prev_addr, &pde_entry);
 					if (r < 0) {
 						asic->mem_funcs.vm_message("[ERROR]: Could not read PDE from SYSTEM RAM: %" PRIx64 "\n", pde_address + pde_idx * 8);
 						return -1;
@@ -1289,13 +1490,13 @@ pte_further:
 				// if in ZFB mode translate VRAM addresses as necessary
 				if (zfb && (pte_addr >= agp_bot && pte_addr < agp_top)) {
 					pte_addr = (pte_addr - agp_bot) + agp_base;
-					r = asic->mem_funcs.access_sram(asic, pte_addr, 8, &pte_entry, 0);
+					r = vm_read_entry(asic, partition, hubid | vmid, 1, pte_addr, &pte_entry);
 					if (r < 0) {
 						asic->mem_funcs.vm_message("[ERROR]: Cannot read PTE entry at SYSRAM address %" PRIx64, pte_addr);
 						return -1;
 					}
 				} else {
-					if (umr_read_vram(asic, partition, UMR_LINEAR_HUB, pte_addr, 8, &pte_entry) < 0) {
+					if (vm_read_entry(asic, partition, hubid | vmid, 0, pte_addr, &pte_entry) < 0) {
 						asic->mem_funcs.vm_message("[ERROR]: Cannot read PTE entry at VRAM address %" PRIx64, pte_addr);
 						return -1;
 					}
@@ -1303,7 +1504,7 @@ pte_further:
 			} else {
 				// the PDE says this PTB is located in system memory so read from there
 				int r;
-				r = asic->mem_funcs.access_sram(asic, prev_addr, 8, &pte_entry, 0);
+				r = vm_read_entry(asic, partition, hubid | vmid, 1, prev_addr, &pte_entry);
 				if (r < 0)
 					return -1;
 			}
@@ -1456,12 +1657,12 @@ pde_is_pte:
 			pte_idx = (address >> (12 + pde0_block_fragment_size));
 
 			if (pde_fields.system == 0) {
-				if (umr_read_vram(asic, partition, UMR_LINEAR_HUB, pde_fields.pte_base_addr + pte_idx * 8, 8, &pte_entry) < 0) {
+				if (vm_read_entry(asic, partition, hubid | vmid, 0, pde_fields.pte_base_addr + pte_idx * 8, &pte_entry) < 0) {
 					asic->err_msg("[ERROR]: Cannot read PTE from VRAM at address 0x%" PRIx64 "\n", pde_fields.pte_base_addr + pte_idx * 8);
 					return -1;
 				}
 			} else {
-				if (asic->mem_funcs.access_sram(asic, pde_fields.pte_base_addr + pte_idx * 8, 8, &pte_entry, 0) < 0) {
+				if (vm_read_entry(asic, partition, hubid | vmid, 1, pde_fields.pte_base_addr + pte_idx * 8, &pte_entry) < 0) {
 					asic->err_msg("[ERROR]: Cannot read PTE from SYS RAM at address 0x%" PRIx64 "\n", pde_fields.pte_base_addr + pte_idx * 8);
 					return -1;
 				}
@@ -1618,6 +1819,12 @@ int umr_access_vram(struct umr_asic *asic, int partition, uint32_t vmid, uint64_
 		return -1;
 	}
 
+	// a write may change the page tables or shaders so forget any cached translations
+	if (write_en) {
+		umr_vm_cache_invalidate(asic);
+		umr_shader_cache_invalidate(asic);
+	}
+
 	// read/write from process space
 	if ((vmid & 0xFF00) == UMR_PROCESS_HUB) {
 		if (!write_en)
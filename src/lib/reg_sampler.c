@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+#include <stdatomic.h>
+#include <time.h>
+#include <errno.h>
+
+/* A sampler reads a fixed list of registers at a fixed rate from its own
+ * thread and hands each sample to a single consumer through a ring.  The
+ * producer only ever writes head and the consumer only ever writes tail
+ * so the ring needs no lock.
+ */
+struct umr_sampler {
+	struct umr_asic asic;              // copy with its own regs2 handle (see umr_sampler_create())
+	struct umr_reg_batch *plan;        // the registers grouped by banking state
+	int own_mmio2;                     // asic.fd.mmio2 was opened for the sampler
+	uint32_t *slot,                    // plan index of each register in caller order
+		 n;
+
+	_Atomic uint32_t rate_hz;
+
+	// ring of samples, each is a 64-bit timestamp followed by n values
+	uint32_t *ring, ring_size, stride;
+	_Atomic uint32_t head, tail;
+
+	// statistics (written by the producer only)
+	_Atomic uint64_t samples, dropped;
+	uint64_t first_ns, last_ns,
+		 dev_ns, max_dev_ns;       // sum and maximum of |interval - period|
+	pthread_mutex_t stats_lock;
+
+	pthread_t thread;
+	int running;
+	_Atomic int quit;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * umr_sampler_create - Create a register sampler
+ *
+ * @asic: The device to sample
+ * @regs: The registers to read in each sample (see umr_reg_batch_entry())
+ * @n: The number of registers
+ * @rate_hz: The target number of samples per second
+ * @ring_size: The number of samples that can be waiting for the consumer
+ *
+ * The read plan is computed once here: the registers are grouped by
+ * their banking state so a sample only switches banks when it has to.
+ *
+ * The regs2 debugfs file keeps the banking state per open file, so
+ * the sampler opens the file again for its thread.  Sharing the
+ * caller's handle would change the banking under the caller and
+ * leave its cached state (asic->mmio2_bank) stale.
+ *
+ * Returns NULL on error.
+ */
+struct umr_sampler *umr_sampler_create(struct umr_asic *asic, const struct umr_reg_batch *regs, uint32_t n, uint32_t rate_hz, uint32_t ring_size)
+{
+	struct umr_sampler *s;
+	uint32_t x, y, z;
+	char *taken, fname[128];
+
+	if (!n || !rate_hz || !ring_size)
+		return NULL;
+
+	s = calloc(1, sizeof *s);
+	taken = calloc(n, 1);
+	if (s) {
+		pthread_mutex_init(&s->stats_lock, NULL);
+		s->plan = calloc(n, sizeof s->plan[0]);
+		s->slot = calloc(n, sizeof s->slot[0]);
+		s->stride = 2 + n;
+		s->ring = calloc((size_t)ring_size * s->stride, sizeof s->ring[0]);
+	}
+	if (!s || !taken || !s->plan || !s->slot || !s->ring) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		free(taken);
+		umr_sampler_free(s);
+		return NULL;
+	}
+
+	s->asic = *asic;
+	s->asic.mmio2_bank.valid = 0;
+	if (!asic->options.is_virtual && !asic->options.no_kernel && asic->fd.mmio2 >= 0) {
+		snprintf(fname, sizeof(fname)-1, "/sys/kernel/debug/dri/%d/amdgpu_regs2", asic->instance);
+		s->asic.fd.mmio2 = open(fname, O_RDWR);
+		if (s->asic.fd.mmio2 < 0) {
+			asic->err_msg("[ERROR]: Cannot open '%s' for the sampler\n", fname);
+			free(taken);
+			umr_sampler_free(s);
+			return NULL;
+		}
+		s->own_mmio2 = 1;
+	}
+	s->n = n;
+	s->ring_size = ring_size;
+	atomic_init(&s->rate_hz, rate_hz);
+	atomic_init(&s->head, 0);
+	atomic_init(&s->tail, 0);
+	atomic_init(&s->samples, 0);
+	atomic_init(&s->dropped, 0);
+	atomic_init(&s->quit, 0);
+
+	// group registers with the same banking keeping their order otherwise
+	for (z = x = 0; x < n; x++) {
+		if (taken[x])
+			continue;
+		for (y = x; y < n; y++) {
+			if (!taken[y] && !umr_bank_state_cmp(&regs[x].bank, &regs[y].bank)) {
+				taken[y] = 1;
+				s->plan[z] = regs[y];
+				s->slot[y] = z++;
+			}
+		}
+	}
+	free(taken);
+	return s;
+}
+
+/**
+ * sampler_read - Take one sample into @dst
+ */
+static void sampler_read(struct umr_sampler *s, uint32_t *dst)
+{
+	struct umr_asic *asic = &s->asic;
+	uint32_t x;
+
+	if (asic->reg_funcs.read_reg_batch) {
+		asic->reg_funcs.read_reg_batch(asic, s->plan, s->n);
+	} else {
+		for (x = 0; x < s->n; x++) {
+			if (!x || umr_bank_state_cmp(&s->plan[x].bank, &s->plan[x - 1].bank))
+				umr_set_bank_state(asic, &s->plan[x].bank);
+			s->plan[x].value = asic->reg_funcs.read_reg(asic, s->plan[x].addr, s->plan[x].type);
+		}
+	}
+	for (x = 0; x < s->n; x++)
+		dst[x] = s->plan[s->slot[x]].value;
+}
+
+/**
+ * sampler_push - Take a sample and queue it for the consumer
+ */
+static void sampler_push(struct umr_sampler *s, uint64_t ts, uint64_t period)
+{
+	uint32_t head, tail, *p;
+	uint64_t n, dev;
+
+	head = atomic_load_explicit(&s->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&s->tail, memory_order_acquire);
+
+	// a full ring drops the new sample, the consumer is too slow
+	if (head - tail == s->ring_size) {
+		atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+		p = NULL;
+	} else {
+		p = &s->ring[(head % s->ring_size) * s->stride];
+		p[0] = (uint32_t)ts;
+		p[1] = (uint32_t)(ts >> 32);
+	}
+
+	if (p) {
+		sampler_read(s, &p[2]);
+		atomic_store_explicit(&s->head, head + 1, memory_order_release);
+	}
+
+	// how far the interval between samples is off the period
+	pthread_mutex_lock(&s->stats_lock);
+	n = atomic_fetch_add_explicit(&s->samples, 1, memory_order_relaxed);
+	if (!n) {
+		s->first_ns = ts;
+	} else {
+		dev = ts - s->last_ns;
+		dev = (dev > period) ? dev - period : period - dev;
+		s->dev_ns += dev;
+		if (dev > s->max_dev_ns)
+			s->max_dev_ns = dev;
+	}
+	s->last_ns = ts;
+	pthread_mutex_unlock(&s->stats_lock);
+}
+
+/**
+ * umr_sampler_run - Take samples from the calling thread
+ *
+ * @s: The sampler
+ * @nsamples: The number of samples to take (0 to run until stopped)
+ *
+ * Samples are taken at absolute deadlines so time spent reading does
+ * not add up as drift.  A sample that is already late is taken right
+ * away and the following deadlines are moved so the sampler does not
+ * try to catch up with a burst.
+ */
+void umr_sampler_run(struct umr_sampler *s, uint64_t nsamples)
+{
+	struct timespec ts;
+	uint64_t deadline, period, t, taken;
+
+	period = 1000000000ULL / atomic_load(&s->rate_hz);
+	deadline = now_ns();
+	for (taken = 0; !atomic_load(&s->quit) && (!nsamples || taken < nsamples); taken++) {
+		t = now_ns();
+		if (t < deadline) {
+			ts.tv_sec = deadline / 1000000000ULL;
+			ts.tv_nsec = deadline % 1000000000ULL;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+			t = now_ns();
+		}
+		sampler_push(s, t, period);
+
+		period = 1000000000ULL / atomic_load(&s->rate_hz);
+		deadline += period;
+		if (deadline < t)
+			deadline = t + period;
+	}
+}
+
+static void *sampler_thread(void *data)
+{
+	umr_sampler_run(data, 0);
+	return NULL;
+}
+
+/**
+ * umr_sampler_start - Start sampling in a thread of its own
+ *
+ * Returns 0 on success.
+ */
+int umr_sampler_start(struct umr_sampler *s)
+{
+	if (s->running)
+		return 0;
+	atomic_store(&s->quit, 0);
+	if (pthread_create(&s->thread, NULL, sampler_thread, s)) {
+		s->asic.err_msg("[ERROR]: Cannot create the sampler thread\n");
+		return -1;
+	}
+	s->running = 1;
+	return 0;
+}
+
+/**
+ * umr_sampler_stop - Stop the sampling thread
+ *
+ * Samples already taken can still be collected with umr_sampler_pop().
+ */
+void umr_sampler_stop(struct umr_sampler *s)
+{
+	if (!s->running)
+		return;
+	atomic_store(&s->quit, 1);
+	pthread_join(s->thread, NULL);
+	s->running = 0;
+}
+
+/**
+ * umr_sampler_set_rate - Change the target sample rate
+ */
+void umr_sampler_set_rate(struct umr_sampler *s, uint32_t rate_hz)
+{
+	if (rate_hz)
+		atomic_store(&s->rate_hz, rate_hz);
+}
+
+/**
+ * umr_sampler_pop - Collect the oldest sample
+ *
+ * @s: The sampler
+ * @ts_ns: Where to store the CLOCK_MONOTONIC time of the sample (can be NULL)
+ * @values: Where to store the register values in the order they were
+ *          given to umr_sampler_create()
+ *
+ * Only one thread may collect samples.  Returns 1 if a sample was
+ * collected or 0 if there is none waiting.
+ */
+int umr_sampler_pop(struct umr_sampler *s, uint64_t *ts_ns, uint32_t *values)
+{
+	uint32_t head, tail, *p;
+
+	tail = atomic_load_explicit(&s->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&s->head, memory_order_acquire);
+	if (head == tail)
+		return 0;
+
+	p = &s->ring[(tail % s->ring_size) * s->stride];
+	if (ts_ns)
+		*ts_ns = p[0] | ((uint64_t)p[1] << 32);
+	memcpy(values, &p[2], s->n * sizeof values[0]);
+	atomic_store_explicit(&s->tail, tail + 1, memory_order_release);
+	return 1;
+}
+
+/**
+ * umr_sampler_get_stats - Get the achieved rate and timing jitter
+ *
+ * The jitter is how far the time between two samples was off the
+ * period on average, a sample taken late and the next one on time
+ * both count.
+ */
+void umr_sampler_get_stats(struct umr_sampler *s, struct umr_sampler_stats *st)
+{
+	uint64_t n;
+
+	memset(st, 0, sizeof *st);
+	pthread_mutex_lock(&s->stats_lock);
+	n = atomic_load(&s->samples);
+	st->samples = n;
+	st->dropped = atomic_load(&s->dropped);
+	if (n > 1) {
+		st->rate_hz = (double)(n - 1) * 1e9 / (double)(s->last_ns - s->first_ns ? s->last_ns - s->first_ns : 1);
+		st->jitter_us = (double)s->dev_ns / (n - 1) / 1e3;
+		st->max_jitter_us = (double)s->max_dev_ns / 1e3;
+	}
+	pthread_mutex_unlock(&s->stats_lock);
+}
+
+/**
+ * umr_sampler_free - Stop a sampler and free it
+ */
+void umr_sampler_free(struct umr_sampler *s)
+{
+	if (!s)
+		return;
+	umr_sampler_stop(s);
+	if (s->own_mmio2)
+		close(s->asic.fd.mmio2);
+	pthread_mutex_destroy(&s->stats_lock);
+	free(s->ring);
+	free(s->plan);
+	free(s->slot);
+	free(s);
+}
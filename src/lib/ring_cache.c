@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+
+/* A ring cache keeps the packets between the read and write pointers
+ * of a ring decoded as a list of segments in ring order.  When it is
+ * updated only the packets submitted since the last update are read
+ * and decoded and segments the CP has consumed are released, so a
+ * ring that barely moves between samples costs a read of its pointers.
+ */
+
+#define RING_DIST(a, b, size) (((b) + (size) - (a)) % (size))
+
+static void clear_lookups(struct umr_ring_cache *rc)
+{
+	int x;
+
+	for (x = 0; x < UMR_RING_CACHE_LOOKUPS; x++) {
+		free(rc->lookups[x].shader);
+		rc->lookups[x].shader = NULL;
+		rc->lookups[x].valid = 0;
+	}
+}
+
+static void drop_segments(struct umr_ring_cache *rc, int n)
+{
+	int x;
+
+	for (x = 0; x < n; x++)
+		umr_packet_free(rc->segs[x].stream);
+	memmove(&rc->segs[0], &rc->segs[n], (rc->nsegs - n) * sizeof rc->segs[0]);
+	rc->nsegs -= n;
+}
+
+static int read_ptrs(struct umr_ring_cache *rc, uint32_t *ptrs, uint32_t *ringsize)
+{
+	uint32_t *ringdata;
+
+	if (rc->asic->ring_func.read_ring_ptrs)
+		return rc->asic->ring_func.read_ring_ptrs(rc->asic, rc->ringname, ptrs, ringsize);
+
+	ringdata = rc->asic->ring_func.read_ring_data(rc->asic, rc->ringname, ringsize);
+	if (!ringdata)
+		return -1;
+	memcpy(ptrs, ringdata, 3 * sizeof ptrs[0]);
+	free(ringdata);
+	return 0;
+}
+
+static int read_words(struct umr_ring_cache *rc, uint32_t start, uint32_t n, uint32_t *dst)
+{
+	uint32_t *ringdata, ringsize, x;
+
+	if (rc->asic->ring_func.read_ring_ptrs)
+		return umr_read_ring_words(rc->asic, rc->ringname, start, n, dst);
+
+	ringdata = rc->asic->ring_func.read_ring_data(rc->asic, rc->ringname, &ringsize);
+	if (!ringdata)
+		return -1;
+	ringsize /= 4;
+	for (x = 0; x < n; x++)
+		dst[x] = ringdata[3 + (start + x) % ringsize];
+	free(ringdata);
+	return 0;
+}
+
+/*
+ * decode_segment - Decode @n words of the ring from @start into @seg
+ */
+static int decode_segment(struct umr_ring_cache *rc, int seg, uint32_t start, uint32_t n)
+{
+	uint32_t *words;
+
+	words = calloc(n, sizeof *words);
+	if (!words) {
+		rc->asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	if (read_words(rc, start, n, words)) {
+		free(words);
+		return -1;
+	}
+	rc->segs[seg].start = start;
+	rc->segs[seg].nwords = n;
+	rc->segs[seg].stream = umr_packet_decode_buffer(rc->asic, NULL, 0, 0, words, n, rc->rt);
+	rc->words_decoded += n;
+	free(words);
+	return 0;
+}
+
+/**
+ * umr_ring_cache_create - Create a cache of the decoded packets of a ring
+ *
+ * @asic: The ASIC the ring belongs to
+ * @ringname: The name of the ring without the amdgpu_ring_ prefix
+ * @rt: The type of packets on the ring (can be UMR_RING_GUESS)
+ *
+ * Nothing is decoded until umr_ring_cache_update() is called.
+ *
+ * Returns NULL on error.
+ */
+struct umr_ring_cache *umr_ring_cache_create(struct umr_asic *asic, const char *ringname, enum umr_ring_type rt)
+{
+	struct umr_ring_cache *rc;
+
+	if (rt == UMR_RING_GUESS) {
+		rt = umr_packet_guess_ring_type(asic, ringname);
+		if (rt == UMR_RING_UNK)
+			return NULL;
+	}
+
+	rc = calloc(1, sizeof *rc);
+	if (!rc) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return NULL;
+	}
+	rc->asic = asic;
+	rc->rt = rt;
+	strncpy(rc->ringname, ringname, sizeof(rc->ringname) - 1);
+	return rc;
+}
+
+/**
+ * umr_ring_cache_update - Bring the cache up to date with the ring
+ *
+ * @rc: The ring cache
+ *
+ * Reads the ring pointers and decodes only what was written since the
+ * last update.  If the ring was reset or the pointers moved in a way
+ * that does not follow on from the last update the whole active part
+ * of the ring is decoded again.
+ *
+ * Returns 0 on success.
+ */
+int umr_ring_cache_update(struct umr_ring_cache *rc)
+{
+	uint32_t ptrs[3], ringsize, r, w, from, n, skip;
+
+	if (read_ptrs(rc, ptrs, &ringsize))
+		return -1;
+	ringsize /= 4;
+	if (!ringsize)
+		return -1;
+	r = ptrs[0] % ringsize;
+	w = ptrs[1] % ringsize;
+
+	if (ringsize == rc->ringsize && r == rc->rptr && w == rc->wptr)
+		return 0;
+	clear_lookups(rc);
+
+	// new submissions may come with new mappings and shaders
+	umr_vm_cache_invalidate(rc->asic);
+	umr_shader_cache_invalidate(rc->asic);
+
+	// the new active part has to start inside what is cached and end after it
+	if (ringsize != rc->ringsize || !rc->nsegs ||
+	    RING_DIST(rc->segs[0].start, r, ringsize) > RING_DIST(rc->segs[0].start, rc->wptr, ringsize) ||
+	    RING_DIST(r, rc->wptr, ringsize) > RING_DIST(r, w, ringsize)) {
+		drop_segments(rc, rc->nsegs);
+		from = r;
+	} else {
+		from = rc->wptr;
+
+		// release what the CP consumed and re-decode a partly consumed segment
+		for (n = 0; (int)n < rc->nsegs && RING_DIST(rc->segs[n].start, r, ringsize) >= rc->segs[n].nwords; n++);
+		drop_segments(rc, n);
+		if (rc->nsegs && (skip = RING_DIST(rc->segs[0].start, r, ringsize))) {
+			umr_packet_free(rc->segs[0].stream);
+			rc->segs[0].stream = NULL;
+			if (decode_segment(rc, 0, r, rc->segs[0].nwords - skip))
+				goto reset;
+		}
+	}
+
+	n = RING_DIST(from, w, ringsize);
+	if (n) {
+		if (rc->nsegs == UMR_RING_CACHE_SEGMENTS) {
+			drop_segments(rc, rc->nsegs);
+			from = r;
+			n = RING_DIST(r, w, ringsize);
+		}
+		if (decode_segment(rc, rc->nsegs, from, n))
+			goto reset;
+		++rc->nsegs;
+	}
+
+	rc->ringsize = ringsize;
+	rc->rptr = r;
+	rc->wptr = w;
+	return 0;
+
+reset:
+	drop_segments(rc, rc->nsegs);
+	rc->ringsize = 0;
+	return -1;
+}
+
+/**
+ * umr_ring_cache_find_shader - Find a shader or compute kernel in the cached packets
+ *
+ * @rc: The ring cache
+ * @vmid: Which VMID space does the kernel belong to
+ * @addr: An address inside the kernel program
+ *
+ * Gives the same result as umr_packet_find_shader() on the packets
+ * between the read and write pointers at the last update.  Lookups are
+ * remembered until the cached packets change.
+ *
+ * Returns a copy of the shader to be freed by the caller or NULL.
+ */
+struct umr_shaders_pgm *umr_ring_cache_find_shader(struct umr_ring_cache *rc, unsigned vmid, uint64_t addr)
+{
+	struct umr_shaders_pgm *shader = NULL, *copy;
+	uint32_t slot;
+	int x;
+
+	slot = (uint32_t)((addr >> 2) ^ (addr >> 14) ^ ((uint64_t)vmid * 0x9E3779B1UL)) % UMR_RING_CACHE_LOOKUPS;
+	if (rc->lookups[slot].valid && rc->lookups[slot].vmid == vmid && rc->lookups[slot].addr == addr) {
+		++rc->lookups_cached;
+		shader = rc->lookups[slot].shader;
+	} else {
+		for (x = 0; x < rc->nsegs && !shader; x++)
+			if (rc->segs[x].stream)
+				shader = umr_packet_find_shader(rc->segs[x].stream, vmid, addr);
+
+		free(rc->lookups[slot].shader);
+		rc->lookups[slot].vmid = vmid;
+		rc->lookups[slot].addr = addr;
+		rc->lookups[slot].shader = shader;
+		rc->lookups[slot].valid = 1;
+	}
+
+	if (!shader)
+		return NULL;
+	copy = calloc(1, sizeof *copy);
+	if (copy)
+		*copy = *shader;
+	return copy;
+}
+
+/**
+ * umr_ring_cache_free - Free a ring cache and everything it decoded
+ */
+void umr_ring_cache_free(struct umr_ring_cache *rc)
+{
+	if (!rc)
+		return;
+	clear_lookups(rc);
+	drop_segments(rc, rc->nsegs);
+	free(rc);
+}
@@ -34,27 +34,31 @@
  */
 int umr_ring_is_halted(struct umr_asic *asic, char *ringname)
 {
-	uint32_t *ringdata, ringsize;
+	uint32_t *ringdata, ringsize, ptrs[3];
 	int n;
 
 	if (!strcmp(ringname, "none"))
 		return 1;
 
-	// read ring data and reduce indeices modulo ring size
+	// read the ring pointers and reduce them modulo ring size
 	// since the kernel returned values might be unwrapped.
 	for (n = 0; n < 100; n++) {
-		ringdata = asic->ring_func.read_ring_data(asic, ringname, &ringsize);
-		if (!ringdata) {
-			return 0;
+		if (asic->ring_func.read_ring_ptrs) {
+			if (asic->ring_func.read_ring_ptrs(asic, ringname, ptrs, &ringsize))
+				return 0;
+		} else {
+			ringdata = asic->ring_func.read_ring_data(asic, ringname, &ringsize);
+			if (!ringdata) {
+				return 0;
+			}
+			memcpy(ptrs, ringdata, sizeof ptrs);
+			free(ringdata);
 		}
 		ringsize /= 4;
-		ringdata[0] %= ringsize;
-		ringdata[1] %= ringsize;
-		if (ringdata[0] == ringdata[1]) {
-			free(ringdata);
+		if (!ringsize)
+			return 0;
+		if ((ptrs[0] % ringsize) == (ptrs[1] % ringsize))
 			return 0;
-		}
-		free(ringdata);
 		usleep(5);
 	}
 
@@ -30,96 +30,235 @@
  * for client services
  */
 
-/* helper used to send opcodes to the server */
-static struct rumr_buffer *send_opcode(struct rumr_client_state *state, uint32_t opcode, int nparam, ...)
+static int id_test(const uint32_t *map, uint32_t id)
+{
+	return (map[id >> 5] >> (id & 31)) & 1;
+}
+
+static void id_set(uint32_t *map, uint32_t id)
+{
+	map[id >> 5] |= 1UL << (id & 31);
+}
+
+static void id_clear(uint32_t *map, uint32_t id)
+{
+	map[id >> 5] &= ~(1UL << (id & 31));
+}
+
+// the reply to @id arrived (or never will), its ID may be handed out again
+static void id_retire(struct rumr_client_state *state, uint32_t id)
+{
+	id_clear(state->outstanding, id);
+	id_clear(state->discarded, id);
+	--state->no_outstanding;
+}
+
+/**
+ * @brief Transmit a request to the server without waiting for the reply.
+ *
+ * Every request is tagged with an ID that the server echoes back so
+ * several requests can be in flight at once and their replies picked up
+ * with rumr_client_collect() in any order.  An ID is not reused until
+ * the reply to the request it was last given to has arrived so a late
+ * reply is never taken for the answer to a newer request.
+ *
+ * @param state Pointer to the RUMR client state structure.
+ * @param opcode The RUMR_OP_* opcode of the request.
+ * @param pkt The words following the header.
+ * @param pktsize The number of words in @pkt.
+ * @param id Where to store the ID of the request.
+ * @return int Returns 0 on success, -1 on failure.
+ */
+int rumr_client_submit(struct rumr_client_state *state, uint32_t opcode, const uint32_t *pkt, uint32_t pktsize, uint32_t *id)
 {
-	va_list ap;
 	struct rumr_buffer *buf;
 	int r;
 
-	va_start(ap, nparam);
+	if (state->no_outstanding >= RUMR_MAX_OUTSTANDING) {
+		state->log_msg("[ERROR]: Too many requests waiting for a reply from the server.\n");
+		return -1;
+	}
+
+	// skip IDs still waiting for a reply after the ID wrapped
+	while (id_test(state->outstanding, state->next_id))
+		state->next_id = (state->next_id + 1) & RUMR_MAX_ID;
+	*id = state->next_id;
+	state->next_id = (state->next_id + 1) & RUMR_MAX_ID;
+
 	buf = rumr_buffer_init();
-	rumr_buffer_add_uint32(buf, (opcode << 10) | (RUMR_VERSION << 1)); // header word
-	while (nparam--) {
-		uint32_t next;
-		next = va_arg(ap, uint32_t);
-		rumr_buffer_add_uint32(buf, next);
+	if (!buf) {
+		state->log_msg("[ERROR]: Out of memory\n");
+		return -1;
 	}
-	r = state->comm.tx(&state->comm, buf);
+	rumr_buffer_add_uint32(buf, RUMR_HEADER(opcode, *id)); // header word
+	if (pktsize)
+		rumr_buffer_add_data(buf, (void *)pkt, pktsize * 4);
+	r = buf->failed ? -1 : state->comm.tx(&state->comm, buf);
 	rumr_buffer_free(buf);
-	buf = NULL;
+
+	// part of the request may have gone out so a reply can still arrive
+	id_set(state->outstanding, *id);
+	++state->no_outstanding;
 	if (r) {
+		id_set(state->discarded, *id);
 		state->log_msg("[ERROR]: Could not transmit opcode to server.\n");
-		goto error;
+		return -1;
 	}
+	return 0;
+}
 
-	// there is no return packet
-	if (opcode == RUMR_OP_GOODBYE)
-		goto error;
-
-	// return reply from server
-	r = state->comm.rx(&state->comm, &buf);
-	if (!r && buf) {
-		uint32_t reply;
-		// ensure version and server bit is correct
-		reply = rumr_buffer_read_uint32(buf);
-		if (((reply>>1)&0xFF) != RUMR_VERSION) {
-			state->log_msg("[ERROR]: Incorrect server version returned from server\n");
-			rumr_buffer_free(buf);
-			return NULL;
-		}
-		if (!(reply&1)) {
-			state->log_msg("[ERROR]: Incorrect server flag returned from server\n");
-			rumr_buffer_free(buf);
-			return NULL;
+/**
+ * @brief Give up on the reply to a request made with rumr_client_submit().
+ *
+ * The reply is dropped if it already arrived and otherwise when it
+ * does.  Until then the ID is not handed out again.
+ *
+ * @param state Pointer to the RUMR client state structure.
+ * @param id The ID returned by rumr_client_submit().
+ */
+void rumr_client_discard(struct rumr_client_state *state, uint32_t id)
+{
+	struct rumr_pending_reply **pp, *p;
+
+	if (id > RUMR_MAX_ID || !id_test(state->outstanding, id))
+		return;
+
+	for (pp = &state->pending; *pp; pp = &(*pp)->next) {
+		if ((*pp)->id == id) {
+			p = *pp;
+			*pp = p->next;
+			rumr_buffer_free(p->buf);
+			free(p);
+			id_retire(state, id);
+			return;
 		}
-	} else {
-		rumr_buffer_free(buf);
-		buf = NULL;
 	}
-error:
-	va_end(ap);
-	return buf;
+	id_set(state->discarded, id);
 }
 
-static struct rumr_buffer *send_opcode_buf(struct rumr_client_state *state, uint32_t opcode, uint32_t *pkt, uint32_t pktsize)
+/**
+ * @brief Wait for the reply to a request made with rumr_client_submit().
+ *
+ * Replies to other outstanding requests that arrive first are kept until
+ * they are collected, replies to discarded or unknown requests are
+ * dropped.  If no reply can be returned the request is discarded.
+ *
+ * @param state Pointer to the RUMR client state structure.
+ * @param id The ID returned by rumr_client_submit().
+ * @return struct rumr_buffer* The reply positioned after the header or NULL on error.
+ */
+struct rumr_buffer *rumr_client_collect(struct rumr_client_state *state, uint32_t id)
 {
+	struct rumr_pending_reply **pp, *p;
 	struct rumr_buffer *buf;
-	int r;
+	uint32_t reply, rid;
 
-	buf = rumr_buffer_init();
-		rumr_buffer_add_uint32(buf, (opcode << 10) | (RUMR_VERSION << 1)); // header word
-		rumr_buffer_add_data(buf, pkt, pktsize*4);
-	r = state->comm.tx(&state->comm, buf);
-	rumr_buffer_free(buf);
-	buf = NULL;
-	if (r) {
-		state->log_msg("[ERROR]: Could not transmit opcode to server.\n");
-		goto error;
+	if (id > RUMR_MAX_ID || !id_test(state->outstanding, id) || id_test(state->discarded, id)) {
+		state->log_msg("[ERROR]: No request with ID %" PRIu32 " is waiting for a reply.\n", id);
+		return NULL;
+	}
+
+	// did it already arrive?
+	for (pp = &state->pending; *pp; pp = &(*pp)->next) {
+		if ((*pp)->id == id) {
+			p = *pp;
+			*pp = p->next;
+			buf = p->buf;
+			free(p);
+			id_retire(state, id);
+			return buf;
+		}
 	}
 
-	// return reply from server
-	r = state->comm.rx(&state->comm, &buf);
-	if (!r && buf) {
-		uint32_t reply;
+	for (;;) {
+		if (state->comm.rx(&state->comm, &buf) || !buf) {
+			rumr_buffer_free(buf);
+			goto error;
+		}
+
 		// ensure version and server bit is correct
 		reply = rumr_buffer_read_uint32(buf);
 		if (((reply>>1)&0xFF) != RUMR_VERSION) {
 			state->log_msg("[ERROR]: Incorrect server version returned from server\n");
 			rumr_buffer_free(buf);
-			return NULL;
+			goto error;
 		}
 		if (!(reply&1)) {
 			state->log_msg("[ERROR]: Incorrect server flag returned from server\n");
 			rumr_buffer_free(buf);
-			return NULL;
+			goto error;
 		}
-	} else {
-		rumr_buffer_free(buf);
-		buf = NULL;
+
+		rid = RUMR_HEADER_ID(reply);
+		if (rid == id) {
+			id_retire(state, id);
+			return buf;
+		}
+
+		if (!id_test(state->outstanding, rid)) {
+			state->log_msg("[WARNING]: Dropping reply to unknown request %" PRIu32 "\n", rid);
+			rumr_buffer_free(buf);
+			continue;
+		}
+		if (id_test(state->discarded, rid)) {
+			id_retire(state, rid);
+			rumr_buffer_free(buf);
+			continue;
+		}
+		for (p = state->pending; p && p->id != rid; p = p->next);
+		if (p) {
+			state->log_msg("[WARNING]: Dropping second reply to request %" PRIu32 "\n", rid);
+			rumr_buffer_free(buf);
+			continue;
+		}
+
+		// hold on to it for whoever asked, there is at most one per outstanding request
+		p = calloc(1, sizeof *p);
+		if (!p) {
+			state->log_msg("[ERROR]: Out of memory\n");
+			rumr_buffer_free(buf);
+			rumr_client_discard(state, rid);
+			goto error;
+		}
+		p->id = rid;
+		p->buf = buf;
+		p->next = state->pending;
+		state->pending = p;
 	}
 error:
-	return buf;
+	rumr_client_discard(state, id);
+	return NULL;
+}
+
+/* helper used to send opcodes to the server */
+static struct rumr_buffer *send_opcode_buf(struct rumr_client_state *state, uint32_t opcode, uint32_t *pkt, uint32_t pktsize)
+{
+	uint32_t id;
+
+	if (rumr_client_submit(state, opcode, pkt, pktsize, &id))
+		return NULL;
+
+	// there is no return packet
+	if (opcode == RUMR_OP_GOODBYE) {
+		rumr_client_discard(state, id);
+		return NULL;
+	}
+
+	return rumr_client_collect(state, id);
+}
+
+static struct rumr_buffer *send_opcode(struct rumr_client_state *state, uint32_t opcode, int nparam, ...)
+{
+	va_list ap;
+	uint32_t pkt[16];
+	int n;
+
+	va_start(ap, nparam);
+	for (n = 0; n < nparam; n++)
+		pkt[n] = va_arg(ap, uint32_t);
+	va_end(ap);
+
+	return send_opcode_buf(state, opcode, pkt, nparam);
 }
 
 // handle VRAM/SRAM reads/writes and DMA translations
@@ -226,9 +365,9 @@ static int gprs_op(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thr
 			shift = 3;  // on SI..CIK allocations were done in 8-dword blocks
 		else
 			shift = 4;  // on VI allocations are in 16-dword blocks
-		size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "SGPR_SIZE") + 1) << shift);
+		size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE) + 1) << shift);
 	} else {
-		size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << asic->parameters.vgpr_granularity);
+		size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity);
 	}
 
 	buf = send_opcode(asic->gpr_read_funcs.data, RUMR_OP_GPR_ACCESS, 9,
@@ -331,81 +470,45 @@ static int get_wave_status(struct umr_asic *asic, unsigned se, unsigned sh, unsi
 	return r;
 }
 
-static int mmio_reg_op(struct umr_asic *asic, uint64_t addr, enum regclass type, uint32_t *value, int read_en)
+// build a REG_ACCESS packet, returns the number of words
+static uint32_t reg_op_pkt(uint32_t *pkt, uint64_t addr, enum regclass type, int use_bank, const union umr_bank_select *bank, uint32_t value, int read_en)
 {
-	struct rumr_buffer *buf;
-	struct rumr_client_state *state = asic->reg_funcs.data;
-
-	if (asic->options.use_bank == 1) {
+	pkt[0] = (uint32_t)(addr & 0xFFFFFFFFULL);		// ADDR_LO
+	pkt[1] = (uint32_t)(addr >> 32ULL);			// ADDR_HI
+	pkt[2] = (uint32_t)((read_en ? 1 : 0) | (type << 3));	// ACCESS_BANK
+	if (use_bank == 1) {
 		// GRBM
-		if (read_en) {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 7,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(1 | (1 << 1) | (type << 3)),		// ACCESS_BANK
-					(uint32_t)asic->options.bank.grbm.se,
-					(uint32_t)asic->options.bank.grbm.sh,
-					(uint32_t)asic->options.bank.grbm.instance,
-					(uint32_t)0);
-		} else {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 9,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(0 | (1 << 1) | (type << 3)),		// ACCESS_BANK
-					(uint32_t)asic->options.bank.grbm.se,
-					(uint32_t)asic->options.bank.grbm.sh,
-					(uint32_t)asic->options.bank.grbm.instance,
-					(uint32_t)0,
-					(uint32_t)(*value),
-					(uint32_t)0);
-		}
-	} else if (asic->options.use_bank == 2) {
+		pkt[2] |= 1 << 1;
+		pkt[3] = bank->grbm.se;
+		pkt[4] = bank->grbm.sh;
+		pkt[5] = bank->grbm.instance;
+		pkt[6] = 0;
+	} else if (use_bank == 2) {
 		// SRBM
-		if (read_en) {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 7,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(1 | (1 << 2) | (type << 3)),		// ACCESS_BANK
-					(uint32_t)asic->options.bank.srbm.me,
-					(uint32_t)asic->options.bank.srbm.pipe,
-					(uint32_t)asic->options.bank.srbm.queue,
-					(uint32_t)asic->options.bank.srbm.vmid);
-		} else {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 9,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(0 | (1 << 2) | (type << 3)),		// ACCESS_BANK
-					(uint32_t)asic->options.bank.srbm.me,
-					(uint32_t)asic->options.bank.srbm.pipe,
-					(uint32_t)asic->options.bank.srbm.queue,
-					(uint32_t)asic->options.bank.srbm.vmid,
-					(uint32_t)(*value),
-					(uint32_t)0);
-		}
+		pkt[2] |= 1 << 2;
+		pkt[3] = bank->srbm.me;
+		pkt[4] = bank->srbm.pipe;
+		pkt[5] = bank->srbm.queue;
+		pkt[6] = bank->srbm.vmid;
 	} else {
 		// No bank switching
-		if (read_en) {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 7,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(1 | (type << 3)),			// ACCESS_BANK
-					(uint32_t)0,
-					(uint32_t)0,
-					(uint32_t)0,
-					(uint32_t)0);
-		} else {
-			buf = send_opcode(asic->reg_funcs.data, RUMR_OP_REG_ACCESS, 9,
-					(uint32_t)(addr & 0xFFFFFFFFULL),		// ADDR_LO
-					(uint32_t)(addr >> 32ULL),			// ADDR_HI
-					(uint32_t)(0 | (type << 3)),			// ACCESS_BANK
-					(uint32_t)0,
-					(uint32_t)0,
-					(uint32_t)0,
-					(uint32_t)0,
-					(uint32_t)(*value),
-					(uint32_t)0);
-		}
+		pkt[3] = pkt[4] = pkt[5] = pkt[6] = 0;
 	}
+	if (read_en)
+		return 7;
+	pkt[7] = value;
+	pkt[8] = 0;
+	return 9;
+}
+
+static int mmio_reg_op(struct umr_asic *asic, uint64_t addr, enum regclass type, uint32_t *value, int read_en)
+{
+	struct rumr_buffer *buf;
+	struct rumr_client_state *state = asic->reg_funcs.data;
+	uint32_t pkt[9], n;
+
+	n = reg_op_pkt(pkt, addr, type, asic->options.use_bank, &asic->options.bank, *value, read_en);
+	buf = send_opcode_buf(state, RUMR_OP_REG_ACCESS, pkt, n);
 
 	if (!buf || rumr_buffer_read_uint32(buf) != 1) {
 		state->log_msg("[ERROR]: Could not transmit register opcode.\n");
@@ -420,6 +523,108 @@ static int mmio_reg_op(struct umr_asic *asic, uint64_t addr, enum regclass type,
 	return 0;
 }
 
+// read a list of registers with one RUMR_OP_BATCH frame per RUMR_BATCH_MAX reads
+static int read_reg_batch_frames(struct rumr_client_state *state, struct umr_reg_batch *regs, uint32_t n)
+{
+	struct rumr_buffer *buf;
+	uint32_t *pkt, x, y, count, len;
+	int r = 0;
+
+	pkt = calloc(1 + RUMR_BATCH_MAX * 8, sizeof pkt[0]);
+	if (!pkt) {
+		state->log_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+
+	for (x = 0; x < n && !r; x += count) {
+		count = (n - x > RUMR_BATCH_MAX) ? RUMR_BATCH_MAX : n - x;
+		pkt[0] = count;
+		for (len = 1, y = 0; y < count; y++) {
+			pkt[len] = (7 << 8) | RUMR_OP_REG_ACCESS;
+			len += 1 + reg_op_pkt(&pkt[len + 1], regs[x + y].addr, regs[x + y].type,
+					      regs[x + y].bank.use_bank, &regs[x + y].bank.bank, 0, 1);
+		}
+
+		buf = send_opcode_buf(state, RUMR_OP_BATCH, pkt, len);
+		if (!buf || rumr_buffer_read_uint32(buf) != count) {
+			state->log_msg("[ERROR]: Could not transmit register batch.\n");
+			rumr_buffer_free(buf);
+			r = -1;
+			break;
+		}
+		for (y = 0; y < count; y++) {
+			len = rumr_buffer_read_uint32(buf);
+			if (len != 12 || rumr_buffer_read_uint32(buf) != 1) {
+				regs[x + y].value = 0xBEBEBEEF;
+				r = -1;
+				buf->roffset += (len >= 4) ? len - 4 : 0;
+				continue;
+			}
+			regs[x + y].value = rumr_buffer_read_uint32(buf);
+			(void)rumr_buffer_read_uint32(buf); // VALUE_HI
+		}
+		rumr_buffer_free(buf);
+	}
+	free(pkt);
+	return r;
+}
+
+// read a list of registers keeping up to RUMR_MAX_INFLIGHT requests queued
+static int read_reg_batch_pipelined(struct rumr_client_state *state, struct umr_reg_batch *regs, uint32_t n)
+{
+	struct rumr_buffer *buf;
+	uint32_t ids[RUMR_MAX_INFLIGHT], pkt[9], sent, done, len;
+	int r = 0;
+
+	for (sent = done = 0; done < n; ) {
+		if (sent < n && sent - done < RUMR_MAX_INFLIGHT) {
+			len = reg_op_pkt(pkt, regs[sent].addr, regs[sent].type, regs[sent].bank.use_bank, &regs[sent].bank.bank, 0, 1);
+			if (rumr_client_submit(state, RUMR_OP_REG_ACCESS, pkt, len, &ids[sent % RUMR_MAX_INFLIGHT]))
+				goto error;
+			++sent;
+			continue;
+		}
+
+		buf = rumr_client_collect(state, ids[done % RUMR_MAX_INFLIGHT]);
+		if (!buf) {
+			++done; // collect already discarded it
+			goto error;
+		}
+		if (rumr_buffer_read_uint32(buf) == 1) {
+			regs[done].value = rumr_buffer_read_uint32(buf);
+		} else {
+			regs[done].value = 0xBEBEBEEF;
+			r = -1;
+		}
+		rumr_buffer_free(buf);
+		++done;
+	}
+	return r;
+error:
+	// the replies still on their way are not answers to whatever is sent next
+	for (; done < sent; done++)
+		rumr_client_discard(state, ids[done % RUMR_MAX_INFLIGHT]);
+	return -1;
+}
+
+/** read_reg_batch -- Read a list of registers
+ * @asic: The device the registers are from
+ * @regs: The registers to read and the banking for each
+ * @n: The number of entries in @regs
+ *
+ * Servers at revision 2 or later get the reads in RUMR_OP_BATCH frames,
+ * older ones get them as individual requests without waiting for each
+ * reply in turn.
+ */
+static int read_reg_batch(struct umr_asic *asic, struct umr_reg_batch *regs, uint32_t n)
+{
+	struct rumr_client_state *state = asic->reg_funcs.data;
+
+	if (state->server_revision >= 2)
+		return read_reg_batch_frames(state, regs, n);
+	return read_reg_batch_pipelined(state, regs, n);
+}
+
 /** read_reg -- Read a register
  * @asic: The device the register is from
  * @addr:  The byte address of the register to read
@@ -480,7 +685,8 @@ int rumr_client_discover(struct rumr_client_state *state)
 {
 	struct rumr_buffer *buf;
 
-	buf = send_opcode(state, RUMR_OP_DISCOVER, 0);
+	// tell the server our revision, one that predates revisions ignores it
+	buf = send_opcode(state, RUMR_OP_DISCOVER, 1, (uint32_t)RUMR_REVISION);
 	if (!buf) {
 		state->log_msg("[ERROR]: Could not transmit discoever opcode.\n");
 		return -1;
@@ -488,6 +694,13 @@ int rumr_client_discover(struct rumr_client_state *state)
 
 	state->asic = rumr_parse_serialized_asic(buf);
 
+	// a server that knows about revisions appends its own
+	if (buf->woffset - buf->roffset >= 4)
+		state->server_revision = rumr_buffer_read_uint32(buf);
+	else
+		state->server_revision = 1;
+	rumr_buffer_free(buf);
+
 	return state->asic ? 0 : -1;
 }
 
@@ -510,6 +723,11 @@ int rumr_client_connect(struct rumr_client_state *state, struct rumr_comm_funcs
 
 	state->comm = *cf;
 	state->log_msg = state->comm.log_msg;
+	state->next_id = 0;
+	state->no_outstanding = 0;
+	memset(state->outstanding, 0, sizeof state->outstanding);
+	memset(state->discarded, 0, sizeof state->discarded);
+	state->pending = NULL;
 
 	r = state->comm.connect(&state->comm, addr);
 	if (r < 0) {
@@ -538,6 +756,7 @@ int rumr_client_connect(struct rumr_client_state *state, struct rumr_comm_funcs
 		state->asic->reg_funcs.data = state;
 		state->asic->reg_funcs.read_reg = read_reg;
 		state->asic->reg_funcs.write_reg = write_reg;
+		state->asic->reg_funcs.read_reg_batch = read_reg_batch;
 	// wavefuncs
 		state->asic->wave_funcs.data = state;
 		state->asic->wave_funcs.get_wave_status = get_wave_status;
@@ -571,6 +790,7 @@ int rumr_client_connect(struct rumr_client_state *state, struct rumr_comm_funcs
 
 	// create mmio lookup accelerator
 		umr_create_mmio_accel(state->asic);
+		umr_create_reg_index(state->asic);
 
 	return 0;
 }
@@ -585,6 +805,16 @@ int rumr_client_connect(struct rumr_client_state *state, struct rumr_comm_funcs
  */
 void rumr_client_close(struct rumr_client_state *state)
 {
+	struct rumr_pending_reply *p;
+
 	send_opcode(state, RUMR_OP_GOODBYE, 0);
 	umr_free_asic(state->asic);
+
+	// drop replies nobody collected
+	while (state->pending) {
+		p = state->pending->next;
+		rumr_buffer_free(state->pending->buf);
+		free(state->pending);
+		state->pending = p;
+	}
 }
@@ -295,10 +295,11 @@ static int handle_op_reg_access(struct rumr_server_state *state, struct rumr_buf
 		asic->options.bank.srbm.vmid	 = in.vmid;
 	}
 
+	// go through the callbacks so the server can also be backed by the test harness
 	if (in.access == 0) {
-		umr_write_reg(asic, addr, in.value_lo | ((uint64_t)in.value_hi << 32ULL), in.type);
+		asic->reg_funcs.write_reg(asic, addr, in.value_lo | ((uint64_t)in.value_hi << 32ULL), in.type);
 	} else {
-		readval = umr_read_reg(asic, addr, in.type);
+		readval = asic->reg_funcs.read_reg(asic, addr, in.type);
 	}
 
 	// turn off bank selection
@@ -340,6 +341,104 @@ static int handle_op_ring_access(struct rumr_server_state *state, struct rumr_bu
 	return 0;
 }
 
+// handle DISCOVER, a client that knows about protocol revisions
+// passes its own and gets ours after the serialized ASIC
+static int handle_op_discover(struct rumr_server_state *state, struct rumr_buffer *inbuf, struct rumr_buffer *outbuf)
+{
+	rumr_buffer_add_buffer(outbuf, state->serialized_asic);
+	if (inbuf->woffset - inbuf->roffset >= 4) {
+		state->log_msg("[VERBOSE]: Client is at protocol revision %"PRIu32"\n", rumr_buffer_read_uint32(inbuf));
+		rumr_buffer_add_uint32(outbuf, RUMR_REVISION);
+	}
+	return 0;
+}
+
+static int handle_op(struct rumr_server_state *state, uint32_t opcode, struct rumr_buffer *inbuf, struct rumr_buffer *outbuf);
+
+// handle a batch of requests answering each in turn.  A request that
+// fails is answered with a lone STATUS of 0 so the other replies in the
+// frame still line up
+static int handle_op_batch(struct rumr_server_state *state, struct rumr_buffer *inbuf, struct rumr_buffer *outbuf)
+{
+	struct rumr_buffer sub, *subout;
+	uint32_t count, x, entry, opcode, size;
+	int r;
+
+	count = rumr_buffer_read_uint32(inbuf);
+	if (count > RUMR_BATCH_MAX) {
+		state->log_msg("[ERROR]: Batch of %"PRIu32" requests is too large\n", count);
+		return -1;
+	}
+
+	subout = rumr_buffer_init();
+	if (!subout)
+		return -1;
+
+	rumr_buffer_add_uint32(outbuf, count);
+	for (x = 0; x < count; x++) {
+		entry = rumr_buffer_read_uint32(inbuf);
+		opcode = entry & 0xFF;
+		size = (entry >> 8) * 4;
+		if (size > inbuf->woffset - inbuf->roffset) {
+			state->log_msg("[ERROR]: Batch entry %"PRIu32" is larger than the packet\n", x);
+			rumr_buffer_free(subout);
+			return -1;
+		}
+
+		// present the entry as a buffer of its own
+		memset(&sub, 0, sizeof sub);
+		sub.data = &inbuf->data[inbuf->roffset];
+		sub.size = sub.woffset = size;
+		inbuf->roffset += size;
+
+		subout->woffset = 0;
+		switch (opcode) {
+			case RUMR_OP_REG_ACCESS:
+			case RUMR_OP_MEM_ACCESS:
+			case RUMR_OP_WAVE_ACCESS:
+			case RUMR_OP_GPR_ACCESS:
+			case RUMR_OP_RING_ACCESS:
+				r = handle_op(state, opcode, &sub, subout);
+				break;
+			default:
+				state->log_msg("[ERROR]: Opcode 0x%"PRIx32" is not allowed in a batch\n", opcode);
+				r = -1;
+		}
+		if (r) {
+			subout->woffset = 0;
+			rumr_buffer_add_uint32(subout, 0);
+		}
+		rumr_buffer_add_uint32(outbuf, subout->woffset);
+		rumr_buffer_add_buffer(outbuf, subout);
+	}
+	r = subout->failed ? -1 : 0;
+	rumr_buffer_free(subout);
+	return r;
+}
+
+static int handle_op(struct rumr_server_state *state, uint32_t opcode, struct rumr_buffer *inbuf, struct rumr_buffer *outbuf)
+{
+	switch (opcode) {
+		case RUMR_OP_DISCOVER:
+			return handle_op_discover(state, inbuf, outbuf);
+		case RUMR_OP_REG_ACCESS:
+			return handle_op_reg_access(state, inbuf, outbuf);
+		case RUMR_OP_MEM_ACCESS:
+			return handle_op_mem_access(state, inbuf, outbuf);
+		case RUMR_OP_WAVE_ACCESS:
+			return handle_op_wave_access(state, inbuf, outbuf);
+		case RUMR_OP_GPR_ACCESS:
+			return handle_op_gpr_access(state, inbuf, outbuf);
+		case RUMR_OP_RING_ACCESS:
+			return handle_op_ring_access(state, inbuf, outbuf);
+		case RUMR_OP_BATCH:
+			return handle_op_batch(state, inbuf, outbuf);
+		default:
+			state->log_msg("[ERROR]: Invalid packet upcode (0x%" PRIx32 ")\n", opcode);
+			return -1;
+	}
+}
+
 /** rumr_server_loop: Handles one command from client
  * state: The server state
  *
@@ -380,36 +479,13 @@ int rumr_server_loop(struct rumr_server_state *state)
 		}
 		outbuf->woffset = 4; // skip over packet header
 
-		r = 0;
-		switch ((header >> 10) & 0xFF) {
-			case RUMR_OP_DISCOVER:
-				rumr_buffer_add_buffer(outbuf, state->serialized_asic);
-				break;
-			case RUMR_OP_REG_ACCESS:
-				r = handle_op_reg_access(state, rbuf, outbuf);
-				break;
-			case RUMR_OP_MEM_ACCESS:
-				r = handle_op_mem_access(state, rbuf, outbuf);
-				break;
-			case RUMR_OP_WAVE_ACCESS:
-				r = handle_op_wave_access(state, rbuf, outbuf);
-				break;
-			case RUMR_OP_GPR_ACCESS:
-				r = handle_op_gpr_access(state, rbuf, outbuf);
-				break;
-			case RUMR_OP_RING_ACCESS:
-				r = handle_op_ring_access(state, rbuf, outbuf);
-				break;
-			case RUMR_OP_GOODBYE:
-				state->comm.closeconn(&state->comm);
-				rumr_buffer_free(rbuf);
-				rumr_buffer_free(outbuf);
-				return 1;
-			default:
-				state->log_msg("[ERROR]: Invalid packet upcode (0x%" PRIx32 ")\n", (header >> 10) & 0xFF);
-				r = -1;
-				goto error;
+		if (RUMR_HEADER_OPCODE(header) == RUMR_OP_GOODBYE) {
+			state->comm.closeconn(&state->comm);
+			rumr_buffer_free(rbuf);
+			rumr_buffer_free(outbuf);
+			return 1;
 		}
+		r = handle_op(state, RUMR_HEADER_OPCODE(header), rbuf, outbuf);
 
 		if (r) {
 			goto error;
@@ -423,7 +499,7 @@ int rumr_server_loop(struct rumr_server_state *state)
 			return -1;
 		}
 
-	// fix packet header
+	// fix packet header (the request ID is echoed back as is)
 		header |= 1; // set SERVER flag
 		memcpy(&outbuf->data[0], &header, 4);
 
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#include "umr.h"
+
+/* A sample log is a sequence of records each starting with a tag byte.
+ *
+ * 'H' starts a new set of columns: the magic and version followed by
+ * the number of fields and the name and unit of each as a length
+ * prefixed string.  A log can hold several of these (e.g. when it is
+ * appended to by another session or continued with other fields by
+ * umr_sample_log_set_fields()).
+ *
+ * 'B' is a block of up to SAMPLE_LOG_BLOCK samples stored column by
+ * column: the number of samples and size of the payload then the
+ * timestamps followed by each field.  The first entry of a column is
+ * stored as is and the others as the difference to the entry before
+ * it, all as zigzag varints so counters that barely move take a byte.
+ */
+
+#define SAMPLE_LOG_MAGIC   "UMRSLOG"
+#define SAMPLE_LOG_VERSION 1
+#define SAMPLE_LOG_BLOCK   256
+
+struct umr_sample_log {
+	FILE *f;
+	uint32_t nfields, nsamples;
+	uint64_t *ts,                      // [SAMPLE_LOG_BLOCK]
+		 *values;                  // [nfields][SAMPLE_LOG_BLOCK]
+	uint8_t *buf;
+};
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (v & 0x7F) | 0x80;
+		v >>= 7;
+	}
+	*p++ = v;
+	return p;
+}
+
+static uint8_t *put_delta(uint8_t *p, uint64_t v, uint64_t prev)
+{
+	int64_t d = (int64_t)(v - prev);
+	return put_varint(p, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+}
+
+static uint8_t *put_string(uint8_t *p, const char *s)
+{
+	size_t len = strlen(s);
+
+	p = put_varint(p, len);
+	memcpy(p, s, len);
+	return p + len;
+}
+
+/*
+ * sample_log_header - Size the buffers for @nfields and write an 'H' record
+ *
+ * Returns 0 on success.
+ */
+static int sample_log_header(struct umr_sample_log *log, uint32_t nfields, const char **names, const char **units)
+{
+	uint64_t *values;
+	uint8_t *hdr, *p, *buf;
+	size_t size;
+	uint32_t x;
+
+	values = realloc(log->values, (size_t)SAMPLE_LOG_BLOCK * (nfields ? nfields : 1) * sizeof log->values[0]);
+	if (!values)
+		return -1;
+	log->values = values;
+	buf = realloc(log->buf, (size_t)SAMPLE_LOG_BLOCK * (nfields + 1) * 10 + 32);
+	if (!buf)
+		return -1;
+	log->buf = buf;
+
+	size = 32;
+	for (x = 0; x < nfields; x++)
+		size += strlen(names[x]) + (units ? strlen(units[x]) : 0) + 20;
+	hdr = malloc(size);
+	if (!hdr)
+		return -1;
+
+	p = hdr;
+	*p++ = 'H';
+	memcpy(p, SAMPLE_LOG_MAGIC, 7);
+	p += 7;
+	*p++ = SAMPLE_LOG_VERSION;
+	p = put_varint(p, nfields);
+	for (x = 0; x < nfields; x++) {
+		p = put_string(p, names[x]);
+		p = put_string(p, units ? units[x] : "");
+	}
+	if (fwrite(hdr, 1, p - hdr, log->f) != (size_t)(p - hdr)) {
+		free(hdr);
+		return -1;
+	}
+	free(hdr);
+	log->nfields = nfields;
+	return 0;
+}
+
+/**
+ * umr_sample_log_open - Start a sample log
+ *
+ * @path: The file to append the log to
+ * @nfields: The number of values in each sample
+ * @names: The name of each field
+ * @units: The unit of each field (can be NULL)
+ *
+ * Returns NULL on error.
+ */
+struct umr_sample_log *umr_sample_log_open(const char *path, uint32_t nfields, const char **names, const char **units)
+{
+	struct umr_sample_log *log;
+
+	log = calloc(1, sizeof *log);
+	if (!log)
+		return NULL;
+
+	log->ts = calloc(SAMPLE_LOG_BLOCK, sizeof log->ts[0]);
+	if (!log->ts || !(log->f = fopen(path, "ab")) || sample_log_header(log, nfields, names, units)) {
+		umr_sample_log_close(log);
+		return NULL;
+	}
+	return log;
+}
+
+/**
+ * umr_sample_log_set_fields - Continue a sample log with other fields
+ *
+ * @log: The log
+ * @nfields: The number of values in each sample from now on
+ * @names: The name of each field
+ * @units: The unit of each field (can be NULL)
+ *
+ * The samples buffered so far are written with the old fields and a
+ * new set of columns is started in the same file.
+ *
+ * Returns 0 on success.  On error the log must be closed.
+ */
+int umr_sample_log_set_fields(struct umr_sample_log *log, uint32_t nfields, const char **names, const char **units)
+{
+	if (umr_sample_log_flush(log))
+		return -1;
+	return sample_log_header(log, nfields, names, units);
+}
+
+/**
+ * umr_sample_log_flush - Write the samples buffered so far to disk
+ *
+ * Returns 0 on success.
+ */
+int umr_sample_log_flush(struct umr_sample_log *log)
+{
+	uint8_t *p, *payload, head[24], *h;
+	uint64_t *col;
+	uint32_t x, y;
+
+	if (!log->nsamples)
+		return 0;
+
+	payload = p = log->buf;
+	for (y = 0; y < log->nsamples; y++)
+		p = put_delta(p, log->ts[y], y ? log->ts[y - 1] : 0);
+	for (x = 0; x < log->nfields; x++) {
+		col = &log->values[x * SAMPLE_LOG_BLOCK];
+		for (y = 0; y < log->nsamples; y++)
+			p = put_delta(p, col[y], y ? col[y - 1] : 0);
+	}
+
+	h = head;
+	*h++ = 'B';
+	h = put_varint(h, log->nsamples);
+	h = put_varint(h, p - payload);
+	log->nsamples = 0;
+
+	if (fwrite(head, 1, h - head, log->f) != (size_t)(h - head) ||
+	    fwrite(payload, 1, p - payload, log->f) != (size_t)(p - payload))
+		return -1;
+	return fflush(log->f) ? -1 : 0;
+}
+
+/**
+ * umr_sample_log_write - Add a sample to a log
+ *
+ * @log: The log
+ * @ts_ns: The time of the sample in nanoseconds
+ * @values: The nfields values of the sample
+ *
+ * Samples are buffered and written a block at a time.
+ *
+ * Returns 0 on success.
+ */
+int umr_sample_log_write(struct umr_sample_log *log, uint64_t ts_ns, const uint64_t *values)
+{
+	uint32_t x;
+
+	log->ts[log->nsamples] = ts_ns;
+	for (x = 0; x < log->nfields; x++)
+		log->values[x * SAMPLE_LOG_BLOCK + log->nsamples] = values[x];
+	if (++log->nsamples == SAMPLE_LOG_BLOCK)
+		return umr_sample_log_flush(log);
+	return 0;
+}
+
+/**
+ * umr_sample_log_close - Flush and close a sample log
+ *
+ * Returns 0 if everything was written.
+ */
+int umr_sample_log_close(struct umr_sample_log *log)
+{
+	int r = 0;
+
+	if (!log)
+		return 0;
+	if (log->f) {
+		r = umr_sample_log_flush(log);
+		if (fclose(log->f))
+			r = -1;
+	}
+	free(log->ts);
+	free(log->values);
+	free(log->buf);
+	free(log);
+	return r;
+}
+
+static int get_varint(FILE *f, uint64_t *v)
+{
+	int c, shift;
+
+	*v = 0;
+	for (shift = 0; shift < 64; shift += 7) {
+		if ((c = fgetc(f)) == EOF)
+			return -1;
+		*v |= (uint64_t)(c & 0x7F) << shift;
+		if (!(c & 0x80))
+			return 0;
+	}
+	return -1;
+}
+
+static int get_delta(FILE *f, uint64_t *v, uint64_t prev)
+{
+	uint64_t z;
+
+	if (get_varint(f, &z))
+		return -1;
+	*v = prev + ((z >> 1) ^ -(z & 1));
+	return 0;
+}
+
+static int get_string(FILE *f, char **s)
+{
+	uint64_t len;
+
+	if (get_varint(f, &len) || len > 4096 || !(*s = calloc(1, len + 1)))
+		return -1;
+	return fread(*s, 1, len, f) == len ? 0 : -1;
+}
+
+/**
+ * umr_sample_log_to_csv - Convert a sample log to comma separated values
+ *
+ * @errout: Where to report errors
+ * @in: The log
+ * @out: Where to write the CSV
+ *
+ * Every set of columns in the log starts with a line of field names
+ * (with the unit in brackets) followed by one line per sample with the
+ * time in seconds in the first column.
+ *
+ * Returns the number of samples converted or -1 on error.
+ */
+int64_t umr_sample_log_to_csv(umr_err_output errout, FILE *in, FILE *out)
+{
+	char magic[8], *s;
+	uint64_t nfields = 0, nsamples, size, *ts = NULL, *values = NULL, total = 0;
+	uint32_t x, y;
+	int c, r = -1;
+
+	while ((c = fgetc(in)) != EOF) {
+		if (c == 'H') {
+			if (fread(magic, 1, 8, in) != 8 || memcmp(magic, SAMPLE_LOG_MAGIC, 7) ||
+			    magic[7] != SAMPLE_LOG_VERSION) {
+				errout("[ERROR]: Not a sample log or unsupported version\n");
+				goto done;
+			}
+			if (get_varint(in, &nfields) || nfields > 65536)
+				goto corrupt;
+			fprintf(out, "Time (seconds)");
+			for (x = 0; x < nfields; x++) {
+				if (get_string(in, &s))
+					goto corrupt;
+				fprintf(out, ",%s", s);
+				free(s);
+				if (get_string(in, &s))
+					goto corrupt;
+				if (s[0])
+					fprintf(out, " (%s)", s);
+				free(s);
+			}
+			fprintf(out, "\n");
+
+			free(values);
+			values = calloc((size_t)SAMPLE_LOG_BLOCK * (nfields ? nfields : 1), sizeof values[0]);
+			if (!ts)
+				ts = calloc(SAMPLE_LOG_BLOCK, sizeof ts[0]);
+			if (!ts || !values)
+				goto done;
+		} else if (c == 'B' && values) {
+			if (get_varint(in, &nsamples) || get_varint(in, &size) || !nsamples || nsamples > SAMPLE_LOG_BLOCK)
+				goto corrupt;
+			for (y = 0; y < nsamples; y++)
+				if (get_delta(in, &ts[y], y ? ts[y - 1] : 0))
+					goto corrupt;
+			for (x = 0; x < nfields; x++)
+				for (y = 0; y < nsamples; y++)
+					if (get_delta(in, &values[x * SAMPLE_LOG_BLOCK + y], y ? values[x * SAMPLE_LOG_BLOCK + y - 1] : 0))
+						goto corrupt;
+			for (y = 0; y < nsamples; y++) {
+				fprintf(out, "%" PRIu64 ".%09" PRIu64, ts[y] / 1000000000, ts[y] % 1000000000);
+				for (x = 0; x < nfields; x++)
+					fprintf(out, ",%" PRIu64, values[x * SAMPLE_LOG_BLOCK + y]);
+				fprintf(out, "\n");
+			}
+			total += nsamples;
+		} else {
+			goto corrupt;
+		}
+	}
+	r = 0;
+	goto done;
+corrupt:
+	errout("[ERROR]: The sample log is truncated or corrupt\n");
+done:
+	free(ts);
+	free(values);
+	return r ? -1 : (int64_t)total;
+}
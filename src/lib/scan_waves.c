@@ -26,6 +26,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #define MANY_TO_INSTANCE(wgp, simd) (((simd) & 3) | ((wgp) << 2))
 
@@ -76,11 +77,11 @@ static int read_gpr_mmio(struct umr_asic *asic, int v_or_s, uint32_t thread, str
 	uint64_t addr = 0;
 
 	if (asic->family < FAMILY_NV) {
-		se = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SE_ID");
-		sh = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SH_ID");
-		cu = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "CU_ID");
-		wave = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID");
-		simd = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID");
+		se = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SE_ID);
+		sh = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SH_ID);
+		cu = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_CU_ID);
+		wave = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID);
+		simd = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID);
 
 		if (v_or_s == 0) {
 			uint32_t shift;
@@ -88,20 +89,20 @@ static int read_gpr_mmio(struct umr_asic *asic, int v_or_s, uint32_t thread, str
 				shift = 3;  // on SI..CIK allocations were done in 8-dword blocks
 			else
 				shift = 4;  // on VI allocations are in 16-dword blocks
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "SGPR_SIZE") + 1) << shift);
+			size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE) + 1) << shift);
 		} else {
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << asic->parameters.vgpr_granularity);
+			size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity);
 		}
 	} else {
-		se = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SE_ID");
-		sh = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SA_ID");
-		cu = ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WGP_ID") << 2) | umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID"));
-		wave = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID");
+		se = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SE_ID);
+		sh = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SA_ID);
+		cu = ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WGP_ID) << 2) | umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID));
+		wave = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID);
 		simd = 0;
 		if (v_or_s == 0) {
 			size = 4 * 124; // regular SGPRs, VCC, and TTMPs
 		} else {
-			size = 4 * ((umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << asic->parameters.vgpr_granularity);
+			size = 4 * ((umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity);
 		}
 	}
 
@@ -451,6 +452,142 @@ int umr_parse_wave_data_gfx(struct umr_asic *asic, struct umr_wave_status *ws, c
 	return 0;
 }
 
+/*
+ * wave_alloc_gprs - Allocate the GPR buffers of a wave from its GPR_ALLOC
+ *
+ * The SGPR buffer always has room for the trap registers at 0x6C..0x7B,
+ * on older parts they are read with the same size as the SGPRs.
+ */
+static int wave_alloc_gprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t num_threads)
+{
+	uint32_t shift, no_sgprs;
+
+	umr_wave_data_free_gprs(wd);
+
+	shift = (asic->family <= FAMILY_CIK) ? 3 : 4;
+	no_sgprs = (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE) + 1) << shift;
+	if (asic->family >= FAMILY_NV && no_sgprs < 124)
+		no_sgprs = 124; // regular SGPRs, VCC, and TTMPs
+	if (no_sgprs < 0x6C)
+		no_sgprs += 0x6C;
+	if (no_sgprs < 0x6C + 16)
+		no_sgprs = 0x6C + 16;
+
+	wd->num_threads = num_threads;
+	wd->no_sgprs = no_sgprs;
+	wd->vgpr_stride = (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << asic->parameters.vgpr_granularity;
+	wd->sgprs = calloc(wd->no_sgprs, sizeof wd->sgprs[0]);
+	wd->vgprs = calloc((size_t)wd->num_threads * wd->vgpr_stride, sizeof wd->vgprs[0]);
+	if (!wd->sgprs || !wd->vgprs) {
+		umr_wave_data_free_gprs(wd);
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * umr_wave_data_free_gprs - Release the GPR buffers of a single wave
+ *
+ * @wd: The wave data whose SGPR/VGPR buffers are to be freed
+ *
+ * Used for wave data that was filled in by umr_scan_wave_slot() directly
+ * instead of coming from umr_scan_wave_data().
+ */
+void umr_wave_data_free_gprs(struct umr_wave_data *wd)
+{
+	free(wd->sgprs);
+	free(wd->vgprs);
+	wd->sgprs = wd->vgprs = NULL;
+	wd->no_sgprs = wd->vgpr_stride = 0;
+	wd->have_vgprs = 0;
+}
+
+/**
+ * umr_free_wave_data - Free the waves returned by umr_scan_wave_data()
+ *
+ * @waves: The array of waves (may be NULL)
+ */
+void umr_free_wave_data(struct umr_wave_data *waves)
+{
+	struct umr_wave_data *wd;
+
+	umr_for_each_wave(wd, waves)
+		umr_wave_data_free_gprs(wd);
+	free(waves);
+}
+
+/**
+ * umr_wave_data_count - Count the waves returned by umr_scan_wave_data()
+ *
+ * @waves: The array of waves (may be NULL)
+ *
+ * Returns the number of waves.
+ */
+uint32_t umr_wave_data_count(struct umr_wave_data *waves)
+{
+	struct umr_wave_data *wd;
+	uint32_t n = 0;
+
+	umr_for_each_wave(wd, waves)
+		++n;
+	return n;
+}
+
+/**
+ * umr_wave_data_footprint - Memory used by the waves from umr_scan_wave_data()
+ *
+ * @waves: The array of waves (may be NULL)
+ *
+ * Returns the number of bytes held by the wave array and its GPR buffers.
+ */
+size_t umr_wave_data_footprint(struct umr_wave_data *waves)
+{
+	struct umr_wave_data *wd;
+	size_t bytes = 0;
+
+	umr_for_each_wave(wd, waves) {
+		bytes += sizeof *wd;
+		if (wd->sgprs)
+			bytes += wd->no_sgprs * sizeof wd->sgprs[0];
+		if (wd->vgprs)
+			bytes += (size_t)wd->num_threads * wd->vgpr_stride * sizeof wd->vgprs[0];
+	}
+	return bytes;
+}
+
+/**
+ * umr_wave_data_sgpr - Read a captured SGPR of a wave
+ *
+ * @wd: The wave data
+ * @idx: The SGPR index, the trap registers start at 0x6C
+ *
+ * Returns the value, 0 if the SGPRs were not read or @idx is out of range.
+ */
+uint32_t umr_wave_data_sgpr(struct umr_wave_data *wd, uint32_t idx)
+{
+	if (!wd->sgprs || idx >= wd->no_sgprs)
+		return 0;
+	return wd->sgprs[idx];
+}
+
+/**
+ * umr_wave_data_vgpr - Read a captured VGPR of a wave
+ *
+ * @wd: The wave data
+ * @thread: The thread in the wave
+ * @idx: The VGPR index
+ *
+ * Returns the value, 0 if the VGPRs were not read or the thread or
+ * @idx are out of range.
+ */
+uint32_t umr_wave_data_vgpr(struct umr_wave_data *wd, uint32_t thread, uint32_t idx)
+{
+	if (!wd->have_vgprs || !wd->vgprs || thread >= wd->num_threads || idx >= wd->vgpr_stride)
+		return 0;
+	return wd->vgprs[thread * wd->vgpr_stride + idx];
+}
+
 /**
  * umr_scan_wave_slot - Scan a wave slot for register data
  *
@@ -462,12 +599,16 @@ int umr_parse_wave_data_gfx(struct umr_asic *asic, struct umr_wave_status *ws, c
  * @wave: The WAVE to query
  * pwd: Where to put the wave data
  *
+ * The GPR buffers of @pwd are (re)allocated to the size of the wave's
+ * allocation, release them with umr_wave_data_free_gprs().
+ *
  * Returns -1 on error, 0 if success but no wave data, 1 if success with wave data.
  */
 int umr_scan_wave_slot(struct umr_asic *asic, uint32_t se, uint32_t sh, uint32_t cu,
 			       uint32_t simd, uint32_t wave, struct umr_wave_data *pwd)
 {
 	unsigned thread, num_threads;
+	uint64_t mask;
 	int r;
 
 	if (asic->family <= FAMILY_AI)
@@ -479,7 +620,7 @@ int umr_scan_wave_slot(struct umr_asic *asic, uint32_t se, uint32_t sh, uint32_t
 		return -1;
 
 	if (!umr_wave_data_get_flag_valid(asic, pwd) &&
-	    (!umr_wave_data_get_flag_halt(asic, pwd) || umr_wave_data_get_value(asic, pwd, "ixSQ_WAVE_STATUS") == 0xbebebeef))
+	    (!umr_wave_data_get_flag_halt(asic, pwd) || umr_wave_data_get_reg(asic, pwd, UMR_WAVE_REG_STATUS) == 0xbebebeef))
 		return 0;
 
 	pwd->se = se;
@@ -489,20 +630,29 @@ int umr_scan_wave_slot(struct umr_asic *asic, uint32_t se, uint32_t sh, uint32_t
 	pwd->wave = wave;
 
 	if (!asic->options.skip_gprs) {
-		asic->gpr_read_funcs.read_sgprs(asic, pwd, &pwd->sgprs[0]);
-
 		if (asic->family <= FAMILY_AI)
 			num_threads = 64;
 		else
 			num_threads = umr_wave_data_get_flag_wave64(asic, pwd) ? 64 : 32;
 
+		if (wave_alloc_gprs(asic, pwd, num_threads) < 0)
+			return -1;
+
+		asic->gpr_read_funcs.read_sgprs(asic, pwd, &pwd->sgprs[0]);
+
 		pwd->have_vgprs = 1;
-		pwd->num_threads = num_threads;
-		for (thread = 0; thread < num_threads; ++thread) {
-			if (asic->gpr_read_funcs.read_vgprs(asic, pwd, thread,
-					   &pwd->vgprs[256 * thread]) < 0) {
+		if (asic->gpr_read_funcs.read_vgprs_batch) {
+			// all threads in one go
+			mask = num_threads == 64 ? ~0ULL : ((1ULL << num_threads) - 1);
+			if (asic->gpr_read_funcs.read_vgprs_batch(asic, pwd, mask, pwd->vgpr_stride, &pwd->vgprs[0]) < 0)
 				pwd->have_vgprs = 0;
-				break;
+		} else {
+			for (thread = 0; thread < num_threads; ++thread) {
+				if (asic->gpr_read_funcs.read_vgprs(asic, pwd, thread,
+						   &pwd->vgprs[pwd->vgpr_stride * thread]) < 0) {
+					pwd->have_vgprs = 0;
+					break;
+				}
 			}
 		}
 	} else {
@@ -551,6 +701,7 @@ static int umr_scan_wave_simd(struct umr_asic *asic, uint32_t se, uint32_t sh, u
 				return -1;
 			}
 			pwd->next->reg_names = pwd->reg_names;
+			pwd->next->reg_slots = pwd->reg_slots;
 			*pppwd = &pwd->next;
 		}
 		if (r == -1)
@@ -667,6 +818,190 @@ static const char *gfx12_regs[] = {
 	NULL
 };
 
+// indexed by enum umr_wave_reg
+static const char *wave_reg_names[UMR_WAVE_REG_MAX] = {
+	[UMR_WAVE_REG_STATUS] = "ixSQ_WAVE_STATUS",
+	[UMR_WAVE_REG_PC_LO] = "ixSQ_WAVE_PC_LO",
+	[UMR_WAVE_REG_PC_HI] = "ixSQ_WAVE_PC_HI",
+	[UMR_WAVE_REG_EXEC_LO] = "ixSQ_WAVE_EXEC_LO",
+	[UMR_WAVE_REG_EXEC_HI] = "ixSQ_WAVE_EXEC_HI",
+	[UMR_WAVE_REG_HW_ID] = "ixSQ_WAVE_HW_ID",
+	[UMR_WAVE_REG_HW_ID1] = "ixSQ_WAVE_HW_ID1",
+	[UMR_WAVE_REG_HW_ID2] = "ixSQ_WAVE_HW_ID2",
+	[UMR_WAVE_REG_INST_DW0] = "ixSQ_WAVE_INST_DW0",
+	[UMR_WAVE_REG_INST_DW1] = "ixSQ_WAVE_INST_DW1",
+	[UMR_WAVE_REG_GPR_ALLOC] = "ixSQ_WAVE_GPR_ALLOC",
+	[UMR_WAVE_REG_LDS_ALLOC] = "ixSQ_WAVE_LDS_ALLOC",
+	[UMR_WAVE_REG_TRAPSTS] = "ixSQ_WAVE_TRAPSTS",
+	[UMR_WAVE_REG_IB_STS] = "ixSQ_WAVE_IB_STS",
+	[UMR_WAVE_REG_IB_STS2] = "ixSQ_WAVE_IB_STS2",
+	[UMR_WAVE_REG_TBA_LO] = "ixSQ_WAVE_TBA_LO",
+	[UMR_WAVE_REG_TBA_HI] = "ixSQ_WAVE_TBA_HI",
+	[UMR_WAVE_REG_TMA_LO] = "ixSQ_WAVE_TMA_LO",
+	[UMR_WAVE_REG_TMA_HI] = "ixSQ_WAVE_TMA_HI",
+	[UMR_WAVE_REG_IB_DBG0] = "ixSQ_WAVE_IB_DBG0",
+	[UMR_WAVE_REG_IB_DBG1] = "ixSQ_WAVE_IB_DBG1",
+	[UMR_WAVE_REG_M0] = "ixSQ_WAVE_M0",
+	[UMR_WAVE_REG_MODE] = "ixSQ_WAVE_MODE",
+	[UMR_WAVE_REG_STATE_PRIV] = "ixSQ_WAVE_STATE_PRIV",
+	[UMR_WAVE_REG_EXCP_FLAG_PRIV] = "ixSQ_WAVE_EXCP_FLAG_PRIV",
+	[UMR_WAVE_REG_EXCP_FLAG_USER] = "ixSQ_WAVE_EXCP_FLAG_USER",
+	[UMR_WAVE_REG_TRAP_CTRL] = "ixSQ_WAVE_TRAP_CTRL",
+	[UMR_WAVE_REG_ACTIVE] = "ixSQ_WAVE_ACTIVE",
+	[UMR_WAVE_REG_VALID_AND_IDLE] = "ixSQ_WAVE_VALID_AND_IDLE",
+	[UMR_WAVE_REG_DVGPR_ALLOC_LO] = "ixSQ_WAVE_DVGPR_ALLOC_LO",
+	[UMR_WAVE_REG_DVGPR_ALLOC_HI] = "ixSQ_WAVE_DVGPR_ALLOC_HI",
+	[UMR_WAVE_REG_SCHED_MODE] = "ixSQ_WAVE_SCHED_MODE",
+};
+
+// per generation map of enum umr_wave_reg to the slot in ws.reg_values (-1 if absent)
+static int8_t gfx8_slots[UMR_WAVE_REG_MAX], gfx9_slots[UMR_WAVE_REG_MAX],
+	      gfx10_slots[UMR_WAVE_REG_MAX], gfx11_slots[UMR_WAVE_REG_MAX],
+	      gfx12_slots[UMR_WAVE_REG_MAX];
+static pthread_once_t wave_slots_once = PTHREAD_ONCE_INIT;
+
+static void build_wave_slots(const char **regs, int8_t *slots)
+{
+	int x, y;
+
+	for (x = 0; x < UMR_WAVE_REG_MAX; x++) {
+		slots[x] = -1;
+		for (y = 0; regs[y]; y++) {
+			if (!strcmp(regs[y], wave_reg_names[x])) {
+				slots[x] = y;
+				break;
+			}
+		}
+	}
+}
+
+static void init_wave_slots(void)
+{
+	build_wave_slots(gfx8_regs, gfx8_slots);
+	build_wave_slots(gfx9_regs, gfx9_slots);
+	build_wave_slots(gfx10_regs, gfx10_slots);
+	build_wave_slots(gfx11_regs, gfx11_slots);
+	build_wave_slots(gfx12_regs, gfx12_slots);
+}
+
+// indexed by enum umr_wave_field
+static const struct {
+	enum umr_wave_reg reg;
+	const char *bitname;
+} wave_field_defs[UMR_WAVE_FIELD_MAX] = {
+	[UMR_WAVE_FIELD_STATUS_VALID] = { UMR_WAVE_REG_STATUS, "VALID" },
+	[UMR_WAVE_FIELD_STATUS_HALT] = { UMR_WAVE_REG_STATUS, "HALT" },
+	[UMR_WAVE_FIELD_STATUS_FATAL_HALT] = { UMR_WAVE_REG_STATUS, "FATAL_HALT" },
+	[UMR_WAVE_FIELD_STATUS_TRAP_EN] = { UMR_WAVE_REG_STATUS, "TRAP_EN" },
+	[UMR_WAVE_FIELD_STATUS_PRIV] = { UMR_WAVE_REG_STATUS, "PRIV" },
+	[UMR_WAVE_FIELD_STATUS_WAVE64] = { UMR_WAVE_REG_STATUS, "WAVE64" },
+	[UMR_WAVE_FIELD_HW_ID_SE_ID] = { UMR_WAVE_REG_HW_ID, "SE_ID" },
+	[UMR_WAVE_FIELD_HW_ID_SH_ID] = { UMR_WAVE_REG_HW_ID, "SH_ID" },
+	[UMR_WAVE_FIELD_HW_ID_CU_ID] = { UMR_WAVE_REG_HW_ID, "CU_ID" },
+	[UMR_WAVE_FIELD_HW_ID_WAVE_ID] = { UMR_WAVE_REG_HW_ID, "WAVE_ID" },
+	[UMR_WAVE_FIELD_HW_ID_SIMD_ID] = { UMR_WAVE_REG_HW_ID, "SIMD_ID" },
+	[UMR_WAVE_FIELD_HW_ID_VM_ID] = { UMR_WAVE_REG_HW_ID, "VM_ID" },
+	[UMR_WAVE_FIELD_HW_ID1_SE_ID] = { UMR_WAVE_REG_HW_ID1, "SE_ID" },
+	[UMR_WAVE_FIELD_HW_ID1_SA_ID] = { UMR_WAVE_REG_HW_ID1, "SA_ID" },
+	[UMR_WAVE_FIELD_HW_ID1_WGP_ID] = { UMR_WAVE_REG_HW_ID1, "WGP_ID" },
+	[UMR_WAVE_FIELD_HW_ID1_WAVE_ID] = { UMR_WAVE_REG_HW_ID1, "WAVE_ID" },
+	[UMR_WAVE_FIELD_HW_ID1_SIMD_ID] = { UMR_WAVE_REG_HW_ID1, "SIMD_ID" },
+	[UMR_WAVE_FIELD_HW_ID2_VM_ID] = { UMR_WAVE_REG_HW_ID2, "VM_ID" },
+	[UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE] = { UMR_WAVE_REG_GPR_ALLOC, "VGPR_SIZE" },
+	[UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE] = { UMR_WAVE_REG_GPR_ALLOC, "SGPR_SIZE" },
+	[UMR_WAVE_FIELD_IB_STS2_WAVE64] = { UMR_WAVE_REG_IB_STS2, "WAVE64" },
+	[UMR_WAVE_FIELD_STATE_PRIV_HALT] = { UMR_WAVE_REG_STATE_PRIV, "HALT" },
+};
+
+/* The wave registers of the device's gfx block and the bitfields in
+ * wave_field_defs[] resolved once so reading a field is a table lookup
+ * plus a shift and mask.  The handles are only used while
+ * options.vm_partition matches the instance they were resolved for.
+ * Whatever is missing from this generation's database is looked up by
+ * name again so the error is reported as before.
+ */
+struct umr_wave_fields {
+	int partition;
+	struct umr_reg *regs[UMR_WAVE_REG_MAX];
+	struct umr_bitslice bits[UMR_WAVE_FIELD_MAX];
+	uint8_t have_bits[UMR_WAVE_FIELD_MAX];
+};
+
+static pthread_mutex_t wave_fields_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * umr_wave_fields_resolve - Resolve the wave register bitfields of a device
+ *
+ * @asic: The device the wave data will be read from
+ *
+ * This happens on first use but should be called before @asic (or
+ * shallow copies of it) is shared between threads.  Calling it again
+ * after options.vm_partition changed resolves the handles for the new
+ * instance, which must not race with threads reading wave data.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int umr_wave_fields_resolve(struct umr_asic *asic)
+{
+	struct umr_wave_fields *wf;
+	char name[64];
+	int x, r = 0;
+
+	pthread_mutex_lock(&wave_fields_lock);
+	wf = asic->wave_fields;
+	if (wf && wf->partition == asic->options.vm_partition)
+		goto out;
+
+	if (!wf) {
+		wf = calloc(1, sizeof *wf);
+		if (!wf) {
+			asic->err_msg("[ERROR]: Out of memory\n");
+			r = -1;
+			goto out;
+		}
+	}
+	memset(wf, 0, sizeof *wf);
+	wf->partition = asic->options.vm_partition;
+
+	// registers a generation does not have are expected so look them up quietly
+	for (x = 0; x < UMR_WAVE_REG_MAX; x++) {
+		snprintf(name, sizeof name, "@%s", wave_reg_names[x]);
+		wf->regs[x] = umr_find_reg_data_by_ip_by_instance(asic, "gfx", wf->partition, name);
+	}
+	for (x = 0; x < UMR_WAVE_FIELD_MAX; x++) {
+		if (wf->regs[wave_field_defs[x].reg])
+			wf->have_bits[x] = !umr_bitslice_resolve(asic, wf->regs[wave_field_defs[x].reg],
+								  wave_field_defs[x].bitname, &wf->bits[x]);
+	}
+	asic->wave_fields = wf;
+out:
+	pthread_mutex_unlock(&wave_fields_lock);
+	return r;
+}
+
+/**
+ * umr_wave_fields_free - Free the resolved wave register bitfields of a device
+ *
+ * @asic: The device
+ */
+void umr_wave_fields_free(struct umr_asic *asic)
+{
+	free(asic->wave_fields);
+	asic->wave_fields = NULL;
+}
+
+/*
+ * wave_fields_get - Return the resolved bitfields if they match the current instance
+ */
+static struct umr_wave_fields *wave_fields_get(struct umr_asic *asic)
+{
+	if (!asic->wave_fields)
+		umr_wave_fields_resolve(asic);
+	if (asic->wave_fields && asic->wave_fields->partition == asic->options.vm_partition)
+		return asic->wave_fields;
+	return NULL;
+}
+
 /**
  * umr_wave_data_init - Initialize a umr_wave_data structure per GFX IP version
  *
@@ -680,22 +1015,28 @@ int umr_wave_data_init(struct umr_asic *asic, struct umr_wave_data *wd)
 	int maj, min;
 
 	memset(wd, 0, sizeof(*wd));
+	pthread_once(&wave_slots_once, init_wave_slots);
 	umr_gfx_get_ip_ver(asic, &maj, &min);
 	switch (maj) {
 		case 8:
 			wd->reg_names = gfx8_regs;
+			wd->reg_slots = gfx8_slots;
 			break;
 		case 9:
 			wd->reg_names = gfx9_regs;
+			wd->reg_slots = gfx9_slots;
 			break;
 		case 10:
 			wd->reg_names = gfx10_regs;
+			wd->reg_slots = gfx10_slots;
 			break;
 		case 11:
 			wd->reg_names = gfx11_regs;
+			wd->reg_slots = gfx11_slots;
 			break;
 		case 12:
 			wd->reg_names = gfx12_regs;
+			wd->reg_slots = gfx12_slots;
 			break;
 		default:
 			return -1;
@@ -703,9 +1044,233 @@ int umr_wave_data_init(struct umr_asic *asic, struct umr_wave_data *wd)
 	return 0;
 }
 
+// a SIMD (a WGP/SIMD pair on gfx10+) that the SQ reported as busy
+struct wave_scan_unit {
+	uint32_t se, sh, cu, simd;
+	struct umr_wave_status ws;
+	struct umr_wave_data *head, **ptail;
+	int r;
+};
+
+struct wave_scan_work {
+	struct umr_asic *asic;
+	struct wave_scan_unit *units;
+	uint32_t no_units, *next;
+	pthread_mutex_t *lock;
+};
+
+static void *wave_scan_thread(void *arg)
+{
+	struct wave_scan_work *w = arg;
+	struct wave_scan_unit *u;
+
+	for (;;) {
+		pthread_mutex_lock(w->lock);
+		u = (*w->next < w->no_units) ? &w->units[(*w->next)++] : NULL;
+		pthread_mutex_unlock(w->lock);
+		if (!u)
+			break;
+		u->r = umr_scan_wave_simd(w->asic, u->se, u->sh, u->cu, u->simd, &u->ptail);
+	}
+	return NULL;
+}
+
+static void free_wave_list(struct umr_wave_data *wd)
+{
+	struct umr_wave_data *next;
+
+	while (wd) {
+		next = wd->next;
+		umr_wave_data_free_gprs(wd);
+		free(wd);
+		wd = next;
+	}
+}
+
+/*
+ * wave_list_to_array - Move the scanned waves into one contiguous array
+ *
+ * The nodes are freed, their GPR buffers move along with the copies.
+ */
+static struct umr_wave_data *wave_list_to_array(struct umr_asic *asic, struct umr_wave_data *head)
+{
+	struct umr_wave_data *waves, *wd, *next;
+	uint32_t n, x;
+
+	for (n = 0, wd = head; wd; wd = wd->next)
+		++n;
+	if (!n)
+		return NULL;
+
+	waves = calloc(n, sizeof *waves);
+	if (!waves) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		free_wave_list(head);
+		return NULL;
+	}
+
+	for (x = 0, wd = head; wd; wd = next, x++) {
+		next = wd->next;
+		waves[x] = *wd;
+		waves[x].next = (x + 1 < n) ? &waves[x + 1] : NULL;
+		free(wd);
+	}
+	return waves;
+}
+
+/*
+ * scan_wave_data_threaded - Scan the busy SIMDs with several threads
+ *
+ * The SQ busy query uses banked MMIO so it is done up front by the
+ * caller's thread.  The busy SIMDs are then handed out to threads that
+ * each use their own copy of the ASIC (see wave_funcs.thread_context) and
+ * collect the waves in a private list.  The lists are appended to
+ * **pptail in SE/SH/CU/SIMD order so the result matches a serial scan.
+ */
+static int scan_wave_data_threaded(struct umr_asic *asic, struct umr_wave_data ***pptail)
+{
+	struct wave_scan_unit *units = NULL, *u;
+	struct wave_scan_work *work = NULL;
+	struct umr_asic *copies = NULL;
+	pthread_t *threads = NULL;
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct umr_wave_status ws;
+	uint32_t se, sh, cu, simd, no_units = 0, max_units, next = 0, x, nthreads;
+	int r = -1;
+
+	max_units = asic->config.gfx.max_shader_engines * asic->config.gfx.max_sh_per_se * asic->config.gfx.max_cu_per_sh * 4;
+	if (!max_units)
+		return 0;
+	units = calloc(max_units, sizeof *units);
+	if (!units)
+		goto oom;
+
+	for (se = 0; se < asic->config.gfx.max_shader_engines; se++)
+	for (sh = 0; sh < asic->config.gfx.max_sh_per_se; sh++) {
+		if (asic->family <= FAMILY_AI) {
+			for (cu = 0; cu < asic->config.gfx.max_cu_per_sh; cu++) {
+				memset(&ws, 0, sizeof ws);
+				asic->wave_funcs.get_wave_sq_info(asic, se, sh, cu, &ws);
+				if (ws.sq_info.busy) {
+					for (simd = 0; simd < 4; simd++) {
+						u = &units[no_units++];
+						u->se = se; u->sh = sh; u->cu = cu; u->simd = simd; u->ws = ws;
+					}
+				}
+			}
+		} else {
+			for (cu = 0; cu < asic->config.gfx.max_cu_per_sh / 2; cu++)
+			for (simd = 0; simd < 4; simd++) {
+				memset(&ws, 0, sizeof ws);
+				asic->wave_funcs.get_wave_sq_info(asic, se, sh, MANY_TO_INSTANCE(cu, simd), &ws);
+				if (ws.sq_info.busy) {
+					u = &units[no_units++];
+					u->se = se; u->sh = sh; u->cu = cu; u->simd = simd; u->ws = ws;
+				}
+			}
+		}
+	}
+
+	for (x = 0; x < no_units; x++) {
+		units[x].head = calloc(1, sizeof *units[x].head);
+		if (!units[x].head)
+			goto oom;
+		units[x].head->reg_names = (**pptail)->reg_names;
+		units[x].head->reg_slots = (**pptail)->reg_slots;
+		units[x].head->ws.sq_info = units[x].ws.sq_info;
+		units[x].ptail = &units[x].head;
+	}
+
+	nthreads = (uint32_t)asic->options.wave_threads;
+	if (nthreads > no_units)
+		nthreads = no_units;
+
+	copies = calloc(nthreads ? nthreads : 1, sizeof *copies);
+	work = calloc(nthreads ? nthreads : 1, sizeof *work);
+	threads = calloc(nthreads ? nthreads : 1, sizeof *threads);
+	if (!copies || !work || !threads)
+		goto oom;
+
+	// the copies share the bitfield index so it has to be complete before they run
+	if (umr_create_bit_index(asic))
+		goto oom;
+
+	// set up a private copy of the device for each thread
+	for (x = 0; x < nthreads; x++) {
+		copies[x] = *asic;
+		if (asic->wave_funcs.thread_context(asic, &copies[x], 1))
+			break;
+		work[x].asic = &copies[x];
+		work[x].units = units;
+		work[x].no_units = no_units;
+		work[x].next = &next;
+		work[x].lock = &lock;
+	}
+	nthreads = x;
+
+	if (nthreads) {
+		for (x = 0; x < nthreads; x++) {
+			if (pthread_create(&threads[x], NULL, wave_scan_thread, &work[x])) {
+				// whatever was not started is picked up by the running threads
+				break;
+			}
+		}
+		if (!x) {
+			// could not start any threads so scan from this thread
+			work[0].asic = asic;
+			wave_scan_thread(&work[0]);
+		}
+		while (x--)
+			pthread_join(threads[x], NULL);
+		for (x = 0; x < nthreads; x++)
+			asic->wave_funcs.thread_context(asic, &copies[x], 0);
+	} else {
+		work[0].asic = asic;
+		work[0].units = units;
+		work[0].no_units = no_units;
+		work[0].next = &next;
+		work[0].lock = &lock;
+		wave_scan_thread(&work[0]);
+	}
+
+	for (x = 0; x < no_units; x++)
+		if (units[x].r < 0)
+			goto error;
+
+	// append the per SIMD lists in scan order
+	for (x = 0; x < no_units; x++) {
+		free(**pptail);
+		**pptail = units[x].head;
+		*pptail = units[x].ptail;
+		units[x].head = NULL;
+	}
+	r = 0;
+	goto error;
+oom:
+	asic->err_msg("[ERROR]: Out of memory\n");
+error:
+	if (units)
+		for (x = 0; x < no_units; x++)
+			free_wave_list(units[x].head);
+	free(units);
+	free(copies);
+	free(work);
+	free(threads);
+	pthread_mutex_destroy(&lock);
+	return r;
+}
+
 /**
  * umr_scan_wave_data - Scan for any halted valid waves
  *
+ * If asic->options.wave_threads is above one and the wave access
+ * callbacks support per thread copies of the device the scan of the
+ * busy SIMDs is spread over that many threads.  The resulting list is
+ * in the same order as a serial scan.
+ *
+ * The waves are returned as one contiguous array that is also linked
+ * through ->next, free it with umr_free_wave_data().
+ *
  * Returns NULL on error (or no waves found).
  */
 struct umr_wave_data *umr_scan_wave_data(struct umr_asic *asic)
@@ -727,6 +1292,16 @@ struct umr_wave_data *umr_scan_wave_data(struct umr_asic *asic)
 		return NULL;
 	}
 
+	// resolved up front since the threaded scan shares them through copies of @asic
+	umr_wave_fields_resolve(asic);
+
+	// the test log is written in access order so it needs a serial scan
+	if (asic->options.wave_threads > 1 && asic->wave_funcs.thread_context && !asic->options.test_log) {
+		if (scan_wave_data_threaded(asic, &ptail) < 0)
+			goto error;
+		goto done;
+	}
+
 	for (se = 0; se < asic->config.gfx.max_shader_engines; se++)
 	for (sh = 0; sh < asic->config.gfx.max_sh_per_se; sh++) {
 		if (asic->family <= FAMILY_AI) {
@@ -753,16 +1328,13 @@ struct umr_wave_data *umr_scan_wave_data(struct umr_asic *asic)
 		}
 	}
 
+done:
 	// drop the pre-allocated tail node
 	free(*ptail);
 	*ptail = NULL;
-	return head;
+	return wave_list_to_array(asic, head);
 error:
-	while (ohead) {
-		head = ohead->next;
-		free(ohead);
-		ohead = head;
-	}
+	free_wave_list(ohead);
 	return NULL;
 }
 
@@ -808,6 +1380,158 @@ uint32_t umr_wave_data_get_bits(struct umr_asic *asic, struct umr_wave_data *wd,
 	return umr_bitslice_reg_by_name_by_ip_by_instance(asic, "gfx", asic->options.vm_partition, (char*)regname, (char*)bitname, value);
 }
 
+/**
+ * umr_wave_reg_lookup - Find the enum umr_wave_reg of a wave register name
+ *
+ * @regname: The register name, e.g. "ixSQ_WAVE_STATUS"
+ *
+ * Meant to resolve a name once so the wave data can then be read with
+ * umr_wave_data_get_reg().
+ *
+ * Returns the enum umr_wave_reg value or -1 if the name is not known.
+ */
+int umr_wave_reg_lookup(const char *regname)
+{
+	int x;
+
+	for (x = 0; x < UMR_WAVE_REG_MAX; x++)
+		if (!strcmp(wave_reg_names[x], regname))
+			return x;
+	return -1;
+}
+
+/**
+ * umr_wave_reg_name - Return the register name of an enum umr_wave_reg
+ *
+ * @reg: The wave register
+ *
+ * Returns the name or NULL if @reg is out of range.
+ */
+const char *umr_wave_reg_name(enum umr_wave_reg reg)
+{
+	if ((unsigned)reg >= UMR_WAVE_REG_MAX)
+		return NULL;
+	return wave_reg_names[reg];
+}
+
+/**
+ * umr_wave_data_get_reg - return one of the WAVE STATUS registers by ID
+ *
+ * @asic: The ASIC these registers are from
+ * @wd: The WAVE STATUS data that has been captured
+ * @reg: Which register to read.
+ *
+ * Same as umr_wave_data_get_value() but the register is found through
+ * the per generation slot table instead of by name.
+ *
+ * Returns 0xDEADBEEF if the register is not found, otherwise the value.
+ */
+uint32_t umr_wave_data_get_reg(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_reg reg)
+{
+	int slot;
+
+	if ((unsigned)reg >= UMR_WAVE_REG_MAX) {
+		asic->err_msg("[BUG]: Invalid wave register ID %d\n", (int)reg);
+		return 0xDEADBEEF;
+	}
+
+	// wave data that was not set up by umr_wave_data_init()
+	if (!wd->reg_slots)
+		return umr_wave_data_get_value(asic, wd, wave_reg_names[reg]);
+
+	slot = wd->reg_slots[reg];
+	if (slot < 0) {
+		asic->err_msg("[BUG]: Register (%s) not found in umr_wave_data list for this ASIC\n", wave_reg_names[reg]);
+		return 0xDEADBEEF;
+	}
+	return wd->ws.reg_values[slot];
+}
+
+/**
+ * umr_wave_data_get_reg_bits - return a bit slice of one of the WAVE STATUS registers by ID
+ *
+ * @asic: The ASIC these registers are from
+ * @wd: The WAVE STATUS data that has been captured
+ * @reg: Which register to read.
+ * @bitname: Which bitslice to return of the register.
+ *
+ * Returns 0xDEADBEEF if the register is not found, otherwise the value.
+ */
+uint32_t umr_wave_data_get_reg_bits(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_reg reg, const char *bitname)
+{
+	struct umr_wave_fields *wf;
+	uint32_t value;
+
+	value = umr_wave_data_get_reg(asic, wd, reg);
+	if (value == 0xDEADBEEF) {
+		return 0xDEADBEEF;
+	}
+	wf = wave_fields_get(asic);
+	if (wf && wf->regs[reg])
+		return umr_bitslice_reg(asic, wf->regs[reg], (char*)bitname, value);
+	return umr_bitslice_reg_by_name_by_ip_by_instance(asic, "gfx", asic->options.vm_partition, (char*)wave_reg_names[reg], (char*)bitname, value);
+}
+
+/**
+ * umr_wave_data_get_field - return a bitfield of one of the WAVE STATUS registers by ID
+ *
+ * @asic: The ASIC these registers are from
+ * @wd: The WAVE STATUS data that has been captured
+ * @field: Which bitfield to return.
+ *
+ * Same as umr_wave_data_get_reg_bits() with the register and bitfield
+ * of @field but uses the handle resolved by umr_wave_fields_resolve().
+ *
+ * Returns 0xDEADBEEF if the register is not found, otherwise the value.
+ */
+uint32_t umr_wave_data_get_field(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_field field)
+{
+	struct umr_wave_fields *wf;
+	uint32_t value;
+
+	if ((unsigned)field >= UMR_WAVE_FIELD_MAX) {
+		asic->err_msg("[BUG]: Invalid wave field ID %d\n", (int)field);
+		return 0xDEADBEEF;
+	}
+
+	value = umr_wave_data_get_reg(asic, wd, wave_field_defs[field].reg);
+	if (value == 0xDEADBEEF) {
+		return 0xDEADBEEF;
+	}
+	wf = wave_fields_get(asic);
+	if (wf && wf->have_bits[field])
+		return umr_bitslice_extract(&wf->bits[field], value);
+	return umr_wave_data_get_reg_bits(asic, wd, wave_field_defs[field].reg, wave_field_defs[field].bitname);
+}
+
+/**
+ * umr_wave_field_reg - Return the register an enum umr_wave_field is part of
+ *
+ * @field: The wave bitfield
+ *
+ * Returns the register or UMR_WAVE_REG_MAX if @field is out of range.
+ */
+enum umr_wave_reg umr_wave_field_reg(enum umr_wave_field field)
+{
+	if ((unsigned)field >= UMR_WAVE_FIELD_MAX)
+		return UMR_WAVE_REG_MAX;
+	return wave_field_defs[field].reg;
+}
+
+/**
+ * umr_wave_field_name - Return the bitfield name of an enum umr_wave_field
+ *
+ * @field: The wave bitfield
+ *
+ * Returns the name or NULL if @field is out of range.
+ */
+const char *umr_wave_field_name(enum umr_wave_field field)
+{
+	if ((unsigned)field >= UMR_WAVE_FIELD_MAX)
+		return NULL;
+	return wave_field_defs[field].bitname;
+}
+
 /**
  * umr_wave_data_get_bit_info - Retrieve bitfield information for a WAVE STATUS registers
  *
@@ -869,7 +1593,7 @@ int umr_wave_data_get_flag_valid(struct umr_asic *asic, struct umr_wave_data *wd
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "VALID");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_VALID);
 	}
 	return -1;
 }
@@ -894,7 +1618,7 @@ int umr_wave_data_get_flag_trap_en(struct umr_asic *asic, struct umr_wave_data *
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "TRAP_EN");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_TRAP_EN);
 	}
 	return -1;
 }
@@ -918,9 +1642,9 @@ int umr_wave_data_get_flag_halt(struct umr_asic *asic, struct umr_wave_data *wd)
 		case 9:
 		case 10:
 		case 11:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "HALT");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_HALT);
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATE_PRIV", "HALT");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATE_PRIV_HALT);
 	}
 	return -1;
 }
@@ -945,7 +1669,7 @@ int umr_wave_data_get_flag_fatal_halt(struct umr_asic *asic, struct umr_wave_dat
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "FATAL_HALT");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_FATAL_HALT);
 	}
 	return -1;
 }
@@ -970,7 +1694,7 @@ int umr_wave_data_get_flag_priv(struct umr_asic *asic, struct umr_wave_data *wd)
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "PRIV");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_PRIV);
 	}
 	return -1;
 }
@@ -994,9 +1718,9 @@ int umr_wave_data_get_flag_wave64(struct umr_asic *asic, struct umr_wave_data *w
 		case 9:
 		case 10:
 		case 11:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_IB_STS2", "WAVE64");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_IB_STS2_WAVE64);
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_STATUS", "WAVE64");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_STATUS_WAVE64);
 	}
 	return -1;
 }
@@ -1020,14 +1744,14 @@ int umr_wave_data_get_shader_pc_vmid(struct umr_asic *asic, struct umr_wave_data
 		case 7:
 		case 8:
 		case 9:
-			*addr = umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_PC_LO") | ((uint64_t)umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_PC_HI") << 32ULL);
-			*vmid = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "VM_ID");
+			*addr = umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_PC_LO) | ((uint64_t)umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_PC_HI) << 32ULL);
+			*vmid = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_VM_ID);
 			return 0;
 		case 10:
 		case 11:
 		case 12:
-			*addr = umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_PC_LO") | ((uint64_t)umr_wave_data_get_value(asic, wd, "ixSQ_WAVE_PC_HI") << 32ULL);
-			*vmid = umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID2", "VM_ID");
+			*addr = umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_PC_LO) | ((uint64_t)umr_wave_data_get_reg(asic, wd, UMR_WAVE_REG_PC_HI) << 32ULL);
+			*vmid = umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID2_VM_ID);
 			return 0;
 	}
 	return -1;
@@ -1050,11 +1774,11 @@ int umr_wave_data_get_flag_simd_id(struct umr_asic *asic, struct umr_wave_data *
 		case 7:
 		case 8:
 		case 9:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID);
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID);
 	}
 	return -1;
 }
@@ -1076,11 +1800,11 @@ int umr_wave_data_get_flag_wave_id(struct umr_asic *asic, struct umr_wave_data *
 		case 7:
 		case 8:
 		case 9:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID);
 		case 10:
 		case 11:
 		case 12:
-			return umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID");
+			return umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID);
 	}
 	return -1;
 }
@@ -1099,9 +1823,9 @@ uint32_t umr_wave_data_num_of_sgprs(struct umr_asic *asic, struct umr_wave_data
 	umr_gfx_get_ip_ver(asic, &maj, &min);
 	switch (maj) {
 		case 6:
-		case 7: return (umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "SGPR_SIZE")) << 3;
+		case 7: return (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE)) << 3;
 		case 8:
-		case 9: return (umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "SGPR_SIZE")) << 4;
+		case 9: return (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE)) << 4;
 		case 10:
 		case 11:
 		case 12: // TODO: confirm
@@ -1131,16 +1855,16 @@ char *umr_wave_data_describe_wavefront(struct umr_asic *asic, struct umr_wave_da
 		case 9:
 			snprintf(str, sizeof(str)-1, "se%" PRIu32 ".sh%" PRIu32 ".cu%" PRIu32 ".simd%" PRIu32 ".wave%" PRIu32,
 				wd->se, wd->sh, wd->cu,
-				umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID"),
-				umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID"));
+				umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID),
+				umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID));
 			break;
 		case 10:
 		case 11:
 		case 12:
 			snprintf(str, sizeof(str)-1, "se%" PRIu32 ".sa%" PRIu32 ".wgp%" PRIu32 ".simd%" PRIu32 ".wave%" PRIu32,
 				wd->se, wd->sh, wd->cu,
-				umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID"),
-				umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID"));
+				umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID),
+				umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID));
 			break;
 	}
 	return strdup(str);
@@ -1183,14 +1907,18 @@ int umr_singlestep_wave(struct umr_asic *asic, struct umr_wave_data *wd)
 
 		r = umr_scan_wave_slot(asic, wd->se, wd->sh, wd->cu, wd->simd, wd->wave, &new_wd);
 		if (r < 0) {
+			umr_wave_data_free_gprs(&new_wd);
 			r = -2;
 			goto out;
 		}
 
 		if (umr_wave_data_get_shader_pc_vmid(asic, &new_wd, &vmid, &new_pc)) {
+			umr_wave_data_free_gprs(&new_wd);
 			return -1;
 		}
 		bool moved = pc != new_pc;
+		umr_wave_data_free_gprs(wd);
+		new_wd.next = wd->next;
 		memcpy(wd, &new_wd, sizeof(new_wd));
 		if (moved)
 			break;
@@ -24,6 +24,112 @@
  */
 #include "umr.h"
 
+#define SHADER_CACHE_ENTRIES   64
+#define SHADER_CACHE_MAX_BYTES (64UL * 1024UL) // contents of larger shaders are not kept
+
+// a shader sized by umr_compute_shader_size()
+struct shader_cache_entry {
+	int valid, partition, early_term;
+	uint32_t vmid,
+		 size,
+		 no_bytes;           // number of bytes in words (0 if not kept)
+	uint64_t addr;
+	uint32_t *words;             // the shader contents read while sizing it
+};
+
+struct umr_shader_cache {
+	struct shader_cache_entry entries[SHADER_CACHE_ENTRIES];
+	int next_entry;
+};
+
+/**
+ * umr_shader_cache_invalidate - Drop all cached shader sizes and contents
+ *
+ * @asic: The device whose cache to invalidate
+ *
+ * Must be called whenever shader memory or its mappings may have changed.
+ */
+void umr_shader_cache_invalidate(struct umr_asic *asic)
+{
+	struct umr_shader_cache *sc = asic->shader_cache;
+	int x;
+
+	if (!sc)
+		return;
+
+	for (x = 0; x < SHADER_CACHE_ENTRIES; x++)
+		free(sc->entries[x].words);
+	memset(sc, 0, sizeof *sc);
+}
+
+/**
+ * umr_shader_cache_free - Free the shader cache of a device
+ */
+void umr_shader_cache_free(struct umr_asic *asic)
+{
+	umr_shader_cache_invalidate(asic);
+	free(asic->shader_cache);
+	asic->shader_cache = NULL;
+}
+
+/**
+ * shader_cache_find - Find a cached shader
+ *
+ * Returns the entry for the shader at @vmid@@addr or NULL if it
+ * has not been sized (or caching is disabled).
+ */
+static struct shader_cache_entry *shader_cache_find(struct umr_asic *asic, int partition, uint32_t vmid, uint64_t addr)
+{
+	struct umr_shader_cache *sc = asic->shader_cache;
+	int x;
+
+	if (!sc || asic->options.no_vm_cache)
+		return NULL;
+
+	for (x = 0; x < SHADER_CACHE_ENTRIES; x++)
+		if (sc->entries[x].valid && sc->entries[x].partition == partition &&
+		    sc->entries[x].vmid == vmid && sc->entries[x].addr == addr)
+			return &sc->entries[x];
+	return NULL;
+}
+
+/**
+ * shader_cache_add - Remember the size and contents of a shader
+ *
+ * @size: The size of the shader in bytes
+ * @words: The first @no_bytes bytes of the shader (the cache takes
+ *         ownership of it) or NULL.
+ */
+static void shader_cache_add(struct umr_asic *asic, int partition, struct umr_shaders_pgm *shader, uint32_t size, uint32_t *words, uint32_t no_bytes)
+{
+	struct umr_shader_cache *sc;
+	struct shader_cache_entry *e;
+
+	if (asic->options.no_vm_cache) {
+		free(words);
+		return;
+	}
+	if (!asic->shader_cache)
+		asic->shader_cache = calloc(1, sizeof *asic->shader_cache);
+	sc = asic->shader_cache;
+	if (!sc) {
+		free(words);
+		return;
+	}
+
+	e = &sc->entries[sc->next_entry];
+	sc->next_entry = (sc->next_entry + 1) % SHADER_CACHE_ENTRIES;
+	free(e->words);
+	e->valid = 1;
+	e->partition = partition;
+	e->early_term = asic->options.disasm_early_term;
+	e->vmid = shader->vmid;
+	e->addr = shader->addr;
+	e->size = size;
+	e->words = words;
+	e->no_bytes = words ? no_bytes : 0;
+}
+
 /**
  * find_wave - Find a wave by VMID@PC inside an array of wave data
  *
@@ -61,6 +167,7 @@ static struct umr_wave_data *find_wave(struct umr_asic *asic, struct umr_wave_da
  */
 int umr_vm_disasm_to_str(struct umr_asic *asic, int vm_partition, unsigned vmid, uint64_t addr, uint64_t PC, uint32_t size, uint32_t start_offset, char ***out)
 {
+	struct shader_cache_entry *e;
 	uint32_t *opcodes = NULL, x, y;
 	char **opcode_strs = NULL;
 	int r = 0;
@@ -77,7 +184,10 @@ int umr_vm_disasm_to_str(struct umr_asic *asic, int vm_partition, unsigned vmid,
 
 	// read the shader from an offset.  This allows us to know
 	// where the shader starts but only read/display a portion of it
-	if (umr_read_vram(asic, vm_partition, vmid, addr + start_offset, size, (void*)opcodes)) {
+	e = shader_cache_find(asic, vm_partition, vmid, addr);
+	if (e && start_offset + size <= e->no_bytes) {
+		memcpy(opcodes, (uint8_t *)e->words + start_offset, size);
+	} else if (umr_read_vram(asic, vm_partition, vmid, addr + start_offset, size, (void*)opcodes)) {
 		r = -1;
 		goto error;
 	}
@@ -177,6 +287,15 @@ int umr_vm_disasm(struct umr_asic *asic, FILE *output, int vm_partition, unsigne
 #define S_ENDPGM 0xbf810000
 #define S_ENDINV 0xbf9f0000
 
+// shaders are read in chunks growing from the first to the last size
+// never crossing a page so a fault only ends the scan at that page
+#define SHADER_FIRST_CHUNK 256
+#define SHADER_LAST_CHUNK  4096
+#define SHADER_PAGE_SIZE   4096
+
+// give up looking for the end of a shader past this many bytes
+#define SHADER_MAX_SCAN    (8UL * 1024UL * 1024UL)
+
 /**
  * umr_compute_shader_size - Compute the size of a shader
  *
@@ -185,31 +304,83 @@ int umr_vm_disasm(struct umr_asic *asic, FILE *output, int vm_partition, unsigne
  * resort to using the last 's_endpgm' if the shader vm mappings
  * run out.
  *
+ * The size and the contents read are cached per device so sizing
+ * or disassembling the same shader again does not read it again
+ * (see umr_shader_cache_invalidate()).
+ *
  * @asic: The ASIC where the shader is attached to
  * @vm_partition: Which partition to use when page walking
  * @shader: The shader program to query.
  */
 uint32_t umr_compute_shader_size(struct umr_asic *asic, int vm_partition, struct umr_shaders_pgm *shader)
 {
+	struct shader_cache_entry *e;
 	uint64_t addr;
-	uint32_t buf[256/4]; // read 256 byte pages at a time
-	uint32_t lastendpgm, endpgm_cnt, y, x;
+	uint32_t *buf, *tmp;
+	uint32_t lastendpgm, endpgm_cnt, y, x, size, step, chunk, nread, bufsize, base;
+	int keep, shrunk;
+
+	e = shader_cache_find(asic, vm_partition, shader->vmid, shader->addr);
+	if (e && e->early_term == asic->options.disasm_early_term)
+		return e->size;
+
+	bufsize = SHADER_FIRST_CHUNK;
+	buf = malloc(bufsize);
+	if (!buf) {
+		asic->err_msg("[ERROR]: Out of memory\n");
+		return 4;
+	}
 
 	addr = shader->addr;
+	keep = 1;
+	shrunk = 0;
 	endpgm_cnt = 0;
-	x = 256 / 4;
-	y = 0;
+	step = nread = 0;
+	x = y = 0;
 	lastendpgm = 0;
 	for (;;) {
-		if (x == 256/4) {
-			// read next page
+		if (y == nread) {
+			if (nread >= SHADER_MAX_SCAN)
+				break;
+
+			// read the next chunk, doubling them up to a page
+			step = (step && !shrunk) ? step * 2 : SHADER_FIRST_CHUNK;
+			if (step > SHADER_LAST_CHUNK)
+				step = SHADER_LAST_CHUNK;
+			chunk = step;
+retry:
+			if (chunk > SHADER_PAGE_SIZE - (addr & (SHADER_PAGE_SIZE - 1)))
+				chunk = SHADER_PAGE_SIZE - (addr & (SHADER_PAGE_SIZE - 1));
+
+			// keep everything read for the cache as long as the shader is small
+			if (keep && nread + chunk > bufsize) {
+				tmp = (nread + chunk <= SHADER_CACHE_MAX_BYTES) ? realloc(buf, nread + chunk) : NULL;
+				if (tmp) {
+					buf = tmp;
+					bufsize = nread + chunk;
+				} else {
+					keep = 0;
+				}
+			}
+			if (!keep && chunk > bufsize)
+				chunk = bufsize;
+			base = keep ? nread : 0;
+
 			// if we hit a fault just assume that's the end of the memory
 			// mapped to the shader.  This is to account for
-			// older UMDs that might not use the 5 ENDPGM postfix.
-			if (umr_read_vram(asic, vm_partition, shader->vmid, addr, 256, &buf[0]) < 0)
-				break;
-			addr += 256;
-			x = 0;
+			// older UMDs that might not use the 5 ENDPGM postfix.  A
+			// larger chunk is retried at the smallest size in case only
+			// part of it is backed (e.g. the blocks of a test harness).
+			if (umr_read_vram(asic, vm_partition, shader->vmid, addr, chunk, &buf[base / 4]) < 0) {
+				if (chunk <= SHADER_FIRST_CHUNK)
+					break;
+				chunk = step = SHADER_FIRST_CHUNK;
+				shrunk = 1;
+				goto retry;
+			}
+			addr += chunk;
+			nread += chunk;
+			x = base / 4;
 		}
 		y += 4;
 		if (buf[x] == S_ENDPGM || buf[x] == S_ENDINV) {
@@ -225,8 +396,15 @@ uint32_t umr_compute_shader_size(struct umr_asic *asic, int vm_partition, struct
 		++x;
 	}
 	if (endpgm_cnt == 5)
-		return y - 16; // remove last 4 endpgm's
+		size = y - 16; // remove last 4 endpgm's
 	else
-		return lastendpgm + 4; // assume the last endpgm seen was the end
-}
+		size = lastendpgm + 4; // assume the last endpgm seen was the end
 
+	if (keep) {
+		shader_cache_add(asic, vm_partition, shader, size, buf, nread);
+	} else {
+		free(buf);
+		shader_cache_add(asic, vm_partition, shader, size, NULL, 0);
+	}
+	return size;
+}
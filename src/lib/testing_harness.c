@@ -26,6 +26,9 @@
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <pthread.h>
+
+static pthread_mutex_t wave_lock = PTHREAD_MUTEX_INITIALIZER;
 
 // chomp out rest of line
 static void chomp(const char **ptr)
@@ -585,6 +588,22 @@ static uint64_t gpu_bus_to_cpu_address(struct umr_asic *asic, uint64_t dma_addr)
 	return dma_addr;
 }
 
+// track bank changes the way the regs2 debugfs interface would see them
+static void apply_bank(struct umr_asic *asic, struct umr_test_harness *th, enum regclass type)
+{
+	struct umr_bank_state bs;
+
+	if (type != REG_MMIO)
+		return;
+
+	umr_get_bank_state(asic, &bs);
+	if (!th->last_bank_valid || umr_bank_state_cmp(&bs, &th->last_bank)) {
+		th->last_bank = bs;
+		th->last_bank_valid = 1;
+		++(th->bank_switches);
+	}
+}
+
 static uint32_t read_reg(struct umr_asic *asic, uint64_t addr, enum regclass type)
 {
 	struct umr_test_harness *th = asic->reg_funcs.data;
@@ -597,6 +616,9 @@ static uint32_t read_reg(struct umr_asic *asic, uint64_t addr, enum regclass typ
 	// is stored in DWORD addresses
 	qaddr = addr >> 2;
 
+	++(th->reg_reads);
+	apply_bank(asic, th, type);
+
 	if (type != REG_MMIO)
 		return 0xDEADBEEF;
 
@@ -665,6 +687,8 @@ static int write_reg(struct umr_asic *asic, uint64_t addr, uint32_t value, enum
 	// is stored in DWORD addresses
 	qaddr = addr >> 2;
 
+	apply_bank(asic, th, type);
+
 	if (type != REG_MMIO)
 		return -1;
 
@@ -713,7 +737,7 @@ static int write_reg(struct umr_asic *asic, uint64_t addr, uint32_t value, enum
 	}
 }
 
-static int read_sgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst)
+static int read_sgprs_locked(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst)
 {
 	uint64_t addr, nr, x;
 	struct umr_test_harness *th = asic->reg_funcs.data;
@@ -721,20 +745,20 @@ static int read_sgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t
 
 	if (asic->family >= FAMILY_NV) {
 		addr =  (1ULL << 60) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SE_ID") << 12) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SA_ID") << 20) |
-				((((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WGP_ID") << 2) |
-				  (uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID")) << 28) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID") << 36);
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SE_ID) << 12) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SA_ID) << 20) |
+				((((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WGP_ID) << 2) |
+				  (uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID)) << 28) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID) << 36);
 
 		nr = umr_wave_data_num_of_sgprs(asic, wd);
 	} else if (asic->family < FAMILY_NV) {
 		addr =  (1ULL << 60) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SE_ID") << 12) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SH_ID") << 20) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "CU_ID") << 28) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID") << 36) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID") << 44);
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SE_ID) << 12) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SH_ID) << 20) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_CU_ID) << 28) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID) << 36) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID) << 44);
 		nr = umr_wave_data_num_of_sgprs(asic, wd);
 	} else {
 		return -1;
@@ -775,7 +799,7 @@ static int read_sgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t
 	return 0;
 }
 
-static int read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thread, uint32_t *dst)
+static int read_vgprs_locked(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thread, uint32_t *dst)
 {
 	struct umr_test_harness *th = asic->reg_funcs.data;
 	struct umr_test_harness_mmio_blocks *mm;
@@ -789,23 +813,23 @@ static int read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t
 
 	if (asic->family >= FAMILY_NV) {
 		addr =  (0ULL << 60) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SE_ID") << 12) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SA_ID") << 20) |
-				((((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WGP_ID") << 2) |
-				  (uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "SIMD_ID")) << 28) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID1", "WAVE_ID") << 36) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SE_ID) << 12) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SA_ID) << 20) |
+				((((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WGP_ID) << 2) |
+				  (uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_SIMD_ID)) << 28) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID1_WAVE_ID) << 36) |
 				((uint64_t)thread << 52);
 
-		nr = (umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << granularity;
+		nr = (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << granularity;
 	} else if (asic->family < FAMILY_NV) {
 		addr =  (0ULL << 60) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SE_ID") << 12) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SH_ID") << 20) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "CU_ID") << 28) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "WAVE_ID") << 36) |
-				((uint64_t)umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_HW_ID", "SIMD_ID") << 44) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SE_ID) << 12) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SH_ID) << 20) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_CU_ID) << 28) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_WAVE_ID) << 36) |
+				((uint64_t)umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_HW_ID_SIMD_ID) << 44) |
 				((uint64_t)thread << 52);
-		nr = (umr_wave_data_get_bits(asic, wd, "ixSQ_WAVE_GPR_ALLOC", "VGPR_SIZE") + 1) << granularity;
+		nr = (umr_wave_data_get_field(asic, wd, UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE) + 1) << granularity;
 	} else {
 		return -1;
 	}
@@ -833,7 +857,7 @@ static int read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t
 	return 0;
 }
 
-static int wave_status(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, struct umr_wave_status *ws)
+static int wave_status_locked(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, struct umr_wave_status *ws)
 {
 	struct umr_test_harness *th = asic->reg_funcs.data;
 	struct umr_test_harness_mmio_blocks *mm;
@@ -869,6 +893,58 @@ static int wave_status(struct umr_asic *asic, unsigned se, unsigned sh, unsigned
 		return -1;
 }
 
+// the wave callbacks consume slots so serialize them for threaded wave scans
+static int read_sgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst)
+{
+	int r;
+
+	pthread_mutex_lock(&wave_lock);
+	r = read_sgprs_locked(asic, wd, dst);
+	pthread_mutex_unlock(&wave_lock);
+	return r;
+}
+
+static int read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thread, uint32_t *dst)
+{
+	int r;
+
+	pthread_mutex_lock(&wave_lock);
+	r = read_vgprs_locked(asic, wd, thread, dst);
+	pthread_mutex_unlock(&wave_lock);
+	return r;
+}
+
+static int read_vgprs_batch(struct umr_asic *asic, struct umr_wave_data *wd, uint64_t thread_mask, uint32_t stride, uint32_t *dst)
+{
+	uint32_t thread;
+	int r = 0;
+
+	pthread_mutex_lock(&wave_lock);
+	for (thread = 0; thread < 64 && !r; thread++)
+		if (thread_mask & (1ULL << thread))
+			r = read_vgprs_locked(asic, wd, thread, &dst[stride * thread]);
+	pthread_mutex_unlock(&wave_lock);
+	return r;
+}
+
+static int wave_status(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, struct umr_wave_status *ws)
+{
+	int r;
+
+	pthread_mutex_lock(&wave_lock);
+	r = wave_status_locked(asic, se, sh, cu, simd, wave, ws);
+	pthread_mutex_unlock(&wave_lock);
+	return r;
+}
+
+static int thread_context(struct umr_asic *asic, struct umr_asic *copy, int setup)
+{
+	(void)asic;
+	(void)copy;
+	(void)setup;
+	return 0;
+}
+
 /**
  * umr_test_harness_get_config_data - Copy the GC config data from the harness
  *
@@ -909,6 +985,53 @@ void *umr_test_harness_get_ring_data(struct umr_asic *asic, uint32_t *ringsize)
 	return rd;
 }
 
+static void rewind_mmio(struct umr_test_harness_mmio_blocks *b)
+{
+	for (; b; b = b->next)
+		b->cur_slot = 0;
+}
+
+/**
+ * umr_test_harness_rewind - Rewind every register value list in the harness
+ *
+ * @asic: The ASIC the test harness is attached to
+ *
+ * Subsequent reads return the scripted values from the first slot again so
+ * the same sequence of accesses can be replayed against the harness.
+ */
+void umr_test_harness_rewind(struct umr_asic *asic)
+{
+	struct umr_test_harness *th = asic->reg_funcs.data;
+	struct umr_test_harness_sq_blocks *sq;
+
+	rewind_mmio(&th->mmio);
+	rewind_mmio(&th->ws);
+	rewind_mmio(&th->vgpr);
+	rewind_mmio(&th->sgpr);
+	rewind_mmio(&th->wave);
+	rewind_mmio(&th->ring);
+	for (sq = &th->sq; sq; sq = sq->next)
+		sq->cur_slot = 0;
+}
+
+/**
+ * umr_test_harness_get_access_counts - Get the simulated register traffic
+ *
+ * @asic: The ASIC the test harness is attached to
+ * @reg_reads: Where to store the number of register reads (can be NULL)
+ * @bank_switches: Where to store the number of times the banking state
+ * had to be reprogrammed (can be NULL)
+ */
+void umr_test_harness_get_access_counts(struct umr_asic *asic, uint32_t *reg_reads, uint32_t *bank_switches)
+{
+	struct umr_test_harness *th = asic->reg_funcs.data;
+
+	if (reg_reads)
+		*reg_reads = th->reg_reads;
+	if (bank_switches)
+		*bank_switches = th->bank_switches;
+}
+
 /**
  * umr_attach_test_harness - Attach a test harness to an existing ASIC structure including callbacks.
  *
@@ -929,10 +1052,13 @@ void umr_attach_test_harness(struct umr_test_harness *th, struct umr_asic *asic)
 
 	asic->gpr_read_funcs.read_sgprs = read_sgprs;
 	asic->gpr_read_funcs.read_vgprs = read_vgprs;
+	asic->gpr_read_funcs.read_vgprs_batch = read_vgprs_batch;
 
 	asic->wave_funcs.get_wave_status = wave_status;
 	asic->wave_funcs.get_wave_sq_info = umr_get_wave_sq_info;
+	asic->wave_funcs.thread_context = thread_context;
 	asic->ring_func.read_ring_data = umr_read_ring_data;
+	asic->ring_func.read_ring_ptrs = umr_read_ring_ptrs;
 
 	asic->shader_disasm_funcs.disasm = umr_shader_disasm;
 
@@ -958,4 +1084,5 @@ void umr_attach_test_harness(struct umr_test_harness *th, struct umr_asic *asic)
 		asic->options.shader_enable.enable_es_ls_swap = 1;  // on >FAMILY_VI we swap LS/ES for HS/GS
 
 	umr_create_mmio_accel(asic);
+	umr_create_reg_index(asic);
 }
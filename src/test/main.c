@@ -2,6 +2,17 @@
 
 DECLARE_TESTS(mmio_tests);
 DECLARE_TESTS(vm_tests);
+DECLARE_TESTS(find_reg_tests);
+DECLARE_TESTS(wave_tests);
+DECLARE_TESTS(pm4_tests);
+DECLARE_TESTS(rumr_tests);
+DECLARE_TESTS(ip_cache_tests);
+DECLARE_TESTS(pci_did_tests);
+DECLARE_TESTS(db_image_tests);
+DECLARE_TESTS(ring_tests);
+#ifndef UMR_NO_LLVM
+DECLARE_TESTS(disasm_tests);
+#endif
 #if COMMANDS_TEST
 DECLARE_TESTS(server_tests);
 #endif
@@ -12,6 +23,17 @@ int main(int argc, char **argv)
 
     REGISTER_TESTS(mmio_tests);
     REGISTER_TESTS(vm_tests);
+    REGISTER_TESTS(find_reg_tests);
+    REGISTER_TESTS(wave_tests);
+    REGISTER_TESTS(pm4_tests);
+    REGISTER_TESTS(rumr_tests);
+    REGISTER_TESTS(ip_cache_tests);
+    REGISTER_TESTS(pci_did_tests);
+    REGISTER_TESTS(db_image_tests);
+    REGISTER_TESTS(ring_tests);
+    #ifndef UMR_NO_LLVM
+    REGISTER_TESTS(disasm_tests);
+    #endif
     #if COMMANDS_TEST
     REGISTER_TESTS(server_tests);
     #endif
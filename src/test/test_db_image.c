@@ -0,0 +1,382 @@
+#include "test_framework.h"
+#include "umr_database_image.h"
+#include <sys/stat.h>
+#include <errno.h>
+
+// a tiny database tree: one register file, its SOC15 offsets and an ASIC using both
+static const char reg_text[] =
+    "3\n"
+    "regIMG_CNTL 0 0x10 2 0 0\n"
+    "\tENABLE 0 0\n"
+    "\tMODE 4 7\n"
+    "regIMG_STATUS 0 0x24 0 0 1\n"
+    "regIMG_COUNTER 0 0x30 1 1 0\n"
+    "\tVALUE 0 63\n";
+static const char soc15_text[] =
+    "IMG\n"
+    "\t0x00001000 0x00002000\n";
+static const char asic_text[] =
+    "imgtest imgtest.soc15 4 1 2 0\n"
+    "img100 IMG 0 ip/imgtest_1_0_0.reg\n";
+
+static const uint64_t segs[] = { 0x1000, 0x2000 };
+
+#define LOAD_REG   1
+#define LOAD_SOC15 2
+#define LOAD_ASIC  4
+#define LOAD_ALL   (LOAD_REG | LOAD_SOC15 | LOAD_ASIC)
+
+static int quiet_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+static int write_file(const char *dir, const char *name, const void *data, size_t size)
+{
+    char path[512];
+    FILE *f;
+    int r;
+
+    snprintf(path, sizeof path, "%s/%s", dir, name);
+    f = fopen(path, "wb");
+    if (!f)
+        return -1;
+    r = fwrite(data, 1, size, f) == size ? 0 : -1;
+    if (fclose(f))
+        r = -1;
+    return r;
+}
+
+// replace the image with a new file so a stale mapping of the old one is never reused
+static int install_image(const char *dir, const uint8_t *data, size_t size)
+{
+    char from[512], to[512];
+
+    if (write_file(dir, UMR_DB_IMAGE_NAME ".new", data, size))
+        return -1;
+    snprintf(from, sizeof from, "%s/%s.new", dir, UMR_DB_IMAGE_NAME);
+    snprintf(to, sizeof to, "%s/%s", dir, UMR_DB_IMAGE_NAME);
+    return rename(from, to);
+}
+
+// write the text database into @dir
+static int write_database(const char *dir)
+{
+    char path[512];
+
+    snprintf(path, sizeof path, "%s/ip", dir);
+    if (mkdir(path, 0755) && errno != EEXIST)
+        return -1;
+    if (write_file(dir, "ip/imgtest_1_0_0.reg", reg_text, strlen(reg_text)) ||
+        write_file(dir, "imgtest.soc15", soc15_text, strlen(soc15_text)) ||
+        write_file(dir, "imgtest.asic", asic_text, strlen(asic_text)))
+        return -1;
+    return 0;
+}
+
+// compile the database in @dir with dbcompiler and return the image
+static uint8_t *compile_image(const char *dir, size_t *size)
+{
+    char path[512], cmd[1200];
+    uint8_t *data;
+    struct stat st;
+    FILE *f;
+
+    snprintf(cmd, sizeof cmd, "%s %s %s/%s 2>/dev/null", UMR_DBCOMPILER, dir, dir, UMR_DB_IMAGE_NAME);
+    if (system(cmd))
+        return NULL;
+
+    snprintf(path, sizeof path, "%s/%s", dir, UMR_DB_IMAGE_NAME);
+    f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    data = NULL;
+    if (!fstat(fileno(f), &st) && (data = malloc(st.st_size + 1)) &&
+        fread(data, 1, st.st_size, f) != (size_t)st.st_size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = st.st_size;
+    return data;
+}
+
+// does @ip hold exactly the registers of reg_text relocated by segs[]?
+static int check_block(struct umr_ip_block *ip)
+{
+    static const struct {
+        const char *name;
+        uint64_t addr;
+        int no_bits;
+        uint64_t bit64;
+        const char *bits[2];
+        int start[2], stop[2];
+    } want[] = {
+        { "regIMG_CNTL", 0x1010, 2, 0, { "ENABLE", "MODE" }, { 0, 4 }, { 0, 7 } },
+        { "regIMG_STATUS", 0x2024, 0, 0, { NULL }, { 0 }, { 0 } },
+        { "regIMG_COUNTER", 0x1030, 1, 1, { "VALUE" }, { 0 }, { 63 } },
+    };
+    int x, y;
+
+    if (ip->no_regs != 3)
+        return 0;
+    for (x = 0; x < 3; x++) {
+        if (strcmp(ip->regs[x].regname, want[x].name) ||
+            ip->regs[x].type != REG_MMIO ||
+            ip->regs[x].addr != want[x].addr ||
+            ip->regs[x].no_bits != want[x].no_bits ||
+            ip->regs[x].bit64 != want[x].bit64)
+            return 0;
+        for (y = 0; y < want[x].no_bits; y++)
+            if (strcmp(ip->regs[x].bits[y].regname, want[x].bits[y]) ||
+                ip->regs[x].bits[y].start != want[x].start[y] ||
+                ip->regs[x].bits[y].stop != want[x].stop[y])
+                return 0;
+    }
+    return 1;
+}
+
+// try every image loader on @dir and return which of them produced the right answer
+static int load_database(char *dir)
+{
+    struct umr_soc15_database *soc15;
+    struct umr_options options;
+    struct umr_ip_block *ip;
+    struct umr_asic *asic;
+    int ok = 0;
+
+    ip = umr_database_image_read_ipblock(dir, "ip/imgtest_1_0_0.reg", "img100", segs, 2);
+    if (ip) {
+        if (ip->image && check_block(ip))
+            ok |= LOAD_REG;
+        umr_free_ip_block_regs(ip);
+        free(ip->ipname);
+        free(ip);
+    }
+
+    soc15 = umr_database_image_read_soc15(dir, "imgtest.soc15");
+    if (soc15) {
+        if (!strcmp(soc15->ipname, "IMG") &&
+            soc15->off[0][0] == segs[0] && soc15->off[0][1] == segs[1] && !soc15->off[0][2] &&
+            soc15->next && !soc15->next->next)
+            ok |= LOAD_SOC15;
+        umr_database_free_soc15(soc15);
+    }
+
+    // the blocks of an ASIC fall back to the text files on their own
+    memset(&options, 0, sizeof options);
+    snprintf(options.database_path, sizeof options.database_path, "%s", dir);
+    asic = umr_database_image_read_asic(&options, "imgtest.asic", quiet_printf);
+    if (asic) {
+        if (!strcmp(asic->asicname, "imgtest") && asic->family == 4 &&
+            asic->parameters.vgpr_granularity == 2 && asic->no_blocks == 1 &&
+            !strcmp(asic->blocks[0]->ipname, "img100") && check_block(asic->blocks[0]))
+            ok |= LOAD_ASIC;
+        umr_free_asic_blocks(asic);
+    }
+    return ok;
+}
+
+// a compiled image must load through every loader
+enum TEST_RESULT test_database_image(struct umr_asic* asic)
+{
+    uint8_t *image;
+    size_t size;
+    char *dir;
+
+    (void)asic;
+    dir = make_temp_dir("umrimg");
+    ASSERT_NOT_NULL(dir);
+    ASSERT_EQ(write_database(dir), 0);
+    image = compile_image(dir, &size);
+    ASSERT_NOT_NULL(image);
+    ASSERT_EQ(load_database(dir), LOAD_ALL);
+
+    // a text file that changed after the image was compiled is not taken from the image
+    ASSERT_EQ(write_file(dir, "imgtest.soc15", "IMG\n\t0x00003000\n", 16), 0);
+    ASSERT_EQ(load_database(dir), LOAD_REG);
+    free(image);
+
+    ASSERT_EQ(write_database(dir), 0);
+    image = compile_image(dir, &size);
+    ASSERT_NOT_NULL(image);
+    ASSERT_EQ(load_database(dir), LOAD_ALL);
+
+    // the image can be turned off
+    setenv("UMR_NO_DATABASE_IMAGE", "1", 1);
+    ASSERT_EQ(load_database(dir), 0);
+    unsetenv("UMR_NO_DATABASE_IMAGE");
+
+    free(image);
+    ASSERT_EQ(remove_temp_dir(dir), 0);
+    return TEST_SUCCESS;
+}
+
+/* Ways to damage an image.  Each case names the loaders that must still
+ * produce the right answer: the damaged part is rejected and everything
+ * built on top of it comes from the text files instead.
+ */
+enum image_damage {
+    DAMAGE_TRUNCATED,
+    DAMAGE_TRUNCATED_HEADER,
+    DAMAGE_HEADER_ONLY,
+    DAMAGE_STRINGS_SIZE,
+    DAMAGE_STRINGS_NUL,
+    DAMAGE_FILES_OFF,
+    DAMAGE_FILES_ALIGN,
+    DAMAGE_NO_FILES,
+    DAMAGE_FILE_NAME,
+    DAMAGE_REG_PAYLOAD,
+    DAMAGE_REGS_OFF,
+    DAMAGE_NO_REGS,
+    DAMAGE_BITS_OFF,
+    DAMAGE_BIT_NAME,
+    DAMAGE_BIT_RANGE,
+    DAMAGE_BIT_STOP,
+    DAMAGE_REG_NAME,
+    DAMAGE_REG_BITS,
+    DAMAGE_SOC15_IPS,
+    DAMAGE_SOC15_NAME,
+    DAMAGE_SOC15_SEGS,
+    DAMAGE_SOC15_OFF,
+    DAMAGE_ASIC_NAME,
+    DAMAGE_ASIC_NO_BLOCKS,
+    DAMAGE_ASIC_BLOCKS,
+    DAMAGE_ASIC_REGFILE,
+    NUM_DAMAGE
+};
+
+static const struct {
+    const char *what;
+    int loads;
+} damage_cases[NUM_DAMAGE] = {
+    [DAMAGE_TRUNCATED]        = { "truncated file", 0 },
+    [DAMAGE_TRUNCATED_HEADER] = { "truncated file and image_size", 0 },
+    [DAMAGE_HEADER_ONLY]      = { "header without tables", 0 },
+    [DAMAGE_STRINGS_SIZE]     = { "string table past the end", 0 },
+    [DAMAGE_STRINGS_NUL]      = { "unterminated string table", 0 },
+    [DAMAGE_FILES_OFF]        = { "file table past the end", 0 },
+    [DAMAGE_FILES_ALIGN]      = { "misaligned file table", 0 },
+    [DAMAGE_NO_FILES]         = { "file count", 0 },
+    [DAMAGE_FILE_NAME]        = { "file name offset", 0 },
+    [DAMAGE_REG_PAYLOAD]      = { "register file payload offset", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_REGS_OFF]         = { "register array offset", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_NO_REGS]          = { "register count", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_BITS_OFF]         = { "bitfield array offset", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_BIT_NAME]         = { "bitfield name offset", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_BIT_RANGE]        = { "bitfield start after stop", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_BIT_STOP]         = { "bitfield stop past bit 63", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_REG_NAME]         = { "register name offset", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_REG_BITS]         = { "register bitfields past the array", LOAD_SOC15 | LOAD_ASIC },
+    [DAMAGE_SOC15_IPS]        = { "SOC15 IP array offset", LOAD_REG | LOAD_ASIC },
+    [DAMAGE_SOC15_NAME]       = { "SOC15 IP name offset", LOAD_REG | LOAD_ASIC },
+    [DAMAGE_SOC15_SEGS]       = { "SOC15 segment count", LOAD_REG | LOAD_ASIC },
+    [DAMAGE_SOC15_OFF]        = { "SOC15 segment array offset", LOAD_REG | LOAD_ASIC },
+    [DAMAGE_ASIC_NAME]        = { "ASIC SOC15 file name offset", LOAD_REG | LOAD_SOC15 },
+    [DAMAGE_ASIC_NO_BLOCKS]   = { "negative ASIC block count", LOAD_REG | LOAD_SOC15 },
+    [DAMAGE_ASIC_BLOCKS]      = { "ASIC block count", LOAD_REG | LOAD_SOC15 },
+    [DAMAGE_ASIC_REGFILE]     = { "ASIC register file name offset", LOAD_REG | LOAD_SOC15 },
+};
+
+static void *payload(uint8_t *image, enum umr_db_image_type type)
+{
+    struct umr_db_image_header *hdr = (void *)image;
+    struct umr_db_image_file *files = (void *)(image + hdr->files_off);
+    uint32_t x;
+
+    for (x = 0; x < hdr->no_files; x++)
+        if (files[x].type == type)
+            return &files[x];
+    return NULL;
+}
+
+// apply @damage to the image in @image and return its new size
+static size_t damage_image(uint8_t *image, size_t size, enum image_damage damage)
+{
+    struct umr_db_image_header *hdr = (void *)image;
+    struct umr_db_image_file *freg = payload(image, UMR_DB_IMAGE_REG);
+    struct umr_db_image_file *fsoc = payload(image, UMR_DB_IMAGE_SOC15);
+    struct umr_db_image_file *fasic = payload(image, UMR_DB_IMAGE_ASIC);
+    struct umr_db_image_regfile *rf = (void *)(image + freg->off);
+    struct umr_db_image_reg *regs = (void *)(image + rf->regs_off);
+    struct umr_db_image_bit *bits = (void *)(image + rf->bits_off);
+    struct umr_db_image_soc15 *soc = (void *)(image + fsoc->off);
+    struct umr_db_image_soc15_ip *ips = (void *)(image + soc->ips_off);
+    struct umr_db_image_asic *ia = (void *)(image + fasic->off);
+    struct umr_db_image_asic_block *blocks = (void *)(image + ia->blocks_off);
+
+    switch (damage) {
+    case DAMAGE_TRUNCATED:        return size / 2;
+    case DAMAGE_TRUNCATED_HEADER: return hdr->image_size = hdr->strings_off + 1;
+    case DAMAGE_HEADER_ONLY:      return hdr->image_size = sizeof *hdr;
+    case DAMAGE_STRINGS_SIZE:     hdr->strings_size = size; break;
+    case DAMAGE_STRINGS_NUL:      image[size - 1] = 'x'; break;
+    case DAMAGE_FILES_OFF:        hdr->files_off = size & ~7; break;
+    case DAMAGE_FILES_ALIGN:      hdr->files_off += 4; break;
+    case DAMAGE_NO_FILES:         hdr->no_files = 0x7FFFFFFF; break;
+    case DAMAGE_FILE_NAME:        freg->basename = hdr->strings_size; break;
+    case DAMAGE_REG_PAYLOAD:      freg->off = (size & ~7) - 8; break;
+    case DAMAGE_REGS_OFF:         rf->regs_off = size & ~7; break;
+    case DAMAGE_NO_REGS:          rf->no_regs = 0xFFFFFFFF; break;
+    case DAMAGE_BITS_OFF:         rf->bits_off = (size & ~7) - 8; break;
+    case DAMAGE_BIT_NAME:         bits[1].name = hdr->strings_size; break;
+    case DAMAGE_BIT_RANGE:        bits[1].start = 8; break;
+    case DAMAGE_BIT_STOP:         bits[2].stop = 64; break;
+    case DAMAGE_REG_NAME:         regs[0].name = 0xFFFFFFFF; break;
+    case DAMAGE_REG_BITS:         regs[2].first_bit = rf->no_bits; break;
+    case DAMAGE_SOC15_IPS:        soc->ips_off = size & ~7; break;
+    case DAMAGE_SOC15_NAME:       ips[0].name = hdr->strings_size; break;
+    case DAMAGE_SOC15_SEGS:       ips[0].no_seg = UMR_SOC15_MAX_SEG + 1; break;
+    case DAMAGE_SOC15_OFF:        ips[0].off = (size & ~7) - 8; break;
+    case DAMAGE_ASIC_NAME:        ia->soc15name = hdr->strings_size; break;
+    case DAMAGE_ASIC_NO_BLOCKS:   ia->no_blocks = -1; break;
+    case DAMAGE_ASIC_BLOCKS:      ia->no_blocks = 0x40000000; break;
+    case DAMAGE_ASIC_REGFILE:     blocks[0].regfile = hdr->strings_size; break;
+    default: break;
+    }
+    return size;
+}
+
+// a damaged image is rejected (down to the damaged part) instead of being trusted
+enum TEST_RESULT test_database_image_damaged(struct umr_asic* asic)
+{
+    uint8_t *image, *copy;
+    size_t size, dsize;
+    int x, loads;
+    char *dir;
+
+    (void)asic;
+    dir = make_temp_dir("umrimg");
+    ASSERT_NOT_NULL(dir);
+    ASSERT_EQ(write_database(dir), 0);
+    image = compile_image(dir, &size);
+    ASSERT_NOT_NULL(image);
+    copy = malloc(size);
+    ASSERT_NOT_NULL(copy);
+
+    for (x = 0; x < NUM_DAMAGE; x++) {
+        memcpy(copy, image, size);
+        dsize = damage_image(copy, size, x);
+        ASSERT_EQ(install_image(dir, copy, dsize), 0);
+        loads = load_database(dir);
+        if (loads != damage_cases[x].loads)
+            fprintf(stderr, "%s:%d: %s: loaders 0x%x succeeded, expected 0x%x\n",
+                    __FILE__, __LINE__, damage_cases[x].what, loads, damage_cases[x].loads);
+        ASSERT_EQ(loads, damage_cases[x].loads);
+    }
+
+    // and the undamaged image still loads
+    ASSERT_EQ(install_image(dir, image, size), 0);
+    ASSERT_EQ(load_database(dir), LOAD_ALL);
+
+    free(copy);
+    free(image);
+    ASSERT_EQ(remove_temp_dir(dir), 0);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(db_image_tests)
+TEST(test_database_image, "navi_reg_only.envdef", "navi10"),
+TEST(test_database_image_damaged, "navi_reg_only.envdef", "navi10"),
+END_TESTS(db_image_tests);
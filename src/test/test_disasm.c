@@ -0,0 +1,134 @@
+#include "test_framework.h"
+
+#ifndef UMR_NO_LLVM
+
+// s_mov_b32 s0, 0; s_mov_b32 s1, 0x12345678; v_mov_b32 v0, v1; s_nop 0; s_endpgm
+static const uint32_t shader[] = {
+    0xBE800380, 0xBE8103FF, 0x12345678, 0x7E000301, 0xBF800000, 0xBF810000,
+};
+
+#define NWORDS (sizeof(shader) / sizeof(shader[0]))
+
+static void free_text(char **text)
+{
+    unsigned x;
+
+    for (x = 0; x < NWORDS; x++)
+        free(text[x]);
+    free(text);
+}
+
+// reusing the disassembler context must not change the output
+enum TEST_RESULT test_shader_disasm_reuse_navi(struct umr_asic* asic)
+{
+    char **fresh, **text;
+    int x;
+    unsigned y;
+
+    ASSERT_SUCCESS(umr_shader_disasm(asic, (uint8_t *)shader, sizeof shader, 0x1000, &fresh));
+    ASSERT_NOT_NULL(asic->disasm);
+    ASSERT_NOT_NULL(strstr(fresh[0], "s_mov_b32"));
+    ASSERT_STR_EQ(fresh[2], ";;");
+    ASSERT_NOT_NULL(strstr(fresh[5], "s_endpgm"));
+
+    for (x = 0; x < 1000; x++) {
+        ASSERT_SUCCESS(umr_shader_disasm(asic, (uint8_t *)shader, sizeof shader, 0x1000, &text));
+        for (y = 0; y < NWORDS; y++)
+            ASSERT_STR_EQ(text[y], fresh[y]);
+        free_text(text);
+    }
+
+    // switching to wave64 needs a new context, going back to wave32 another one
+    asic->options.wave64 = 1;
+    ASSERT_SUCCESS(umr_shader_disasm(asic, (uint8_t *)shader, sizeof shader, 0x1000, &text));
+    free_text(text);
+    asic->options.wave64 = 0;
+
+    umr_shader_disasm_free(asic);
+    ASSERT_EQ(asic->disasm, NULL);
+    ASSERT_SUCCESS(umr_shader_disasm(asic, (uint8_t *)shader, sizeof shader, 0x1000, &text));
+    for (y = 0; y < NWORDS; y++)
+        ASSERT_STR_EQ(text[y], fresh[y]);
+    free_text(text);
+    free_text(fresh);
+    return TEST_SUCCESS;
+}
+
+// linear VRAM holding a shader of 1500 s_nop and the s_endpgm postfix
+#define SHADER_BASE 0x10000
+static uint32_t shader_vram[0x1000];
+static uint32_t shader_vram_reads;
+
+static int count_linear_vram(struct umr_asic *asic, uint64_t address, uint32_t size, void *data, int write_en)
+{
+    (void)asic;
+    if (write_en || address < SHADER_BASE || address + size > SHADER_BASE + sizeof shader_vram)
+        return -1;
+    memcpy(data, (uint8_t *)shader_vram + (address - SHADER_BASE), size);
+    ++shader_vram_reads;
+    return 0;
+}
+
+static void free_lines(char **text, uint32_t n)
+{
+    while (n--)
+        free(text[n]);
+    free(text);
+}
+
+// sizing or disassembling a shader again must not read it again
+enum TEST_RESULT test_shader_size_cache_navi(struct umr_asic* asic)
+{
+    int (*access_linear_vram)(struct umr_asic *, uint64_t, uint32_t, void *, int);
+    struct umr_shaders_pgm pgm;
+    char **cached, **uncached;
+    uint32_t x, size;
+
+    asic->options.vm_partition = -1;
+    asic->options.no_disasm = 1;
+    for (x = 0; x < 0x1000; x++)
+        shader_vram[x] = (x >= 1500 && x < 1505) ? 0xBF810000 : 0xBF800000;
+    access_linear_vram = asic->mem_funcs.access_linear_vram;
+    asic->mem_funcs.access_linear_vram = count_linear_vram;
+
+    memset(&pgm, 0, sizeof pgm);
+    pgm.vmid = UMR_LINEAR_HUB;
+    pgm.addr = SHADER_BASE;
+
+    // 256, 512, 1024, 2048, the 256 left of the page and a whole page
+    shader_vram_reads = 0;
+    size = umr_compute_shader_size(asic, -1, &pgm);
+    ASSERT_EQ(size, 1501 * 4);
+    ASSERT_EQ(shader_vram_reads, 6);
+
+    ASSERT_EQ(umr_compute_shader_size(asic, -1, &pgm), size);
+    ASSERT_SUCCESS(umr_vm_disasm_to_str(asic, -1, UMR_LINEAR_HUB, SHADER_BASE, 0, size, 0, &cached));
+    ASSERT_EQ(shader_vram_reads, 6);
+
+    // the same lines from VRAM
+    asic->options.no_vm_cache = 1;
+    ASSERT_SUCCESS(umr_vm_disasm_to_str(asic, -1, UMR_LINEAR_HUB, SHADER_BASE, 0, size, 0, &uncached));
+    asic->options.no_vm_cache = 0;
+    ASSERT_EQ(shader_vram_reads, 7);
+    for (x = 0; x < size / 4; x++)
+        ASSERT_STR_EQ(cached[x], uncached[x]);
+    free_lines(cached, size / 4);
+    free_lines(uncached, size / 4);
+
+    // a changed shader is only seen once the cache is invalidated
+    shader_vram[1499] = 0xBF810000;
+    ASSERT_EQ(umr_compute_shader_size(asic, -1, &pgm), size);
+    umr_shader_cache_invalidate(asic);
+    ASSERT_EQ(umr_compute_shader_size(asic, -1, &pgm), 1500 * 4);
+    ASSERT_EQ(shader_vram_reads, 13);
+
+    asic->mem_funcs.access_linear_vram = access_linear_vram;
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(disasm_tests)
+TEST(test_shader_disasm_reuse_navi, "navi_reg_only.envdef", "navi10"),
+TEST(test_shader_size_cache_navi, "navi_reg_only.envdef", "navi10"),
+END_TESTS(disasm_tests);
+
+#endif
@@ -0,0 +1,339 @@
+#include "test_framework.h"
+#include <ctype.h>
+#include <dirent.h>
+
+static int quiet_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+// look up @name via the index and via the per block search and require the same answer
+static enum TEST_RESULT compare_lookup(struct umr_asic* asic, const char* ip, int inst, const char* name)
+{
+    struct umr_reg_index_entry *index;
+    struct umr_reg *fast, *slow;
+    struct umr_ip_block *fast_ip, *slow_ip;
+
+    fast = umr_find_reg_data_by_ip_by_instance_with_ip(asic, ip, inst, name, &fast_ip);
+    index = asic->reg_index;
+    asic->reg_index = NULL;
+    slow = umr_find_reg_data_by_ip_by_instance_with_ip(asic, ip, inst, name, &slow_ip);
+    asic->reg_index = index;
+
+    if (fast != slow || fast_ip != slow_ip) {
+        fprintf(stderr, "%s: lookup of [%s](%s, %d) differs: %s.%s vs %s.%s\n", asic->asicname, name, ip ? ip : "NULL", inst,
+                fast_ip ? fast_ip->ipname : "NULL", fast ? fast->regname : "NULL",
+                slow_ip ? slow_ip->ipname : "NULL", slow ? slow->regname : "NULL");
+        return TEST_FATAL_FAIL;
+    }
+    return TEST_SUCCESS;
+}
+
+static enum TEST_RESULT compare_asic(struct umr_asic* asic)
+{
+    char name[128], ipshort[4], *p;
+    int i, j, inst;
+
+    for (i = 0; i < asic->no_blocks; i++) {
+        inst = -1;
+        p = strstr(asic->blocks[i]->ipname, "{");
+        if (p)
+            sscanf(p, "{%d}", &inst);
+        snprintf(ipshort, sizeof ipshort, "%s", asic->blocks[i]->ipname);
+
+        for (j = 0; j < asic->blocks[i]->no_regs; j++) {
+            // '@' suppresses the not found messages
+            snprintf(name, sizeof name, "@%s", asic->blocks[i]->regs[j].regname);
+            ASSERT_EQ(compare_lookup(asic, NULL, -2, name), TEST_SUCCESS);
+            ASSERT_EQ(compare_lookup(asic, NULL, -1, name), TEST_SUCCESS);
+            ASSERT_EQ(compare_lookup(asic, asic->blocks[i]->ipname, inst, name), TEST_SUCCESS);
+            ASSERT_EQ(compare_lookup(asic, ipshort, inst, name), TEST_SUCCESS);
+
+            // case folding
+            for (p = name; *p; p++)
+                *p = tolower(*p);
+            ASSERT_EQ(compare_lookup(asic, NULL, -2, name), TEST_SUCCESS);
+
+            // mm to reg aliasing
+            if (!memcmp(asic->blocks[i]->regs[j].regname, "reg", 3)) {
+                snprintf(name, sizeof name, "@mm%s", asic->blocks[i]->regs[j].regname + 3);
+                ASSERT_EQ(compare_lookup(asic, NULL, -2, name), TEST_SUCCESS);
+                ASSERT_EQ(compare_lookup(asic, asic->blocks[i]->ipname, inst, name), TEST_SUCCESS);
+            }
+        }
+    }
+
+    // names that do not exist
+    ASSERT_EQ(compare_lookup(asic, NULL, -2, "@mmNOT_A_REAL_REGISTER"), TEST_SUCCESS);
+    ASSERT_EQ(compare_lookup(asic, "gfx", -1, "@regNOT_A_REAL_REGISTER"), TEST_SUCCESS);
+    return TEST_SUCCESS;
+}
+
+// compare the register name index against the per IP block search for every ASIC model in the database
+enum TEST_RESULT test_reg_index_matches_search(struct umr_asic* asic)
+{
+    struct umr_options options;
+    struct umr_asic *dbasic;
+    struct dirent *de;
+    DIR *dir;
+    int len, n = 0;
+
+    (void)asic;
+    dir = opendir(UMR_SOURCE_DIR "/database");
+    ASSERT_NOT_NULL(dir);
+    while ((de = readdir(dir))) {
+        len = strlen(de->d_name);
+        if (len < 6 || strcmp(de->d_name + len - 5, ".asic"))
+            continue;
+
+        memset(&options, 0, sizeof options);
+        dbasic = umr_database_read_asic(&options, de->d_name, quiet_printf);
+        if (!dbasic)
+            continue;
+        if (umr_create_reg_index(dbasic) || compare_asic(dbasic) != TEST_SUCCESS) {
+            umr_free_asic_blocks(dbasic);
+            closedir(dir);
+            return TEST_FATAL_FAIL;
+        }
+        umr_free_asic_blocks(dbasic);
+        ++n;
+    }
+    closedir(dir);
+    ASSERT_EQ(n > 0, 1);
+    return TEST_SUCCESS;
+}
+
+// the preformatted window names must match what umr_reg_name() formats for any other register
+enum TEST_RESULT test_reg_name_table_navi(struct umr_asic* asic)
+{
+    static const uint32_t bases[3] = { 0x2C00, 0xA000, 0xC000 }, sizes[3] = { 0x400, 0x400, 0x4000 };
+    struct umr_ip_block *ip;
+    struct umr_reg *reg;
+    char expect[512];
+    const char *name;
+    uint32_t w, x, known;
+    int colour;
+
+    for (colour = 0; colour < 2; colour++) {
+        asic->options.use_colour = colour;
+        for (known = w = 0; w < 3; w++) {
+            for (x = 0; x < sizes[w]; x++) {
+                reg = umr_find_reg_by_addr(asic, bases[w] + x, &ip);
+                if (reg && ip) {
+                    sprintf(expect, "%s%s.%s%s", RED, ip->ipname, reg->regname, RST);
+                    ++known;
+                } else {
+                    strcpy(expect, "<unknown>");
+                }
+                name = umr_reg_name(asic, bases[w] + x);
+                ASSERT_EQ(strcmp(name, expect), 0);
+                // the names do not live in a shared buffer
+                ASSERT_EQ(umr_reg_name(asic, bases[w] + x), name);
+            }
+        }
+        ASSERT_EQ(known > 0x100, 1);
+    }
+
+    // outside of the windows there is no table entry
+    ASSERT_EQ(umr_reg_name_table_lookup(asic, 0x2BFF, &name), -1);
+    ASSERT_EQ(umr_reg_name_table_lookup(asic, 0x10000, &name), -1);
+    return TEST_SUCCESS;
+}
+
+// the first bitfield named @bitname the way the bitfields used to be searched
+static struct umr_bitfield *find_bit_slow(struct umr_reg* reg, const char* bitname)
+{
+    int i;
+
+    for (i = 0; i < reg->no_bits; i++)
+        if (!strcmp(bitname, reg->bits[i].regname))
+            return &reg->bits[i];
+    return NULL;
+}
+
+static enum TEST_RESULT compare_bits(struct umr_asic* asic)
+{
+    static const uint64_t values[3] = { ~0ULL, 0x0123456789ABCDEFULL, 0xA5A5A5A55A5A5A5AULL };
+    struct umr_bitslice bs;
+    struct umr_bitfield *bit;
+    struct umr_reg *reg;
+    uint64_t mask;
+    int i, j, k, v, width;
+
+    for (i = 0; i < asic->no_blocks; i++) {
+        for (j = 0; j < asic->blocks[i]->no_regs; j++) {
+            reg = &asic->blocks[i]->regs[j];
+            for (k = 0; k < reg->no_bits; k++) {
+                bit = find_bit_slow(reg, reg->bits[k].regname);
+                ASSERT_EQ(umr_find_bitfield(asic, reg, reg->bits[k].regname), bit);
+                ASSERT_SUCCESS(umr_bitslice_resolve(asic, reg, reg->bits[k].regname, &bs));
+
+                width = bit->stop - bit->start + 1;
+                mask = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+                for (v = 0; v < 3; v++) {
+                    ASSERT_EQ(umr_bitslice_extract(&bs, values[v]), (values[v] >> bit->start) & mask);
+                    ASSERT_EQ(umr_bitslice_compose(&bs, values[v]), (values[v] & mask) << bit->start);
+                    ASSERT_EQ(umr_bitslice_reg(asic, reg, reg->bits[k].regname, values[v]), umr_bitslice_extract(&bs, values[v]));
+                    ASSERT_EQ(umr_bitslice_compose_value(asic, reg, reg->bits[k].regname, values[v]), umr_bitslice_compose(&bs, values[v]));
+                }
+            }
+            ASSERT_EQ(umr_find_bitfield(asic, reg, "NOT_A_REAL_FIELD"), NULL);
+            ASSERT_EQ(umr_bitslice_resolve(asic, reg, "NOT_A_REAL_FIELD", &bs), -1);
+            ASSERT_EQ(umr_bitslice_reg_quiet(asic, reg, "NOT_A_REAL_FIELD", 0), 0xFFFFFFFFULL);
+        }
+    }
+    return TEST_SUCCESS;
+}
+
+// resolved bitfields and the bitfield index must agree with the by name search for every ASIC model in the database
+enum TEST_RESULT test_bitslice_handles_match_search(struct umr_asic* asic)
+{
+    struct umr_options options;
+    struct umr_asic *dbasic;
+    struct umr_bitslice bs;
+    struct dirent *de;
+    DIR *dir;
+    int len, n = 0;
+
+    dir = opendir(UMR_SOURCE_DIR "/database");
+    ASSERT_NOT_NULL(dir);
+    while ((de = readdir(dir))) {
+        len = strlen(de->d_name);
+        if (len < 6 || strcmp(de->d_name + len - 5, ".asic"))
+            continue;
+
+        memset(&options, 0, sizeof options);
+        dbasic = umr_database_read_asic(&options, de->d_name, quiet_printf);
+        if (!dbasic)
+            continue;
+        dbasic->err_msg = quiet_printf;
+        if (compare_bits(dbasic) != TEST_SUCCESS) {
+            umr_free_asic_blocks(dbasic);
+            closedir(dir);
+            return TEST_FATAL_FAIL;
+        }
+        umr_free_asic_blocks(dbasic);
+        ++n;
+    }
+    closedir(dir);
+    ASSERT_EQ(n > 0, 1);
+
+    // and through an index built up front
+    ASSERT_SUCCESS(umr_create_bit_index(asic));
+    ASSERT_EQ(compare_bits(asic), TEST_SUCCESS);
+
+    // by name
+    ASSERT_SUCCESS(umr_bitslice_resolve_by_name_by_ip(asic, NULL, "mmGRBM_STATUS", "GUI_ACTIVE", &bs));
+    ASSERT_EQ(umr_bitslice_extract(&bs, 0x80000000ULL), 1);
+    ASSERT_EQ(umr_bitslice_extract(&bs, 0x7FFFFFFFULL), 0);
+    ASSERT_EQ(umr_bitslice_resolve_by_name_by_ip(asic, NULL, "@mmNOT_A_REAL_REGISTER", "GUI_ACTIVE", &bs), -1);
+    return TEST_SUCCESS;
+}
+
+// the registers a lookup found, in order
+struct lookup_hits {
+    int n;
+    struct {
+        struct umr_ip_block *ip;
+        struct umr_reg *reg;
+        uint32_t value;
+    } hit[16];
+};
+
+static void record_hit(struct umr_asic *asic, struct umr_ip_block *ip, struct umr_reg *reg, uint32_t value, void *data)
+{
+    struct lookup_hits *h = data;
+
+    (void)asic;
+    if (h->n < 16) {
+        h->hit[h->n].ip = ip;
+        h->hit[h->n].reg = reg;
+        h->hit[h->n].value = value;
+    }
+    ++h->n;
+}
+
+static int lookup_batch(struct umr_asic *asic, const char *text, struct lookup_hits *h)
+{
+    FILE *f = fmemopen((void *)text, strlen(text), "r");
+    int bad;
+
+    memset(h, 0, sizeof *h);
+    if (!f)
+        return -1;
+    bad = umr_lookup_reg_batch(asic, f, record_hit, h);
+    fclose(f);
+    return bad;
+}
+
+// a batch of values decodes the same by address and by name, bad lines are counted
+enum TEST_RESULT test_lookup_batch(struct umr_asic* asic)
+{
+    struct lookup_hits by_addr, by_name;
+    struct umr_ip_block *ip;
+    struct umr_reg *reg;
+    char text[1024];
+    int i, found;
+
+    reg = umr_find_reg_by_name(asic, "mmGRBM_STATUS", &ip);
+    ASSERT_NOT_NULL(reg);
+    asic->err_msg = quiet_printf;
+
+    // an address finds every register at it, the name finds exactly one of them
+    snprintf(text, sizeof text, "0x%" PRIx64 " 0x80000001\n", reg->addr);
+    ASSERT_EQ(lookup_batch(asic, text, &by_addr), 0);
+    snprintf(text, sizeof text, "%s.%s 0x80000001\n", ip->ipname, reg->regname);
+    ASSERT_EQ(lookup_batch(asic, text, &by_name), 0);
+    ASSERT_EQ(by_name.n, 1);
+    ASSERT_EQ(by_name.hit[0].reg, reg);
+    ASSERT_EQ(by_name.hit[0].value, 0x80000001);
+    for (found = i = 0; i < by_addr.n && i < 16; i++) {
+        ASSERT_EQ(by_addr.hit[i].reg->addr, reg->addr);
+        ASSERT_EQ(by_addr.hit[i].value, 0x80000001);
+        found |= by_addr.hit[i].reg == by_name.hit[0].reg && by_addr.hit[i].ip == by_name.hit[0].ip;
+    }
+    ASSERT_EQ(found, 1);
+
+    // every separator, comments and blank lines
+    snprintf(text, sizeof text,
+        "# %s.%s 0x1\n"
+        "\n"
+        "   \t\n"
+        "  # indented comment\n"
+        "%s.%s=0x10\n"
+        "%s.%s:0x11\n"
+        "%s.%s,0x12\n"
+        "%s.%s\t0x13\r\n"
+        "%s.%s = 0x14\n"
+        "%s.%s 15",
+        ip->ipname, reg->regname, ip->ipname, reg->regname, ip->ipname, reg->regname,
+        ip->ipname, reg->regname, ip->ipname, reg->regname, ip->ipname, reg->regname,
+        ip->ipname, reg->regname);
+    ASSERT_EQ(lookup_batch(asic, text, &by_name), 0);
+    ASSERT_EQ(by_name.n, 6);
+    for (i = 0; i < 6; i++) {
+        ASSERT_EQ(by_name.hit[i].reg, reg);
+        ASSERT_EQ(by_name.hit[i].value, 0x10 + (uint32_t)i);
+    }
+
+    // unknown registers and missing values are reported and skipped
+    snprintf(text, sizeof text,
+        "%s.mmNOT_A_REAL_REGISTER 0x1\n"
+        "NOT_A_REGISTER 0x1\n"
+        "0xFFFFFFF0 0x1\n"
+        "%s.%s\n"
+        "%s.%s 0x20\n",
+        ip->ipname, ip->ipname, reg->regname, ip->ipname, reg->regname);
+    ASSERT_EQ(lookup_batch(asic, text, &by_name), 4);
+    ASSERT_EQ(by_name.n, 1);
+    ASSERT_EQ(by_name.hit[0].value, 0x20);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(find_reg_tests)
+TEST(test_reg_index_matches_search, "navi_reg_only.envdef", "navi10"),
+TEST(test_reg_name_table_navi, "navi_reg_only.envdef", "navi10"),
+TEST(test_bitslice_handles_match_search, "navi_reg_only.envdef", "navi10"),
+TEST(test_lookup_batch, "navi_reg_only.envdef", "navi10"),
+END_TESTS(find_reg_tests);
@@ -1,6 +1,9 @@
 #include "test_framework.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 struct registered_tests
 {
@@ -28,6 +31,63 @@ static int vm_printf(const char *fmt, ...)
 	return r;
 }
 
+char* make_temp_dir(const char* prefix)
+{
+    size_t len = strlen("/tmp/") + strlen(prefix) + strlen("XXXXXX") + 1;
+    char* dir = malloc(len);
+
+    if (!dir)
+        return NULL;
+    snprintf(dir, len, "/tmp/%sXXXXXX", prefix);
+    if (!mkdtemp(dir))
+    {
+        free(dir);
+        return NULL;
+    }
+    return dir;
+}
+
+static int remove_tree(const char* path)
+{
+    char child[1024];
+    struct dirent* de;
+    struct stat st;
+    DIR* d;
+    int r = 0;
+
+    if (lstat(path, &st))
+        return -1;
+    if (!S_ISDIR(st.st_mode))
+        return unlink(path);
+
+    d = opendir(path);
+    if (!d)
+        return -1;
+    while ((de = readdir(d)))
+    {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+            continue;
+        snprintf(child, sizeof child, "%s/%s", path, de->d_name);
+        if (remove_tree(child))
+            r = -1;
+    }
+    closedir(d);
+    if (rmdir(path))
+        r = -1;
+    return r;
+}
+
+int remove_temp_dir(char* dir)
+{
+    int r;
+
+    if (!dir)
+        return -1;
+    r = remove_tree(dir);
+    free(dir);
+    return r;
+}
+
 void register_tests(struct test_table_entry* tests, size_t ntests)
 {
     struct registered_tests** ptr_to_update = &registered_tests;
@@ -87,6 +87,16 @@ struct global_config
     int   verbose;
 };
 
+/**make_temp_dir()/remove_temp_dir()
+ * Scratch directories for tests that need files on disk (database trees, caches, ...).
+ * make_temp_dir() creates a new directory under /tmp whose name starts with the given prefix
+ * and returns its path, or NULL on failure.
+ * remove_temp_dir() deletes the directory and everything in it and frees the path.
+ * It returns 0 on success.
+*/
+char* make_temp_dir(const char* prefix);
+int remove_temp_dir(char* dir);
+
 /**run_tests()
  * Run all the tests that were registered. 
  * 
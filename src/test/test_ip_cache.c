@@ -0,0 +1,311 @@
+#include "test_framework.h"
+#include <dirent.h>
+#include <utime.h>
+
+static int quiet_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+// @b must share every register table of @a and resolve names to the same registers
+static enum TEST_RESULT compare_shared(struct umr_asic* a, struct umr_asic* b)
+{
+    char name[128];
+    int i, j;
+
+    ASSERT_EQ(a->no_blocks, b->no_blocks);
+    for (i = 0; i < a->no_blocks; i++) {
+        ASSERT_NOT_NULL(a->blocks[i]->shared);
+        ASSERT_EQ(a->blocks[i]->shared, b->blocks[i]->shared);
+        ASSERT_EQ(a->blocks[i]->regs, b->blocks[i]->regs);
+        ASSERT_EQ(a->blocks[i]->no_regs, b->blocks[i]->no_regs);
+        ASSERT_STR_EQ(a->blocks[i]->ipname, b->blocks[i]->ipname);
+        ASSERT_EQ(a->blocks[i] != b->blocks[i], 1);
+        ASSERT_EQ(a->blocks[i]->ipname != b->blocks[i]->ipname, 1);
+
+        for (j = 0; j < a->blocks[i]->no_regs; j++) {
+            snprintf(name, sizeof name, "@%s", a->blocks[i]->regs[j].regname);
+            ASSERT_EQ(umr_find_reg_data_by_ip_by_instance(a, a->blocks[i]->ipname, -1, name),
+                      umr_find_reg_data_by_ip_by_instance(b, b->blocks[i]->ipname, -1, name));
+        }
+    }
+    return TEST_SUCCESS;
+}
+
+// identical devices share register tables which stay valid until the last one is closed
+enum TEST_RESULT test_ip_block_cache_sharing(struct umr_asic* asic)
+{
+    struct umr_options options;
+    struct umr_asic *dev[2];
+    struct umr_reg *reg;
+    uint64_t addr;
+
+    memset(&options, 0, sizeof options);
+    dev[0] = umr_database_read_asic(&options, "navi10.asic", quiet_printf);
+    ASSERT_NOT_NULL(dev[0]);
+    dev[1] = umr_database_read_asic(&options, "navi10.asic", quiet_printf);
+    ASSERT_NOT_NULL(dev[1]);
+
+    ASSERT_EQ(compare_shared(asic, dev[0]), TEST_SUCCESS);
+    ASSERT_EQ(compare_shared(dev[0], dev[1]), TEST_SUCCESS);
+
+    reg = umr_find_reg_data_by_ip(asic, "gfx", "mmGRBM_STATUS");
+    ASSERT_NOT_NULL(reg);
+    addr = reg->addr;
+
+    // the tables outlive any one device
+    umr_free_asic_blocks(dev[0]);
+    ASSERT_EQ(umr_find_reg_data_by_ip(dev[1], "gfx", "mmGRBM_STATUS"), reg);
+    umr_free_asic_blocks(dev[1]);
+    ASSERT_EQ(umr_find_reg_data_by_ip(asic, "gfx", "mmGRBM_STATUS"), reg);
+    ASSERT_EQ(reg->addr, addr);
+    ASSERT_STR_EQ(reg->regname, "mmGRBM_STATUS");
+
+    // and are picked up again by the next device
+    dev[0] = umr_database_read_asic(&options, "navi10.asic", quiet_printf);
+    ASSERT_NOT_NULL(dev[0]);
+    ASSERT_EQ(compare_shared(asic, dev[0]), TEST_SUCCESS);
+    umr_free_asic_blocks(dev[0]);
+    return TEST_SUCCESS;
+}
+
+static int cached_blocks;
+
+static int count_cached(const char *fmt, ...)
+{
+    cached_blocks += strstr(fmt, "(cached)") != NULL;
+    return 0;
+}
+
+// append one IP discovery record in the test harness log format
+static char *add_det(char *p, const char *ipname, int maj, int min, int rev, int logical_inst, uint64_t seg0)
+{
+    int x, v[6] = { 0, logical_inst, maj, min, rev, logical_inst };
+
+    for (x = 0; x < 128; x++)
+        p += sprintf(p, "%02x", x < (int)strlen(ipname) ? (unsigned)ipname[x] : 0);
+    for (x = 0; x < 6; x++)
+        p += sprintf(p, "%04x", (unsigned)v[x]);
+    for (x = 0; x < 32; x++)
+        p += sprintf(p, "%016" PRIx64, x < 2 ? seg0 + ((uint64_t)x << 16) : 0);
+    return p;
+}
+
+static struct umr_asic *discover(struct umr_options *options, umr_err_output errout)
+{
+    cached_blocks = 0;
+    return umr_discover_asic_by_discovery_table("cachetest", options, errout);
+}
+
+static enum TEST_RESULT compare_models(struct umr_asic* a, struct umr_asic* b)
+{
+    int i;
+
+    ASSERT_EQ(a->no_blocks, b->no_blocks);
+    for (i = 0; i < a->no_blocks; i++) {
+        ASSERT_STR_EQ(a->blocks[i]->ipname, b->blocks[i]->ipname);
+        ASSERT_EQ(a->blocks[i]->regs, b->blocks[i]->regs);
+        ASSERT_EQ(a->blocks[i]->no_regs, b->blocks[i]->no_regs);
+        ASSERT_EQ(memcmp(&a->blocks[i]->discoverable, &b->blocks[i]->discoverable, sizeof a->blocks[i]->discoverable), 0);
+    }
+    return TEST_SUCCESS;
+}
+
+static int scan_has_index(const char *dir)
+{
+    struct dirent *di;
+    DIR *d;
+    int n = 0;
+
+    d = opendir(dir);
+    if (!d)
+        return 0;
+    while ((di = readdir(d)))
+        n += !memcmp(di->d_name, "scan-", 5);
+    closedir(d);
+    return n;
+}
+
+// a model assembled from a cached snapshot must match one assembled from scratch
+enum TEST_RESULT test_discovery_model_cache(struct umr_asic* asic)
+{
+    struct umr_options options;
+    struct umr_asic *scratch, *cached;
+    struct utimbuf ut;
+    char script[16384], *cachedir, *dbdir, *p;
+
+    (void)asic;
+    cachedir = make_temp_dir("umrmodel");
+    ASSERT_NOT_NULL(cachedir);
+    dbdir = make_temp_dir("umrdb");
+    ASSERT_NOT_NULL(dbdir);
+    setenv("UMR_MODEL_CACHE", cachedir, 1);
+
+    // two VCN instances (numbered {0} and {1}) and a few renamed IPs
+    p = script + sprintf(script, "DISCOVERY = { ");
+    p = add_det(p, "gc", 10, 1, 0, 0, 0x1260);
+    p = add_det(p, "uvd", 2, 0, 0, 0, 0x7800);
+    p = add_det(p, "uvd", 2, 0, 0, 1, 0x7E00);
+    p = add_det(p, "nbif", 2, 3, 0, 0, 0x0);
+    p = add_det(p, "mp1", 11, 0, 0, 0, 0x16000);
+    p = add_det(p, "mmhub", 2, 0, 0, 0, 0x1A000);
+    p = add_det(p, "athub", 2, 0, 0, 0, 0xC00);
+    sprintf(p, " }\n");
+
+    memset(&options, 0, sizeof options);
+    options.test_log = 1;
+    options.verbose = 1;
+    options.th = umr_create_test_harness(script);
+    ASSERT_NOT_NULL(options.th);
+    strcpy(options.database_path, dbdir);
+
+    scratch = discover(&options, count_cached);
+    ASSERT_NOT_NULL(scratch);
+    ASSERT_EQ(cached_blocks, 0);
+    ASSERT_EQ(scratch->no_blocks, 6);
+    ASSERT_STR_EQ(scratch->blocks[1]->ipname, "vcn200{0}");
+    ASSERT_STR_EQ(scratch->blocks[2]->ipname, "vcn200{1}");
+
+    cached = discover(&options, count_cached);
+    ASSERT_NOT_NULL(cached);
+    ASSERT_EQ(cached_blocks, 6);
+    ASSERT_EQ(compare_models(scratch, cached), TEST_SUCCESS);
+    umr_free_asic_blocks(cached);
+
+    // the database scan index is kept elsewhere
+    ASSERT_EQ(scan_has_index(cachedir), 0);
+
+    // the cache can be bypassed
+    setenv("UMR_NO_MODEL_CACHE", "1", 1);
+    cached = discover(&options, count_cached);
+    unsetenv("UMR_NO_MODEL_CACHE");
+    ASSERT_NOT_NULL(cached);
+    ASSERT_EQ(cached_blocks, 0);
+    ASSERT_EQ(compare_models(scratch, cached), TEST_SUCCESS);
+    umr_free_asic_blocks(cached);
+
+    // any change to the database tree makes the snapshot stale until it is saved again
+    ut.actime = ut.modtime = 1000000000;
+    ASSERT_SUCCESS(utime(dbdir, &ut));
+    cached = discover(&options, count_cached);
+    ASSERT_NOT_NULL(cached);
+    ASSERT_EQ(cached_blocks, 0);
+    umr_free_asic_blocks(cached);
+    cached = discover(&options, count_cached);
+    ASSERT_NOT_NULL(cached);
+    ASSERT_EQ(cached_blocks, 6);
+    ASSERT_EQ(compare_models(scratch, cached), TEST_SUCCESS);
+    umr_free_asic_blocks(cached);
+
+    umr_free_asic_blocks(scratch);
+    umr_free_test_harness(options.th);
+    unsetenv("UMR_MODEL_CACHE");
+
+    ASSERT_SUCCESS(remove_temp_dir(cachedir));
+    ASSERT_SUCCESS(remove_temp_dir(dbdir));
+    return TEST_SUCCESS;
+}
+
+static int same_item(struct umr_database_scan_item *a, struct umr_database_scan_item *b)
+{
+    if (!a || !b)
+        return a == b;
+    return !strcmp(a->path, b->path) && !strcmp(a->fname, b->fname);
+}
+
+// the indexed scan must pick the same register file as a linear search of a fresh scan
+enum TEST_RESULT test_database_scan_index(struct umr_asic* asic)
+{
+    static const char *paths[] = { NULL, "ip", "no_such_dir" };
+    struct umr_database_scan_item *scanned, *indexed, *a, *b, **hash;
+    char *cachedir, *dbdir, fname[600];
+    struct utimbuf ut;
+    int dmin, drev, x, n;
+    FILE *f;
+
+    (void)asic;
+    cachedir = make_temp_dir("umrscan");
+    ASSERT_NOT_NULL(cachedir);
+    setenv("UMR_SCAN_INDEX", cachedir, 1);
+
+    // the index can be turned off, and is independent of the model cache
+    setenv("UMR_NO_SCAN_INDEX", "1", 1);
+    scanned = umr_database_scan(NULL);
+    unsetenv("UMR_NO_SCAN_INDEX");
+    ASSERT_NOT_NULL(scanned);
+    ASSERT_EQ(scan_has_index(cachedir), 0);
+    umr_database_free_scan_items(scanned);
+
+    setenv("UMR_NO_MODEL_CACHE", "1", 1);
+    scanned = umr_database_scan(NULL);
+    unsetenv("UMR_NO_MODEL_CACHE");
+    ASSERT_NOT_NULL(scanned);
+    ASSERT_EQ(scan_has_index(cachedir), 1);
+    indexed = umr_database_scan(NULL);
+    ASSERT_NOT_NULL(indexed);
+    ASSERT_NOT_NULL(indexed->ip_hash);
+
+    for (n = 0, a = scanned, b = indexed; a && b; a = a->next, b = b->next, n++) {
+        ASSERT_EQ(same_item(a, b), 1);
+        ASSERT_STR_EQ(a->ipname, b->ipname);
+        ASSERT_EQ(a->maj, b->maj);
+        ASSERT_EQ(a->min, b->min);
+        ASSERT_EQ(a->rev, b->rev);
+    }
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(n > 200, 1);
+
+    // every IP version and its neighbours, searched item by item in the fresh scan
+    hash = scanned->ip_hash;
+    scanned->ip_hash = NULL;
+    for (a = scanned; a; a = a->next)
+        for (dmin = -1; dmin <= 1; dmin++)
+            for (drev = -1; drev <= 1; drev++)
+                for (x = 0; x < 3; x++)
+                    ASSERT_EQ(same_item(umr_database_find_ip(scanned, a->ipname, a->maj, a->min + dmin, a->rev + drev, (char *)paths[x]),
+                                        umr_database_find_ip(indexed, a->ipname, a->maj, a->min + dmin, a->rev + drev, (char *)paths[x])), 1);
+    scanned->ip_hash = hash;
+    ASSERT_EQ(umr_database_find_ip(indexed, "no_such_ip", 1, 0, 0, NULL), NULL);
+    umr_database_free_scan_items(scanned);
+    umr_database_free_scan_items(indexed);
+
+    // adding a register file to a database root regenerates the index
+    dbdir = make_temp_dir("umrdb");
+    ASSERT_NOT_NULL(dbdir);
+    snprintf(fname, sizeof fname, "%s/foo_1_0_0.reg", dbdir);
+    f = fopen(fname, "w");
+    ASSERT_NOT_NULL(f);
+    fclose(f);
+    ut.actime = ut.modtime = 1000000000;
+    ASSERT_SUCCESS(utime(dbdir, &ut));
+    scanned = umr_database_scan(dbdir);
+    ASSERT_EQ(scan_has_index(cachedir), 2);
+    a = umr_database_find_ip(scanned, "foo", 1, 2, 0, NULL);
+    ASSERT_NOT_NULL(a);
+    ASSERT_STR_EQ(a->fname, "foo_1_0_0.reg");
+    umr_database_free_scan_items(scanned);
+
+    snprintf(fname, sizeof fname, "%s/foo_1_2_0.reg", dbdir);
+    f = fopen(fname, "w");
+    ASSERT_NOT_NULL(f);
+    fclose(f);
+    ut.actime = ut.modtime = 1000000100;
+    ASSERT_SUCCESS(utime(dbdir, &ut));
+    scanned = umr_database_scan(dbdir);
+    a = umr_database_find_ip(scanned, "foo", 1, 2, 0, NULL);
+    ASSERT_NOT_NULL(a);
+    ASSERT_STR_EQ(a->fname, "foo_1_2_0.reg");
+    umr_database_free_scan_items(scanned);
+
+    unsetenv("UMR_SCAN_INDEX");
+    ASSERT_SUCCESS(remove_temp_dir(cachedir));
+    ASSERT_SUCCESS(remove_temp_dir(dbdir));
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(ip_cache_tests)
+TEST(test_ip_block_cache_sharing, "navi_reg_only.envdef", "navi10"),
+TEST(test_discovery_model_cache, "navi_reg_only.envdef", "navi10"),
+TEST(test_database_scan_index, "navi_reg_only.envdef", "navi10"),
+END_TESTS(ip_cache_tests);
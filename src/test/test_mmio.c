@@ -28,8 +28,283 @@ enum TEST_RESULT test_reg_name_to_offset_renoir(struct umr_asic* asic)
     return test_reg_name_to_offset(asic, "mmSMUIO_GFX_MISC_CNTL", 0x5A320, 0x524E5231);
 }
 
+// registers alternating between two GRBM banks
+static void fill_reg_batch(struct umr_asic* asic, struct umr_reg_batch* rb)
+{
+    static const uint32_t addr[8] = { 0xA600, 0xA604, 0xA614, 0xA618, 0xA600, 0xA604, 0xA614, 0xA618 };
+    static const uint32_t se[8] = { 0, 1, 0, 1, 1, 0, 1, 0 };
+    int x;
+
+    for (x = 0; x < 8; x++) {
+        asic->options.use_bank = 1;
+        asic->options.bank.grbm.se = se[x];
+        asic->options.bank.grbm.sh = 0;
+        asic->options.bank.grbm.instance = 0;
+        umr_reg_batch_entry(asic, &rb[x], addr[x], REG_MMIO);
+    }
+    asic->options.use_bank = 0;
+}
+
+// within a bank the reads happen in array order so the first
+// read of each address comes from the SE0 bank
+static const uint32_t batch_expect[8] = {
+    0x11110000, 0x22220001, 0x33330000, 0x44440001,
+    0x11110001, 0x22220000, 0x33330001, 0x44440000 };
+
+enum TEST_RESULT test_read_reg_batch_groups_banks(struct umr_asic* asic)
+{
+    struct umr_reg_batch rb[8];
+    uint32_t reads[2], switches[2];
+    int x;
+
+    fill_reg_batch(asic, rb);
+    umr_test_harness_get_access_counts(asic, &reads[0], &switches[0]);
+    ASSERT_SUCCESS(umr_read_reg_batch(asic, rb, 8));
+    umr_test_harness_get_access_counts(asic, &reads[1], &switches[1]);
+
+    ASSERT_EQ(reads[1] - reads[0], 8);
+    ASSERT_EQ(switches[1] - switches[0], 2);
+    for (x = 0; x < 8; x++)
+        ASSERT_EQ(rb[x].value, batch_expect[x]);
+
+    // banking options are restored
+    ASSERT_EQ(asic->options.use_bank, 0);
+
+    // the same reads one at a time reprogram the bank whenever it
+    // differs from the previous access (7 times for this pattern)
+    umr_test_harness_rewind(asic);
+    umr_test_harness_get_access_counts(asic, &reads[0], &switches[0]);
+    for (x = 0; x < 8; x++) {
+        umr_set_bank_state(asic, &rb[x].bank);
+        asic->reg_funcs.read_reg(asic, rb[x].addr, rb[x].type);
+    }
+    asic->options.use_bank = 0;
+    umr_test_harness_get_access_counts(asic, &reads[1], &switches[1]);
+    ASSERT_EQ(reads[1] - reads[0], 8);
+    ASSERT_EQ(switches[1] - switches[0], 7);
+    return TEST_SUCCESS;
+}
+
+// samples come out in order with the values in the order they were given
+enum TEST_RESULT test_reg_sampler_navi(struct umr_asic* asic)
+{
+    struct umr_reg_batch rb[8];
+    struct umr_sampler *s;
+    struct umr_sampler_stats st;
+    uint32_t reads[2], switches[2], values[8];
+    uint64_t ts, last_ts;
+    int x, n;
+
+    fill_reg_batch(asic, rb);
+    s = umr_sampler_create(asic, rb, 8, 1000, 16);
+    ASSERT_NOT_NULL(s);
+
+    umr_test_harness_get_access_counts(asic, &reads[0], &switches[0]);
+    umr_sampler_run(s, 4);
+    umr_test_harness_get_access_counts(asic, &reads[1], &switches[1]);
+    ASSERT_EQ(reads[1] - reads[0], 4 * 8);
+
+    for (n = 0, last_ts = 0; umr_sampler_pop(s, &ts, values); n++) {
+        ASSERT_EQ(ts >= last_ts, 1);
+        last_ts = ts;
+        for (x = 0; x < 8; x++)
+            ASSERT_EQ(values[x], n ? 0xDEADBEEF : batch_expect[x]);
+    }
+    ASSERT_EQ(n, 4);
+
+    umr_sampler_get_stats(s, &st);
+    ASSERT_EQ(st.samples, 4);
+    ASSERT_EQ(st.dropped, 0);
+    ASSERT_EQ(st.rate_hz > 0, 1);
+    umr_sampler_free(s);
+
+    // a consumer that does not keep up loses the newest samples
+    s = umr_sampler_create(asic, rb, 8, 1000, 2);
+    ASSERT_NOT_NULL(s);
+    umr_sampler_run(s, 5);
+    umr_sampler_get_stats(s, &st);
+    ASSERT_EQ(st.samples, 5);
+    ASSERT_EQ(st.dropped, 3);
+    for (n = 0; umr_sampler_pop(s, NULL, values); n++);
+    ASSERT_EQ(n, 2);
+
+    // and from a thread of its own
+    ASSERT_SUCCESS(umr_sampler_start(s));
+    do {
+        umr_sampler_get_stats(s, &st);
+    } while (st.samples < 8);
+    umr_sampler_stop(s);
+    for (n = 0; umr_sampler_pop(s, NULL, values); n++)
+        ASSERT_EQ(values[0], 0xDEADBEEF);
+    ASSERT_EQ(n >= 1 && n <= 2, 1);
+    umr_sampler_free(s);
+    return TEST_SUCCESS;
+}
+
+static int quiet_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+// samples logged from the sampler come back out of the CSV converter
+enum TEST_RESULT test_sample_log_csv_navi(struct umr_asic* asic)
+{
+    static const char *names[8] = { "A600.se0", "A604.se1", "A614.se0", "A618.se1",
+                                    "A600.se1", "A604.se0", "A614.se1", "A618.se0" };
+    static const char *units[8] = { "", "", "", "", "", "", "", "raw" };
+    char path[] = "/tmp/umr_slog_XXXXXX", line[512], want[512], *p;
+    struct umr_reg_batch rb[8];
+    struct umr_sampler *s;
+    struct umr_sample_log *log;
+    uint32_t values[8];
+    uint64_t ts[300], v64[8];
+    long size;
+    FILE *f, *csv;
+    int fd, x, n;
+
+    fd = mkstemp(path);
+    ASSERT_EQ(fd >= 0, 1);
+    close(fd);
+    unlink(path);
+
+    // more than a block of samples from the harness
+    fill_reg_batch(asic, rb);
+    s = umr_sampler_create(asic, rb, 8, 100000, 512);
+    ASSERT_NOT_NULL(s);
+    umr_sampler_run(s, 300);
+
+    log = umr_sample_log_open(path, 8, names, units);
+    ASSERT_NOT_NULL(log);
+    for (n = 0; umr_sampler_pop(s, &ts[n], values); n++) {
+        for (x = 0; x < 8; x++)
+            v64[x] = values[x] + ((uint64_t)(n & 1) << 32);
+        ASSERT_SUCCESS(umr_sample_log_write(log, ts[n], v64));
+    }
+    ASSERT_EQ(n, 300);
+    ASSERT_SUCCESS(umr_sample_log_close(log));
+    umr_sampler_free(s);
+
+    // a second session appended with other columns
+    log = umr_sample_log_open(path, 1, names, NULL);
+    ASSERT_NOT_NULL(log);
+    v64[0] = 5;
+    ASSERT_SUCCESS(umr_sample_log_write(log, 1500000000ULL, v64));
+    ASSERT_SUCCESS(umr_sample_log_close(log));
+
+    f = fopen(path, "rb");
+    ASSERT_NOT_NULL(f);
+    csv = tmpfile();
+    ASSERT_NOT_NULL(csv);
+    ASSERT_EQ(umr_sample_log_to_csv(quiet_printf, f, csv), 301);
+    rewind(csv);
+
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "Time (seconds),A600.se0,A604.se1,A614.se0,A618.se1,A600.se1,A604.se0,A614.se1,A618.se0 (raw)\n");
+    for (n = 0; n < 300; n++) {
+        p = want + sprintf(want, "%" PRIu64 ".%09" PRIu64, ts[n] / 1000000000, ts[n] % 1000000000);
+        for (x = 0; x < 8; x++)
+            p += sprintf(p, ",%" PRIu64, (n ? 0xDEADBEEF : batch_expect[x]) + ((uint64_t)(n & 1) << 32));
+        strcpy(p, "\n");
+        ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+        ASSERT_STR_EQ(line, want);
+    }
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "Time (seconds),A600.se0\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "1.500000000,5\n");
+    ASSERT_EQ(fgets(line, sizeof line, csv), NULL);
+
+    // smaller than the CSV even with every value moving by 2^32 each sample
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    ASSERT_EQ(size * 2 < ftell(csv), 1);
+    fclose(csv);
+
+    // a truncated log is an error
+    fclose(f);
+    ASSERT_EQ(truncate(path, size - 3), 0);
+    f = fopen(path, "rb");
+    ASSERT_NOT_NULL(f);
+    csv = tmpfile();
+    ASSERT_EQ(umr_sample_log_to_csv(quiet_printf, f, csv), -1);
+    fclose(csv);
+    fclose(f);
+    unlink(path);
+    return TEST_SUCCESS;
+}
+
+// top keeps logging when the panels change, the log goes on with the new columns
+enum TEST_RESULT test_sample_log_set_fields_navi(struct umr_asic* asic)
+{
+    static const char *names[3] = { "GRBM.GUI_ACTIVE", "GRBM.CP_BUSY", "SENSOR.GFX_SCLK" };
+    static const char *units[3] = { "samples", "samples", "MHz" };
+    char path[] = "/tmp/umr_slog_XXXXXX", line[512];
+    struct umr_sample_log *log;
+    uint64_t v64[3];
+    FILE *f, *csv;
+    int fd, n;
+
+    (void)asic;
+    fd = mkstemp(path);
+    ASSERT_EQ(fd >= 0, 1);
+    close(fd);
+    unlink(path);
+
+    log = umr_sample_log_open(path, 2, names, units);
+    ASSERT_NOT_NULL(log);
+    for (n = 0; n < 3; n++) {
+        v64[0] = n;
+        v64[1] = 10 * n;
+        ASSERT_SUCCESS(umr_sample_log_write(log, 1000000000ULL * (n + 1), v64));
+    }
+
+    // a panel was enabled, then all of them disabled
+    ASSERT_SUCCESS(umr_sample_log_set_fields(log, 3, names, units));
+    v64[0] = 7;
+    v64[1] = 8;
+    v64[2] = 1800;
+    ASSERT_SUCCESS(umr_sample_log_write(log, 4000000000ULL, v64));
+    ASSERT_SUCCESS(umr_sample_log_set_fields(log, 0, names, units));
+    ASSERT_SUCCESS(umr_sample_log_write(log, 5000000000ULL, v64));
+    ASSERT_SUCCESS(umr_sample_log_close(log));
+
+    f = fopen(path, "rb");
+    ASSERT_NOT_NULL(f);
+    csv = tmpfile();
+    ASSERT_NOT_NULL(csv);
+    ASSERT_EQ(umr_sample_log_to_csv(quiet_printf, f, csv), 5);
+    rewind(csv);
+
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "Time (seconds),GRBM.GUI_ACTIVE (samples),GRBM.CP_BUSY (samples)\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "1.000000000,0,0\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "2.000000000,1,10\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "3.000000000,2,20\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "Time (seconds),GRBM.GUI_ACTIVE (samples),GRBM.CP_BUSY (samples),SENSOR.GFX_SCLK (MHz)\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "4.000000000,7,8,1800\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "Time (seconds)\n");
+    ASSERT_NOT_NULL(fgets(line, sizeof line, csv));
+    ASSERT_STR_EQ(line, "5.000000000\n");
+    ASSERT_EQ(fgets(line, sizeof line, csv), NULL);
+    fclose(csv);
+    fclose(f);
+    unlink(path);
+    return TEST_SUCCESS;
+}
+
 DEFINE_TESTS(mmio_tests)
 TEST(test_reg_name_to_offset_navi, "navi_reg_only.envdef", "navi10"),
 TEST(test_reg_name_to_offset_raven, "raven_reg_only.envdef", "raven1"),
 TEST(test_reg_name_to_offset_renoir, "renoir_reg_only.envdef", "renoir"),
+TEST(test_read_reg_batch_groups_banks, "navi_reg_batch.envdef", "navi10"),
+TEST(test_reg_sampler_navi, "navi_reg_batch.envdef", "navi10"),
+TEST(test_sample_log_csv_navi, "navi_reg_batch.envdef", "navi10"),
+TEST(test_sample_log_set_fields_navi, "navi_reg_batch.envdef", "navi10"),
 END_TESTS(mmio_tests);
@@ -0,0 +1,42 @@
+#include "test_framework.h"
+
+// every pci.did entry must resolve to what a line by line scan finds first
+enum TEST_RESULT test_pci_did_index(struct umr_asic* asic)
+{
+    char linebuf[256], name[128], first[128], indexed[128];
+    uint32_t did, ldid;
+    long pos;
+    int n = 0;
+    FILE *f;
+
+    (void)asic;
+    f = umr_database_open(NULL, "pci.did", 0);
+    ASSERT_NOT_NULL(f);
+    while (fgets(linebuf, sizeof linebuf, f)) {
+        if (sscanf(linebuf, "%"SCNx32" %127s", &did, name) != 2)
+            continue;
+
+        // the scan umr_discover_asic_by_did() used to do
+        pos = ftell(f);
+        rewind(f);
+        while (fgets(linebuf, sizeof linebuf, f))
+            if (sscanf(linebuf, "%"SCNx32" %127s", &ldid, first) == 2 && ldid == did)
+                break;
+        fseek(f, pos, SEEK_SET);
+
+        ASSERT_EQ(umr_database_did_lookup(NULL, did, indexed, sizeof indexed), 1);
+        ASSERT_STR_EQ(indexed, first);
+        ++n;
+    }
+    fclose(f);
+    ASSERT_EQ(n > 300, 1);
+
+    ASSERT_EQ(umr_database_did_lookup(NULL, 0x0, indexed, sizeof indexed), 0);
+    ASSERT_EQ(umr_database_did_lookup(NULL, 0xFFFFFFFF, NULL, 0), 0);
+    ASSERT_EQ(umr_database_did_lookup(NULL, 0x731F, NULL, 0), 1);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(pci_did_tests)
+TEST(test_pci_did_index, "navi_reg_only.envdef", "navi10"),
+END_TESTS(pci_did_tests);
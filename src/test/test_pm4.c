@@ -0,0 +1,171 @@
+#include "test_framework.h"
+
+#define PKT3(op, n) ((3u << 30) | ((((n) - 1) & 0x3FFF) << 16) | ((op) << 8))
+
+// a stream is decoded into a list of packets whose words point at a copy of the stream
+enum TEST_RESULT test_pm4_decode_stream_navi(struct umr_asic* asic)
+{
+    uint32_t words[] = {
+        PKT3(0x10, 1), 0x11111111,                          // NOP
+        PKT3(0x69, 3), 0x100, 0x22222222, 0x33333333,       // SET_CONTEXT_REG
+        PKT3(0x10, 2), 0x44444444, 0x55555555,              // NOP
+        PKT3(0x69, 4), 0x100,                               // truncated
+    };
+    static const uint32_t opcodes[3] = { 0x10, 0x69, 0x10 };
+    static const uint32_t sizes[3] = { 1, 3, 2 };
+    struct umr_pm4_stream *stream, *ps;
+    uint32_t off = 0;
+    int n;
+
+    asic->options.vm_partition = -1;
+    stream = umr_pm4_decode_stream(asic, -1, 0, words, sizeof words / sizeof words[0]);
+    ASSERT_NOT_NULL(stream);
+
+    for (n = 0, ps = stream; ps; ps = ps->next, ++n) {
+        ASSERT_EQ(ps->pkttype, 3);
+        ASSERT_EQ(ps->header, words[off]);
+        ASSERT_EQ(ps->opcode, opcodes[n]);
+        ASSERT_EQ(ps->n_words, sizes[n]);
+        ASSERT_EQ(ps->arena, stream->arena);
+        ASSERT_EQ(memcmp(ps->words, &words[off + 1], ps->n_words * sizeof words[0]), 0);
+        // the packet does not reference the caller's buffer
+        ASSERT_EQ(ps->words == &words[off + 1], 0);
+        off += 1 + ps->n_words;
+    }
+    ASSERT_EQ(n, 3);
+    umr_free_pm4_stream(stream);
+
+    // nothing to decode if the first packet is already cut short
+    ASSERT_EQ(umr_pm4_decode_stream(asic, -1, 0, &words[9], 2), NULL);
+    return TEST_SUCCESS;
+}
+
+// linear VRAM with three IBs, the second a copy of the first
+#define IB_WORDS 6
+static uint32_t ib_vram[3][IB_WORDS];
+static uint32_t ib_vram_reads;
+
+static int count_linear_vram(struct umr_asic *asic, uint64_t address, uint32_t size, void *data, int write_en)
+{
+    (void)asic;
+    if (write_en || address < 0x1000 || (address & 0xFFF) || address > 0x3000 || size != sizeof ib_vram[0])
+        return -1;
+    memcpy(data, ib_vram[(address >> 12) - 1], size);
+    ++ib_vram_reads;
+    return 0;
+}
+
+struct ib_log {
+    uint64_t ib_addr[16], reused_from[4];
+    uint32_t no_ibs, no_reused, no_opcodes;
+};
+
+static void log_start_ib(struct umr_stream_decode_ui *ui, uint64_t ib_addr, uint32_t ib_vmid, uint64_t from_addr, uint32_t from_vmid, uint32_t size, int type)
+{
+    struct ib_log *log = ui->data;
+    (void)ib_vmid; (void)from_addr; (void)from_vmid; (void)size; (void)type;
+    if (log->no_ibs < 16)
+        log->ib_addr[log->no_ibs] = ib_addr;
+    ++log->no_ibs;
+}
+
+static void log_start_opcode(struct umr_stream_decode_ui *ui, uint64_t ib_addr, uint32_t ib_vmid, int pkttype, uint32_t opcode, uint32_t subop, uint32_t nwords, const char *opcode_name, uint32_t header, const uint32_t* raw_data)
+{
+    struct ib_log *log = ui->data;
+    (void)ib_addr; (void)ib_vmid; (void)pkttype; (void)opcode; (void)subop; (void)nwords; (void)opcode_name; (void)header; (void)raw_data;
+    ++log->no_opcodes;
+}
+
+static void log_add_field(struct umr_stream_decode_ui *ui, uint64_t ib_addr, uint32_t ib_vmid, const char *field_name, uint64_t value, char *str, int ideal_radix, int field_size)
+{
+    (void)ui; (void)ib_addr; (void)ib_vmid; (void)field_name; (void)value; (void)str; (void)ideal_radix; (void)field_size;
+}
+
+static void log_done(struct umr_stream_decode_ui *ui)
+{
+    (void)ui;
+}
+
+static void log_reused_ib(struct umr_stream_decode_ui *ui, uint64_t ib_addr, uint32_t ib_vmid, uint64_t from_addr, uint32_t from_vmid)
+{
+    struct ib_log *log = ui->data;
+    (void)ib_vmid; (void)from_vmid;
+    if (log->no_reused < 4)
+        log->reused_from[log->no_reused] = (ib_addr << 32) | from_addr;
+    ++log->no_reused;
+}
+
+// IBs referenced several times are read and decoded once and shared
+enum TEST_RESULT test_pm4_ib_reuse_navi(struct umr_asic* asic)
+{
+    static const uint64_t targets[5] = { 0x1000, 0x1000, 0x2000, 0x3000, 0x1000 };
+    static const int reused[5] = { 0, 1, 1, 0, 1 };
+    int (*access_linear_vram)(struct umr_asic *, uint64_t, uint32_t, void *, int);
+    struct umr_stream_decode_ui ui;
+    struct umr_pm4_stream *stream, *ps;
+    struct ib_log log;
+    uint32_t ring[5 * 4], x;
+
+    asic->options.vm_partition = -1;
+    for (x = 0; x < 3; x++) {
+        ib_vram[x][0] = PKT3(0x10, 1);
+        ib_vram[x][1] = x == 2 ? 0xCCCCCCCC : 0xAAAAAAAA;
+        ib_vram[x][2] = PKT3(0x69, 3);
+        ib_vram[x][3] = 0x100;
+        ib_vram[x][4] = 0x11111111;
+        ib_vram[x][5] = 0x22222222;
+    }
+    for (x = 0; x < 5; x++) {
+        ring[4 * x + 0] = PKT3(0x3F, 3);                   // INDIRECT_BUFFER
+        ring[4 * x + 1] = (uint32_t)targets[x];
+        ring[4 * x + 2] = 0;
+        ring[4 * x + 3] = IB_WORDS;
+    }
+
+    access_linear_vram = asic->mem_funcs.access_linear_vram;
+    asic->mem_funcs.access_linear_vram = count_linear_vram;
+    ib_vram_reads = 0;
+    stream = umr_pm4_decode_stream(asic, -1, UMR_LINEAR_HUB, ring, 5 * 4);
+    asic->mem_funcs.access_linear_vram = access_linear_vram;
+    ASSERT_NOT_NULL(stream);
+
+    // the second copy at 0x2000 is read but matches the first by contents
+    ASSERT_EQ(ib_vram_reads, 3);
+    for (x = 0, ps = stream; ps; ps = ps->next, x++) {
+        ASSERT_NOT_NULL(ps->ib);
+        ASSERT_EQ(ps->ib_source.addr, targets[x]);
+        ASSERT_EQ(ps->ib_reused, reused[x]);
+        ASSERT_EQ(ps->ib == stream->ib, x != 3);
+        ASSERT_EQ(ps->ib->next->words[2], 0x22222222);
+    }
+    ASSERT_EQ(x, 5);
+
+    // every reference is still decoded at its own address
+    memset(&ui, 0, sizeof ui);
+    memset(&log, 0, sizeof log);
+    ui.rt = UMR_RING_PM4;
+    ui.start_ib = log_start_ib;
+    ui.start_opcode = log_start_opcode;
+    ui.add_field = log_add_field;
+    ui.done = log_done;
+    ui.reused_ib = log_reused_ib;
+    ui.data = &log;
+    umr_pm4_decode_stream_opcodes(asic, &ui, stream, 0, 0, 0, 0, ~0UL, 1);
+    ASSERT_EQ(log.no_ibs, 6);
+    for (x = 0; x < 5; x++)
+        ASSERT_EQ(log.ib_addr[1 + x], targets[x]);
+    ASSERT_EQ(log.no_opcodes, 5 + 5 * 2);
+    ASSERT_EQ(log.no_reused, 3);
+    ASSERT_EQ(log.reused_from[0], (0x1000ULL << 32) | 0x10);
+    ASSERT_EQ(log.reused_from[1], (0x2000ULL << 32) | 0x20);
+    ASSERT_EQ(log.reused_from[2], (0x1000ULL << 32) | 0x40);
+
+    // the shared IBs are released with the last reference
+    umr_free_pm4_stream(stream);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(pm4_tests)
+TEST(test_pm4_decode_stream_navi, "navi_reg_only.envdef", "navi10"),
+TEST(test_pm4_ib_reuse_navi, "navi_reg_only.envdef", "navi10"),
+END_TESTS(pm4_tests);
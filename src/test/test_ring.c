@@ -0,0 +1,195 @@
+#include "test_framework.h"
+
+#define RING_WORDS 1024
+
+// write a ring file with the given pointers and word N of the ring set to N
+static int write_ring_file(const char *path, uint32_t rptr, uint32_t wptr)
+{
+    uint32_t data[3 + RING_WORDS], x;
+    FILE *f;
+
+    data[0] = rptr;
+    data[1] = wptr;
+    data[2] = wptr;
+    for (x = 0; x < RING_WORDS; x++)
+        data[3 + x] = x;
+
+    f = fopen(path, "wb");
+    if (!f)
+        return -1;
+    x = fwrite(data, sizeof data, 1, f);
+    fclose(f);
+    return x == 1 ? 0 : -1;
+}
+
+// polling the pointers must only read the ring header
+enum TEST_RESULT test_ring_poll_header_only(struct umr_asic* asic)
+{
+    char path[] = "/tmp/umr_ring_XXXXXX";
+    uint32_t ptrs[3], ringsize, words[16], x;
+    uint64_t bytes;
+    int fd;
+
+    fd = mkstemp(path);
+    ASSERT_EQ(fd >= 0, 1);
+    close(fd);
+
+    // wrapped pointers that differ, polled until umr gives up
+    ASSERT_SUCCESS(write_ring_file(path, 5, RING_WORDS + 9));
+    ASSERT_SUCCESS(umr_ring_poll_open(asic, "gfx", path));
+    ASSERT_EQ(umr_ring_is_halted(asic, "gfx"), 1);
+    ASSERT_EQ(asic->ring_poll->bytes_read, 100 * 12);
+
+    // the file stays open, new pointers are seen on the next poll
+    ASSERT_SUCCESS(write_ring_file(path, 7, RING_WORDS + 7));
+    bytes = asic->ring_poll->bytes_read;
+    ASSERT_EQ(umr_ring_is_halted(asic, "gfx"), 0);
+    ASSERT_EQ(asic->ring_poll->bytes_read - bytes, 12);
+
+    ASSERT_SUCCESS(umr_read_ring_ptrs(asic, "gfx", ptrs, &ringsize));
+    ASSERT_EQ(ringsize, RING_WORDS * 4);
+    ASSERT_EQ(ptrs[0], 7);
+    ASSERT_EQ(ptrs[1], RING_WORDS + 7);
+
+    // a window that wraps around the end of the ring
+    bytes = asic->ring_poll->bytes_read;
+    ASSERT_SUCCESS(umr_read_ring_words(asic, "gfx", RING_WORDS - 6, 16, words));
+    ASSERT_EQ(asic->ring_poll->bytes_read - bytes, 16 * 4);
+    for (x = 0; x < 16; x++)
+        ASSERT_EQ(words[x], (RING_WORDS - 6 + x) % RING_WORDS);
+
+    umr_ring_poll_close(asic);
+    ASSERT_EQ(asic->ring_poll, NULL);
+    unlink(path);
+    return TEST_SUCCESS;
+}
+
+#define SUB_WORDS 8
+#define SUB_SLOTS (RING_WORDS / SUB_WORDS)
+
+// the shader submission N points at
+static uint64_t sub_shader(uint32_t n)
+{
+    return 0x100000ULL + (uint64_t)n * 0x1000;
+}
+
+// a ring holding submissions first..last-1, each a COMPUTE_PGM_LO/HI write and a NOP
+static int write_pm4_ring(const char *path, uint32_t pgm_lo, uint32_t first, uint32_t last)
+{
+    uint32_t data[3 + RING_WORDS], *p, n;
+    FILE *f;
+
+    memset(data, 0, sizeof data);
+    for (n = first; n < last; n++) {
+        p = &data[3 + (n % SUB_SLOTS) * SUB_WORDS];
+        p[0] = (3U << 30) | (2U << 16) | (0x76 << 8);  // SET_SH_REG
+        p[1] = pgm_lo - 0x2C00;
+        p[2] = (uint32_t)(sub_shader(n) >> 8);
+        p[3] = (uint32_t)(sub_shader(n) >> 40);
+        p[4] = (3U << 30) | (2U << 16) | (0x10 << 8);  // NOP
+    }
+    data[0] = (first % SUB_SLOTS) * SUB_WORDS;
+    data[1] = data[2] = (last % SUB_SLOTS) * SUB_WORDS;
+
+    f = fopen(path, "wb");
+    if (!f)
+        return -1;
+    n = fwrite(data, sizeof data, 1, f);
+    fclose(f);
+    return n == 1 ? 0 : -1;
+}
+
+// what the profiler did before: decode everything between rptr and wptr
+static struct umr_packet_stream *decode_active(struct umr_asic* asic, uint32_t first, uint32_t last, uint64_t *words)
+{
+    uint32_t buf[RING_WORDS], ptrs[3], ringsize, n;
+
+    if (umr_read_ring_ptrs(asic, "gfx", ptrs, &ringsize))
+        return NULL;
+    n = (ptrs[1] + RING_WORDS - ptrs[0]) % RING_WORDS;
+    if (n != (last - first) * SUB_WORDS || !n || umr_read_ring_words(asic, "gfx", ptrs[0], n, buf))
+        return NULL;
+    *words += n;
+    return umr_packet_decode_buffer(asic, NULL, 0, 0, buf, n, UMR_RING_PM4);
+}
+
+// sampling a moving ring incrementally has to find the same shaders as decoding it all each time
+enum TEST_RESULT test_ring_cache_incremental(struct umr_asic* asic)
+{
+    char path[] = "/tmp/umr_ring_XXXXXX";
+    struct umr_ring_cache *rc;
+    struct umr_packet_stream *full;
+    struct umr_shaders_pgm *a, *b;
+    uint32_t pgm_lo, first, last, t, n, pass;
+    uint64_t full_words = 0, hits = 0;
+    int fd;
+
+    asic->options.vm_partition = -1;
+    asic->options.no_follow_shader = 1;
+    asic->options.shader_enable.enable_comp_shader = 1;
+    pgm_lo = umr_find_reg(asic, "mmCOMPUTE_PGM_LO");
+    ASSERT_EQ(pgm_lo != 0xFFFFFFFF, 1);
+
+    fd = mkstemp(path);
+    ASSERT_EQ(fd >= 0, 1);
+    close(fd);
+    ASSERT_SUCCESS(write_pm4_ring(path, pgm_lo, 0, 0));
+    ASSERT_SUCCESS(umr_ring_poll_open(asic, "gfx", path));
+
+    rc = umr_ring_cache_create(asic, "gfx", UMR_RING_GUESS);
+    ASSERT_NOT_NULL(rc);
+    ASSERT_EQ(rc->rt, UMR_RING_PM4);
+
+    // submit 0..3 packets and retire some between samples, wrapping the ring several times
+    for (first = last = 0, t = 0; t < 400; t++) {
+        last += t % 4;
+        if (last - first > 20)
+            first = last - 20 + (t % 5);
+        else if (t % 7 == 0 && first < last)
+            ++first;
+        ASSERT_SUCCESS(write_pm4_ring(path, pgm_lo, first, last));
+        ASSERT_SUCCESS(umr_ring_cache_update(rc));
+        full = (first == last) ? NULL : decode_active(asic, first, last, &full_words);
+        ASSERT_EQ(first == last || full != NULL, 1);
+
+        // every shader that ever was on the ring, twice
+        for (pass = 0; pass < 2; pass++) {
+            for (n = last > 30 ? last - 30 : 0; n <= last; n++) {
+                a = umr_ring_cache_find_shader(rc, 0, sub_shader(n));
+                b = full ? umr_packet_find_shader(full, 0, sub_shader(n)) : NULL;
+                ASSERT_EQ(a != NULL, b != NULL);
+                ASSERT_EQ(a != NULL, n >= first && n < last);
+                if (a) {
+                    ASSERT_EQ(a->addr, b->addr);
+                    ASSERT_EQ(a->vmid, b->vmid);
+                    ASSERT_EQ(a->type, b->type);
+                    ASSERT_EQ(a->size, b->size);
+                    ++hits;
+                }
+                free(a);
+                free(b);
+            }
+        }
+        umr_packet_free(full);
+    }
+    ASSERT_EQ(hits > 1000, 1);
+
+    // a submission is decoded about once instead of on every sample it is pending in
+    ASSERT_EQ(rc->words_decoded * 4 < full_words, 1);
+    ASSERT_EQ(rc->lookups_cached > 0, 1);
+
+    // nothing new, nothing decoded
+    n = rc->words_decoded;
+    ASSERT_SUCCESS(umr_ring_cache_update(rc));
+    ASSERT_EQ(rc->words_decoded, n);
+
+    umr_ring_cache_free(rc);
+    umr_ring_poll_close(asic);
+    unlink(path);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(ring_tests)
+TEST(test_ring_poll_header_only, "navi_reg_only.envdef", "navi10"),
+TEST(test_ring_cache_incremental, "navi_reg_only.envdef", "navi10"),
+END_TESTS(ring_tests);
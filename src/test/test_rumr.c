@@ -0,0 +1,209 @@
+#include "test_framework.h"
+#include "umr_rumr.h"
+#include <pthread.h>
+
+static int quiet_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+static void *server_thread(void *arg)
+{
+    struct rumr_server_state *st = arg;
+
+    if (!rumr_server_accept(st))
+        while (!rumr_server_loop(st));
+    return NULL;
+}
+
+// bind a RUMR server for @asic to the first free loopback port
+static int start_server(struct rumr_server_state *st, struct umr_asic *asic, pthread_t *thread, char *addr)
+{
+    struct rumr_comm_funcs cf = rumr_tcp_funcs;
+    int port;
+
+    cf.log_msg = quiet_printf;
+    memset(st, 0, sizeof *st);
+    st->asic = asic;
+    for (port = 29500; port < 29532; port++) {
+        sprintf(addr, "127.0.0.1:%d", port);
+        if (!rumr_server_bind(st, &cf, addr))
+            return pthread_create(thread, NULL, server_thread, st) ? -1 : 0;
+        rumr_buffer_free(st->serialized_asic);
+        st->serialized_asic = NULL;
+    }
+    return -1;
+}
+
+static void fill_reg_batch(struct umr_asic* asic, struct umr_reg_batch* rb)
+{
+    static const uint32_t addr[8] = { 0xA600, 0xA604, 0xA614, 0xA618, 0xA600, 0xA604, 0xA614, 0xA618 };
+    static const uint32_t se[8] = { 0, 1, 0, 1, 1, 0, 1, 0 };
+    int x;
+
+    for (x = 0; x < 8; x++) {
+        asic->options.use_bank = 1;
+        asic->options.bank.grbm.se = se[x];
+        asic->options.bank.grbm.sh = 0;
+        asic->options.bank.grbm.instance = 0;
+        umr_reg_batch_entry(asic, &rb[x], addr[x], REG_MMIO);
+    }
+    asic->options.use_bank = 0;
+}
+
+// batched, pipelined and one at a time remote reads must agree
+enum TEST_RESULT test_rumr_loopback_batch(struct umr_asic* asic)
+{
+    struct rumr_server_state st;
+    struct rumr_client_state cs;
+    struct rumr_comm_funcs cf = rumr_tcp_funcs;
+    struct rumr_buffer *buf;
+    struct umr_reg_batch batched[8], pipelined[8], single[8];
+    uint32_t reads[2], switches[2], ids[3], x;
+    pthread_t thread;
+    char addr[32];
+
+    ASSERT_SUCCESS(start_server(&st, asic, &thread, addr));
+    cf.log_msg = quiet_printf;
+    memset(&cs, 0, sizeof cs);
+    ASSERT_SUCCESS(rumr_client_connect(&cs, &cf, addr));
+    ASSERT_EQ(cs.server_revision, RUMR_REVISION);
+    ASSERT_NOT_NULL(cs.asic->reg_funcs.read_reg_batch);
+
+    // one frame for the lot
+    fill_reg_batch(cs.asic, batched);
+    umr_test_harness_get_access_counts(asic, &reads[0], &switches[0]);
+    ASSERT_SUCCESS(umr_read_reg_batch(cs.asic, batched, 8));
+    umr_test_harness_get_access_counts(asic, &reads[1], &switches[1]);
+    ASSERT_EQ(reads[1] - reads[0], 8);
+
+    // what an older server gets
+    umr_test_harness_rewind(asic);
+    fill_reg_batch(cs.asic, pipelined);
+    cs.server_revision = 1;
+    ASSERT_SUCCESS(umr_read_reg_batch(cs.asic, pipelined, 8));
+    cs.server_revision = RUMR_REVISION;
+
+    umr_test_harness_rewind(asic);
+    fill_reg_batch(cs.asic, single);
+    for (x = 0; x < 8; x++) {
+        umr_set_bank_state(cs.asic, &single[x].bank);
+        single[x].value = cs.asic->reg_funcs.read_reg(cs.asic, single[x].addr, single[x].type);
+    }
+    cs.asic->options.use_bank = 0;
+
+    for (x = 0; x < 8; x++) {
+        ASSERT_EQ(batched[x].value, single[x].value);
+        ASSERT_EQ(pipelined[x].value, single[x].value);
+    }
+
+    // replies are matched to requests when collected out of order
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, NULL, 0, &ids[0]));
+    x = RUMR_REVISION;
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, &x, 1, &ids[1]));
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, NULL, 0, &ids[2]));
+
+    // a client that does not announce a revision gets just the ASIC
+    buf = rumr_client_collect(&cs, ids[2]);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(buf->woffset, 4 + st.serialized_asic->woffset);
+    rumr_buffer_free(buf);
+    buf = rumr_client_collect(&cs, ids[1]);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(buf->woffset, 8 + st.serialized_asic->woffset);
+    rumr_buffer_free(buf);
+    buf = rumr_client_collect(&cs, ids[0]);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(buf->woffset, 4 + st.serialized_asic->woffset);
+    rumr_buffer_free(buf);
+    ASSERT_EQ(cs.pending, NULL);
+
+    rumr_client_close(&cs);
+    pthread_join(thread, NULL);
+    rumr_server_close(&st);
+    return TEST_SUCCESS;
+}
+
+// replies to abandoned requests never reach whoever reuses their ID
+enum TEST_RESULT test_rumr_discard(struct umr_asic* asic)
+{
+    struct rumr_server_state st;
+    struct rumr_client_state cs;
+    struct rumr_comm_funcs cf = rumr_tcp_funcs;
+    struct rumr_buffer *buf;
+    uint32_t ids[3], pkt[7] = { 0xA600, 0, 1 | (REG_MMIO << 3), 0, 0, 0, 0 }, *reads, x;
+    pthread_t thread;
+    char addr[32];
+
+    ASSERT_SUCCESS(start_server(&st, asic, &thread, addr));
+    cf.log_msg = quiet_printf;
+    memset(&cs, 0, sizeof cs);
+    ASSERT_SUCCESS(rumr_client_connect(&cs, &cf, addr));
+    ASSERT_EQ(cs.no_outstanding, 0);
+
+    // the middle reply is dropped when it turns up while collecting the last
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, NULL, 0, &ids[0]));
+    x = RUMR_REVISION;
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, &x, 1, &ids[1]));
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, NULL, 0, &ids[2]));
+    rumr_client_discard(&cs, ids[1]);
+    ASSERT_EQ(rumr_client_collect(&cs, ids[1]), NULL);
+    buf = rumr_client_collect(&cs, ids[2]);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(buf->woffset, 4 + st.serialized_asic->woffset);
+    rumr_buffer_free(buf);
+
+    // only the first is left waiting, a discarded reply that arrived is freed at once
+    ASSERT_EQ(cs.no_outstanding, 1);
+    ASSERT_NOT_NULL(cs.pending);
+    rumr_client_discard(&cs, ids[0]);
+    ASSERT_EQ(cs.pending, NULL);
+    ASSERT_EQ(cs.no_outstanding, 0);
+    ASSERT_EQ(rumr_client_collect(&cs, ids[0]), NULL);
+
+    // an ID still waiting for a reply is skipped once the counter wraps round to it
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_REG_ACCESS, pkt, 7, &ids[0]));
+    cs.next_id = ids[0];
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_REG_ACCESS, pkt, 7, &ids[1]));
+    ASSERT_EQ(ids[1] == ids[0], 0);
+    buf = rumr_client_collect(&cs, ids[1]);
+    ASSERT_NOT_NULL(buf);
+    rumr_buffer_free(buf);
+    buf = rumr_client_collect(&cs, ids[0]);
+    ASSERT_NOT_NULL(buf);
+    rumr_buffer_free(buf);
+
+    // the number of unanswered requests is bounded
+    reads = calloc(RUMR_MAX_OUTSTANDING, sizeof *reads);
+    ASSERT_NOT_NULL(reads);
+    for (x = 0; x < RUMR_MAX_OUTSTANDING; x++)
+        ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_REG_ACCESS, pkt, 7, &reads[x]));
+    ASSERT_FAILURE(rumr_client_submit(&cs, RUMR_OP_REG_ACCESS, pkt, 7, &ids[0]));
+    buf = rumr_client_collect(&cs, reads[RUMR_MAX_OUTSTANDING - 1]);
+    ASSERT_NOT_NULL(buf);
+    rumr_buffer_free(buf);
+    for (x = 0; x < RUMR_MAX_OUTSTANDING - 1; x++)
+        rumr_client_discard(&cs, reads[x]);
+    free(reads);
+
+    // and once they are given up the next reply is still the right one
+    x = RUMR_REVISION;
+    ASSERT_SUCCESS(rumr_client_submit(&cs, RUMR_OP_DISCOVER, &x, 1, &ids[0]));
+    buf = rumr_client_collect(&cs, ids[0]);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(buf->woffset, 8 + st.serialized_asic->woffset);
+    rumr_buffer_free(buf);
+    ASSERT_EQ(cs.pending, NULL);
+    ASSERT_EQ(cs.no_outstanding, 0);
+
+    rumr_client_close(&cs);
+    pthread_join(thread, NULL);
+    rumr_server_close(&st);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(rumr_tests)
+TEST(test_rumr_loopback_batch, "navi_reg_batch.envdef", "navi10"),
+TEST(test_rumr_discard, "navi_reg_batch.envdef", "navi10"),
+END_TESTS(rumr_tests);
@@ -1,5 +1,11 @@
 #include "test_framework.h"
 #include "parson.h"
+#include <time.h>
+#include <pthread.h>
+#if HAVE_NANOMSG
+#include <nanomsg/nn.h>
+#include <nanomsg/reqrep.h>
+#endif
 
 extern void parse_sysfs_clock_file(char *content, int *min, int *max);
 extern JSON_Value *compare_fence_infos(const char *before, const char *after);
@@ -8,6 +14,8 @@ extern JSON_Array *parse_gem_info(const char *content, void *pids, unsigned n);
 extern JSON_Array *parse_kms_framebuffer_sysfs_file(struct umr_asic *asic, const char *content);
 extern JSON_Object *parse_kms_state_sysfs_file(const char *content);
 extern JSON_Object *parse_pp_features_sysfs_file(const char *content);
+extern JSON_Value *umr_process_json_request(JSON_Object *request, void **raw_data, unsigned *raw_data_size);
+extern struct umr_asic *asics[16];
 
 static enum TEST_RESULT test_parse_sysfs_clock_file(__attribute__((unused)) struct umr_asic* asic)
 {
@@ -471,6 +479,240 @@ static enum TEST_RESULT test_parse_sysfs_pp_features2(__attribute__((unused)) st
     return TEST_SUCCESS;
 }
 
+// an accumulate request that takes a few samples
+static JSON_Value *accumulate_request(struct umr_asic *asic)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof buf,
+        "{\"command\": \"accumulate\", \"asic\": {\"did\": %u, \"instance\": %d},"
+        " \"block\": \"gfx1010\", \"registers\": [\"mmGRBM_STATUS\"], \"step_ms\": 1, \"period\": 4}",
+        asic->did, asic->instance);
+    return json_parse_string(buf);
+}
+
+static JSON_Value *read_request(struct umr_asic *asic)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof buf,
+        "{\"command\": \"read\", \"asic\": {\"did\": %u, \"instance\": %d},"
+        " \"block\": \"gfx1010\", \"register\": \"mmGRBM_STATUS\"}",
+        asic->did, asic->instance);
+    return json_parse_string(buf);
+}
+
+/* The first accumulate sample parks the request until the test lets it
+ * go and every step is logged, so the tests check the order things
+ * happened in rather than how long they took.
+ */
+extern void (*accumulate_step_hook)(void);
+
+enum { ACC_WAITING, ACC_PARKED, ACC_RELEASED };
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int state;
+    char events[8];
+    int no_events;
+} order = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, ACC_WAITING, { 0 }, 0 };
+
+static void order_reset(void)
+{
+    pthread_mutex_lock(&order.lock);
+    order.state = ACC_WAITING;
+    memset(order.events, 0, sizeof order.events);
+    order.no_events = 0;
+    pthread_mutex_unlock(&order.lock);
+}
+
+// log @event, the caller holds order.lock
+static void order_log(char event)
+{
+    if (order.no_events < (int)sizeof order.events - 1)
+        order.events[order.no_events++] = event;
+    pthread_cond_broadcast(&order.cond);
+}
+
+static void order_event(char event)
+{
+    pthread_mutex_lock(&order.lock);
+    order_log(event);
+    pthread_mutex_unlock(&order.lock);
+}
+
+// wait for @state and @no_events, gives up after a generous timeout so a deadlock fails instead of hanging
+static int order_wait(int state, int no_events)
+{
+    struct timespec ts;
+    int r = 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += 10;
+    pthread_mutex_lock(&order.lock);
+    while ((order.state != state || order.no_events < no_events) && !r)
+        r = pthread_cond_timedwait(&order.cond, &order.lock, &ts);
+    pthread_mutex_unlock(&order.lock);
+    return r ? -1 : 0;
+}
+
+static void order_release(void)
+{
+    pthread_mutex_lock(&order.lock);
+    order.state = ACC_RELEASED;
+    pthread_cond_broadcast(&order.cond);
+    pthread_mutex_unlock(&order.lock);
+}
+
+static void accumulate_step(void)
+{
+    pthread_mutex_lock(&order.lock);
+    if (order.state == ACC_WAITING) {
+        order.state = ACC_PARKED;
+        order_log('S');
+        while (order.state != ACC_RELEASED)
+            pthread_cond_wait(&order.cond, &order.lock);
+    }
+    pthread_mutex_unlock(&order.lock);
+}
+
+struct request_thread {
+    JSON_Value *request, *answer;
+    void *raw_data;
+    unsigned raw_data_size;
+    char event;
+};
+
+static void *run_request(void *arg)
+{
+    struct request_thread *rt = arg;
+
+    rt->answer = umr_process_json_request(json_object(rt->request), &rt->raw_data, &rt->raw_data_size);
+    order_event(rt->event);
+    return NULL;
+}
+
+static enum TEST_RESULT test_request_during_accumulate(struct umr_asic* asic)
+{
+    struct request_thread acc = { .event = 'A' }, rd = { .event = 'R' };
+    pthread_t acc_thread, rd_thread;
+
+    asics[0] = asic;
+    acc.request = accumulate_request(asic);
+    rd.request = read_request(asic);
+    ASSERT_NOT_NULL(acc.request);
+    ASSERT_NOT_NULL(rd.request);
+    order_reset();
+    accumulate_step_hook = accumulate_step;
+
+    // the read is answered while the accumulate is parked between two samples
+    ASSERT_EQ(pthread_create(&acc_thread, NULL, run_request, &acc), 0);
+    ASSERT_SUCCESS(order_wait(ACC_PARKED, 1));
+    ASSERT_EQ(pthread_create(&rd_thread, NULL, run_request, &rd), 0);
+    ASSERT_SUCCESS(order_wait(ACC_PARKED, 2));
+    order_release();
+    pthread_join(rd_thread, NULL);
+    pthread_join(acc_thread, NULL);
+    accumulate_step_hook = NULL;
+    asics[0] = NULL;
+
+    ASSERT_STR_EQ(order.events, "SRA");
+    ASSERT_NOT_NULL(json_object_get_value(json_object(rd.answer), "answer"));
+    ASSERT_NOT_NULL(json_object_get_value(json_object(acc.answer), "answer"));
+    json_value_free(rd.answer);
+    json_value_free(acc.answer);
+    free(rd.raw_data);
+    free(acc.raw_data);
+    return TEST_SUCCESS;
+}
+
+#if HAVE_NANOMSG
+extern void run_server_loop(const char *url, struct umr_asic * asic);
+
+struct server_thread {
+    char url[64];
+    struct umr_asic *asic;
+};
+
+static void *server_thread(void *arg)
+{
+    struct server_thread *st = arg;
+
+    run_server_loop(st->url, st->asic);
+    return NULL;
+}
+
+static int send_request(const char *url, JSON_Value *request)
+{
+    char *s = json_serialize_to_string(request);
+    int sock = nn_socket(AF_SP, NN_REQ), timeout = 10000;
+
+    json_value_free(request);
+    if (sock < 0 || nn_connect(sock, url) < 0 ||
+        nn_setsockopt(sock, NN_SOL_SOCKET, NN_RCVTIMEO, &timeout, sizeof timeout) < 0 ||
+        nn_send(sock, s, strlen(s) + 1, 0) < 0) {
+        json_free_serialized_string(s);
+        return -1;
+    }
+    json_free_serialized_string(s);
+    return sock;
+}
+
+// wait for the reply on sock and check it answers the request
+static int recv_reply(int sock)
+{
+    JSON_Value *reply;
+    char *msg;
+    int len, r;
+
+    len = nn_recv(sock, &msg, NN_MSG, 0);
+    nn_close(sock);
+    if (len < (int)sizeof(uint32_t))
+        return -1;
+    reply = json_parse_string(&msg[sizeof(uint32_t)]);
+    nn_freemsg(msg);
+    r = json_object_get_value(json_object(reply), "answer") ? 0 : -1;
+    json_value_free(reply);
+    return r;
+}
+
+static enum TEST_RESULT test_server_request_during_accumulate(struct umr_asic* asic)
+{
+    struct server_thread st;
+    pthread_t thread;
+    int acc, rd;
+
+    snprintf(st.url, sizeof st.url, "ipc:///tmp/umrtest-server-%d.ipc", (int)getpid());
+    st.asic = asic;
+    order_reset();
+    accumulate_step_hook = accumulate_step;
+    ASSERT_EQ(pthread_create(&thread, NULL, server_thread, &st), 0);
+
+    // a cheap request sent while an accumulate runs does not wait for it,
+    // the REQ sockets retry until the server has bound the address
+    acc = send_request(st.url, accumulate_request(asic));
+    ASSERT_SUCCESS(acc);
+    ASSERT_SUCCESS(order_wait(ACC_PARKED, 1));
+    rd = send_request(st.url, read_request(asic));
+    ASSERT_SUCCESS(rd);
+    ASSERT_SUCCESS(recv_reply(rd));
+    order_event('R');
+    order_release();
+    ASSERT_SUCCESS(recv_reply(acc));
+    order_event('A');
+    ASSERT_STR_EQ(order.events, "SRA");
+
+    // the server loop returns once the library is shut down
+    nn_term();
+    pthread_join(thread, NULL);
+    accumulate_step_hook = NULL;
+    asics[0] = NULL;
+    unlink(&st.url[strlen("ipc://")]);
+    return TEST_SUCCESS;
+}
+#endif
+
 DEFINE_TESTS(server_tests)
 TEST(test_parse_sysfs_clock_file, "navi_reg_only.envdef", "navi10"),
 TEST(test_parse_fence_info, "navi_reg_only.envdef", "navi10"),
@@ -480,4 +722,8 @@ TEST(test_parse_sysfs_framebuffer, "navi_reg_only.envdef", "navi10"),
 TEST(test_parse_sysfs_state, "navi_reg_only.envdef", "navi10"),
 TEST(test_parse_sysfs_pp_features, "navi_reg_only.envdef", "navi10"),
 TEST(test_parse_sysfs_pp_features2, "navi_reg_only.envdef", "navi10"),
+TEST(test_request_during_accumulate, "navi_reg_only.envdef", "navi10"),
+#if HAVE_NANOMSG
+TEST(test_server_request_during_accumulate, "navi_reg_only.envdef", "navi10"),
+#endif
 END_TESTS(server_tests);
@@ -1,4 +1,5 @@
 #include "test_framework.h"
+#include <stdarg.h>
 
 // testing direct VM construction
 enum TEST_RESULT test_can_read_from_vm_memory_direct0(struct umr_asic* asic)
@@ -162,6 +163,87 @@ enum TEST_RESULT test_can_read_from_vm_memory_direct18(struct umr_asic* asic)
     return TEST_SUCCESS;
 }
 
+// capture the VM decoding trace so cached and uncached walks can be compared
+static char vm_trace[65536];
+static size_t vm_trace_len;
+
+static int vm_trace_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(vm_trace + vm_trace_len, sizeof(vm_trace) - vm_trace_len, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        vm_trace_len += ((size_t)n < sizeof(vm_trace) - vm_trace_len) ? (size_t)n : sizeof(vm_trace) - vm_trace_len - 1;
+    return n;
+}
+
+static int vm_traced_read(struct umr_asic* asic, uint32_t vmid, uint64_t addr, uint64_t *data, struct umr_vm_pagewalk *vmdata, char *trace)
+{
+    int r;
+
+    vm_trace_len = 0;
+    vm_trace[0] = 0;
+    memset(vmdata, 0, sizeof *vmdata);
+    r = umr_access_vram(asic, -1, vmid, addr, sizeof(*data), data, 0, vmdata);
+    strcpy(trace, vm_trace);
+    return r;
+}
+
+// the same walk done uncached, cached (cold) and cached (warm) must produce the same data and trace
+static enum TEST_RESULT test_vm_cache_matches_uncached(struct umr_asic* asic, uint32_t vmid, uint64_t addr)
+{
+    static char trace[3][sizeof(vm_trace)];
+    struct umr_vm_pagewalk vmdata[3];
+    uint64_t data[3] = { 0 };
+    int x;
+
+    asic->mem_funcs.vm_message = vm_trace_printf;
+    asic->options.verbose = 1;
+
+    asic->options.no_vm_cache = 1;
+    ASSERT_SUCCESS(vm_traced_read(asic, vmid, addr, &data[0], &vmdata[0], trace[0]));
+    asic->options.no_vm_cache = 0;
+    umr_vm_cache_invalidate(asic);
+    umr_test_harness_rewind(asic);
+    ASSERT_SUCCESS(vm_traced_read(asic, vmid, addr, &data[1], &vmdata[1], trace[1]));
+    // no rewind: a warm walk must not touch the (now exhausted) registers
+    ASSERT_SUCCESS(vm_traced_read(asic, vmid, addr, &data[2], &vmdata[2], trace[2]));
+
+    asic->options.verbose = 0;
+    asic->mem_funcs.vm_message = printf;
+
+    ASSERT_EQ(data[0], 0x0706050403020100);
+    for (x = 1; x < 3; x++) {
+        ASSERT_EQ(data[x], data[0]);
+        ASSERT_EQ(memcmp(&vmdata[x], &vmdata[0], sizeof vmdata[0]), 0);
+        ASSERT_STR_EQ(trace[x], trace[0]);
+    }
+    return TEST_SUCCESS;
+}
+
+enum TEST_RESULT test_vm_cache_matches_uncached2(struct umr_asic* asic)
+{
+    return test_vm_cache_matches_uncached(asic, UMR_GFX_HUB|0, 0x446000ULL);
+}
+
+enum TEST_RESULT test_vm_cache_matches_uncached9(struct umr_asic* asic)
+{
+    return test_vm_cache_matches_uncached(asic, UMR_GFX_HUB|8, 0x7ffff6768000ULL);
+}
+
+enum TEST_RESULT test_vm_cache_matches_uncached17(struct umr_asic* asic)
+{
+    return test_vm_cache_matches_uncached(asic, UMR_GFX_HUB|5, 0x2e0a2000);
+}
+
+enum TEST_RESULT test_vm_cache_matches_uncached18(struct umr_asic* asic)
+{
+    return test_vm_cache_matches_uncached(asic, UMR_GFX_HUB|3, 0x7f8047e00000);
+}
+
 DEFINE_TESTS(vm_tests)
 #if 0
 TEST(test_can_read_from_vm_memory_direct1, "direct_vm_test1.envdef", "raven1"),
@@ -185,5 +267,9 @@ TEST(test_can_read_from_vm_memory_direct15, "direct_vm_test15.envdef", "navi10")
 TEST(test_can_read_from_vm_memory_direct16, "direct_vm_test16.envdef", "navi10"),
 TEST(test_can_read_from_vm_memory_direct17, "direct_vm_test17.envdef", "gfx11_vm_test"),
 TEST(test_can_read_from_vm_memory_direct18, "direct_vm_test18.envdef", "aldebaran"),
+TEST(test_vm_cache_matches_uncached2, "direct_vm_test2.envdef", "navi10"),
+TEST(test_vm_cache_matches_uncached9, "direct_vm_test9.envdef", "vega10"),
+TEST(test_vm_cache_matches_uncached17, "direct_vm_test17.envdef", "gfx11_vm_test"),
+TEST(test_vm_cache_matches_uncached18, "direct_vm_test18.envdef", "aldebaran"),
 #endif
 END_TESTS(vm_tests);
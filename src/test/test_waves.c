@@ -0,0 +1,204 @@
+#include "test_framework.h"
+
+static struct umr_wave_data* scan_waves(struct umr_asic* asic, int threads)
+{
+    umr_test_harness_rewind(asic);
+    asic->options.wave_threads = threads;
+    return umr_scan_wave_data(asic);
+}
+
+// a threaded scan has to find the same waves in the same order as a serial one
+enum TEST_RESULT test_scan_waves_threaded_navi(struct umr_asic* asic)
+{
+    struct umr_wave_data *serial, *threaded, *a, *b;
+    int n = 0, threads;
+    uint32_t x;
+
+    asic->config.gfx.max_shader_engines = 2;
+    asic->config.gfx.max_sh_per_se = 1;
+    asic->config.gfx.max_cu_per_sh = 4;
+    asic->options.skip_gprs = 1;
+    asic->options.vm_partition = -1;
+
+    serial = scan_waves(asic, 0);
+    ASSERT_NOT_NULL(serial);
+
+    // one contiguous array without GPR buffers
+    ASSERT_EQ(umr_wave_data_count(serial), 20);
+    for (x = 0, a = serial; a; a = a->next, x++) {
+        ASSERT_EQ(a, &serial[x]);
+        ASSERT_EQ(a->vgprs, NULL);
+        ASSERT_EQ(umr_wave_data_sgpr(a, 0), 0);
+    }
+    ASSERT_EQ(umr_wave_data_footprint(serial), 20 * sizeof *serial);
+
+    for (threads = 2; threads <= 8; threads *= 2) {
+        threaded = scan_waves(asic, threads);
+        ASSERT_NOT_NULL(threaded);
+        // built once up front and shared by the worker copies
+        ASSERT_NOT_NULL(asic->bit_index);
+        ASSERT_NOT_NULL(asic->wave_fields);
+        for (n = 0, a = serial, b = threaded; a && b; a = a->next, b = b->next, ++n) {
+            ASSERT_EQ(a->se, b->se);
+            ASSERT_EQ(a->sh, b->sh);
+            ASSERT_EQ(a->cu, b->cu);
+            ASSERT_EQ(a->simd, b->simd);
+            ASSERT_EQ(a->wave, b->wave);
+            ASSERT_EQ(memcmp(a->ws.reg_values, b->ws.reg_values, sizeof a->ws.reg_values), 0);
+        }
+        ASSERT_EQ(a, b);
+        umr_free_wave_data(threaded);
+    }
+    umr_free_wave_data(serial);
+
+    // 5 valid waves in each of the 4 busy SIMDs
+    ASSERT_EQ(n, 20);
+    return TEST_SUCCESS;
+}
+
+// batched and per thread VGPR reads must return the same contents
+enum TEST_RESULT test_scan_waves_vgprs_batch_navi(struct umr_asic* asic)
+{
+    struct umr_wave_data *batched, *single, *a, *b;
+    uint32_t thread, x;
+    int n;
+
+    asic->config.gfx.max_shader_engines = 1;
+    asic->config.gfx.max_sh_per_se = 1;
+    asic->config.gfx.max_cu_per_sh = 2;
+    asic->options.vm_partition = -1;
+    asic->parameters.vgpr_granularity = 2; // VGPR_SIZE 0 is 4 VGPRs
+
+    ASSERT_NOT_NULL(asic->gpr_read_funcs.read_vgprs_batch);
+    batched = scan_waves(asic, 0);
+    ASSERT_NOT_NULL(batched);
+
+    asic->gpr_read_funcs.read_vgprs_batch = NULL;
+    single = scan_waves(asic, 0);
+    ASSERT_NOT_NULL(single);
+
+    for (n = 0, a = batched, b = single; a && b; a = a->next, b = b->next, ++n) {
+        ASSERT_EQ(a->have_vgprs, 1);
+        ASSERT_EQ(b->have_vgprs, 1);
+        ASSERT_EQ(a->num_threads, 32);
+        ASSERT_EQ(a->vgpr_stride, 4);
+        ASSERT_EQ(memcmp(a->vgprs, b->vgprs, a->num_threads * a->vgpr_stride * sizeof a->vgprs[0]), 0);
+        for (thread = 0; thread < a->num_threads; thread++)
+            for (x = 0; x < 4; x++)
+                ASSERT_EQ(umr_wave_data_vgpr(a, thread, x), ((uint32_t)n << 24) | (thread << 8) | x);
+    }
+    ASSERT_EQ(a, b);
+
+    // the GPR buffers only cover what the waves allocated
+    ASSERT_EQ(umr_wave_data_footprint(batched),
+              2 * (sizeof *batched + 124 * sizeof(uint32_t) + 32 * 4 * sizeof(uint32_t)));
+    umr_free_wave_data(batched);
+    umr_free_wave_data(single);
+
+    // two valid waves on SIMD 0
+    ASSERT_EQ(n, 2);
+    return TEST_SUCCESS;
+}
+
+// every bitfield read by ID must decode the same as the lookup by name
+static enum TEST_RESULT check_wave_fields(struct umr_asic* asic, struct umr_wave_data* wd)
+{
+    struct umr_bitfield *bit;
+    struct umr_reg *reg;
+    char name[64];
+    int id, field, x, present;
+
+    for (present = 0; wd->reg_names[present]; present++) {
+        id = umr_wave_reg_lookup(wd->reg_names[present]);
+        ASSERT_EQ(id >= 0, 1);
+        ASSERT_EQ(strcmp(umr_wave_reg_name(id), wd->reg_names[present]), 0);
+        ASSERT_EQ(umr_wave_data_get_reg(asic, wd, id),
+                  umr_wave_data_get_value(asic, wd, wd->reg_names[present]));
+
+        // the layouts of other generations name registers navi10 does not have
+        snprintf(name, sizeof name, "@%s", wd->reg_names[present]);
+        reg = umr_find_reg_data_by_ip_by_instance(asic, "gfx", asic->options.vm_partition, name);
+        if (!reg)
+            continue;
+        for (x = 0; x < reg->no_bits; x++)
+            ASSERT_EQ(umr_wave_data_get_reg_bits(asic, wd, id, reg->bits[x].regname),
+                      umr_wave_data_get_bits(asic, wd, wd->reg_names[present], reg->bits[x].regname));
+    }
+    for (id = x = 0; id < UMR_WAVE_REG_MAX; id++)
+        x += wd->reg_slots[id] >= 0;
+    ASSERT_EQ(x, present);
+
+    for (field = 0; field < UMR_WAVE_FIELD_MAX; field++) {
+        id = umr_wave_field_reg(field);
+        ASSERT_EQ(id < UMR_WAVE_REG_MAX, 1);
+        if (wd->reg_slots[id] < 0)
+            continue;
+        snprintf(name, sizeof name, "@%s", umr_wave_reg_name(id));
+        reg = umr_find_reg_data_by_ip_by_instance(asic, "gfx", asic->options.vm_partition, name);
+        bit = reg ? umr_find_bitfield(asic, reg, umr_wave_field_name(field)) : NULL;
+        if (!bit)
+            continue;
+        ASSERT_EQ(umr_wave_data_get_field(asic, wd, field),
+                  umr_wave_data_get_bits(asic, wd, umr_wave_reg_name(id), umr_wave_field_name(field)));
+    }
+    return TEST_SUCCESS;
+}
+
+// the ID based accessors must agree with the name based ones on every generation
+enum TEST_RESULT test_wave_reg_ids_all_gens_navi(struct umr_asic* asic)
+{
+    struct umr_wave_data *waves, *a, wd;
+    struct umr_ip_block *gfx;
+    enum TEST_RESULT r = TEST_SUCCESS;
+    int maj, orig_maj, x;
+
+    asic->config.gfx.max_shader_engines = 2;
+    asic->config.gfx.max_sh_per_se = 1;
+    asic->config.gfx.max_cu_per_sh = 4;
+    asic->options.skip_gprs = 1;
+    asic->options.vm_partition = -1;
+
+    waves = scan_waves(asic, 0);
+    ASSERT_NOT_NULL(waves);
+    ASSERT_NOT_NULL(asic->wave_fields);
+
+    gfx = umr_find_ip_block(asic, "gfx", 0);
+    if (!gfx)
+        gfx = umr_find_ip_block(asic, "gfx", -1);
+    if (!gfx) {
+        umr_free_wave_data(waves);
+        ASSERT_NOT_NULL(gfx);
+    }
+    orig_maj = gfx->discoverable.maj;
+
+    // the real navi10 waves
+    for (a = waves; a && r == TEST_SUCCESS; a = a->next)
+        r = check_wave_fields(asic, a);
+
+    // the captured status words laid out as each generation's wave data
+    for (maj = 8; maj <= 12 && r == TEST_SUCCESS; maj++) {
+        gfx->discoverable.maj = maj;
+        for (a = waves; a && r == TEST_SUCCESS; a = a->next) {
+            if (umr_wave_data_init(asic, &wd) < 0) {
+                r = TEST_FATAL_FAIL;
+                break;
+            }
+            for (x = 0; x < 64; x++)
+                wd.ws.reg_values[x] = a->ws.reg_values[x] ^ ((uint32_t)maj << 24 | x);
+            r = check_wave_fields(asic, &wd);
+        }
+    }
+    gfx->discoverable.maj = orig_maj;
+    umr_free_wave_data(waves);
+    ASSERT_EQ(r, TEST_SUCCESS);
+
+    ASSERT_EQ(umr_wave_reg_lookup("ixSQ_WAVE_NOT_A_REG"), -1);
+    ASSERT_EQ(umr_wave_field_name(UMR_WAVE_FIELD_MAX), NULL);
+    return TEST_SUCCESS;
+}
+
+DEFINE_TESTS(wave_tests)
+TEST(test_scan_waves_threaded_navi, "navi_waves.envdef", "navi10"),
+TEST(test_scan_waves_vgprs_batch_navi, "navi_vgprs.envdef", "navi10"),
+TEST(test_wave_reg_ids_all_gens_navi, "navi_waves.envdef", "navi10"),
+END_TESTS(wave_tests);
@@ -168,10 +168,15 @@ struct umr_find_reg_iter {
 	int ip_i, reg_i;
 };
 
+struct umr_database_image;
+struct umr_ip_block_cache_entry;
+
 struct umr_ip_block {
 	char *ipname;
 	int no_regs;
 	struct umr_reg *regs;
+	struct umr_database_image *image; // non-NULL if regs/names live in a mapped database image
+	struct umr_ip_block_cache_entry *shared; // non-NULL if regs are shared through the IP block cache (read only)
 	struct {
           int die, maj, min, rev, instance, logical_inst;
     } discoverable;
@@ -239,6 +244,30 @@ struct umr_fw_config {
 
 #define NUM_HBM_INSTANCES 4
 
+union umr_bank_select {
+	struct {
+		uint32_t
+			instance,
+			se,
+			sh;
+	} grbm;
+	struct {
+		uint32_t
+			me,
+			queue,
+			pipe,
+			vmid;
+	} srbm;
+};
+
+// the banking state (from umr_options) a register access is issued under
+struct umr_bank_state {
+	int use_bank,  // 0 == none, 1 == GRBM, 2 == SRBM
+	    pg_lock,
+	    vm_partition;
+	union umr_bank_select bank;
+};
+
 // struct for sysram and vram blocks
 struct umr_test_harness_ram_blocks {
 	uint64_t base_address; // base address in bytes
@@ -272,6 +301,11 @@ struct umr_test_harness {
 
 	uint64_t vram_mm_index; // when these are written they are shadowed here
 	uint32_t sq_ind_index;
+
+	// simulated register traffic (modelled on the regs2 debugfs interface)
+	struct umr_bank_state last_bank;
+	int last_bank_valid;
+	uint32_t reg_reads, bank_switches;
 };
 
 struct umr_options {
@@ -301,6 +335,7 @@ struct umr_options {
 	    full_shader,
 	    context_reg_bank,
 	    no_fold_vm_decode,
+	    no_vm_cache,
 	    pg_lock,
 	    test_log,
 	    vm_partition,
@@ -309,7 +344,8 @@ struct umr_options {
 	    export_model,
 	    vgpr_granularity,
 	    use_v1_regs_debugfs,
-	    trap_unsorted_db;
+	    trap_unsorted_db,
+	    wave_threads;
 
 	// hs/gs shaders can be opaque depending on circumstances on gfx9+ platforms
 	struct {
@@ -324,21 +360,7 @@ struct umr_options {
 			enable_comp_shader;
 	} shader_enable;
 
-	union {
-		struct {
-			uint32_t
-				instance,
-				se,
-				sh;
-		} grbm;
-		struct {
-			uint32_t
-				me,
-				queue,
-				pipe,
-				vmid;
-		} srbm;
-	} bank;
+	union umr_bank_select bank;
 
 	long forcedid;
 	char
@@ -445,6 +467,7 @@ struct umr_memory_access_funcs {
 	void *data;
 };
 
+struct umr_reg_batch;
 struct umr_register_access_funcs {
 	/** read_reg -- Read a register
 	 * @asic: The device the register is from
@@ -461,10 +484,28 @@ struct umr_register_access_funcs {
 	 */
 	int (*write_reg)(struct umr_asic *asic, uint64_t addr, uint32_t value, enum regclass type);
 
+	/** read_reg_batch -- Read a list of registers (optional)
+	 * @asic: The device the registers are from
+	 * @regs: The registers to read along with the banking for each
+	 * @n: The number of entries in @regs
+	 *
+	 * For backends where each access has a round trip (e.g. RUMR) so the
+	 * reads of umr_read_reg_batch() can be issued together.
+	 */
+	int (*read_reg_batch)(struct umr_asic *asic, struct umr_reg_batch *regs, uint32_t n);
+
 	/** data -- opaque pointer the callbacks can use for state tracking */
 	void *data;
 };
 
+// one register read of a umr_read_reg_batch() call
+struct umr_reg_batch {
+	uint64_t addr;                 // byte address
+	enum regclass type;
+	struct umr_bank_state bank;    // banking to apply for this read
+	uint32_t value;                // filled in by umr_read_reg_batch()
+};
+
 struct umr_wave_status;
 struct umr_wave_access_funcs {
 	/** get_wave_status -- Populate the umr_wave_status structure
@@ -481,6 +522,16 @@ struct umr_wave_access_funcs {
 	 */
 	int (*get_wave_sq_info)(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, struct umr_wave_status *ws);
 
+	/** thread_context -- Set up (or tear down) a copy of the device for a wave scanning thread
+	 * @asic: The device the copy was made from
+	 * @copy: A copy of @asic that will only be used by one thread
+	 * @setup: 1 to set up @copy, 0 to release it
+	 *
+	 * Optional.  If set get_wave_status() and the GPR read callbacks may be
+	 * called concurrently on different copies.  Returns 0 on success.
+	 */
+	int (*thread_context)(struct umr_asic *asic, struct umr_asic *copy, int setup);
+
 	/** data -- opaque pointer the callbacks can use for state tracking */
 	void *data;
 };
@@ -515,10 +566,27 @@ struct umr_wave_status {
 };
 
 // This captures *all* active/halted waves
+//
+// umr_scan_wave_data() returns the waves as one contiguous array, the
+// ->next pointers link each element to the following one.  The GPR
+// buffers are sized from the wave's GPR_ALLOC and are NULL if the GPRs
+// were not read, use umr_wave_data_sgpr()/umr_wave_data_vgpr() to read
+// them and umr_free_wave_data() to release the lot.
+//
+// UMR_WAVE_DATA_API is bumped whenever this changes in a way callers
+// have to follow:
+//   1 - list of separately allocated nodes with the GPRs embedded,
+//       freed node by node
+//   2 - the array described above, freeing single nodes is an error
+#define UMR_WAVE_DATA_API 2
+
 struct umr_wave_data {
-	uint32_t vgprs[64 * 256], sgprs[1024], num_threads;
+	uint32_t *vgprs,        // VGPR n of thread t is vgprs[t * vgpr_stride + n]
+		 *sgprs,
+		 num_threads, vgpr_stride, no_sgprs;
 	int se, sh, cu, simd, wave, have_vgprs;
 	const char **reg_names;
+	const int8_t *reg_slots;        // enum umr_wave_reg -> index in ws.reg_values (or -1)
 	struct umr_wave_status ws;
 	struct umr_wave_thread *threads;
 	struct umr_wave_data *next;
@@ -532,12 +600,19 @@ struct umr_read_gpr_funcs {
 
 	/** read_sgprs -- Read VGPR data for a given wave */
 	int (*read_sgprs)(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst);
+
+	/** read_vgprs_batch -- Read VGPR data for the threads in thread_mask of a
+	 * given wave, thread N goes to dst[stride * N] (optional) */
+	int (*read_vgprs_batch)(struct umr_asic *asic, struct umr_wave_data *wd, uint64_t thread_mask, uint32_t stride, uint32_t *dst);
 };
 
 struct umr_read_ring_func {
 	void *data;
 
 	void *(*read_ring_data)(struct umr_asic *asic, char *ringname, uint32_t *ringsize);
+
+	/** read_ring_ptrs -- Read only the rptr, wptr and driver wptr of a ring (optional) */
+	int (*read_ring_ptrs)(struct umr_asic *asic, char *ringname, uint32_t *ptrs, uint32_t *ringsize);
 };
 
 // contains info about a node in an XGMI hive
@@ -554,6 +629,20 @@ struct umr_mmio_accel_data {
 	struct umr_reg *reg;
 };
 
+struct umr_vm_cache;
+struct umr_disasm_context;
+struct umr_ring_poll;
+struct umr_reg_name_table;
+struct umr_bit_index;
+struct umr_shader_cache;
+struct umr_wave_fields;
+
+struct umr_reg_index_entry {
+	uint32_t hash;
+	int block;
+	struct umr_reg *reg;
+};
+
 struct umr_asic {
 	char *asicname;
 	int no_blocks;
@@ -601,6 +690,11 @@ struct umr_asic {
 		    iomem,
 		    gfxoff;
 	} fd;
+	// last banking state sent to fd.mmio2 so redundant IOCTLs can be skipped
+	struct {
+		int valid;
+		struct umr_bank_state state;
+	} mmio2_bank;
 	struct {
 		uint64_t sq_ind_index;
 	} test_harness;
@@ -619,6 +713,15 @@ struct umr_asic {
 	struct umr_mmio_accel_data *mmio_accel;
 	struct umr_read_ring_func ring_func;
 	uint32_t mmio_accel_size;
+	struct umr_reg_index_entry *reg_index;
+	uint32_t reg_index_size;
+	struct umr_reg_name_table *reg_names; // created on first use (see umr_reg_name())
+	struct umr_bit_index *bit_index; // created on first use (see umr_find_bitfield())
+	struct umr_wave_fields *wave_fields; // created on first use (see umr_wave_fields_resolve())
+	struct umr_vm_cache *vm_cache;
+	struct umr_shader_cache *shader_cache; // shaders sized by umr_compute_shader_size()
+	struct umr_disasm_context *disasm; // created on first use (see umr_shader_disasm())
+	struct umr_ring_poll *ring_poll; // ring file kept open by umr_read_ring_ptrs()
 	int (*err_msg)(const char *fmt, ...);
 	int (*std_msg)(const char *fmt, ...);
 };
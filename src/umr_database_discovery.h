@@ -41,6 +41,23 @@ struct umr_database_scan_item {
 	char path[256], fname[128], ipname[128];
 	int maj, min, rev;
 	struct umr_database_scan_item *next;
+
+	// items with the same ipname in list order, found through the
+	// hash table on the head of a list made by umr_database_scan()
+	struct umr_database_scan_item *next_ip, **ip_hash;
+	uint32_t ip_hash_size;
+};
+
+// an assembled ASIC model (see model_cache.c)
+struct umr_database_model_block {
+	char ipname[128], fname[512];
+	struct umr_discovery_table_entry det;
+};
+
+struct umr_database_model {
+	uint64_t key;
+	int no_blocks;
+	struct umr_database_model_block *blocks;
 };
 
 #define UMR_SOC15_MAX_INST 256
@@ -70,12 +87,35 @@ struct umr_database_scan_item *umr_database_find_ip(
 	struct umr_database_scan_item *db,
 	char *ipname, int maj, int min, int rev,
 	char *desired_path);
+struct umr_database_scan_item *umr_database_scan_find_ipname(struct umr_database_scan_item *head, const char *ipname);
 void umr_database_free_scan_items(struct umr_database_scan_item *it);
 
 struct umr_soc15_database *umr_database_read_soc15(char *path, char *filename, umr_err_output errout);
 struct umr_ip_block *umr_database_read_ipblock(struct umr_soc15_database *soc15, char *path, char *filename, char *cmnname, char *soc15name, int inst, umr_err_output errout);
 struct umr_asic *umr_database_read_asic(struct umr_options *options, char *filename, umr_err_output errout);
 void umr_database_free_soc15(struct umr_soc15_database *soc15);
+void umr_database_fill_ipver_from_path(char *ip_path, struct umr_ip_block *ip_block);
+
+// precompiled database image (see comp/dbcompiler.c)
+struct umr_ip_block *umr_database_image_read_ipblock(char *path, char *filename, char *cmnname, const uint64_t *segs, int no_segs);
+struct umr_soc15_database *umr_database_image_read_soc15(char *path, char *filename);
+struct umr_asic *umr_database_image_read_asic(struct umr_options *options, char *filename, umr_err_output errout);
+void umr_database_image_put(struct umr_database_image *img);
+
+// register tables shared between ASIC models (see ip_cache.c)
+struct umr_ip_block *umr_database_ip_cache_get(char *path, char *filename, const uint64_t *segs, int no_segs);
+struct umr_ip_block *umr_database_ip_cache_add(char *path, char *filename, const uint64_t *segs, int no_segs, struct umr_ip_block *ip);
+void umr_database_ip_cache_put(struct umr_ip_block_cache_entry *ent);
+
+// PCI device ID to ASIC name table (see pci_did.c)
+int umr_database_did_lookup(char *path, uint32_t did, char *name, int size);
+
+// assembled ASIC models cached across runs (see model_cache.c)
+int umr_database_cache_filename(char *fname, size_t size, const char *dir, const char *subdir, const char *name, int create);
+uint64_t umr_database_model_key(const char *asicname, struct umr_options *options, struct umr_discovery_table_entry *det);
+struct umr_database_model *umr_database_model_load(uint64_t key);
+int umr_database_model_save(struct umr_options *options, struct umr_database_model *model);
+void umr_database_model_free(struct umr_database_model *model);
 
 int umr_discovery_table_is_supported(struct umr_asic *asic);
 int umr_discovery_read_table(struct umr_asic *asic, uint8_t *table, uint32_t *size);
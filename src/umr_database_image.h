@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2025 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Authors: Tom St Denis <tom.stdenis@amd.com>
+ *
+ */
+#ifndef UMR_DATABASE_IMAGE_H_
+#define UMR_DATABASE_IMAGE_H_
+
+#include <stdint.h>
+
+/* ==== Precompiled database image ====
+ *
+ * The image holds the parsed contents of the .reg, .asic and .soc15
+ * files of a database tree.  Every reference inside the image is a byte
+ * offset from the start of the image so it can be mapped at any address
+ * and used in place.  Strings are NUL terminated and are referenced by
+ * their offset from hdr->strings_off.
+ *
+ * The image is produced by comp/dbcompiler and is only used if it was
+ * built for the same UMR_DB_IMAGE_VERSION and the same byte order.
+ */
+
+#define UMR_DB_IMAGE_NAME     "umrdb.bin"
+#define UMR_DB_IMAGE_MAGIC    "UMRDBIMG"
+#define UMR_DB_IMAGE_VERSION  1
+#define UMR_DB_IMAGE_ENDIAN   0x01020304UL
+
+enum umr_db_image_type {
+	UMR_DB_IMAGE_REG = 0,
+	UMR_DB_IMAGE_ASIC,
+	UMR_DB_IMAGE_SOC15,
+};
+
+struct umr_db_image_header {
+	char magic[8];
+	uint32_t version, endian;
+	uint32_t no_files, pad;
+	uint64_t files_off,            // array of umr_db_image_file sorted by basename
+		 strings_off,
+		 strings_size,
+		 image_size;
+};
+
+// one entry per source text file
+struct umr_db_image_file {
+	uint32_t basename,             // e.g. "gc_10_1_0.reg"
+		 relpath,              // path relative to the database root, e.g. "ip/gc_10_1_0.reg"
+		 type,
+		 pad;
+	uint64_t src_size,             // size and mtime of the text file this was compiled from
+		 src_mtime,
+		 off;                  // offset of the payload (depends on type)
+};
+
+// UMR_DB_IMAGE_REG payload
+struct umr_db_image_regfile {
+	uint32_t no_regs, no_bits;
+	uint64_t regs_off, bits_off;
+};
+
+struct umr_db_image_reg {
+	uint32_t name, type;
+	uint64_t addr;
+	uint32_t no_bits,
+		 first_bit,            // index of the first bitfield in the bits array
+		 bit64,
+		 idx;                  // SOC15 segment index
+};
+
+struct umr_db_image_bit {
+	uint32_t name;
+	uint8_t start, stop;
+	uint16_t pad;
+};
+
+// UMR_DB_IMAGE_ASIC payload
+struct umr_db_image_asic {
+	uint32_t name, soc15name;
+	int32_t family, no_blocks, vgpr_granularity, is_apu;
+	uint64_t blocks_off;
+};
+
+struct umr_db_image_asic_block {
+	uint32_t ipname, socname, regfile;
+	int32_t instance;
+};
+
+// UMR_DB_IMAGE_SOC15 payload
+struct umr_db_image_soc15 {
+	uint32_t no_ips, pad;
+	uint64_t ips_off;
+};
+
+struct umr_db_image_soc15_ip {
+	uint32_t name, no_inst, no_seg, pad;
+	uint64_t off;                  // uint64_t[no_inst][no_seg] segment offsets
+};
+
+#endif
@@ -37,6 +37,7 @@ struct umr_asic *umr_discover_asic_by_did(struct umr_options *options, long did,
 struct umr_asic *umr_discover_asic_by_name(struct umr_options *options, char *name, umr_err_output errout);
 struct umr_asic *umr_discover_asic_by_discovery_table(char *asicname, struct umr_options *options, umr_err_output errout);
 void umr_free_asic_blocks(struct umr_asic *asic);
+void umr_free_ip_block_regs(struct umr_ip_block *ip);
 void umr_free_asic(struct umr_asic *asic);
 void umr_free_maps(struct umr_asic *asic);
 void umr_close_asic(struct umr_asic *asic); // call this to close a fully open asic
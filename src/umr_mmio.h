@@ -31,6 +31,20 @@
 // init the mmio lookup table
 int umr_create_mmio_accel(struct umr_asic *asic);
 
+// init the register name lookup table
+int umr_create_reg_index(struct umr_asic *asic);
+uint32_t umr_reg_index_hash(const char *regname);
+
+// preformatted names of the registers PM4 packets write to (created on first use)
+int umr_create_reg_name_table(struct umr_asic *asic);
+void umr_free_reg_name_table(struct umr_asic *asic);
+int umr_reg_name_table_lookup(struct umr_asic *asic, uint64_t addr, const char **name);
+
+// find a bitfield of a register by name (indexed on first use)
+struct umr_bitfield *umr_find_bitfield(struct umr_asic *asic, struct umr_reg *reg, const char *bitname);
+int umr_create_bit_index(struct umr_asic *asic);
+void umr_free_bit_index(struct umr_asic *asic);
+
 // find ip block with optional instance
 struct umr_ip_block *umr_find_ip_block(const struct umr_asic *asic, const char *ipname, int instance);
 
@@ -52,10 +66,51 @@ struct umr_reg *umr_find_reg_data_by_ip_quiet(struct umr_asic *asic, const char
 struct umr_reg *umr_find_reg_by_name(struct umr_asic *asic, const char *regname, struct umr_ip_block **ip);
 struct umr_reg *umr_find_reg_by_addr(struct umr_asic *asic, uint64_t addr, struct umr_ip_block **ip);
 
+// find the registers a value was read from by address or ipname.regname
+typedef void (*umr_reg_lookup_cb)(struct umr_asic *asic, struct umr_ip_block *ip, struct umr_reg *reg, uint32_t value, void *data);
+int umr_lookup_reg_value(struct umr_asic *asic, const char *address, uint32_t value, umr_reg_lookup_cb cb, void *data);
+int umr_lookup_reg_batch(struct umr_asic *asic, FILE *f, umr_reg_lookup_cb cb, void *data);
+
 // read/write a 32-bit register given a BYTE address
 uint32_t umr_read_reg(struct umr_asic *asic, uint64_t addr, enum regclass type);
 int umr_write_reg(struct umr_asic *asic, uint64_t addr, uint32_t value, enum regclass type);
 
+// read many registers grouping them by banking state
+void umr_reg_batch_entry(struct umr_asic *asic, struct umr_reg_batch *rb, uint64_t addr, enum regclass type);
+int umr_read_reg_batch(struct umr_asic *asic, struct umr_reg_batch *regs, uint32_t n);
+
+// sample registers at a fixed rate from a thread of their own
+struct umr_sampler;
+struct umr_sampler_stats {
+	uint64_t samples,              // samples taken
+		 dropped;              // samples not kept because nobody collected them
+	double rate_hz,                // achieved rate
+	       jitter_us,              // average deviation of the sample interval from the period
+	       max_jitter_us;
+};
+struct umr_sampler *umr_sampler_create(struct umr_asic *asic, const struct umr_reg_batch *regs, uint32_t n, uint32_t rate_hz, uint32_t ring_size);
+void umr_sampler_run(struct umr_sampler *s, uint64_t nsamples);
+int umr_sampler_start(struct umr_sampler *s);
+void umr_sampler_stop(struct umr_sampler *s);
+void umr_sampler_set_rate(struct umr_sampler *s, uint32_t rate_hz);
+int umr_sampler_pop(struct umr_sampler *s, uint64_t *ts_ns, uint32_t *values);
+void umr_sampler_get_stats(struct umr_sampler *s, struct umr_sampler_stats *st);
+void umr_sampler_free(struct umr_sampler *s);
+
+// compact binary log of timestamped samples
+struct umr_sample_log;
+struct umr_sample_log *umr_sample_log_open(const char *path, uint32_t nfields, const char **names, const char **units);
+int umr_sample_log_write(struct umr_sample_log *log, uint64_t ts_ns, const uint64_t *values);
+int umr_sample_log_set_fields(struct umr_sample_log *log, uint32_t nfields, const char **names, const char **units);
+int umr_sample_log_flush(struct umr_sample_log *log);
+int umr_sample_log_close(struct umr_sample_log *log);
+int64_t umr_sample_log_to_csv(umr_err_output errout, FILE *in, FILE *out);
+
+// capture/apply/compare the banking options
+void umr_get_bank_state(struct umr_asic *asic, struct umr_bank_state *bs);
+void umr_set_bank_state(struct umr_asic *asic, const struct umr_bank_state *bs);
+int umr_bank_state_cmp(const struct umr_bank_state *a, const struct umr_bank_state *b);
+
 // read/write a register given a name
 uint64_t umr_read_reg_by_name(struct umr_asic *asic, char *name);
 int umr_write_reg_by_name(struct umr_asic *asic, char *name, uint64_t value);
@@ -75,6 +130,16 @@ uint64_t umr_bitslice_reg_by_name(struct umr_asic *asic, char *regname, char *bi
 uint64_t umr_bitslice_reg_by_name_by_ip(struct umr_asic *asic, char *ip, char *regname, char *bitname, uint64_t regvalue);
 uint64_t umr_bitslice_reg_by_name_by_ip_by_instance(struct umr_asic *asic, char *ip, int instance, char *regname, char *bitname, uint64_t regvalue);
 
+// a bitfield resolved once to slice or compose values without name lookups
+struct umr_bitslice {
+	uint64_t mask;
+	unsigned shift;
+};
+int umr_bitslice_resolve(struct umr_asic *asic, struct umr_reg *reg, const char *bitname, struct umr_bitslice *bs);
+int umr_bitslice_resolve_by_name_by_ip(struct umr_asic *asic, char *ip, char *regname, const char *bitname, struct umr_bitslice *bs);
+uint64_t umr_bitslice_extract(const struct umr_bitslice *bs, uint64_t regvalue);
+uint64_t umr_bitslice_compose(const struct umr_bitslice *bs, uint64_t value);
+
 // compose a 64-bit register with a value and a bitfield
 uint64_t umr_bitslice_compose_value(struct umr_asic *asic, struct umr_reg *reg, char *bitname, uint64_t regvalue);
 uint64_t umr_bitslice_compose_value_by_name(struct umr_asic *asic, char *reg, char *bitname, uint64_t regvalue);
@@ -163,6 +163,14 @@ struct umr_stream_decode_ui {
 
 	/** data -- opaque pointer that can be used to track state information */
 	void *data;
+
+	/** reused_ib -- An IB that was already decoded for another packet is about to be followed again
+	 * ib_addr/ib_vmid: Address of the IB
+	 * from_addr/from_vmid: Where does this reference come from?
+	 *
+	 * Can be NULL.
+	 */
+	void (*reused_ib)(struct umr_stream_decode_ui *ui, uint64_t ib_addr, uint32_t ib_vmid, uint64_t from_addr, uint32_t from_vmid);
 };
 
 // all of the supported formats are wrapped up in the "packet" API
@@ -216,6 +224,56 @@ int umr_packet_disassemble_opcodes_vm(struct umr_asic *asic, struct umr_stream_d
 int umr_ring_is_halted(struct umr_asic *asic, char *ringname);
 void *umr_read_ring_data(struct umr_asic *asic, char *ringname, uint32_t *ringsize);
 
+// a ring debugfs file kept open to poll its read/write pointers
+struct umr_ring_poll {
+	int fd;
+	uint32_t ringsize;      // bytes of ring contents after the 12 byte header
+	uint64_t bytes_read;
+	char ringname[64];
+};
+
+int umr_ring_poll_open(struct umr_asic *asic, const char *ringname, const char *path);
+void umr_ring_poll_close(struct umr_asic *asic);
+int umr_read_ring_ptrs(struct umr_asic *asic, char *ringname, uint32_t *ptrs, uint32_t *ringsize);
+int umr_read_ring_words(struct umr_asic *asic, char *ringname, uint32_t start, uint32_t n, uint32_t *dst);
+
+// guess the type of packets on a ring from its name
+enum umr_ring_type umr_packet_guess_ring_type(struct umr_asic *asic, const char *ringname);
+
+// the active packets of a ring decoded incrementally as it is sampled
+#define UMR_RING_CACHE_SEGMENTS 32
+#define UMR_RING_CACHE_LOOKUPS  256
+struct umr_ring_cache {
+	struct umr_asic *asic;
+	char ringname[64];
+	enum umr_ring_type rt;
+
+	// ring size in words and the pointers the segments were decoded for
+	uint32_t ringsize, rptr, wptr;
+
+	// decoded packets in ring order covering rptr to wptr
+	int nsegs;
+	struct {
+		uint32_t start, nwords;
+		struct umr_packet_stream *stream;
+	} segs[UMR_RING_CACHE_SEGMENTS];
+
+	// shader lookups since the segments last changed
+	struct {
+		uint32_t vmid;
+		uint64_t addr;
+		int valid;
+		struct umr_shaders_pgm *shader;  // NULL if no shader was found
+	} lookups[UMR_RING_CACHE_LOOKUPS];
+
+	uint64_t words_decoded, lookups_cached;
+};
+
+struct umr_ring_cache *umr_ring_cache_create(struct umr_asic *asic, const char *ringname, enum umr_ring_type rt);
+int umr_ring_cache_update(struct umr_ring_cache *rc);
+struct umr_shaders_pgm *umr_ring_cache_find_shader(struct umr_ring_cache *rc, unsigned vmid, uint64_t addr);
+void umr_ring_cache_free(struct umr_ring_cache *rc);
+
 #include <umr_packet_pm4.h>
 #include <umr_packet_sdma.h>
 #include <umr_packet_mes.h>
@@ -230,9 +288,14 @@ int umr_shader_disasm(struct umr_asic *asic,
 		    uint8_t *inst, unsigned inst_bytes,
 		    uint64_t PC,
 		    char ***disasm_text);
+void umr_shader_disasm_free(struct umr_asic *asic);
 int umr_vm_disasm_to_str(struct umr_asic *asic, int vm_partition, unsigned vmid, uint64_t addr, uint64_t PC, uint32_t size, uint32_t start_offset, char ***out);
 int umr_vm_disasm(struct umr_asic *asic, FILE *output, int vm_partition, unsigned vmid, uint64_t addr, uint64_t PC, uint32_t size, uint32_t start_offset, struct umr_wave_data *wd);
 uint32_t umr_compute_shader_size(struct umr_asic *asic, int vm_partition, struct umr_shaders_pgm *shader);
 
+// cache of shader sizes and contents used by umr_compute_shader_size() and umr_vm_disasm_to_str()
+void umr_shader_cache_invalidate(struct umr_asic *asic);
+void umr_shader_cache_free(struct umr_asic *asic);
+
 
 #endif
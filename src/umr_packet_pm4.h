@@ -26,6 +26,8 @@
 #define UMR_PACKET_PM4_H_
 
 // PM4 decoding library
+struct umr_pm4_arena;
+
 struct umr_pm4_stream {
 	uint32_t pkttype,				// packet type (0==simple write, 3 == packet)
 			 pkt0off,				// base address for PKT0 writes
@@ -41,11 +43,14 @@ struct umr_pm4_stream {
 		uint64_t addr;
 		uint32_t vmid;
 	} ib_source;					// where did an IB if any come from?
+	int ib_reused;					// ib was already decoded for another packet and is shared with it
 
 	struct umr_shaders_pgm *shader; // shader program if any
 	struct umr_vcn_cmd_message *vcn; // VCN command message if any
 
 	int invalid;
+
+	struct umr_pm4_arena *arena;	// block the packet and its words live in (NULL if allocated on their own)
 };
 
 struct umr_pm4_stream *umr_pm4_decode_stream(struct umr_asic *asic, int vm_partition, uint32_t vmid, uint32_t *stream, uint32_t nwords);
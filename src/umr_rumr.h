@@ -30,6 +30,40 @@
 // version of RUMR protocol
 #define RUMR_VERSION 0x01
 
+// revision of the optional protocol features.  A client sends its
+// revision as the only parameter of DISCOVER and a server that knows
+// about revisions appends its own after the serialized ASIC.  Peers
+// that predate this send and return nothing which reads as revision 1.
+//   1: one request per frame
+//   2: request IDs, RUMR_OP_BATCH
+#define RUMR_REVISION 2
+
+// packet header word
+//   bit 0:      SERVER flag (set on replies)
+//   bits 1-8:   RUMR_VERSION
+//   bits 10-17: opcode
+//   bits 18-31: request ID, echoed back in the reply
+#define RUMR_HEADER(opcode, id)  (((uint32_t)(id) << 18) | ((uint32_t)(opcode) << 10) | (RUMR_VERSION << 1))
+#define RUMR_HEADER_OPCODE(hdr)  (((hdr) >> 10) & 0xFF)
+#define RUMR_HEADER_ID(hdr)      ((hdr) >> 18)
+#define RUMR_MAX_ID              0x3FFF
+
+// RUMR_OP_BATCH frames carry COUNT followed by COUNT entries of
+//   ENTRY: (payload words << 8) | opcode
+//   payload words in the format of the single opcode
+// and are answered with COUNT followed by COUNT entries of
+//   ENTRY: payload bytes
+//   reply payload in the format of the single opcode (without header)
+// only REG/MEM/WAVE/GPR/RING access opcodes may appear in a batch
+#define RUMR_BATCH_MAX 1024
+
+// most requests a client keeps in flight when pipelining
+#define RUMR_MAX_INFLIGHT 64
+
+// most requests a client may have submitted and not collected, this
+// also bounds how many early replies it holds on to
+#define RUMR_MAX_OUTSTANDING 1024
+
 // amount of preheader space used by comms
 // layer this allows transmitting "once"
 // which so far for TCP speeds things up
@@ -44,6 +78,7 @@ enum rumr_opcodes {
 	RUMR_OP_GPR_ACCESS,
 	RUMR_OP_RING_ACCESS,
 	RUMR_OP_GOODBYE,
+	RUMR_OP_BATCH,
 };
 
 struct rumr_buffer{
@@ -99,16 +134,33 @@ struct rumr_server_state {
 
 #include <umr.h>
 
+// a reply that arrived before the caller asked for it
+struct rumr_pending_reply {
+	uint32_t id;
+	struct rumr_buffer *buf;
+	struct rumr_pending_reply *next;
+};
+
 struct rumr_client_state {
 	struct rumr_comm_funcs comm;
 	struct umr_asic *asic;
 	int (*log_msg)(const char *fmt, ...);
+
+	uint32_t server_revision,	// RUMR_REVISION reported by the server during DISCOVER
+		 next_id,
+		 no_outstanding;
+	uint32_t outstanding[(RUMR_MAX_ID + 1) / 32],	// IDs submitted whose reply was not collected
+		 discarded[(RUMR_MAX_ID + 1) / 32];	// outstanding IDs whose reply is dropped on arrival
+	struct rumr_pending_reply *pending;
 };
 
 // client functions
 int rumr_client_connect(struct rumr_client_state *state, struct rumr_comm_funcs *cf, char *addr);
 void rumr_client_close(struct rumr_client_state *state);
 int rumr_client_discover(struct rumr_client_state *state);
+int rumr_client_submit(struct rumr_client_state *state, uint32_t opcode, const uint32_t *pkt, uint32_t pktsize, uint32_t *id);
+struct rumr_buffer *rumr_client_collect(struct rumr_client_state *state, uint32_t id);
+void rumr_client_discard(struct rumr_client_state *state, uint32_t id);
 #endif
 
 // buffer functions
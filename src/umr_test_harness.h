@@ -32,5 +32,7 @@ void umr_free_test_harness(struct umr_test_harness *th);
 void umr_attach_test_harness(struct umr_test_harness *th, struct umr_asic *asic);
 int umr_test_harness_get_config_data(struct umr_asic *asic, uint8_t *dst);
 void *umr_test_harness_get_ring_data(struct umr_asic *asic, uint32_t *ringsize);
+void umr_test_harness_rewind(struct umr_asic *asic);
+void umr_test_harness_get_access_counts(struct umr_asic *asic, uint32_t *reg_reads, uint32_t *bank_switches);
 
 #endif
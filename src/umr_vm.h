@@ -44,6 +44,12 @@ uint64_t umr_vm_dma_to_phys(struct umr_asic *asic, uint64_t dma_addr);
 int umr_access_sram(struct umr_asic *asic, uint64_t address, uint32_t size, void *dst, int write_en);
 int umr_access_vram(struct umr_asic *asic, int partition, uint32_t vmid, uint64_t address, uint32_t size, void *data, int write_en, struct umr_vm_pagewalk *vmdata);
 int umr_access_linear_vram(struct umr_asic *asic, uint64_t address, uint32_t size, void *data, int write_en);
+
+// cache of VM context registers and PDE/PTEs used by umr_access_vram()
+void umr_vm_cache_invalidate(struct umr_asic *asic);
+void umr_vm_cache_invalidate_vmid(struct umr_asic *asic, int partition, uint32_t vmid);
+void umr_vm_cache_free(struct umr_asic *asic);
+
 #define umr_read_vram(asic, partition, vmid, address, size, dst) umr_access_vram(asic, partition, vmid, address, size, dst, 0, NULL)
 #define umr_write_vram(asic, partition, vmid, address, size, src) umr_access_vram(asic, partition, vmid, address, size, src, 1, NULL)
 
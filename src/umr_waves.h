@@ -28,14 +28,97 @@
 /* ==== WAVE Status ====
  * These functions deal with reading WAVE status data including flags, shaders, etc
  */
+
+// wave status registers across all GFX generations, see umr_wave_data_get_reg()
+enum umr_wave_reg {
+	UMR_WAVE_REG_STATUS = 0,
+	UMR_WAVE_REG_PC_LO,
+	UMR_WAVE_REG_PC_HI,
+	UMR_WAVE_REG_EXEC_LO,
+	UMR_WAVE_REG_EXEC_HI,
+	UMR_WAVE_REG_HW_ID,
+	UMR_WAVE_REG_HW_ID1,
+	UMR_WAVE_REG_HW_ID2,
+	UMR_WAVE_REG_INST_DW0,
+	UMR_WAVE_REG_INST_DW1,
+	UMR_WAVE_REG_GPR_ALLOC,
+	UMR_WAVE_REG_LDS_ALLOC,
+	UMR_WAVE_REG_TRAPSTS,
+	UMR_WAVE_REG_IB_STS,
+	UMR_WAVE_REG_IB_STS2,
+	UMR_WAVE_REG_TBA_LO,
+	UMR_WAVE_REG_TBA_HI,
+	UMR_WAVE_REG_TMA_LO,
+	UMR_WAVE_REG_TMA_HI,
+	UMR_WAVE_REG_IB_DBG0,
+	UMR_WAVE_REG_IB_DBG1,
+	UMR_WAVE_REG_M0,
+	UMR_WAVE_REG_MODE,
+	UMR_WAVE_REG_STATE_PRIV,
+	UMR_WAVE_REG_EXCP_FLAG_PRIV,
+	UMR_WAVE_REG_EXCP_FLAG_USER,
+	UMR_WAVE_REG_TRAP_CTRL,
+	UMR_WAVE_REG_ACTIVE,
+	UMR_WAVE_REG_VALID_AND_IDLE,
+	UMR_WAVE_REG_DVGPR_ALLOC_LO,
+	UMR_WAVE_REG_DVGPR_ALLOC_HI,
+	UMR_WAVE_REG_SCHED_MODE,
+	UMR_WAVE_REG_MAX
+};
+
+// bitfields of the wave status registers, see umr_wave_data_get_field()
+enum umr_wave_field {
+	UMR_WAVE_FIELD_STATUS_VALID = 0,
+	UMR_WAVE_FIELD_STATUS_HALT,
+	UMR_WAVE_FIELD_STATUS_FATAL_HALT,
+	UMR_WAVE_FIELD_STATUS_TRAP_EN,
+	UMR_WAVE_FIELD_STATUS_PRIV,
+	UMR_WAVE_FIELD_STATUS_WAVE64,
+	UMR_WAVE_FIELD_HW_ID_SE_ID,
+	UMR_WAVE_FIELD_HW_ID_SH_ID,
+	UMR_WAVE_FIELD_HW_ID_CU_ID,
+	UMR_WAVE_FIELD_HW_ID_WAVE_ID,
+	UMR_WAVE_FIELD_HW_ID_SIMD_ID,
+	UMR_WAVE_FIELD_HW_ID_VM_ID,
+	UMR_WAVE_FIELD_HW_ID1_SE_ID,
+	UMR_WAVE_FIELD_HW_ID1_SA_ID,
+	UMR_WAVE_FIELD_HW_ID1_WGP_ID,
+	UMR_WAVE_FIELD_HW_ID1_WAVE_ID,
+	UMR_WAVE_FIELD_HW_ID1_SIMD_ID,
+	UMR_WAVE_FIELD_HW_ID2_VM_ID,
+	UMR_WAVE_FIELD_GPR_ALLOC_VGPR_SIZE,
+	UMR_WAVE_FIELD_GPR_ALLOC_SGPR_SIZE,
+	UMR_WAVE_FIELD_IB_STS2_WAVE64,
+	UMR_WAVE_FIELD_STATE_PRIV_HALT,
+	UMR_WAVE_FIELD_MAX
+};
+
 int umr_get_wave_status_raw(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, uint32_t *buf);
 int umr_get_wave_status(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, struct umr_wave_status *ws);
 int umr_get_wave_status_via_mmio(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, unsigned simd, unsigned wave, struct umr_wave_status *ws);
 struct umr_wave_data *umr_scan_wave_data(struct umr_asic *asic);
+void umr_free_wave_data(struct umr_wave_data *waves);
+void umr_wave_data_free_gprs(struct umr_wave_data *wd);
+uint32_t umr_wave_data_count(struct umr_wave_data *waves);
+size_t umr_wave_data_footprint(struct umr_wave_data *waves);
+uint32_t umr_wave_data_sgpr(struct umr_wave_data *wd, uint32_t idx);
+uint32_t umr_wave_data_vgpr(struct umr_wave_data *wd, uint32_t thread, uint32_t idx);
+
+// iterate over the waves returned by umr_scan_wave_data()
+#define umr_for_each_wave(wd, waves) for ((wd) = (waves); (wd); (wd) = (wd)->next)
 
 int umr_wave_data_init(struct umr_asic *asic, struct umr_wave_data *wd);
 uint32_t umr_wave_data_get_value(struct umr_asic *asic, struct umr_wave_data *wd, const char *regname);
 uint32_t umr_wave_data_get_bits(struct umr_asic *asic, struct umr_wave_data *wd, const char *regname, const char *bitname);
+int umr_wave_reg_lookup(const char *regname);
+const char *umr_wave_reg_name(enum umr_wave_reg reg);
+uint32_t umr_wave_data_get_reg(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_reg reg);
+uint32_t umr_wave_data_get_reg_bits(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_reg reg, const char *bitname);
+uint32_t umr_wave_data_get_field(struct umr_asic *asic, struct umr_wave_data *wd, enum umr_wave_field field);
+enum umr_wave_reg umr_wave_field_reg(enum umr_wave_field field);
+const char *umr_wave_field_name(enum umr_wave_field field);
+int umr_wave_fields_resolve(struct umr_asic *asic);
+void umr_wave_fields_free(struct umr_asic *asic);
 int umr_wave_data_get_bit_info(struct umr_asic *asic, struct umr_wave_data *wd, const char *regname, int *no_bits, struct umr_bitfield **bits);
 int umr_wave_data_get_shader_pc_vmid(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *vmid, uint64_t *addr);
 uint32_t umr_wave_data_num_of_sgprs(struct umr_asic *asic, struct umr_wave_data *wd);
@@ -59,6 +142,8 @@ int umr_get_wave_sq_info_vi(struct umr_asic *asic, unsigned se, unsigned sh, uns
 int umr_get_wave_sq_info(struct umr_asic *asic, unsigned se, unsigned sh, unsigned cu, struct umr_wave_status *ws);
 int umr_read_sgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst);
 int umr_read_vgprs(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thread, uint32_t *dst);
+int umr_read_vgprs_batch(struct umr_asic *asic, struct umr_wave_data *wd, uint64_t thread_mask, uint32_t stride, uint32_t *dst);
+int umr_wave_thread_context(struct umr_asic *asic, struct umr_asic *copy, int setup);
 int umr_read_sgprs_via_mmio(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t *dst);
 int umr_read_vgprs_via_mmio(struct umr_asic *asic, struct umr_wave_data *wd, uint32_t thread, uint32_t *dst);
 int umr_read_sensor(struct umr_asic *asic, int sensor, void *dst, int *size);